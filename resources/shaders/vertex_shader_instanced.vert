@@ -0,0 +1,36 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// The instance culler's buffers (see instance_culler::descriptor_set); ubo.model is not used
+struct Instance {
+    mat4 model;
+    vec4 boundingSphere;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer VisibleInstances {
+    uint visibleInstances[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    mat4 model = instances[visibleInstances[gl_InstanceIndex]].model;
+    gl_Position = ubo.proj * ubo.view * model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "pch.h"
+
+namespace helpers
+{
+	bool bindless_texture_table::is_supported(const vk::PhysicalDevice physicalDevice, const uint32_t capacity)
+	{
+		if (!helpers::is_descriptor_indexing_supported(physicalDevice)) {
+			return false;
+		}
+		const auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+		const auto& indexing = properties.get<vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+		return capacity <= indexing.maxDescriptorSetUpdateAfterBindSampledImages
+			&& capacity <= indexing.maxDescriptorSetUpdateAfterBindSamplers
+			&& capacity <= indexing.maxPerStageDescriptorUpdateAfterBindSampledImages
+			&& capacity <= indexing.maxPerStageDescriptorUpdateAfterBindSamplers;
+	}
+
+	bindless_texture_table::bindless_texture_table(
+		const vk::Device device,
+		const uint32_t capacity,
+		const vk::ShaderStageFlags stages)
+		: mDevice{ device }
+		, mCapacity{ capacity }
+		, mUsed(capacity, false)
+	{
+		if (0 == capacity) {
+			throw std::invalid_argument("A bindless texture table must have room for at least one texture.");
+		}
+
+		// Partially bound: slots which no shader accesses may stay unwritten (or hold destroyed views).
+		// Update after bind + unused while pending: adding textures doesn't invalidate command buffers which use the set.
+		const vk::DescriptorBindingFlagsEXT bindingFlags = vk::DescriptorBindingFlagBitsEXT::ePartiallyBound
+			| vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind
+			| vk::DescriptorBindingFlagBitsEXT::eUpdateUnusedWhilePending;
+		const auto bindingFlagsInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT{}
+			.setBindingCount(1u)
+			.setPBindingFlags(&bindingFlags);
+		const auto binding = vk::DescriptorSetLayoutBinding{}
+			.setBinding(0u)
+			.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+			.setDescriptorCount(capacity)
+			.setStageFlags(stages);
+		mLayout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{}
+			.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT)
+			.setBindingCount(1u)
+			.setPBindings(&binding)
+			.setPNext(&bindingFlagsInfo)
+		);
+
+		const auto poolSize = vk::DescriptorPoolSize{ vk::DescriptorType::eCombinedImageSampler, capacity };
+		mPool = device.createDescriptorPool(vk::DescriptorPoolCreateInfo{}
+			.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT)
+			.setMaxSets(1u)
+			.setPoolSizeCount(1u)
+			.setPPoolSizes(&poolSize)
+		);
+
+		mSet = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{}
+			.setDescriptorPool(mPool)
+			.setDescriptorSetCount(1u)
+			.setPSetLayouts(&mLayout)
+		).front();
+	}
+
+	bindless_texture_table::~bindless_texture_table()
+	{
+		// Destroying the pool also frees the set:
+		mDevice.destroyDescriptorPool(mPool);
+		mDevice.destroyDescriptorSetLayout(mLayout);
+	}
+
+	uint32_t bindless_texture_table::add(const vk::ImageView imageView, const vk::Sampler sampler, const vk::ImageLayout layout)
+	{
+		uint32_t index;
+		if (!mFreeSlots.empty()) {
+			index = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else if (mNextUnusedSlot < mCapacity) {
+			index = mNextUnusedSlot++;
+		}
+		else {
+			throw std::runtime_error("The bindless texture table is full (" + std::to_string(mCapacity) + " textures)");
+		}
+
+		const auto imageInfo = vk::DescriptorImageInfo{ sampler, imageView, layout };
+		mDevice.updateDescriptorSets({ vk::WriteDescriptorSet{}
+			.setDstSet(mSet)
+			.setDstBinding(0u)
+			.setDstArrayElement(index)
+			.setDescriptorCount(1u)
+			.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+			.setPImageInfo(&imageInfo)
+		}, {});
+		mUsed[index] = true;
+		++mCount;
+		++mWrites;
+		return index;
+	}
+
+	void bindless_texture_table::remove(const uint32_t index)
+	{
+		if (index >= mCapacity || !mUsed[index]) {
+			throw std::invalid_argument("There is no texture at index " + std::to_string(index) + " of the bindless texture table");
+		}
+		mUsed[index] = false;
+		mFreeSlots.push_back(index);
+		--mCount;
+	}
+
+	void bindless_texture_table::print_statistics(std::ostream& stream) const
+	{
+		stream << "Bindless texture table: " << mCount << " of " << mCapacity << " slots used, "
+			<< mWrites << " descriptor writes" << std::endl;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace helpers
+{
+	// One big, partially bound array of combined image samplers (descriptor indexing), which all textures are added to.
+	// Shaders index into it with a texture index from a push constant or a buffer (see fragment_shader_bindless.frag),
+	// i.e. the descriptor set is bound once per frame and never changes between draws that use different textures.
+	//
+	// The set is allocated from an update-after-bind pool: textures can be added and removed while command buffers which
+	// use the set are pending, as long as those command buffers don't access the very slots which change.
+	// Removed slots are reused by later adds; it is the caller's job to only remove textures the GPU is done with.
+	//
+	// Requires a device created with enableDescriptorIndexing = true, and is_descriptor_indexing_supported.
+	// The table is not thread-safe.
+	class bindless_texture_table
+	{
+	public:
+		// Is the device able to create bindless texture tables at all (for the given capacity)?
+		static bool is_supported(const vk::PhysicalDevice physicalDevice, const uint32_t capacity);
+
+		bindless_texture_table(
+			const vk::Device device,
+			const uint32_t capacity,
+			const vk::ShaderStageFlags stages = vk::ShaderStageFlagBits::eFragment
+		);
+		bindless_texture_table(const bindless_texture_table&) = delete;
+		bindless_texture_table& operator=(const bindless_texture_table&) = delete;
+		// The GPU must be done with all command buffers which have used the table's set.
+		~bindless_texture_table();
+
+		// Layout of the set (one binding: 0, the array), to be put into pipeline layouts
+		vk::DescriptorSetLayout layout() const { return mLayout; }
+		vk::DescriptorSet set() const { return mSet; }
+
+		// Write the texture into a free slot, and return that slot's index. Throws if the table is full.
+		uint32_t add(const vk::ImageView imageView, const vk::Sampler sampler, const vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
+		// Free the slot for later adds. Shaders must not access it anymore (it is left as it is, not written to).
+		void remove(const uint32_t index);
+
+		uint32_t capacity() const { return mCapacity; }
+		uint32_t texture_count() const { return mCount; }
+
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		vk::Device mDevice;
+		uint32_t mCapacity;
+		vk::DescriptorSetLayout mLayout;
+		vk::DescriptorPool mPool;
+		vk::DescriptorSet mSet;
+		std::vector<uint32_t> mFreeSlots;	// Slots which have been removed; used before never used ones
+		std::vector<bool> mUsed;
+		uint32_t mNextUnusedSlot = 0;		// All slots from here on have never been used
+		uint32_t mCount = 0;
+		uint64_t mWrites = 0;
+	};
+}
@@ -0,0 +1,121 @@
+#include "pch.h"
+
+namespace helpers
+{
+	deletion_queue::deletion_queue(const vk::Device device)
+		: mDevice{ device }
+	{
+	}
+
+	deletion_queue::~deletion_queue()
+	{
+		flush();
+	}
+
+	void deletion_queue::destroy_later(const uint64_t usedUntil, const vk::Buffer buffer, const memory_allocation& memory)
+	{
+		enqueue(pending_deletion{ usedUntil, buffer, nullptr, nullptr, nullptr, memory, nullptr });
+	}
+
+	void deletion_queue::destroy_later(const uint64_t usedUntil, const vk::Image image, const memory_allocation& memory, const vk::ImageView imageView)
+	{
+		enqueue(pending_deletion{ usedUntil, nullptr, image, imageView, nullptr, memory, nullptr });
+	}
+
+	void deletion_queue::destroy_later(const uint64_t usedUntil, const vk::ImageView imageView)
+	{
+		enqueue(pending_deletion{ usedUntil, nullptr, nullptr, imageView, nullptr, memory_allocation{}, nullptr });
+	}
+
+	void deletion_queue::destroy_later(const uint64_t usedUntil, const vk::Sampler sampler)
+	{
+		enqueue(pending_deletion{ usedUntil, nullptr, nullptr, nullptr, sampler, memory_allocation{}, nullptr });
+	}
+
+	void deletion_queue::destroy_later(const uint64_t usedUntil, std::function<void()> deleter)
+	{
+		enqueue(pending_deletion{ usedUntil, nullptr, nullptr, nullptr, nullptr, memory_allocation{}, std::move(deleter) });
+	}
+
+	void deletion_queue::enqueue(pending_deletion&& deletion)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStatistics.pendingBytes += deletion.memory.size;
+		// Usually, resources are enqueued in the order of their counts => appending keeps the queue sorted:
+		const auto pos = std::upper_bound(mPending.begin(), mPending.end(), deletion.usedUntil, [](const uint64_t usedUntil, const pending_deletion& d) {
+			return usedUntil < d.usedUntil;
+		});
+		mPending.insert(pos, std::move(deletion));
+		++mStatistics.enqueued;
+		mStatistics.peakPending = std::max(mStatistics.peakPending, mPending.size());
+	}
+
+	size_t deletion_queue::collect(const uint64_t completedCount)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const auto end = std::find_if(mPending.begin(), mPending.end(), [completedCount](const pending_deletion& d) {
+			return d.usedUntil > completedCount;
+		});
+		const auto count = static_cast<size_t>(std::distance(mPending.begin(), end));
+		destroy_front(count);
+		return count;
+	}
+
+	void deletion_queue::flush()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		destroy_front(mPending.size());
+	}
+
+	void deletion_queue::destroy_front(const size_t count)
+	{
+		if (0 == count) {
+			return;
+		}
+		mMemoryToFree.clear();
+		for (size_t i = 0; i < count; ++i) {
+			auto& d = mPending[i];
+			if (d.deleter) {
+				d.deleter();
+			}
+			if (d.imageView) {
+				destroy_image_view(mDevice, d.imageView);
+			}
+			if (d.image) {
+				destroy_image(mDevice, d.image);
+			}
+			if (d.buffer) {
+				destroy_buffer(mDevice, d.buffer);
+			}
+			if (d.sampler) {
+				mDevice.destroySampler(d.sampler);
+			}
+			if (d.memory.memory) {
+				mMemoryToFree.push_back(d.memory);
+				mStatistics.pendingBytes -= d.memory.size;
+			}
+		}
+		// One lock of the memory arena for all of them:
+		if (!mMemoryToFree.empty()) {
+			get_memory_arena(mDevice).free(mMemoryToFree);
+		}
+		mPending.erase(mPending.begin(), mPending.begin() + static_cast<std::ptrdiff_t>(count));
+		mStatistics.destroyed += count;
+		++mStatistics.collections;
+	}
+
+	deletion_queue_statistics deletion_queue::get_statistics() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto stats = mStatistics;
+		stats.pending = mPending.size();
+		return stats;
+	}
+
+	void deletion_queue::print_statistics(std::ostream& stream) const
+	{
+		const auto stats = get_statistics();
+		stream << "Deletion queue: " << stats.enqueued << " enqueued, " << stats.destroyed << " destroyed in " << stats.collections
+			<< " collections, " << stats.pending << " pending (" << stats.pendingBytes / 1024 << " KiB), peak " << stats.peakPending << " pending" << std::endl;
+	}
+}
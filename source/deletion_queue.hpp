@@ -0,0 +1,83 @@
+#pragma once
+
+namespace helpers
+{
+	// How a deletion queue has been used
+	struct deletion_queue_statistics
+	{
+		uint64_t enqueued = 0;
+		uint64_t destroyed = 0;
+		size_t pending = 0;				// Enqueued, but not destroyed yet
+		size_t peakPending = 0;
+		vk::DeviceSize pendingBytes = 0;	// Memory of the pending resources, which can't be reused yet
+		uint64_t collections = 0;		// collect calls which have destroyed anything
+	};
+
+	// Destroys resources once the GPU is done with them, instead of waiting for the device to become idle.
+	//
+	// Each resource is enqueued with the frame count up to which the GPU may still use it -- usually the frame
+	// scheduler's frame_number() at the time the resource is replaced, i.e. it may be used by all frames which have been
+	// begun so far. collect destroys all resources whose frames the GPU has completed, in bulk: the memory of all of them
+	// is returned to the memory arena at once. Nothing ever waits for the GPU; resources just live a few frames longer.
+	//
+	// Usage:
+	//   auto& frame = frameScheduler.begin_frame();
+	//   deletionQueue.collect(frameScheduler.completed_frame_count());
+	//   ... an asset is evicted or replaced:
+	//   deletionQueue.destroy_later(frameScheduler.frame_number(), oldBuffer, oldMemory);
+	//
+	// The counts don't have to be frames, they just have to grow monotonically with the GPU's progress on one queue.
+	// The deletion queue is thread-safe, s.t. resources can be enqueued from worker threads (e.g. by streamers).
+	class deletion_queue
+	{
+	public:
+		explicit deletion_queue(const vk::Device device);
+		deletion_queue(const deletion_queue&) = delete;
+		deletion_queue& operator=(const deletion_queue&) = delete;
+		// Destroys all pending resources => the GPU must be done with them (e.g. after device.waitIdle()).
+		~deletion_queue();
+
+		// Destroy the buffer and free its memory once <completedCount> passed to collect is at least <usedUntil>
+		void destroy_later(const uint64_t usedUntil, const vk::Buffer buffer, const memory_allocation& memory);
+
+		// Destroy the image (and the image view, if given) and free its memory, once the GPU is done with them
+		void destroy_later(const uint64_t usedUntil, const vk::Image image, const memory_allocation& memory, const vk::ImageView imageView = nullptr);
+
+		void destroy_later(const uint64_t usedUntil, const vk::ImageView imageView);
+		void destroy_later(const uint64_t usedUntil, const vk::Sampler sampler);
+
+		// For everything else, e.g. [device, mesh]() { helpers::destroy_device_mesh(device, mesh); }
+		void destroy_later(const uint64_t usedUntil, std::function<void()> deleter);
+
+		// Destroy everything which has been used until at most <completedCount>. Returns the number of destroyed entries.
+		size_t collect(const uint64_t completedCount);
+
+		// Destroy everything now. The GPU must be done with all of it.
+		void flush();
+
+		deletion_queue_statistics get_statistics() const;
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		struct pending_deletion
+		{
+			uint64_t usedUntil;
+			vk::Buffer buffer;
+			vk::Image image;
+			vk::ImageView imageView;
+			vk::Sampler sampler;
+			memory_allocation memory;
+			std::function<void()> deleter;
+		};
+
+		void enqueue(pending_deletion&& deletion);
+		// Destroys the first <count> entries of mPending; mMutex must be held
+		void destroy_front(const size_t count);
+
+		vk::Device mDevice;
+		std::deque<pending_deletion> mPending;		// Sorted by usedUntil
+		std::vector<memory_allocation> mMemoryToFree;
+		deletion_queue_statistics mStatistics;
+		mutable std::mutex mMutex;
+	};
+}
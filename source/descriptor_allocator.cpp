@@ -0,0 +1,255 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		template <typename T>
+		uint64_t hash_value(const T& value, const uint64_t hash)
+		{
+			return fnv1a_64(&value, sizeof(value), hash);
+		}
+
+		// Hash member by member (the structs may contain padding):
+		uint64_t hash_binding(const vk::DescriptorSetLayoutBinding& b, uint64_t hash)
+		{
+			hash = hash_value(b.binding, hash);
+			hash = hash_value(b.descriptorType, hash);
+			hash = hash_value(b.descriptorCount, hash);
+			hash = hash_value(static_cast<VkShaderStageFlags>(b.stageFlags), hash);
+			return hash_value(b.pImmutableSamplers, hash);
+		}
+
+		uint64_t hash_write(const descriptor_write& w, uint64_t hash)
+		{
+			hash = hash_value(w.binding, hash);
+			hash = hash_value(w.type, hash);
+			hash = hash_value(static_cast<VkBuffer>(w.bufferInfo.buffer), hash);
+			hash = hash_value(w.bufferInfo.offset, hash);
+			hash = hash_value(w.bufferInfo.range, hash);
+			hash = hash_value(static_cast<VkImageView>(w.imageInfo.imageView), hash);
+			hash = hash_value(static_cast<VkSampler>(w.imageInfo.sampler), hash);
+			return hash_value(w.imageInfo.imageLayout, hash);
+		}
+
+		bool is_buffer_descriptor(const vk::DescriptorType type)
+		{
+			return vk::DescriptorType::eUniformBuffer == type || vk::DescriptorType::eStorageBuffer == type
+				|| vk::DescriptorType::eUniformBufferDynamic == type || vk::DescriptorType::eStorageBufferDynamic == type;
+		}
+
+		// How many descriptors of each type a pool gets, per set it can hold
+		const std::array<std::tuple<vk::DescriptorType, float>, 7> PoolSizeRatios = {{
+			{ vk::DescriptorType::eUniformBuffer, 2.0f },
+			{ vk::DescriptorType::eUniformBufferDynamic, 1.0f },
+			{ vk::DescriptorType::eStorageBuffer, 2.0f },
+			{ vk::DescriptorType::eCombinedImageSampler, 4.0f },
+			{ vk::DescriptorType::eSampledImage, 2.0f },
+			{ vk::DescriptorType::eSampler, 1.0f },
+			{ vk::DescriptorType::eStorageImage, 1.0f }
+		}};
+	}
+
+	descriptor_write descriptor_write::buffer(const uint32_t binding, const vk::DescriptorType type, const vk::Buffer buffer, const vk::DeviceSize offset, const vk::DeviceSize range)
+	{
+		descriptor_write write;
+		write.binding = binding;
+		write.type = type;
+		write.bufferInfo = vk::DescriptorBufferInfo{ buffer, offset, range };
+		return write;
+	}
+
+	descriptor_write descriptor_write::image(const uint32_t binding, const vk::DescriptorType type, const vk::ImageView imageView, const vk::Sampler sampler, const vk::ImageLayout layout)
+	{
+		descriptor_write write;
+		write.binding = binding;
+		write.type = type;
+		write.imageInfo = vk::DescriptorImageInfo{ sampler, imageView, layout };
+		return write;
+	}
+
+	bool descriptor_write::operator==(const descriptor_write& other) const
+	{
+		return binding == other.binding && type == other.type && bufferInfo == other.bufferInfo && imageInfo == other.imageInfo;
+	}
+
+	descriptor_layout_cache::descriptor_layout_cache(const vk::Device device)
+		: mDevice{ device }
+	{
+	}
+
+	descriptor_layout_cache::~descriptor_layout_cache()
+	{
+		for (auto& [hash, layouts] : mLayouts) {
+			for (auto& cached : layouts) {
+				mDevice.destroyDescriptorSetLayout(cached.layout);
+			}
+		}
+	}
+
+	vk::DescriptorSetLayout descriptor_layout_cache::get_layout(std::vector<vk::DescriptorSetLayoutBinding> bindings)
+	{
+		std::sort(bindings.begin(), bindings.end(), [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) {
+			return a.binding < b.binding;
+		});
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const auto& b : bindings) {
+			hash = hash_binding(b, hash);
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto& candidates = mLayouts[hash];
+		for (const auto& cached : candidates) {
+			if (cached.bindings == bindings) {
+				return cached.layout;
+			}
+		}
+
+		auto layout = mDevice.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{}
+			.setBindingCount(static_cast<uint32_t>(bindings.size()))
+			.setPBindings(bindings.data())
+		);
+		candidates.push_back(cached_layout{ std::move(bindings), layout });
+		return layout;
+	}
+
+	size_t descriptor_layout_cache::layout_count() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		size_t count = 0;
+		for (const auto& [hash, layouts] : mLayouts) {
+			count += layouts.size();
+		}
+		return count;
+	}
+
+	descriptor_allocator::descriptor_allocator(const vk::Device device, const uint32_t framesInFlight)
+		: mDevice{ device }
+		, mSlots(framesInFlight)
+	{
+		if (0 == framesInFlight) {
+			throw std::invalid_argument("There must be at least one frame in flight.");
+		}
+	}
+
+	descriptor_allocator::~descriptor_allocator()
+	{
+		for (auto& slot : mSlots) {
+			for (auto pool : slot.pools) {
+				// Destroying the pool also frees its sets:
+				mDevice.destroyDescriptorPool(pool);
+			}
+		}
+	}
+
+	vk::DescriptorPool descriptor_allocator::create_pool(const uint32_t maxSets)
+	{
+		std::vector<vk::DescriptorPoolSize> poolSizes;
+		for (const auto& [type, ratio] : PoolSizeRatios) {
+			poolSizes.push_back(vk::DescriptorPoolSize{ type, std::max(1u, static_cast<uint32_t>(ratio * static_cast<float>(maxSets))) });
+		}
+		++mStatistics.poolsCreated;
+		++mStatistics.poolCount;
+		// No eFreeDescriptorSet: sets are never freed individually, the whole pool is reset instead
+		return mDevice.createDescriptorPool(vk::DescriptorPoolCreateInfo{}
+			.setMaxSets(maxSets)
+			.setPoolSizeCount(static_cast<uint32_t>(poolSizes.size()))
+			.setPPoolSizes(poolSizes.data())
+		);
+	}
+
+	void descriptor_allocator::begin_frame()
+	{
+		mCurrentSlot = static_cast<size_t>(mFrameNumber % mSlots.size());
+		auto& slot = mSlots[mCurrentSlot];
+		for (auto pool : slot.pools) {
+			mDevice.resetDescriptorPool(pool);
+		}
+		slot.currentPool = 0;
+		slot.cachedSets.clear();
+		++mFrameNumber;
+	}
+
+	vk::DescriptorSet descriptor_allocator::allocate(const vk::DescriptorSetLayout layout)
+	{
+		auto& slot = mSlots[mCurrentSlot];
+		// Try the frame's pools which are not known to be exhausted yet, then create a new one:
+		while (true) {
+			const bool newPool = slot.currentPool == slot.pools.size();
+			if (newPool) {
+				slot.pools.push_back(create_pool(mNextPoolSize));
+				mNextPoolSize = std::min(mNextPoolSize * 2, MaxSetsPerPool);
+			}
+
+			VkDescriptorSet set = VK_NULL_HANDLE;
+			const auto vkLayout = static_cast<VkDescriptorSetLayout>(layout);
+			const auto allocateInfo = VkDescriptorSetAllocateInfo{
+				VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, static_cast<VkDescriptorPool>(slot.pools[slot.currentPool]), 1u, &vkLayout
+			};
+			// Not through vulkan.hpp, which would throw on the (expected) out of pool memory errors:
+			const auto result = static_cast<vk::Result>(vkAllocateDescriptorSets(mDevice, &allocateInfo, &set));
+			if (vk::Result::eSuccess == result) {
+				return vk::DescriptorSet{ set };
+			}
+			if (vk::Result::eErrorOutOfPoolMemory != result && vk::Result::eErrorFragmentedPool != result) {
+				throw std::runtime_error("Couldn't allocate a descriptor set: " + vk::to_string(result));
+			}
+			if (newPool) {
+				// Not even an empty pool has room => the layout needs more descriptors of some type than a pool has:
+				throw std::runtime_error("A descriptor set of this layout doesn't fit into a descriptor pool");
+			}
+			++slot.currentPool;
+		}
+	}
+
+	vk::DescriptorSet descriptor_allocator::get_set(const vk::DescriptorSetLayout layout, const std::vector<descriptor_write>& writes)
+	{
+		++mStatistics.setsRequested;
+		auto hash = hash_value(static_cast<VkDescriptorSetLayout>(layout), 0xcbf29ce484222325ull);
+		for (const auto& w : writes) {
+			hash = hash_write(w, hash);
+		}
+
+		auto& slot = mSlots[mCurrentSlot];
+		const auto it = slot.cachedSets.find(hash);
+		if (slot.cachedSets.end() != it && it->second.layout == layout && it->second.writes == writes) {
+			return it->second.set;
+		}
+
+		const auto set = allocate(layout);
+		std::vector<vk::WriteDescriptorSet> descriptorWrites;
+		descriptorWrites.reserve(writes.size());
+		for (const auto& w : writes) {
+			auto descriptorWrite = vk::WriteDescriptorSet{}
+				.setDstSet(set)
+				.setDstBinding(w.binding)
+				.setDescriptorCount(1u)
+				.setDescriptorType(w.type);
+			if (is_buffer_descriptor(w.type)) {
+				descriptorWrite.setPBufferInfo(&w.bufferInfo);
+			}
+			else {
+				descriptorWrite.setPImageInfo(&w.imageInfo);
+			}
+			descriptorWrites.push_back(descriptorWrite);
+		}
+		mDevice.updateDescriptorSets(descriptorWrites, {});
+		++mStatistics.setsAllocated;
+
+		// On a hash collision, the older set stays cached:
+		slot.cachedSets.emplace(hash, cached_set{ layout, writes, set });
+		return set;
+	}
+
+	descriptor_allocator_statistics descriptor_allocator::get_statistics() const
+	{
+		return mStatistics;
+	}
+
+	void descriptor_allocator::print_statistics(std::ostream& stream) const
+	{
+		stream << "Descriptor allocator: " << mStatistics.setsRequested << " sets requested, " << mStatistics.setsAllocated
+			<< " allocated (" << (mStatistics.setsRequested - mStatistics.setsAllocated) << " served from the cache), "
+			<< mStatistics.poolCount << " pools" << std::endl;
+	}
+}
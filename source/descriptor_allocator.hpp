@@ -0,0 +1,119 @@
+#pragma once
+
+namespace helpers
+{
+	// What to write into one binding of a descriptor set: a buffer, or an image and/or a sampler
+	struct descriptor_write
+	{
+		uint32_t binding = 0;
+		vk::DescriptorType type = vk::DescriptorType::eUniformBuffer;
+		vk::DescriptorBufferInfo bufferInfo;	// For (dynamic) uniform and storage buffers
+		vk::DescriptorImageInfo imageInfo;		// For samplers, combined image samplers, sampled and storage images
+
+		static descriptor_write buffer(const uint32_t binding, const vk::DescriptorType type, const vk::Buffer buffer, const vk::DeviceSize offset = 0, const vk::DeviceSize range = VK_WHOLE_SIZE);
+		static descriptor_write image(const uint32_t binding, const vk::DescriptorType type, const vk::ImageView imageView, const vk::Sampler sampler, const vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
+		bool operator==(const descriptor_write& other) const;
+	};
+
+	// Creates descriptor set layouts, and returns the same layout for identical bindings instead of creating another one.
+	// Thread-safe. The layouts are destroyed together with the cache.
+	class descriptor_layout_cache
+	{
+	public:
+		explicit descriptor_layout_cache(const vk::Device device);
+		descriptor_layout_cache(const descriptor_layout_cache&) = delete;
+		descriptor_layout_cache& operator=(const descriptor_layout_cache&) = delete;
+		~descriptor_layout_cache();
+
+		// The order of <bindings> doesn't matter
+		vk::DescriptorSetLayout get_layout(std::vector<vk::DescriptorSetLayoutBinding> bindings);
+
+		size_t layout_count() const;
+
+	private:
+		struct cached_layout
+		{
+			std::vector<vk::DescriptorSetLayoutBinding> bindings;	// Sorted by binding
+			vk::DescriptorSetLayout layout;
+		};
+
+		vk::Device mDevice;
+		mutable std::mutex mMutex;
+		std::unordered_map<uint64_t, std::vector<cached_layout>> mLayouts;	// Hash of the bindings => layouts with that hash
+	};
+
+	// How a descriptor allocator is doing
+	struct descriptor_allocator_statistics
+	{
+		uint64_t setsRequested = 0;		// get_set calls
+		uint64_t setsAllocated = 0;		// ...which had to allocate and write a new set; the others have been served from the cache
+		uint64_t poolsCreated = 0;
+		uint32_t poolCount = 0;			// Pools which currently exist (over all frames in flight)
+	};
+
+	// Allocates descriptor sets for one frame at a time, from pools which belong to that frame.
+	//
+	// Each frame in flight has its own list of pools. When a pool is exhausted, another one is created, each new one twice
+	// as large as the previous one (up to MaxSetsPerPool). begin_frame resets all of the frame's pools at once, instead of
+	// freeing individual sets, so the sets of a frame must not be used by any later frame.
+	//
+	// Within a frame, get_set returns the same set for the same layout and the same writes, i.e. sets which many draws
+	// share (e.g. the same texture and uniform buffer) are only allocated and written once per frame.
+	//
+	// Usage per frame (with the same number of frames in flight as the frame scheduler):
+	//   auto& frame = frameScheduler.begin_frame();
+	//   descriptorAllocator.begin_frame();
+	//   auto set = descriptorAllocator.get_set(layout, { descriptor_write::buffer(0, vk::DescriptorType::eUniformBuffer, ubo),
+	//       descriptor_write::image(1, vk::DescriptorType::eCombinedImageSampler, textureView, sampler) });
+	//   frame.commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0u, { set }, {});
+	//
+	// The descriptor allocator is not thread-safe.
+	class descriptor_allocator
+	{
+	public:
+		static constexpr uint32_t InitialSetsPerPool = 64;
+		static constexpr uint32_t MaxSetsPerPool = 4096;
+
+		descriptor_allocator(const vk::Device device, const uint32_t framesInFlight);
+		descriptor_allocator(const descriptor_allocator&) = delete;
+		descriptor_allocator& operator=(const descriptor_allocator&) = delete;
+		// The GPU must be done with all frames which have used sets of this allocator.
+		~descriptor_allocator();
+
+		// Start the next frame: reset the pools of its slot, and forget its cached sets. The GPU must be done with the
+		// frame which used the same slot before (i.e. call this after frame_scheduler::begin_frame).
+		void begin_frame();
+
+		// A set of the given layout with the given descriptors written into it, valid until the end of the current frame
+		vk::DescriptorSet get_set(const vk::DescriptorSetLayout layout, const std::vector<descriptor_write>& writes);
+
+		descriptor_allocator_statistics get_statistics() const;
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		struct cached_set
+		{
+			vk::DescriptorSetLayout layout;
+			std::vector<descriptor_write> writes;
+			vk::DescriptorSet set;
+		};
+
+		struct frame_pools
+		{
+			std::vector<vk::DescriptorPool> pools;
+			size_t currentPool = 0;						// Index of the pool which is being allocated from; the ones before are full
+			std::unordered_map<uint64_t, cached_set> cachedSets;
+		};
+
+		vk::DescriptorSet allocate(const vk::DescriptorSetLayout layout);
+		vk::DescriptorPool create_pool(const uint32_t maxSets);
+
+		vk::Device mDevice;
+		std::vector<frame_pools> mSlots;
+		size_t mCurrentSlot = 0;
+		uint64_t mFrameNumber = 0;
+		uint32_t mNextPoolSize = InitialSetsPerPool;
+		descriptor_allocator_statistics mStatistics;
+	};
+}
@@ -0,0 +1,279 @@
+#include "pch.h"
+
+namespace helpers
+{
+	std::vector<std::string> get_flipbook_frame_paths(
+		const std::string directory,
+		const std::string fileNamePrefix)
+	{
+		std::vector<std::string> paths;
+		for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+			if (entry.is_regular_file() && 0 == entry.path().filename().string().rfind(fileNamePrefix, 0)) {
+				paths.push_back(entry.path().string());
+			}
+		}
+		if (paths.empty()) {
+			throw std::runtime_error("No flipbook frames '" + fileNamePrefix + "*' found in '" + directory + "'");
+		}
+		std::sort(paths.begin(), paths.end());
+		return paths;
+	}
+
+	flipbook_streamer::flipbook_streamer(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const uint32_t queueFamilyIndex,
+		const vk::Queue queue,
+		std::vector<std::string> framePaths,
+		const uint32_t framesInFlight,
+		const uint32_t slotCount)
+		: mDevice{ device }
+		, mFramePaths{ std::move(framePaths) }
+		, mFramesInFlight{ framesInFlight }
+	{
+		if (mFramePaths.empty()) {
+			throw std::runtime_error("A flipbook needs at least one frame.");
+		}
+		if (0 == framesInFlight || framesInFlight >= slotCount) {
+			throw std::runtime_error("A flipbook needs more slots than there are frames in flight.");
+		}
+
+		// Only read the header here; all frames are decoded by the worker thread:
+		const auto info = helpers::get_image_info(mFramePaths.front());
+		mWidth = info.width;
+		mHeight = info.height;
+
+		// The slots which the GPU may still be reading from (up to one per frame in flight) are not available for the lookahead:
+		mLookahead = std::min(frame_count(), slotCount - framesInFlight);
+		mSlots.resize(slotCount);
+
+		std::tie(mImage, mImageMemory) = helpers::create_image(device, physicalDevice,
+			mWidth, mHeight, vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+			1u, slotCount
+		);
+		mImageView = helpers::create_image_view(device, physicalDevice,
+			mImage, vk::Format::eR8G8B8A8Unorm, vk::ImageAspectFlagBits::eColor,
+			1u, slotCount, vk::ImageViewType::e2DArray
+		);
+
+		// Room for the uploads of two updates, s.t. an update only has to wait for the GPU if it lags behind that much:
+		const auto frameSize = static_cast<vk::DeviceSize>(mWidth) * mHeight * 4;
+		mUploadEngine = std::make_unique<upload_engine>(physicalDevice, device, queueFamilyIndex, queue, 2 * MaxUploadsPerUpdate * frameSize);
+
+		// Whenever the image view is used, all of its layers must be in a defined layout -- including those which have never been filled:
+		mUploadEngine->enqueue_image_layout_transition(mImage,
+			vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0u, 1u, 0u, slotCount },
+			vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+		);
+		mUploadEngine->wait(mUploadEngine->submit());
+
+		mWorker = std::thread([this]() { worker_loop(); });
+	}
+
+	flipbook_streamer::~flipbook_streamer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mWorkAvailable.notify_all();
+		mWorker.join();
+
+		mUploadEngine.reset(); // Waits for the uploads which are still in flight
+		helpers::destroy_image_view(mDevice, mImageView);
+		helpers::destroy_image(mDevice, mImage);
+		helpers::free_memory(mDevice, mImageMemory);
+	}
+
+	void flipbook_streamer::worker_loop()
+	{
+		for (;;) {
+			uint32_t frameIndex;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWorkAvailable.wait(lock, [this]() {
+					return mStopping || (!mDecodeRequests.empty() && mDecodedFrames.size() < MaxDecodedFrames);
+				});
+				if (mStopping) {
+					return;
+				}
+				frameIndex = mDecodeRequests.front();
+				mDecodeRequests.pop_front();
+				mFrameBeingDecoded = frameIndex;
+			}
+
+			// Read and decode without holding the lock (mFramePaths is not modified after construction):
+			const auto& path = mFramePaths[frameIndex];
+			std::vector<uint8_t> pixels;
+			std::exception_ptr error;
+			try {
+				const auto info = helpers::get_image_info(path);
+				if (info.width != mWidth || info.height != mHeight) {
+					throw std::runtime_error("The flipbook frame '" + path + "' has different dimensions than the first frame.");
+				}
+				pixels.resize(static_cast<size_t>(mWidth) * mHeight * 4);
+				helpers::decode_image(path, info, texel_order::rgba, pixels.data());
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFrameBeingDecoded.reset();
+			if (error) {
+				mWorkerError = error;
+				return;
+			}
+			mDecodedFrames.push_back(decoded_frame{ frameIndex, std::move(pixels) });
+			++mFramesDecoded;
+		}
+	}
+
+	bool flipbook_streamer::is_wanted(const uint32_t frameIndex) const
+	{
+		return (frameIndex + frame_count() - mCursor) % frame_count() < mLookahead;
+	}
+
+	size_t flipbook_streamer::find_slot(const uint32_t frameIndex) const
+	{
+		for (size_t i = 0; i < mSlots.size(); ++i) {
+			if (slot_state::empty != mSlots[i].state && frameIndex == mSlots[i].frameIndex) {
+				return i;
+			}
+		}
+		return mSlots.size();
+	}
+
+	size_t flipbook_streamer::find_free_slot(const uint64_t renderFrameNumber) const
+	{
+		size_t evictable = mSlots.size();
+		for (size_t i = 0; i < mSlots.size(); ++i) {
+			const auto& s = mSlots[i];
+			if (slot_state::empty == s.state) {
+				return i;
+			}
+			// A resident frame can be evicted once it is behind the cursor (or too far ahead), and all render frames
+			// which have sampled it have finished on the GPU:
+			if (slot_state::resident == s.state && !is_wanted(s.frameIndex)
+				&& (!s.hasBeenShown || s.lastShownFrameNumber + mFramesInFlight <= renderFrameNumber)) {
+				evictable = i;
+			}
+		}
+		return evictable;
+	}
+
+	void flipbook_streamer::update(const uint32_t cursorFrameIndex, const uint64_t renderFrameNumber)
+	{
+		mCursor = cursorFrameIndex % frame_count();
+
+		// Slots whose uploads have completed on the GPU become resident (non-blocking):
+		for (auto& s : mSlots) {
+			if (slot_state::uploading == s.state && mUploadEngine->is_complete(s.uploadToken)) {
+				s.state = slot_state::resident;
+			}
+		}
+
+		// Show the cursor's frame if it is resident; otherwise, the most recent resident frame before it (wrapping around):
+		size_t shownSlot = mSlots.size();
+		uint32_t shownDistance = frame_count();
+		for (size_t i = 0; i < mSlots.size(); ++i) {
+			if (slot_state::resident != mSlots[i].state) {
+				continue;
+			}
+			const auto distance = (mCursor + frame_count() - mSlots[i].frameIndex) % frame_count();
+			if (distance < shownDistance) {
+				shownSlot = i;
+				shownDistance = distance;
+			}
+		}
+		if (shownSlot < mSlots.size()) {
+			mSlots[shownSlot].lastShownFrameNumber = renderFrameNumber;
+			mSlots[shownSlot].hasBeenShown = true;
+			mCurrentFrame = flipbook_frame{ mSlots[shownSlot].frameIndex, static_cast<uint32_t>(shownSlot) };
+		}
+		if (0 != shownDistance) {
+			++mLateUpdates;
+		}
+
+		// Pick up what the worker has decoded in the meantime:
+		std::deque<decoded_frame> decodedFrames;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mWorkerError) {
+				std::rethrow_exception(mWorkerError);
+			}
+			std::swap(decodedFrames, mDecodedFrames);
+		}
+
+		// Upload the frames which are still wanted into free slots:
+		std::deque<decoded_frame> framesWithoutSlot;
+		uint32_t uploadCount = 0;
+		for (auto& decoded : decodedFrames) {
+			if (!is_wanted(decoded.frameIndex) || find_slot(decoded.frameIndex) < mSlots.size()) {
+				++mFramesDiscarded;
+				continue;
+			}
+			const auto slotIndex = uploadCount < MaxUploadsPerUpdate ? find_free_slot(renderFrameNumber) : mSlots.size();
+			if (slotIndex == mSlots.size()) {
+				framesWithoutSlot.push_back(std::move(decoded));
+				continue;
+			}
+
+			mUploadEngine->enqueue_image_upload(decoded.pixels.data(), decoded.pixels.size(),
+				mImage, mWidth, mHeight, 4u,
+				vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead,
+				static_cast<uint32_t>(slotIndex)
+			);
+			auto& s = mSlots[slotIndex];
+			s.state = slot_state::uploading;
+			s.frameIndex = decoded.frameIndex;
+			s.uploadToken = mUploadEngine->current_token();
+			s.hasBeenShown = false;
+			++uploadCount;
+			++mFramesUploaded;
+		}
+		if (uploadCount > 0) {
+			mUploadEngine->submit();
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		// Frames which didn't get a slot are tried again next time, before the ones which have been decoded meanwhile:
+		for (auto it = framesWithoutSlot.rbegin(); it != framesWithoutSlot.rend(); ++it) {
+			mDecodedFrames.push_front(std::move(*it));
+		}
+
+		// Request the wanted frames which are neither in a slot, nor decoded, nor being decoded -- the nearest ones first:
+		mDecodeRequests.clear();
+		for (uint32_t i = 0; i < mLookahead; ++i) {
+			const auto frameIndex = (mCursor + i) % frame_count();
+			const bool isDecoded = std::any_of(mDecodedFrames.begin(), mDecodedFrames.end(), [frameIndex](const decoded_frame& d) {
+				return frameIndex == d.frameIndex;
+			});
+			if (isDecoded || mFrameBeingDecoded == frameIndex || find_slot(frameIndex) < mSlots.size()) {
+				continue;
+			}
+			mDecodeRequests.push_back(frameIndex);
+		}
+		mWorkAvailable.notify_one();
+	}
+
+	flipbook_statistics flipbook_streamer::get_statistics() const
+	{
+		flipbook_statistics stats;
+		stats.framesUploaded = mFramesUploaded;
+		stats.framesDiscarded = mFramesDiscarded;
+		stats.lateUpdates = mLateUpdates;
+		std::lock_guard<std::mutex> lock(mMutex);
+		stats.framesDecoded = mFramesDecoded;
+		return stats;
+	}
+
+	void flipbook_streamer::print_statistics(std::ostream& stream) const
+	{
+		const auto stats = get_statistics();
+		stream << "Flipbook: " << frame_count() << " frames of " << mWidth << "x" << mHeight
+			<< " in " << slot_count() << " slots (lookahead: " << mLookahead << " frames)\n"
+			<< "  decoded: " << stats.framesDecoded << ", uploaded: " << stats.framesUploaded
+			<< ", discarded: " << stats.framesDiscarded << ", late updates: " << stats.lateUpdates << "\n";
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+namespace helpers
+{
+	// Collect the paths of all files in <directory> whose names start with <fileNamePrefix>, sorted by name
+	// (e.g. "images", "explosion02HD-frame" => the frames of the explosion flipbook, in playback order)
+	std::vector<std::string> get_flipbook_frame_paths(
+		const std::string directory,
+		const std::string fileNamePrefix
+	);
+
+	// A frame of the flipbook which is resident on the GPU: sample layer <layer> of the streamer's array image
+	struct flipbook_frame
+	{
+		uint32_t frameIndex = 0;
+		uint32_t layer = 0;
+	};
+
+	struct flipbook_statistics
+	{
+		uint64_t framesDecoded = 0;		// Decoded by the worker thread
+		uint64_t framesUploaded = 0;	// Copied into a layer of the array image
+		uint64_t framesDiscarded = 0;	// Decoded, but no longer needed by the time they were picked up
+		uint64_t lateUpdates = 0;		// Updates where the cursor's frame was not resident yet and an older one was shown
+	};
+
+	// Streams the frames of a (looping) flipbook animation from disk into a fixed set of texture slots,
+	// which are the layers of one 2D array image (format eR8G8B8A8Unorm, layers in eShaderReadOnlyOptimal).
+	//
+	// A worker thread decodes the frames ahead of the playback cursor. The render thread uploads decoded frames into
+	// layers which are no longer needed, i.e. which hold frames behind the cursor that the GPU has finished reading.
+	// GPU memory is bounded by <slotCount> frames, CPU memory by a few decoded frames, regardless of the frame count.
+	//
+	// update() never waits for the disk or the decoder: if the cursor's frame is not resident yet, the most recent
+	// resident frame before it is shown instead (see flipbook_statistics::lateUpdates).
+	//
+	// Usage per frame (on the render thread):
+	//   frameScheduler.begin_frame();
+	//   flipbook.update(cursorFrameIndex, frameScheduler.frame_number());
+	//   if (auto frame = flipbook.current_frame()) { ... sample flipbook.image_view() at layer frame->layer ... }
+	class flipbook_streamer
+	{
+	public:
+		static constexpr uint32_t DefaultSlotCount = 16;
+
+		// All frames must have the same dimensions. Uploads are submitted to <queue>, which must be the queue
+		// that the frames are rendered with. <framesInFlight> is the number of frames that the renderer may
+		// have in flight concurrently (see frame_scheduler::frames_in_flight); it must be less than <slotCount>.
+		flipbook_streamer(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			const uint32_t queueFamilyIndex,
+			const vk::Queue queue,
+			std::vector<std::string> framePaths,
+			const uint32_t framesInFlight,
+			const uint32_t slotCount = DefaultSlotCount
+		);
+		flipbook_streamer(const flipbook_streamer&) = delete;
+		flipbook_streamer& operator=(const flipbook_streamer&) = delete;
+		// Stops the worker thread and waits for pending uploads. The GPU must no longer use the image.
+		~flipbook_streamer();
+
+		// Move the playback cursor to frame <cursorFrameIndex> (modulo the frame count) for the render frame with
+		// the given number. Must be called once per render frame, after frame_scheduler::begin_frame, such that the
+		// GPU is known to have finished all render frames up to <renderFrameNumber> - framesInFlight.
+		// Rethrows errors of the worker thread (e.g. a frame which could not be loaded).
+		void update(const uint32_t cursorFrameIndex, const uint64_t renderFrameNumber);
+
+		// The frame to be shown in the render frame passed to the last update() call.
+		// Empty until the first frame has become resident.
+		std::optional<flipbook_frame> current_frame() const { return mCurrentFrame; }
+
+		// A view of type e2DArray over all slots (sampler2DArray in GLSL)
+		vk::ImageView image_view() const { return mImageView; }
+		vk::Image image() const { return mImage; }
+
+		uint32_t frame_count() const { return static_cast<uint32_t>(mFramePaths.size()); }
+		uint32_t slot_count() const { return static_cast<uint32_t>(mSlots.size()); }
+		uint32_t width() const { return mWidth; }
+		uint32_t height() const { return mHeight; }
+
+		flipbook_statistics get_statistics() const;
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		struct decoded_frame
+		{
+			uint32_t frameIndex;
+			std::vector<uint8_t> pixels;	// RGBA
+		};
+
+		enum struct slot_state { empty, uploading, resident };
+
+		struct slot
+		{
+			slot_state state = slot_state::empty;
+			uint32_t frameIndex = 0;
+			upload_token uploadToken = 0;		// Valid while uploading
+			uint64_t lastShownFrameNumber = 0;	// Render frame which has sampled this slot last
+			bool hasBeenShown = false;
+		};
+
+		static constexpr size_t MaxDecodedFrames = 4;		// Decoded frames waiting for a free slot or an upload
+		static constexpr uint32_t MaxUploadsPerUpdate = 2;	// Bounds the render thread's per-frame memcpy work
+
+		void worker_loop();
+		// Is <frameIndex> within the lookahead window, which starts at the cursor?
+		bool is_wanted(const uint32_t frameIndex) const;
+		// Index of the slot which holds <frameIndex> (uploading or resident), or slot_count() if there is none
+		size_t find_slot(const uint32_t frameIndex) const;
+		// Index of an empty slot, or of a resident slot which may be overwritten, or slot_count() if there is none
+		size_t find_free_slot(const uint64_t renderFrameNumber) const;
+
+		vk::Device mDevice;
+		std::vector<std::string> mFramePaths;
+		uint32_t mWidth = 0;
+		uint32_t mHeight = 0;
+		uint32_t mFramesInFlight = 0;
+		uint32_t mLookahead = 0;	// Number of frames, starting at the cursor, which are kept resident
+
+		vk::Image mImage;
+		memory_allocation mImageMemory;
+		vk::ImageView mImageView;
+		std::unique_ptr<upload_engine> mUploadEngine;
+
+		// Only accessed by the render thread:
+		std::vector<slot> mSlots;
+		uint32_t mCursor = 0;
+		std::optional<flipbook_frame> mCurrentFrame;
+		uint64_t mFramesUploaded = 0;
+		uint64_t mFramesDiscarded = 0;
+		uint64_t mLateUpdates = 0;
+
+		// Shared between the render thread and the worker thread, guarded by mMutex:
+		mutable std::mutex mMutex;
+		std::condition_variable mWorkAvailable;
+		std::deque<uint32_t> mDecodeRequests;		// Frames to decode, most urgent first; replaced by every update()
+		std::deque<decoded_frame> mDecodedFrames;	// At most MaxDecodedFrames
+		std::optional<uint32_t> mFrameBeingDecoded;
+		std::exception_ptr mWorkerError;
+		uint64_t mFramesDecoded = 0;
+		bool mStopping = false;
+
+		std::thread mWorker;
+	};
+}
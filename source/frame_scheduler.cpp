@@ -0,0 +1,233 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		double milliseconds_between(const std::chrono::steady_clock::time_point from, const std::chrono::steady_clock::time_point to)
+		{
+			return std::chrono::duration<double, std::milli>(to - from).count();
+		}
+
+		// Block until the GPU has finished the frame which has been submitted with <fence>
+		void wait_for_frame_fence(const vk::Device device, const vk::Fence fence)
+		{
+			const auto result = device.waitForFences({ fence }, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			if (vk::Result::eSuccess != result) {
+				throw std::runtime_error("Waiting for a frame's fence failed: " + vk::to_string(result));
+			}
+		}
+	}
+
+	frame_scheduler::frame_scheduler(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const uint32_t queueFamilyIndex,
+		const uint32_t framesInFlight)
+		: mDevice{ device }
+		, mSlots(framesInFlight)
+		, mPendingTimings(framesInFlight)
+	{
+		if (0 == framesInFlight) {
+			throw std::invalid_argument("There must be at least one frame in flight.");
+		}
+
+		for (auto& slot : mSlots) {
+			// Transient, because the command buffer is re-recorded every frame; the pool is reset as a whole:
+			slot.commandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}
+				.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+				.setQueueFamilyIndex(queueFamilyIndex)
+			);
+			slot.commandBuffer = helpers::allocate_command_buffer(device, slot.commandPool);
+			slot.imageAvailableSemaphore = device.createSemaphore(vk::SemaphoreCreateInfo{});
+			slot.renderFinishedSemaphore = device.createSemaphore(vk::SemaphoreCreateInfo{});
+			// Created in signalled state, s.t. the very first wait on it returns immediately:
+			slot.frameFinishedFence = device.createFence(vk::FenceCreateInfo{}.setFlags(vk::FenceCreateFlagBits::eSignaled));
+		}
+
+		// Measure the GPU time of each frame with two timestamps, if the queue family supports them:
+		const auto timestampValidBits = physicalDevice.getQueueFamilyProperties()[queueFamilyIndex].timestampValidBits;
+		if (timestampValidBits > 0) {
+			mTimestampQueryPool = device.createQueryPool(vk::QueryPoolCreateInfo{}
+				.setQueryType(vk::QueryType::eTimestamp)
+				.setQueryCount(2u * framesInFlight)
+			);
+			mTimestampPeriodMs = static_cast<double>(physicalDevice.getProperties().limits.timestampPeriod) * 1e-6;
+			mTimestampMask = timestampValidBits >= 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << timestampValidBits) - 1;
+		}
+	}
+
+	frame_scheduler::~frame_scheduler()
+	{
+		// Make sure that the GPU is done with all of the slots' resources before destroying them. If a wait fails, this
+		// terminates (the destructor is noexcept) rather than destroying resources which the GPU may still use:
+		for (auto& slot : mSlots) {
+			if (slot.hasBeenSubmitted) {
+				wait_for_frame_fence(mDevice, slot.frameFinishedFence);
+			}
+		}
+
+		for (auto& slot : mSlots) {
+			mDevice.destroyFence(slot.frameFinishedFence);
+			mDevice.destroySemaphore(slot.renderFinishedSemaphore);
+			mDevice.destroySemaphore(slot.imageAvailableSemaphore);
+			// Destroying the pool also frees its command buffer:
+			mDevice.destroyCommandPool(slot.commandPool);
+		}
+		if (mTimestampQueryPool) {
+			mDevice.destroyQueryPool(mTimestampQueryPool);
+		}
+	}
+
+	frame_slot& frame_scheduler::begin_frame()
+	{
+		mCurrentSlot = static_cast<size_t>(mFrameNumber % mSlots.size());
+		auto& slot = mSlots[mCurrentSlot];
+
+		// This is the only place where the CPU blocks: if the GPU has not yet finished the frame which
+		// used this slot N frames ago, the CPU is N frames ahead and has to wait.
+		const auto waitBegin = std::chrono::steady_clock::now();
+		if (slot.hasBeenSubmitted) {
+			wait_for_frame_fence(mDevice, slot.frameFinishedFence);
+			collect_timings_of_slot(mCurrentSlot);
+			mCompletedFrameCount = std::max(mCompletedFrameCount, slot.frameNumber + 1);
+		}
+		mBeginTime = std::chrono::steady_clock::now();
+
+		mPendingTimings[mCurrentSlot] = frame_timings{};
+		mPendingTimings[mCurrentSlot].frameNumber = mFrameNumber;
+		mPendingTimings[mCurrentSlot].cpuWaitMs = milliseconds_between(waitBegin, mBeginTime);
+
+		// The GPU is done with this slot's command buffer => reset the whole pool instead of freeing buffers:
+		mDevice.resetCommandPool(slot.commandPool, vk::CommandPoolResetFlags{});
+		slot.commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		if (mTimestampQueryPool) {
+			const auto firstQuery = static_cast<uint32_t>(2 * mCurrentSlot);
+			slot.commandBuffer.resetQueryPool(mTimestampQueryPool, firstQuery, 2u);
+			slot.commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, mTimestampQueryPool, firstQuery);
+		}
+
+		++mFrameNumber;
+		return slot;
+	}
+
+	uint64_t frame_scheduler::completed_frame_count()
+	{
+		for (const auto& slot : mSlots) {
+			// A slot's fence stays signalled until its next submit, which also updates its frameNumber:
+			if (slot.hasBeenSubmitted && slot.frameNumber + 1 > mCompletedFrameCount && vk::Result::eSuccess == mDevice.getFenceStatus(slot.frameFinishedFence)) {
+				mCompletedFrameCount = slot.frameNumber + 1;
+			}
+		}
+		return mCompletedFrameCount;
+	}
+
+	void frame_scheduler::submit_frame(const vk::Queue queue, const vk::PipelineStageFlags waitStage)
+	{
+		submit_current_slot(queue, &waitStage);
+	}
+
+	void frame_scheduler::submit_frame(const vk::Queue queue)
+	{
+		submit_current_slot(queue, nullptr);
+	}
+
+	void frame_scheduler::submit_current_slot(const vk::Queue queue, const vk::PipelineStageFlags* waitStage)
+	{
+		auto& slot = mSlots[mCurrentSlot];
+		if (mTimestampQueryPool) {
+			slot.commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, mTimestampQueryPool, static_cast<uint32_t>(2 * mCurrentSlot + 1));
+		}
+		slot.commandBuffer.end();
+
+		// Only reset the fence right before it is going to be signalled again:
+		mDevice.resetFences({ slot.frameFinishedFence });
+
+		auto submitInfo = vk::SubmitInfo{}
+			.setCommandBufferCount(1u)
+			.setPCommandBuffers(&slot.commandBuffer);
+		if (nullptr != waitStage) {
+			submitInfo
+				.setWaitSemaphoreCount(1u)
+				.setPWaitSemaphores(&slot.imageAvailableSemaphore)
+				.setPWaitDstStageMask(waitStage)
+				.setSignalSemaphoreCount(1u)
+				.setPSignalSemaphores(&slot.renderFinishedSemaphore);
+		}
+		queue.submit({ submitInfo }, slot.frameFinishedFence);
+
+		slot.frameNumber = mPendingTimings[mCurrentSlot].frameNumber;
+		slot.hasBeenSubmitted = true;
+		mPendingTimings[mCurrentSlot].cpuRecordMs = milliseconds_between(mBeginTime, std::chrono::steady_clock::now());
+	}
+
+	void frame_scheduler::collect_timings_of_slot(const size_t slotIndex)
+	{
+		auto timings = mPendingTimings[slotIndex];
+
+		// The slot's fence has been signalled => the results are available, this does not stall:
+		if (mTimestampQueryPool) {
+			std::array<uint64_t, 2> timestamps;
+			const auto result = mDevice.getQueryPoolResults(
+				mTimestampQueryPool, static_cast<uint32_t>(2 * slotIndex), 2u,
+				sizeof(timestamps), timestamps.data(), sizeof(uint64_t),
+				vk::QueryResultFlagBits::e64
+			);
+			if (vk::Result::eSuccess == result) {
+				const auto ticks = (timestamps[1] & mTimestampMask) - (timestamps[0] & mTimestampMask);
+				timings.gpuBusyMs = static_cast<double>(ticks) * mTimestampPeriodMs;
+			}
+		}
+
+		if (mTimingsHistory.size() < TimingsHistorySize) {
+			mTimingsHistory.push_back(timings);
+		}
+		else {
+			mTimingsHistory[mTimingsHistoryNext] = timings;
+		}
+		mTimingsHistoryNext = (mTimingsHistoryNext + 1) % TimingsHistorySize;
+	}
+
+	std::vector<frame_timings> frame_scheduler::completed_frame_timings() const
+	{
+		std::vector<frame_timings> result;
+		result.reserve(mTimingsHistory.size());
+		if (mTimingsHistory.size() < TimingsHistorySize) {
+			result = mTimingsHistory;
+		}
+		else {
+			result.insert(result.end(), mTimingsHistory.begin() + mTimingsHistoryNext, mTimingsHistory.end());
+			result.insert(result.end(), mTimingsHistory.begin(), mTimingsHistory.begin() + mTimingsHistoryNext);
+		}
+		return result;
+	}
+
+	void frame_scheduler::print_timings(std::ostream& stream) const
+	{
+		if (mTimingsHistory.empty()) {
+			stream << "Frame scheduler: no completed frames yet\n";
+			return;
+		}
+
+		double cpuWait = 0.0, cpuRecord = 0.0, gpuBusy = 0.0;
+		size_t gpuSamples = 0;
+		for (const auto& t : mTimingsHistory) {
+			cpuWait += t.cpuWaitMs;
+			cpuRecord += t.cpuRecordMs;
+			if (t.gpuBusyMs >= 0.0) {
+				gpuBusy += t.gpuBusyMs;
+				++gpuSamples;
+			}
+		}
+		const auto n = static_cast<double>(mTimingsHistory.size());
+		stream << "Frame scheduler: " << mSlots.size() << " frames in flight, averages over the last " << mTimingsHistory.size() << " completed frames:\n"
+			<< "  CPU wait:   " << cpuWait / n << " ms\n"
+			<< "  CPU record: " << cpuRecord / n << " ms\n";
+		if (gpuSamples > 0) {
+			stream << "  GPU busy:   " << gpuBusy / static_cast<double>(gpuSamples) << " ms\n";
+		}
+		else {
+			stream << "  GPU busy:   n/a (no timestamp support)\n";
+		}
+	}
+}
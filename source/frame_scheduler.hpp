@@ -0,0 +1,97 @@
+#pragma once
+
+namespace helpers
+{
+	// Timings of one frame, as measured by the frame scheduler
+	struct frame_timings
+	{
+		uint64_t frameNumber = 0;
+		double cpuWaitMs = 0.0;		// How long begin_frame had to block until the frame's slot became available again
+		double cpuRecordMs = 0.0;	// Time between begin_frame and submit_frame
+		double gpuBusyMs = -1.0;	// Time between the first and the last command of the frame on the GPU (-1 if not supported)
+	};
+
+	// One set of per-frame resources. There are as many of them as there are frames in flight,
+	// and they are reused in a round-robin fashion.
+	struct frame_slot
+	{
+		vk::CommandPool commandPool;			// Reset as a whole at the beginning of each frame
+		vk::CommandBuffer commandBuffer;		// Allocated once from commandPool
+		vk::Semaphore imageAvailableSemaphore;	// To be signalled by vkAcquireNextImageKHR
+		vk::Semaphore renderFinishedSemaphore;	// Signalled by submit_frame, to be waited on by vkQueuePresentKHR
+		vk::Fence frameFinishedFence;			// Signalled by submit_frame when the GPU has finished the frame
+		uint64_t frameNumber = 0;				// The frame which has been submitted last using this slot
+		bool hasBeenSubmitted = false;
+	};
+
+	// Manages N frames in flight: The CPU may record and submit frames while the GPU is still busy
+	// with up to N-1 previous frames. It only blocks when it gets N frames ahead of the GPU.
+	//
+	// Usage per frame:
+	//   auto& frame = frameScheduler.begin_frame();		// frame.commandBuffer is in recording state afterwards
+	//   acquire a swapchain image, signalling frame.imageAvailableSemaphore
+	//   record commands into frame.commandBuffer
+	//   frameScheduler.submit_frame(queue, waitStage);	// waits on imageAvailableSemaphore, signals renderFinishedSemaphore
+	//   present, waiting on frame.renderFinishedSemaphore
+	class frame_scheduler
+	{
+	public:
+		frame_scheduler(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			const uint32_t queueFamilyIndex,
+			const uint32_t framesInFlight
+		);
+		frame_scheduler(const frame_scheduler&) = delete;
+		frame_scheduler& operator=(const frame_scheduler&) = delete;
+		~frame_scheduler();
+
+		// Wait until the slot for the next frame is available again, reset its command pool and begin its command buffer
+		frame_slot& begin_frame();
+
+		// End the current frame's command buffer and submit it to the given queue
+		void submit_frame(const vk::Queue queue, const vk::PipelineStageFlags waitStage);
+
+		// Same as above, but for headless rendering: there's no swapchain image to wait for and nothing to present,
+		// i.e. the submission neither waits on imageAvailableSemaphore nor signals renderFinishedSemaphore.
+		void submit_frame(const vk::Queue queue);
+
+		// The slot of the frame which is currently being recorded
+		frame_slot& current_slot() { return mSlots[mCurrentSlot]; }
+
+		// Number of frames which have been begun so far
+		uint64_t frame_number() const { return mFrameNumber; }
+
+		uint32_t frames_in_flight() const { return static_cast<uint32_t>(mSlots.size()); }
+
+		// Number of frames which the GPU has completed, i.e. frames 0 .. completed_frame_count() - 1 are done (they are
+		// submitted to one queue, and complete in order). Polls the fences of the frames in flight, but never blocks.
+		// Pass it to deletion_queue::collect.
+		uint64_t completed_frame_count();
+
+		// Timings of the most recent frames whose GPU work has completed, oldest first
+		std::vector<frame_timings> completed_frame_timings() const;
+
+		// Print averages over the recently completed frames
+		void print_timings(std::ostream& stream) const;
+
+	private:
+		void submit_current_slot(const vk::Queue queue, const vk::PipelineStageFlags* waitStage);
+		void collect_timings_of_slot(const size_t slotIndex);
+
+		static constexpr size_t TimingsHistorySize = 128;
+
+		vk::Device mDevice;
+		std::vector<frame_slot> mSlots;
+		std::vector<frame_timings> mPendingTimings;		// One per slot, completed when the slot becomes available again
+		std::vector<frame_timings> mTimingsHistory;		// Ring buffer of completed frames' timings
+		size_t mTimingsHistoryNext = 0;
+		vk::QueryPool mTimestampQueryPool;				// Two timestamps per slot; null if timestamps are not supported
+		double mTimestampPeriodMs = 0.0;
+		uint64_t mTimestampMask = 0;
+		size_t mCurrentSlot = 0;
+		uint64_t mFrameNumber = 0;
+		uint64_t mCompletedFrameCount = 0;
+		std::chrono::steady_clock::time_point mBeginTime;
+	};
+}
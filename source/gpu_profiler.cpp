@@ -0,0 +1,279 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		double microseconds_between(const std::chrono::steady_clock::time_point from, const std::chrono::steady_clock::time_point to)
+		{
+			return std::chrono::duration<double, std::micro>(to - from).count();
+		}
+
+		std::string escape_json(const char* text)
+		{
+			std::string result;
+			for (auto c = text; *c != '\0'; ++c) {
+				if ('"' == *c || '\\' == *c) {
+					result += '\\';
+				}
+				result += *c;
+			}
+			return result;
+		}
+	}
+
+	gpu_profiler::gpu_scope::gpu_scope(gpu_profiler& profiler, const vk::CommandBuffer commandBuffer, const char* name)
+		: mProfiler{ profiler }
+		, mCommandBuffer{ commandBuffer }
+		, mIndex{ profiler.begin_gpu_scope(commandBuffer, name) }
+	{
+	}
+
+	gpu_profiler::gpu_scope::~gpu_scope()
+	{
+		mProfiler.end_gpu_scope(mCommandBuffer, mIndex);
+	}
+
+	gpu_profiler::cpu_scope::cpu_scope(gpu_profiler& profiler, const char* name)
+		: mProfiler{ profiler }
+		, mName{ name }
+		, mBegin{ std::chrono::steady_clock::now() }
+	{
+	}
+
+	gpu_profiler::cpu_scope::~cpu_scope()
+	{
+		mProfiler.add_cpu_sample(mName, mBegin, std::chrono::steady_clock::now());
+	}
+
+	gpu_profiler::gpu_profiler(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const uint32_t queueFamilyIndex,
+		const vk::Queue queue,
+		const uint32_t framesInFlight,
+		const uint32_t maxScopesPerFrame)
+		: mDevice{ device }
+		, mMaxScopesPerFrame{ maxScopesPerFrame }
+		, mEpoch{ std::chrono::steady_clock::now() }
+		, mSlots(framesInFlight)
+	{
+		if (0 == framesInFlight || 0 == maxScopesPerFrame) {
+			throw std::invalid_argument("A GPU profiler needs at least one frame in flight, and at least one scope per frame.");
+		}
+
+		const auto timestampValidBits = physicalDevice.getQueueFamilyProperties()[queueFamilyIndex].timestampValidBits;
+		if (timestampValidBits > 0) {
+			mQueryPool = device.createQueryPool(vk::QueryPoolCreateInfo{}
+				.setQueryType(vk::QueryType::eTimestamp)
+				.setQueryCount(2u * maxScopesPerFrame * framesInFlight)
+			);
+			mTimestampPeriodNs = static_cast<double>(physicalDevice.getProperties().limits.timestampPeriod);
+			mTimestampMask = timestampValidBits >= 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << timestampValidBits) - 1;
+			calibrate(queueFamilyIndex, queue);
+		}
+	}
+
+	gpu_profiler::~gpu_profiler()
+	{
+		if (mQueryPool) {
+			mDevice.destroyQueryPool(mQueryPool);
+		}
+	}
+
+	void gpu_profiler::calibrate(const uint32_t queueFamilyIndex, const vk::Queue queue)
+	{
+		auto commandPool = mDevice.createCommandPool(vk::CommandPoolCreateInfo{}
+			.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(queueFamilyIndex)
+		);
+		auto commandBuffer = helpers::allocate_command_buffer(mDevice, commandPool);
+		commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		commandBuffer.resetQueryPool(mQueryPool, 0u, 1u);
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, mQueryPool, 0u);
+		commandBuffer.end();
+
+		// The timestamp is written somewhere between the submission and the moment the CPU sees the queue being idle:
+		const auto before = std::chrono::steady_clock::now();
+		queue.submit({ vk::SubmitInfo{}.setCommandBufferCount(1u).setPCommandBuffers(&commandBuffer) }, nullptr);
+		queue.waitIdle();
+		const auto after = std::chrono::steady_clock::now();
+
+		uint64_t timestamp = 0;
+		const auto result = mDevice.getQueryPoolResults(mQueryPool, 0u, 1u, sizeof(timestamp), &timestamp, sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+		if (vk::Result::eSuccess == result) {
+			mCalibrationTicks = timestamp & mTimestampMask;
+			mCalibrationUs = (microseconds_between(mEpoch, before) + microseconds_between(mEpoch, after)) * 0.5;
+		}
+		mDevice.destroyCommandPool(commandPool);
+	}
+
+	double gpu_profiler::ticks_to_us(const uint64_t ticks) const
+	{
+		// Signed difference, s.t. timestamps before the calibration work as well:
+		const auto delta = static_cast<int64_t>((ticks & mTimestampMask) - mCalibrationTicks);
+		return mCalibrationUs + static_cast<double>(delta) * mTimestampPeriodNs * 1e-3;
+	}
+
+	void gpu_profiler::begin_frame(const vk::CommandBuffer commandBuffer)
+	{
+		mCurrentSlot = static_cast<size_t>(mFrameNumber % mSlots.size());
+		resolve_slot(mCurrentSlot);
+
+		auto& slot = mSlots[mCurrentSlot];
+		slot.frameNumber = mFrameNumber++;
+		slot.scopes.clear();
+		if (mQueryPool) {
+			commandBuffer.resetQueryPool(mQueryPool, static_cast<uint32_t>(2 * mMaxScopesPerFrame * mCurrentSlot), 2 * mMaxScopesPerFrame);
+		}
+	}
+
+	uint32_t gpu_profiler::begin_gpu_scope(const vk::CommandBuffer commandBuffer, const char* name)
+	{
+		auto& slot = mSlots[mCurrentSlot];
+		if (!mQueryPool || slot.scopes.size() >= mMaxScopesPerFrame) {
+			return std::numeric_limits<uint32_t>::max();
+		}
+
+		const auto index = static_cast<uint32_t>(slot.scopes.size());
+		slot.scopes.push_back(recorded_scope{ name });
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, mQueryPool,
+			static_cast<uint32_t>(2 * mMaxScopesPerFrame * mCurrentSlot + 2 * index));
+		return index;
+	}
+
+	void gpu_profiler::end_gpu_scope(const vk::CommandBuffer commandBuffer, const uint32_t index)
+	{
+		auto& slot = mSlots[mCurrentSlot];
+		if (index >= slot.scopes.size()) {
+			return;
+		}
+
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, mQueryPool,
+			static_cast<uint32_t>(2 * mMaxScopesPerFrame * mCurrentSlot + 2 * index + 1));
+		slot.scopes[index].ended = true;
+	}
+
+	void gpu_profiler::resolve_slot(const size_t slotIndex)
+	{
+		auto& slot = mSlots[slotIndex];
+		if (slot.scopes.empty()) {
+			return;
+		}
+
+		// No eWait: if the frame hasn't completed yet (or a scope has never been ended), we'd rather lose its results than stall.
+		const auto queryCount = static_cast<uint32_t>(2 * slot.scopes.size());
+		std::vector<uint64_t> timestamps(queryCount);
+		const auto result = mDevice.getQueryPoolResults(
+			mQueryPool, static_cast<uint32_t>(2 * mMaxScopesPerFrame * slotIndex), queryCount,
+			sizeof(uint64_t) * timestamps.size(), timestamps.data(), sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64
+		);
+		if (vk::Result::eSuccess != result) {
+			++mDroppedFrames;
+			return;
+		}
+
+		for (size_t i = 0; i < slot.scopes.size(); ++i) {
+			if (!slot.scopes[i].ended) {
+				continue;
+			}
+			const auto beginUs = ticks_to_us(timestamps[2 * i]);
+			const auto endUs = ticks_to_us(timestamps[2 * i + 1]);
+			add_sample(slot.scopes[i].name, true, slot.frameNumber, beginUs, std::max(0.0, endUs - beginUs));
+		}
+	}
+
+	void gpu_profiler::add_cpu_sample(const char* name, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end)
+	{
+		add_sample(name, false, mFrameNumber == 0 ? 0 : mFrameNumber - 1, microseconds_between(mEpoch, begin), microseconds_between(begin, end));
+	}
+
+	void gpu_profiler::add_sample(const char* name, const bool gpu, const uint64_t frameNumber, const double beginUs, const double durationUs)
+	{
+		const auto key = std::string(gpu ? "G:" : "C:") + name;
+		auto it = mScopeIndices.find(key);
+		if (mScopeIndices.end() == it) {
+			it = mScopeIndices.emplace(key, mScopes.size()).first;
+			mScopes.emplace_back();
+			mScopes.back().statistics.name = name;
+			mScopes.back().statistics.gpu = gpu;
+		}
+
+		auto& scope = mScopes[it->second];
+		const auto ms = durationUs * 1e-3;
+		if (scope.samplesMs.size() < StatisticsWindowSize) {
+			scope.samplesMs.push_back(ms);
+		}
+		else {
+			scope.samplesMs[scope.next] = ms;
+		}
+		scope.next = (scope.next + 1) % StatisticsWindowSize;
+		++scope.statistics.sampleCount;
+		scope.statistics.lastMs = ms;
+
+		mTraceEvents.push_back(trace_event{ name, gpu, frameNumber, beginUs, durationUs });
+		if (mTraceEvents.size() > MaxTraceEvents) {
+			mTraceEvents.pop_front();
+		}
+	}
+
+	std::vector<profiler_scope_statistics> gpu_profiler::get_statistics() const
+	{
+		std::vector<profiler_scope_statistics> result;
+		for (const bool gpu : { true, false }) {
+			for (const auto& scope : mScopes) {
+				if (scope.statistics.gpu != gpu) {
+					continue;
+				}
+				auto statistics = scope.statistics;
+				double sum = 0.0;
+				statistics.minMs = std::numeric_limits<double>::max();
+				statistics.maxMs = 0.0;
+				for (const auto ms : scope.samplesMs) {
+					sum += ms;
+					statistics.minMs = std::min(statistics.minMs, ms);
+					statistics.maxMs = std::max(statistics.maxMs, ms);
+				}
+				statistics.meanMs = sum / static_cast<double>(scope.samplesMs.size());
+				result.push_back(statistics);
+			}
+		}
+		return result;
+	}
+
+	void gpu_profiler::print_statistics(std::ostream& stream) const
+	{
+		stream << "Profiler: " << (is_gpu_supported() ? "" : "no GPU timestamp support, ")
+			<< mDroppedFrames << " frames dropped, statistics over the last " << StatisticsWindowSize << " samples of each scope:\n";
+		for (const auto& s : get_statistics()) {
+			stream << "  " << (s.gpu ? "GPU " : "CPU ") << s.name << ": mean " << s.meanMs << " ms, min " << s.minMs
+				<< " ms, max " << s.maxMs << " ms (" << s.sampleCount << " samples)\n";
+		}
+	}
+
+	void gpu_profiler::write_chrome_trace(const std::string& path) const
+	{
+		std::ofstream stream(path, std::ios::trunc);
+		if (!stream.is_open()) {
+			throw std::runtime_error("Couldn't open '" + path + "' for writing");
+		}
+
+		// Complete events ("ph":"X") on two threads of one process: the CPU and the GPU timeline
+		stream << "{\"traceEvents\":[\n"
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+		stream << std::fixed << std::setprecision(3);
+		for (const auto& e : mTraceEvents) {
+			stream << ",\n{\"name\":\"" << escape_json(e.name) << "\",\"cat\":\"" << (e.gpu ? "gpu" : "cpu")
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (e.gpu ? 2 : 1)
+				<< ",\"ts\":" << e.beginUs << ",\"dur\":" << e.durationUs
+				<< ",\"args\":{\"frame\":" << e.frameNumber << "}}";
+		}
+		stream << "\n]}\n";
+		if (!stream.good()) {
+			throw std::runtime_error("Couldn't write '" + path + "'");
+		}
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+namespace helpers
+{
+	// Rolling statistics of one named scope, over its most recent samples
+	struct profiler_scope_statistics
+	{
+		std::string name;
+		bool gpu = true;			// GPU scope (timestamp queries) or CPU scope (steady_clock)
+		uint64_t sampleCount = 0;	// All samples so far; the averages only cover the most recent ones
+		double lastMs = 0.0;
+		double meanMs = 0.0;
+		double minMs = 0.0;
+		double maxMs = 0.0;
+	};
+
+	// Measures how long scopes of command buffers take on the GPU, using timestamp queries, and how long scopes of
+	// code take on the CPU. GPU results are resolved a few frames later without stalling: each frame in flight has
+	// its own range of queries, whose results are fetched when the frame's slot is reused (at which point the frame
+	// has completed on the GPU; if it hasn't, its results are dropped instead of waiting for them).
+	//
+	// Both GPU and CPU scopes are aggregated into per-scope rolling statistics, and kept as events which can be
+	// exported as a Chrome trace (chrome://tracing, ui.perfetto.dev). GPU timestamps are mapped into the CPU's time
+	// domain with a calibration at startup (one timestamp that is written right before the CPU observes that it has
+	// completed), which is accurate to about the submission latency.
+	//
+	// Usage per frame (with the same number of frames in flight as the frame scheduler):
+	//   auto& frame = frameScheduler.begin_frame();
+	//   profiler.begin_frame(frame.commandBuffer);
+	//   {
+	//       auto scope = profiler.scope(frame.commandBuffer, "copy_buffer_to_image");
+	//       helpers::copy_buffer_to_image(frame.commandBuffer, ...);
+	//   }
+	//
+	// Scope names are kept as pointers => pass string literals (or strings which outlive the profiler).
+	// The profiler is not thread-safe.
+	class gpu_profiler
+	{
+	public:
+		static constexpr uint32_t DefaultMaxScopesPerFrame = 64;
+
+		// Records a GPU scope from its construction until its destruction
+		class gpu_scope
+		{
+		public:
+			gpu_scope(gpu_profiler& profiler, const vk::CommandBuffer commandBuffer, const char* name);
+			gpu_scope(const gpu_scope&) = delete;
+			gpu_scope& operator=(const gpu_scope&) = delete;
+			~gpu_scope();
+		private:
+			gpu_profiler& mProfiler;
+			vk::CommandBuffer mCommandBuffer;
+			uint32_t mIndex;
+		};
+
+		// Records a CPU scope from its construction until its destruction
+		class cpu_scope
+		{
+		public:
+			cpu_scope(gpu_profiler& profiler, const char* name);
+			cpu_scope(const cpu_scope&) = delete;
+			cpu_scope& operator=(const cpu_scope&) = delete;
+			~cpu_scope();
+		private:
+			gpu_profiler& mProfiler;
+			const char* mName;
+			std::chrono::steady_clock::time_point mBegin;
+		};
+
+		gpu_profiler(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			const uint32_t queueFamilyIndex,
+			const vk::Queue queue,
+			const uint32_t framesInFlight,
+			const uint32_t maxScopesPerFrame = DefaultMaxScopesPerFrame
+		);
+		gpu_profiler(const gpu_profiler&) = delete;
+		gpu_profiler& operator=(const gpu_profiler&) = delete;
+		~gpu_profiler();
+
+		// Does the queue family support timestamps? If not, GPU scopes are ignored, but CPU scopes still work.
+		bool is_gpu_supported() const { return static_cast<bool>(mQueryPool); }
+
+		// Start the next frame: resolve the results of the frame which used the same slot before, and reset its queries.
+		// Must be called at the beginning of each frame's command buffer, before any other scope is recorded into it.
+		void begin_frame(const vk::CommandBuffer commandBuffer);
+
+		// Record a GPU scope. Scopes may be nested. Returns an index to pass to end_gpu_scope.
+		uint32_t begin_gpu_scope(const vk::CommandBuffer commandBuffer, const char* name);
+		void end_gpu_scope(const vk::CommandBuffer commandBuffer, const uint32_t index);
+		gpu_scope scope(const vk::CommandBuffer commandBuffer, const char* name) { return gpu_scope(*this, commandBuffer, name); }
+
+		// Record a CPU scope which has already ended
+		void add_cpu_sample(const char* name, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end);
+		cpu_scope cpu(const char* name) { return cpu_scope(*this, name); }
+
+		// Statistics of all scopes, GPU scopes first, in the order in which they have been seen first
+		std::vector<profiler_scope_statistics> get_statistics() const;
+		void print_statistics(std::ostream& stream) const;
+
+		// Frames whose GPU results were not available yet when their slot was reused
+		uint64_t dropped_frame_count() const { return mDroppedFrames; }
+
+		// Write all recorded events (up to MaxTraceEvents most recent ones) as Chrome trace JSON
+		void write_chrome_trace(const std::string& path) const;
+
+	private:
+		static constexpr size_t StatisticsWindowSize = 128;
+		static constexpr size_t MaxTraceEvents = 256 * 1024;
+
+		struct recorded_scope
+		{
+			const char* name;
+			bool ended = false;
+		};
+
+		struct frame_record
+		{
+			uint64_t frameNumber = 0;
+			std::vector<recorded_scope> scopes;		// Scope i uses queries 2i and 2i+1 of the slot's range
+		};
+
+		struct scope_history
+		{
+			profiler_scope_statistics statistics;
+			std::vector<double> samplesMs;			// Ring buffer of the most recent samples
+			size_t next = 0;
+		};
+
+		struct trace_event
+		{
+			const char* name;
+			bool gpu;
+			uint64_t frameNumber;
+			double beginUs;							// Since mEpoch
+			double durationUs;
+		};
+
+		void resolve_slot(const size_t slotIndex);
+		void add_sample(const char* name, const bool gpu, const uint64_t frameNumber, const double beginUs, const double durationUs);
+		void calibrate(const uint32_t queueFamilyIndex, const vk::Queue queue);
+		double ticks_to_us(const uint64_t ticks) const;
+
+		vk::Device mDevice;
+		vk::QueryPool mQueryPool;				// 2 * mMaxScopesPerFrame queries per slot; null if timestamps are not supported
+		uint32_t mMaxScopesPerFrame;
+		double mTimestampPeriodNs = 0.0;
+		uint64_t mTimestampMask = 0;
+		uint64_t mCalibrationTicks = 0;			// A GPU timestamp...
+		double mCalibrationUs = 0.0;			// ...and the corresponding CPU time since mEpoch
+
+		std::chrono::steady_clock::time_point mEpoch;
+		std::vector<frame_record> mSlots;
+		size_t mCurrentSlot = 0;
+		uint64_t mFrameNumber = 0;
+		uint64_t mDroppedFrames = 0;
+
+		std::vector<scope_history> mScopes;
+		std::unordered_map<std::string, size_t> mScopeIndices;	// "G:name" / "C:name" => index into mScopes
+		std::deque<trace_event> mTraceEvents;
+	};
+}
@@ -25,7 +25,10 @@ namespace helpers
 
 		uint32_t numGlfwExtensions;
 		auto glfwExtensions = glfwGetRequiredInstanceExtensions(&numGlfwExtensions);
+		// Vulkan 1.1 for vkGetPhysicalDeviceFeatures2 (see is_descriptor_indexing_supported):
+		const auto appInfo = vk::ApplicationInfo{}.setApiVersion(VK_API_VERSION_1_1);
 		auto instCreateInfo = vk::InstanceCreateInfo{}
+			.setPApplicationInfo(&appInfo)
 			.setEnabledExtensionCount(static_cast<uint32_t>(numGlfwExtensions))
 			.setPpEnabledExtensionNames(glfwExtensions)
 			.setEnabledLayerCount(static_cast<uint32_t>(EnabledVkValidationLayers.size()))
@@ -35,6 +38,25 @@ namespace helpers
 		return vkInstance;
 	}
 
+	vk::Instance create_headless_vulkan_instance()
+	{
+		// Build machines usually don't have the validation layers installed => only enable them if they are there:
+		std::vector<const char*> enabledLayers;
+		for (const auto& layer : vk::enumerateInstanceLayerProperties()) {
+			if (0 == strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation")) {
+				enabledLayers.push_back("VK_LAYER_KHRONOS_validation");
+			}
+		}
+
+		// No surface => no instance extensions required:
+		const auto appInfo = vk::ApplicationInfo{}.setApiVersion(VK_API_VERSION_1_1);
+		auto instCreateInfo = vk::InstanceCreateInfo{}
+			.setPApplicationInfo(&appInfo)
+			.setEnabledLayerCount(static_cast<uint32_t>(enabledLayers.size()))
+			.setPpEnabledLayerNames(enabledLayers.data());
+		return vk::createInstance(instCreateInfo);
+	}
+
 	VkSurfaceKHR create_surface(
 		GLFWwindow* window, 
 		const vk::Instance vulkanInstance)
@@ -53,8 +75,8 @@ namespace helpers
 	{
 		auto familyProps = physicalDevice.getQueueFamilyProperties();
 		for (uint32_t i = 0; i < familyProps.size(); ++i) {
-			// Test for surface support:
-			if (physicalDevice.getSurfaceSupportKHR(i, surfaceToBeSupported) == VK_FALSE) {
+			// Test for surface support (unless we're headless):
+			if (VK_NULL_HANDLE != surfaceToBeSupported && physicalDevice.getSurfaceSupportKHR(i, surfaceToBeSupported) == VK_FALSE) {
 				continue;
 			}
 			// Test for operations support:
@@ -66,37 +88,124 @@ namespace helpers
 		throw std::runtime_error("Couldn't find a suitable queue family");
 	}
 
-	vk::Device create_logical_device(
+	queue_family_indices find_queue_family_indices(
 		const vk::PhysicalDevice physicalDevice,
 		const VkSurfaceKHR surfaceToBeSupported)
 	{
-		static const std::vector<const char*> EnabledVkDeviceExtensions = {
-			VK_KHR_SWAPCHAIN_EXTENSION_NAME
-		};
+		const auto graphics = helpers::find_queue_family_index_for_parameters(
+			physicalDevice,
+			surfaceToBeSupported,
+			vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer
+		);
+		queue_family_indices result{ graphics, graphics, graphics };
 
+		const auto familyProps = physicalDevice.getQueueFamilyProperties();
+		for (uint32_t i = 0; i < familyProps.size(); ++i) {
+			const auto flags = familyProps[i].queueFlags;
+			const auto granularity = familyProps[i].minImageTransferGranularity;
+			// Transfer only; families with a coarser granularity can't copy arbitrary mip levels or image regions:
+			if (graphics == result.transfer && (flags & vk::QueueFlagBits::eTransfer)
+				&& !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))
+				&& 1u == granularity.width && 1u == granularity.height && 1u == granularity.depth) {
+				result.transfer = i;
+			}
+			// Compute, but no graphics:
+			if (graphics == result.compute && (flags & vk::QueueFlagBits::eCompute) && !(flags & vk::QueueFlagBits::eGraphics)) {
+				result.compute = i;
+			}
+		}
+		return result;
+	}
+
+	vk::Device create_logical_device(
+		const vk::PhysicalDevice physicalDevice,
+		const VkSurfaceKHR surfaceToBeSupported)
+	{
 		// Look for a queue family which supports:
 		//  - the surface, and
 		//  - all sorts of queue operations (i.e. graphics, compute, and transfer)
 		//  
 		// Afterwards, when creating the logical device, request ONE such a queue to be created!
 		// 
-		float queuePriority = 1.0f;
-		auto queueCreateInfo = vk::DeviceQueueCreateInfo{}
-			.setQueueCount(1u)
-			.setQueueFamilyIndex(helpers::find_queue_family_index_for_parameters(
-				physicalDevice, 
-				surfaceToBeSupported, 
-				vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer
-			))
-			.setPQueuePriorities(&queuePriority);
+		const auto family = helpers::find_queue_family_index_for_parameters(
+			physicalDevice, 
+			surfaceToBeSupported, 
+			vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eTransfer
+		);
+		return helpers::create_logical_device(physicalDevice, surfaceToBeSupported, queue_family_indices{ family, family, family });
+	}
+
+	bool is_descriptor_indexing_supported(const vk::PhysicalDevice physicalDevice)
+	{
+		// vkGetPhysicalDeviceFeatures2 is core in Vulkan 1.1; the instances are created with 1.1, the device must support it as well:
+		if (physicalDevice.getProperties().apiVersion < VK_API_VERSION_1_1) {
+			return false;
+		}
+		const auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
+		const bool hasExtension = std::any_of(extensions.begin(), extensions.end(), [](const vk::ExtensionProperties& extension) {
+			return 0 == strcmp(extension.extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		});
+		if (!hasExtension) {
+			return false;
+		}
+
+		const auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+		const auto& indexing = features.get<vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+		return VK_TRUE == indexing.shaderSampledImageArrayNonUniformIndexing
+			&& VK_TRUE == indexing.runtimeDescriptorArray
+			&& VK_TRUE == indexing.descriptorBindingPartiallyBound
+			&& VK_TRUE == indexing.descriptorBindingSampledImageUpdateAfterBind
+			&& VK_TRUE == indexing.descriptorBindingUpdateUnusedWhilePending;
+	}
+
+	vk::Device create_logical_device(
+		const vk::PhysicalDevice physicalDevice,
+		const VkSurfaceKHR surfaceToBeSupported,
+		const queue_family_indices& queueFamilies,
+		const bool enableDescriptorIndexing)
+	{
+		// Headless devices can't present => they don't need (and might not even support) the swapchain extension:
+		std::vector<const char*> EnabledVkDeviceExtensions;
+		if (VK_NULL_HANDLE != surfaceToBeSupported) {
+			EnabledVkDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
+
+		// Only the features which bindless_texture_table needs, not everything the device supports:
+		const bool descriptorIndexing = enableDescriptorIndexing && is_descriptor_indexing_supported(physicalDevice);
+		auto indexingFeatures = vk::PhysicalDeviceDescriptorIndexingFeaturesEXT{}
+			.setShaderSampledImageArrayNonUniformIndexing(VK_TRUE)
+			.setRuntimeDescriptorArray(VK_TRUE)
+			.setDescriptorBindingPartiallyBound(VK_TRUE)
+			.setDescriptorBindingSampledImageUpdateAfterBind(VK_TRUE)
+			.setDescriptorBindingUpdateUnusedWhilePending(VK_TRUE);
+		if (descriptorIndexing) {
+			EnabledVkDeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		}
+
+		// Request ONE queue of each distinct family (a family must not be listed twice):
+		static const float QueuePriority = 1.0f;
+		std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+		for (const auto family : { queueFamilies.graphics, queueFamilies.transfer, queueFamilies.compute }) {
+			const bool alreadyRequested = std::any_of(queueCreateInfos.begin(), queueCreateInfos.end(), [family](const vk::DeviceQueueCreateInfo& info) {
+				return info.queueFamilyIndex == family;
+			});
+			if (!alreadyRequested) {
+				queueCreateInfos.push_back(vk::DeviceQueueCreateInfo{}
+					.setQueueCount(1u)
+					.setQueueFamilyIndex(family)
+					.setPQueuePriorities(&QueuePriority)
+				);
+			}
+		}
 
 		// Create a logical device which is an interface to the physical device
-		// and also request a queue to be created
+		// and also request the queues to be created
 		auto deviceCreateInfo = vk::DeviceCreateInfo{}
-			.setQueueCreateInfoCount(1u)
-			.setPQueueCreateInfos(&queueCreateInfo)
+			.setQueueCreateInfoCount(static_cast<uint32_t>(queueCreateInfos.size()))
+			.setPQueueCreateInfos(queueCreateInfos.data())
 			.setEnabledExtensionCount(static_cast<uint32_t>(EnabledVkDeviceExtensions.size()))
-			.setPpEnabledExtensionNames(EnabledVkDeviceExtensions.data());
+			.setPpEnabledExtensionNames(EnabledVkDeviceExtensions.data())
+			.setPNext(descriptorIndexing ? &indexingFeatures : nullptr);
 		auto device = physicalDevice.createDevice(deviceCreateInfo);
 
 		return device;
@@ -115,49 +224,56 @@ namespace helpers
 		return std::make_tuple(queueFamilyIndex, logcialDevice.getQueue(queueFamilyIndex, 0u));
 	}
 
-	vk::DeviceMemory allocate_host_coherent_memory_for_given_requirements(
+	device_queues get_device_queues(
+		const vk::Device device,
+		const queue_family_indices& queueFamilies)
+	{
+		return device_queues{
+			device_queue{ queueFamilies.graphics, device.getQueue(queueFamilies.graphics, 0u) },
+			device_queue{ queueFamilies.transfer, device.getQueue(queueFamilies.transfer, 0u) },
+			device_queue{ queueFamilies.compute, device.getQueue(queueFamilies.compute, 0u) }
+		};
+	}
+
+	memory_allocation allocate_host_coherent_memory_for_given_requirements(
 		const vk::PhysicalDevice physicalDevice,
 		const vk::Device device,
 		const vk::DeviceSize bufferSize,
-		const vk::MemoryRequirements memoryRequirements)
-	{
-		auto memoryAllocInfo = vk::MemoryAllocateInfo{}
-			.setAllocationSize(std::max(bufferSize, memoryRequirements.size))
-			.setMemoryTypeIndex([&]() {
-					// Get memory types supported by the physical device:
-					auto memoryProperties = physicalDevice.getMemoryProperties();
-			
-					// In search for a suitable memory type INDEX:
-					for (uint32_t i = 0u; i < memoryProperties.memoryTypeCount; ++i) {
-						
-						// Is this kind of memory suitable for our buffer?
-						const auto bitmask = memoryRequirements.memoryTypeBits;
-						const auto bit = 1 << i;
-						if (0 == (bitmask & bit)) {
-							continue; // => nope
-						}
-						
-						// Does this kind of memory support our usage requirements?
-						if ((memoryProperties.memoryTypes[i].propertyFlags & (vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent))
-								!= vk::MemoryPropertyFlags{}) {
-							// Return the INDEX of a suitable memory type
-							return i;
-						}
-					}
-					throw std::runtime_error("Couldn't find suitable memory.");
-				}());
-
-		// Allocate:
-		auto memory = device.allocateMemory(memoryAllocInfo);
-		
-		return memory;
+		const vk::MemoryRequirements memoryRequirements,
+		const memory_category category)
+	{
+		auto requirements = memoryRequirements;
+		requirements.size = std::max(bufferSize, memoryRequirements.size);
+
+		// Sub-allocate from a memory type which is both, host visible and host coherent:
+		return helpers::get_memory_arena(physicalDevice, device).allocate(
+			requirements, 
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+			resource_tiling::linear,
+			category
+		);
+	}
+
+	memory_allocation allocate_device_local_memory_for_given_requirements(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const vk::MemoryRequirements memoryRequirements,
+		const resource_tiling tiling,
+		const memory_category category)
+	{
+		return helpers::get_memory_arena(physicalDevice, device).allocate(
+			memoryRequirements, 
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			tiling,
+			category
+		);
 	}
 
 	void free_memory(
 		const vk::Device device,
-		vk::DeviceMemory memory)
+		const memory_allocation& memory)
 	{
-		device.freeMemory(memory);
+		helpers::get_memory_arena(device).free(memory);
 	}
 
 	void destroy_buffer(
@@ -185,46 +301,41 @@ namespace helpers
 		device.freeCommandBuffers(commandPool, 1u, &commandBuffer);
 	}
 
-	std::tuple<vk::Buffer, vk::DeviceMemory, int, int> load_image_into_host_coherent_buffer(
+	std::tuple<vk::Buffer, memory_allocation, int, int> load_image_into_host_coherent_buffer(
 		const vk::PhysicalDevice physicalDevice,
 		const vk::Device device,
 		const std::string pathToImageFile)
 	{
-		const int desiredColorChannels = STBI_rgb_alpha;	
-		int width, height, channelsInFile;
-		stbi_uc* pixels = stbi_load(pathToImageFile.c_str(), &width, &height, &channelsInFile, desiredColorChannels); 
-		size_t imageDataSize = width * height * desiredColorChannels;
-
-		// Convert RGB -> BGR
-		// TODO: Not sure if this is a good idea on all different GPUs. Probably it's not. If the image looks odd => try something else here.
-		for (int i = 0; i < imageDataSize; i += desiredColorChannels) {
-			stbi_uc tmp = pixels[i];
-			pixels[i] = pixels[i+2];
-			pixels[i+2] = tmp;
-		}
+		const auto info = helpers::get_image_info(pathToImageFile);
 
-		// Create a buffer:
-		auto bufferCreateInfo = vk::BufferCreateInfo{}
-			.setSize(static_cast<vk::DeviceSize>(imageDataSize))
-			.setUsage(vk::BufferUsageFlagBits::eTransferSrc);
-		auto buffer = device.createBuffer(bufferCreateInfo);
-		
-		// Create the memory:
-		auto memory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, 
-			bufferCreateInfo.size,
-			device.getBufferMemoryRequirements(buffer)
+		// Create a buffer with host-coherent (persistently mapped) backing memory:
+		auto [buffer, memory] = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice,
+			static_cast<size_t>(info.width) * info.height * 4, vk::BufferUsageFlagBits::eTransferSrc
 		);
 
-		device.bindBufferMemory(buffer, memory, 0);
-		
-		// Copy the image's data into the buffer
-		auto mappedMemory = device.mapMemory(memory, 0, bufferCreateInfo.size);
-		memcpy(mappedMemory, pixels, bufferCreateInfo.size);
-		device.unmapMemory(memory);
+		// Decode the image straight into the buffer, in BGR(A) order
+		// TODO: Not sure if this is a good idea on all different GPUs. Probably it's not. If the image looks odd => try something else here.
+		helpers::decode_image(pathToImageFile, info, texel_order::bgra, static_cast<uint8_t*>(memory.mappedData));
 
-		stbi_image_free(pixels);
+		return std::make_tuple(buffer, memory, static_cast<int>(info.width), static_cast<int>(info.height));
+	}
 
-		return std::make_tuple(buffer, memory, width, height);
+	vk::ImageAspectFlags get_image_aspect_flags(const vk::Format format)
+	{
+		switch (format) {
+		case vk::Format::eD16Unorm:
+		case vk::Format::eX8D24UnormPack32:
+		case vk::Format::eD32Sfloat:
+			return vk::ImageAspectFlagBits::eDepth;
+		case vk::Format::eS8Uint:
+			return vk::ImageAspectFlagBits::eStencil;
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+		default:
+			return vk::ImageAspectFlagBits::eColor;
+		}
 	}
 
 	void establish_pipeline_barrier_with_image_layout_transition(
@@ -232,7 +343,8 @@ namespace helpers
 		const vk::PipelineStageFlags srcPipelineStage, const vk::PipelineStageFlags dstPipelineStage,
 		const vk::AccessFlags srcAccessMask, const vk::AccessFlags dstAccessMask,
 		const vk::Image image,
-		const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout
+		const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout,
+		const vk::ImageSubresourceRange subresourceRange
 	)
 	{
 		auto imageMemoryBarrier = vk::ImageMemoryBarrier{};
@@ -243,7 +355,7 @@ namespace helpers
 		imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		imageMemoryBarrier.image = image;
-		imageMemoryBarrier.subresourceRange = vk::ImageSubresourceRange{vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+		imageMemoryBarrier.subresourceRange = subresourceRange;
 
 		commandBuffer.pipelineBarrier(
 			srcPipelineStage,
@@ -256,11 +368,12 @@ namespace helpers
 	void copy_buffer_to_image(
 		const vk::CommandBuffer commandBuffer,
 		const vk::Buffer buffer,
-		const vk::Image image, const uint32_t width, const uint32_t height)
+		const vk::Image image, const uint32_t width, const uint32_t height,
+		const uint32_t bufferRowLength)
 	{
 		commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, { 
 			vk::BufferImageCopy{
-				0, width, height,
+				0, std::max(width, bufferRowLength), height,
 				vk::ImageSubresourceLayers{vk::ImageAspectFlagBits::eColor, 0, 0, 1}, vk::Offset3D{0, 0, 0}, vk::Extent3D{width, height, 1}
 			}
 		});
@@ -286,10 +399,41 @@ namespace helpers
 		device.destroy();
 	}
 
-	std::tuple<size_t, vk::Buffer, vk::DeviceMemory, vk::Buffer, vk::DeviceMemory, vk::Buffer, vk::DeviceMemory> load_positions_and_texture_coordinates_and_normals_of_obj(
+	bool is_submesh_excluded(const std::string& submeshName, const std::string& submeshNamesToExclude)
+	{
+		// The workshop's model only ever needs its "tile" submeshes excluded:
+		return !submeshNamesToExclude.empty() && submeshName.find("tile") != std::string::npos;
+	}
+
+	void expand_obj_corners(
+		const tinyobj::index_t* corners, const size_t cornerCount,
+		const float* vertices, const float* texcoords, const float* normals,
+		glm::vec3* outPositions, glm::vec2* outTextureCoordinates, glm::vec3* outNormals)
+	{
+		for (size_t i = 0; i < cornerCount; ++i) {
+			const auto& index = corners[i];
+
+			outPositions[i] = glm::vec3(
+				vertices[3 * index.vertex_index + 0],
+				vertices[3 * index.vertex_index + 1],
+				vertices[3 * index.vertex_index + 2]
+			);
+
+			const auto uv = index.texcoord_index < 0 ? glm::vec2{ 0.0f }
+				: glm::vec2(texcoords[2 * index.texcoord_index + 0], texcoords[2 * index.texcoord_index + 1]);
+			outTextureCoordinates[i] = glm::vec2(uv.x, 1.0f - uv.y);
+
+			// Normals have their own indices:
+			outNormals[i] = index.normal_index < 0 ? glm::vec3{ 0.0f } : glm::vec3(
+				normals[3 * index.normal_index + 0],
+				normals[3 * index.normal_index + 1],
+				normals[3 * index.normal_index + 2]
+			);
+		}
+	}
+
+	mesh_data load_mesh_data_of_obj(
 		const std::string modelPath,
-		const vk::Device device,
-		const vk::PhysicalDevice physicalDevice,
 		const std::string submeshNamesToExclude)
 	{
 		// This code is borrowed from Alexander Overvoorde's Vulkan Tutorial, but has been modified:
@@ -303,35 +447,44 @@ namespace helpers
             throw std::runtime_error(warn + err);
         }
 
-		std::vector<glm::vec3> positions;
-		std::vector<glm::vec2> textureCoordinates;
-		std::vector<glm::vec3> normals;
-		
-        for (const auto& shape : shapes) {
-        	if (!submeshNamesToExclude.empty() && shape.name.find("tile") != std::string::npos) {
-        		continue;
-        	}
-        	
-            for (const auto& index : shape.mesh.indices) {
-
-            	positions.emplace_back(
-					attrib.vertices[3 * index.vertex_index + 0], 
-					attrib.vertices[3 * index.vertex_index + 1], 
-					attrib.vertices[3 * index.vertex_index + 2]
-				);
-            	
-				textureCoordinates.emplace_back(
-					attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-				);
+		// Count the corners of all included submeshes first, s.t. the output can be written in one go:
+		size_t cornerCount = 0;
+		for (const auto& shape : shapes) {
+			if (!helpers::is_submesh_excluded(shape.name, submeshNamesToExclude)) {
+				cornerCount += shape.mesh.indices.size();
+			}
+		}
 
-            	normals.emplace_back(
-					attrib.normals[3 * index.vertex_index + 0], 
-					attrib.normals[3 * index.vertex_index + 1], 
-					attrib.normals[3 * index.vertex_index + 2]
-				);
-            }
-        }
+		mesh_data mesh;
+		mesh.positions.resize(cornerCount);
+		mesh.textureCoordinates.resize(cornerCount);
+		mesh.normals.resize(cornerCount);
+
+		size_t offset = 0;
+		for (const auto& shape : shapes) {
+			if (helpers::is_submesh_excluded(shape.name, submeshNamesToExclude)) {
+				continue;
+			}
+			helpers::expand_obj_corners(shape.mesh.indices.data(), shape.mesh.indices.size(),
+				attrib.vertices.data(), attrib.texcoords.data(), attrib.normals.data(),
+				mesh.positions.data() + offset, mesh.textureCoordinates.data() + offset, mesh.normals.data() + offset
+			);
+			offset += shape.mesh.indices.size();
+		}
+
+		return mesh;
+	}
+
+	std::tuple<size_t, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation> load_positions_and_texture_coordinates_and_normals_of_obj(
+		const std::string modelPath,
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		const std::string submeshNamesToExclude)
+	{
+		const auto mesh = helpers::load_mesh_data_of_obj_parallel(modelPath, submeshNamesToExclude);
+		const auto& positions = mesh.positions;
+		const auto& textureCoordinates = mesh.textureCoordinates;
+		const auto& normals = mesh.normals;
 
 		// 1. POSITIONS BUFFER
 		// Create the buffer:
@@ -343,15 +496,14 @@ namespace helpers
 		// Allocate backing memory:
 		auto posMemory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, 
 			posBufferCreateInfo.size,
-			device.getBufferMemoryRequirements(posBuffer)
+			device.getBufferMemoryRequirements(posBuffer),
+			memory_category::mesh
 		);
 
-		device.bindBufferMemory(posBuffer, posMemory, 0);
+		device.bindBufferMemory(posBuffer, posMemory.memory, posMemory.offset);
 		
 		// Copy the positions into the buffer:
-		auto posMappedMemory = device.mapMemory(posMemory, 0, posBufferCreateInfo.size);
-		memcpy(posMappedMemory, positions.data(), posBufferCreateInfo.size);
-		device.unmapMemory(posMemory);
+		memcpy(posMemory.mappedData, positions.data(), posBufferCreateInfo.size);
 
 		// 2. TEXTURE COORDINATES BUFFER
 		// Create the buffer:
@@ -363,15 +515,14 @@ namespace helpers
 		// Allocate backing memory:
 		auto texcoMemory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, 
 			texcoBufferCreateInfo.size,
-			device.getBufferMemoryRequirements(texcoBuffer)
+			device.getBufferMemoryRequirements(texcoBuffer),
+			memory_category::mesh
 		);
 
-		device.bindBufferMemory(texcoBuffer, texcoMemory, 0);
+		device.bindBufferMemory(texcoBuffer, texcoMemory.memory, texcoMemory.offset);
 		
 		// Copy the texture coordinates into the buffer:
-		auto texcoMappedMemory = device.mapMemory(texcoMemory, 0, texcoBufferCreateInfo.size);
-		memcpy(texcoMappedMemory, textureCoordinates.data(), texcoBufferCreateInfo.size);
-		device.unmapMemory(texcoMemory);
+		memcpy(texcoMemory.mappedData, textureCoordinates.data(), texcoBufferCreateInfo.size);
 
 		// 2. NORMALS BUFFER
 		// Create the buffer:
@@ -383,30 +534,266 @@ namespace helpers
 		// Allocate backing memory:
 		auto nrmMemory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, 
 			nrmBufferCreateInfo.size,
-			device.getBufferMemoryRequirements(nrmBuffer)
+			device.getBufferMemoryRequirements(nrmBuffer),
+			memory_category::mesh
 		);
 
-		device.bindBufferMemory(nrmBuffer, nrmMemory, 0);
+		device.bindBufferMemory(nrmBuffer, nrmMemory.memory, nrmMemory.offset);
 		
-		// Copy the texture coordinates into the buffer:
-		auto nrmMappedMemory = device.mapMemory(nrmMemory, 0, nrmBufferCreateInfo.size);
-		memcpy(nrmMappedMemory, normals.data(), nrmBufferCreateInfo.size);
-		device.unmapMemory(nrmMemory);
+		// Copy the normals into the buffer:
+		memcpy(nrmMemory.mappedData, normals.data(), nrmBufferCreateInfo.size);
 
 		// Done => return:
 		return std::make_tuple(positions.size(), posBuffer, posMemory, texcoBuffer, texcoMemory, nrmBuffer, nrmMemory);
 	}
 
-	std::tuple<vk::Image, vk::DeviceMemory> create_image(
+	std::tuple<size_t, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation, upload_token> load_positions_and_texture_coordinates_and_normals_of_obj(
+		const std::string modelPath,
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const std::string submeshNamesToExclude)
+	{
+		const auto mesh = helpers::load_mesh_data_of_obj_parallel(modelPath, submeshNamesToExclude);
+		auto deviceMesh = helpers::upload_mesh_data(device, physicalDevice, uploadEngine, mesh);
+
+		// All three copies go into the same batch => submit once:
+		const auto token = uploadEngine.submit();
+
+		return std::make_tuple(deviceMesh.vertexCount, 
+			deviceMesh.positionsBuffer, deviceMesh.positionsMemory, 
+			deviceMesh.textureCoordinatesBuffer, deviceMesh.textureCoordinatesMemory, 
+			deviceMesh.normalsBuffer, deviceMesh.normalsMemory, 
+			token
+		);
+	}
+
+	namespace
+	{
+		// Create a device-local buffer and let the upload engine copy the data into it
+		std::tuple<vk::Buffer, memory_allocation> upload_buffer(
+			const vk::Device device, const vk::PhysicalDevice physicalDevice, upload_engine& uploadEngine,
+			const void* data, const size_t dataSize, const vk::BufferUsageFlags usage, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+		{
+			auto result = helpers::create_device_local_buffer_and_memory(device, physicalDevice, dataSize, usage, memory_category::mesh);
+			uploadEngine.enqueue_buffer_upload(data, dataSize, std::get<0>(result), 0, dstStages, dstAccess);
+			return result;
+		}
+
+		// Upload the index buffer of a mesh whose vertices have already been set
+		void upload_mesh_indices(
+			const vk::Device device, const vk::PhysicalDevice physicalDevice, upload_engine& uploadEngine,
+			const size_t indexCount, const uint32_t* indices, device_mesh& mesh)
+		{
+			if (0 == indexCount) {
+				return;
+			}
+			mesh.indexCount = indexCount;
+
+			// Half the index data, if all vertices can be addressed with 16 bits (leaving 0xFFFF for primitive restart):
+			if (mesh.vertexCount < std::numeric_limits<uint16_t>::max()) {
+				std::vector<uint16_t> indices16(indices, indices + indexCount);
+				mesh.indexType = vk::IndexType::eUint16;
+				std::tie(mesh.indexBuffer, mesh.indexMemory) = upload_buffer(device, physicalDevice, uploadEngine, indices16.data(), sizeof(uint16_t) * indices16.size(),
+					vk::BufferUsageFlagBits::eIndexBuffer, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eIndexRead);
+			}
+			else {
+				mesh.indexType = vk::IndexType::eUint32;
+				std::tie(mesh.indexBuffer, mesh.indexMemory) = upload_buffer(device, physicalDevice, uploadEngine, indices, sizeof(uint32_t) * indexCount,
+					vk::BufferUsageFlagBits::eIndexBuffer, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eIndexRead);
+			}
+		}
+	}
+
+	device_mesh upload_mesh_data(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const mesh_data& mesh)
+	{
+		return helpers::upload_mesh_streams(device, physicalDevice, uploadEngine,
+			mesh.positions.size(), mesh.positions.data(), mesh.textureCoordinates.data(), mesh.normals.data(),
+			mesh.indices.size(), mesh.indices.empty() ? nullptr : mesh.indices.data()
+		);
+	}
+
+	device_mesh upload_mesh_streams(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const size_t vertexCount,
+		const glm::vec3* positions,
+		const glm::vec2* textureCoordinates,
+		const glm::vec3* normals,
+		const size_t indexCount,
+		const uint32_t* indices)
+	{
+		auto upload_vertex_buffer = [&](const void* data, const size_t dataSize) {
+			return upload_buffer(device, physicalDevice, uploadEngine, data, dataSize, 
+				vk::BufferUsageFlagBits::eVertexBuffer, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead);
+		};
+
+		device_mesh result;
+		result.vertexCount = vertexCount;
+		result.vertexFormat = helpers::get_full_precision_vertex_format();
+		std::tie(result.positionsBuffer, result.positionsMemory) = upload_vertex_buffer(positions, sizeof(glm::vec3) * vertexCount);
+		std::tie(result.textureCoordinatesBuffer, result.textureCoordinatesMemory) = upload_vertex_buffer(textureCoordinates, sizeof(glm::vec2) * vertexCount);
+		std::tie(result.normalsBuffer, result.normalsMemory) = upload_vertex_buffer(normals, sizeof(glm::vec3) * vertexCount);
+		upload_mesh_indices(device, physicalDevice, uploadEngine, indexCount, indices, result);
+		return result;
+	}
+
+	device_mesh upload_encoded_mesh(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const encoded_vertices& vertices,
+		const std::vector<uint32_t>& indices)
+	{
+		device_mesh result;
+		result.vertexCount = vertices.vertexCount;
+		result.vertexFormat = vertices.format;
+		result.positionScale = vertices.positionScale;
+		result.positionOffset = vertices.positionOffset;
+		std::tie(result.vertexBuffer, result.vertexMemory) = upload_buffer(device, physicalDevice, uploadEngine, vertices.data.data(), vertices.data.size(),
+			vk::BufferUsageFlagBits::eVertexBuffer, vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead);
+		result.vertexBindingOffsets.assign(vertices.bindingOffsets.begin(), vertices.bindingOffsets.end());
+		upload_mesh_indices(device, physicalDevice, uploadEngine, indices.size(), indices.data(), result);
+		return result;
+	}
+
+	void bind_device_mesh(
+		const vk::CommandBuffer commandBuffer,
+		const device_mesh& mesh,
+		const uint32_t firstBinding)
+	{
+		if (mesh.vertexBuffer) {
+			const std::vector<vk::Buffer> buffers(mesh.vertexBindingOffsets.size(), mesh.vertexBuffer);
+			commandBuffer.bindVertexBuffers(firstBinding, buffers, mesh.vertexBindingOffsets);
+		}
+		else {
+			const std::array<vk::Buffer, 3> buffers = { mesh.positionsBuffer, mesh.textureCoordinatesBuffer, mesh.normalsBuffer };
+			const std::array<vk::DeviceSize, 3> offsets = { 0, 0, 0 };
+			commandBuffer.bindVertexBuffers(firstBinding, buffers, offsets);
+		}
+		if (mesh.indexBuffer) {
+			commandBuffer.bindIndexBuffer(mesh.indexBuffer, 0, mesh.indexType);
+		}
+	}
+
+	void destroy_device_mesh(
+		const vk::Device device,
+		device_mesh& mesh)
+	{
+		for (auto [buffer, memory] : { 
+				std::make_tuple(mesh.positionsBuffer, mesh.positionsMemory), 
+				std::make_tuple(mesh.textureCoordinatesBuffer, mesh.textureCoordinatesMemory), 
+				std::make_tuple(mesh.normalsBuffer, mesh.normalsMemory), 
+				std::make_tuple(mesh.vertexBuffer, mesh.vertexMemory), 
+				std::make_tuple(mesh.indexBuffer, mesh.indexMemory) }) {
+			if (buffer) {
+				helpers::destroy_buffer(device, buffer);
+				helpers::free_memory(device, memory);
+			}
+		}
+		mesh = device_mesh{};
+	}
+
+	std::tuple<vk::Image, memory_allocation, int, int, upload_token> load_image_into_device_local_image(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		upload_engine& uploadEngine,
+		const std::string pathToImageFile,
+		const vk::ImageUsageFlags usageFlags,
+		const bool generateMipChain)
+	{
+		// Decode into RGBA order => no need to swizzle, if we just use an RGBA format:
+		const auto format = vk::Format::eR8G8B8A8Unorm;
+		const auto info = helpers::get_image_info(pathToImageFile);
+		const auto levelSize = static_cast<size_t>(info.width) * info.height * 4;
+
+		const auto mipLevels = generateMipChain ? helpers::get_mip_level_count(info.width, info.height) : 1u;
+		const bool blitMipChain = mipLevels > 1 && uploadEngine.supports_blits() && helpers::is_linear_blit_supported(physicalDevice, format);
+		const bool decodeIntoStaging = (1 == mipLevels || blitMipChain) && levelSize <= uploadEngine.staging_buffer_size();
+
+		// Unless decoding straight into the staging ring, decode before creating the image => a broken file leaves nothing behind:
+		std::vector<uint8_t> pixels;
+		if (!decodeIntoStaging) {
+			pixels.resize(levelSize);
+			helpers::decode_image(pathToImageFile, info, texel_order::rgba, pixels.data());
+		}
+
+		auto [image, memory] = helpers::create_image(device, physicalDevice, 
+			info.width, info.height, format,
+			usageFlags | vk::ImageUsageFlagBits::eTransferDst | (blitMipChain ? vk::ImageUsageFlagBits::eTransferSrc : vk::ImageUsageFlags{}),
+			mipLevels
+		);
+
+		if (1 == mipLevels || blitMipChain) {
+			if (decodeIntoStaging) {
+				// Decode straight into the staging ring, which level 0 is copied from. Only once that succeeded, the copy is recorded:
+				auto staging = uploadEngine.reserve_image_level_upload(image, 0u, 0u, info.width, info.height, 1u, 4u,
+					vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+				);
+				try {
+					helpers::decode_image(pathToImageFile, info, texel_order::rgba, static_cast<uint8_t*>(staging));
+				}
+				catch (...) {
+					uploadEngine.cancel_reserved_upload();
+					helpers::destroy_image(device, image);
+					helpers::free_memory(device, memory);
+					throw;
+				}
+				uploadEngine.commit_reserved_upload();
+			}
+			else {
+				// Larger than the staging ring => uploaded from CPU memory in chunks:
+				uploadEngine.enqueue_image_upload(pixels.data(), pixels.size(), image, info.width, info.height, 4u,
+					vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+				);
+			}
+			if (blitMipChain) {
+				uploadEngine.enqueue_mip_chain_generation(image, info.width, info.height, mipLevels,
+					vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+				);
+			}
+		}
+		else {
+			// No linear blits for this format => filter on the CPU, and upload every level:
+			const auto levels = helpers::generate_mip_chain_rgba8(pixels.data(), info.width, info.height);
+			for (uint32_t level = 0; level < mipLevels; ++level) {
+				uploadEngine.enqueue_image_level_upload(levels[level].data(), levels[level].size(), image, level, 0u,
+					std::max(1u, info.width >> level), std::max(1u, info.height >> level), 1u, 4u,
+					vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+				);
+			}
+		}
+
+		// Don't submit here. Whoever loads many images, gets them all into one batch:
+		return std::make_tuple(image, memory, static_cast<int>(info.width), static_cast<int>(info.height), uploadEngine.current_token());
+	}
+
+	bool is_linear_blit_supported(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Format format)
+	{
+		const auto required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		return required == (physicalDevice.getFormatProperties(format).optimalTilingFeatures & required);
+	}
+
+	std::tuple<vk::Image, memory_allocation> create_image(
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
-		const uint32_t width, const uint32_t height, const vk::Format format, const vk::ImageUsageFlags usageFlags)
+		const uint32_t width, const uint32_t height, const vk::Format format, const vk::ImageUsageFlags usageFlags,
+		const uint32_t mipLevels,
+		const uint32_t arrayLayers,
+		const memory_category category)
 	{
 		auto createInfo = vk::ImageCreateInfo{}
 			.setImageType(vk::ImageType::e2D)
 			.setExtent({width, height, 1u})
-			.setMipLevels(1u)
-			.setArrayLayers(1u)
+			.setMipLevels(mipLevels)
+			.setArrayLayers(arrayLayers)
 			.setFormat(format)
 			.setTiling(vk::ImageTiling::eOptimal)			// We just create all images in optimal tiling layout
 			.setInitialLayout(vk::ImageLayout::eUndefined)	// Initially, the layout is undefined
@@ -417,35 +804,10 @@ namespace helpers
 
 		auto memoryRequirements = device.getImageMemoryRequirements(image);
 
-		auto memoryAllocInfo = vk::MemoryAllocateInfo{}
-			.setAllocationSize(memoryRequirements.size)
-			.setMemoryTypeIndex([&]() {
-					// Get memory types supported by the physical device:
-					auto memoryProperties = physicalDevice.getMemoryProperties();
-			
-					// In search for a suitable memory type INDEX:
-					for (uint32_t i = 0u; i < memoryProperties.memoryTypeCount; ++i) {
-						
-						// Is this kind of memory suitable for our buffer?
-						const auto bitmask = memoryRequirements.memoryTypeBits;
-						const auto bit = 1 << i;
-						if (0 == (bitmask & bit)) {
-							continue; // => nope
-						}
-						
-						// Does this kind of memory support our usage requirements?
-						if ((memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal) // In contrast to our host-coherent buffers, we just assume that we want all our images to live in device memory
-								!= vk::MemoryPropertyFlags{}) {
-							// Return the INDEX of a suitable memory type
-							return i;
-						}
-					}
-					throw std::runtime_error("Couldn't find suitable memory.");
-				}());
-
-		auto memory = device.allocateMemory(memoryAllocInfo);
-
-		device.bindImageMemory(image, memory, 0);
+		// In contrast to our host-coherent buffers, we just assume that we want all our images to live in device memory
+		auto memory = helpers::allocate_device_local_memory_for_given_requirements(physicalDevice, device, memoryRequirements, resource_tiling::optimal, category);
+
+		device.bindImageMemory(image, memory.memory, memory.offset);
 
 		return std::make_tuple(image, memory);
 	}
@@ -460,13 +822,18 @@ namespace helpers
 	vk::ImageView create_image_view(
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
-		const vk::Image image, const vk::Format format, const vk::ImageAspectFlags imageAspectFlags)
+		const vk::Image image, const vk::Format format, const vk::ImageAspectFlags imageAspectFlags,
+		const uint32_t mipLevels,
+		const uint32_t arrayLayers,
+		const vk::ImageViewType viewType,
+		const vk::ComponentMapping components)
 	{
 		auto createInfo = vk::ImageViewCreateInfo{}
 			.setImage(image)
-			.setViewType(vk::ImageViewType::e2D)
+			.setViewType(viewType)
 			.setFormat(format)
-			.setSubresourceRange({imageAspectFlags, 0u, 1u, 0u, 1u});
+			.setComponents(components)
+			.setSubresourceRange({imageAspectFlags, 0u, mipLevels, 0u, arrayLayers});
 
 		auto imageView = device.createImageView(createInfo);
 
@@ -480,30 +847,42 @@ namespace helpers
 		device.destroyImageView(imageView);
 	}
 
+	std::vector<uint32_t> read_spirv_file(const std::string& path)
+	{
+		constexpr uint32_t SpirvMagicNumber = 0x07230203u;
+
+		// Read straight into 32-bit words, which is what vk::ShaderModuleCreateInfo takes; the memory of a std::vector<char>
+		// isn't guaranteed to be aligned for uint32_t:
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error("Couldn't open shader file '" + path + "'");
+		}
+		const auto fileSize = static_cast<size_t>(file.tellg());
+		if (0 == fileSize || 0 != fileSize % sizeof(uint32_t)) {
+			throw std::runtime_error("'" + path + "' is not a SPIR-V file: its size of " + std::to_string(fileSize) + " bytes is not a multiple of 4");
+		}
+		std::vector<uint32_t> code(fileSize / sizeof(uint32_t));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(fileSize));
+		if (!file) {
+			throw std::runtime_error("Couldn't read shader file '" + path + "'");
+		}
+		if (SpirvMagicNumber != code.front()) {
+			throw std::runtime_error("'" + path + "' is not a SPIR-V file: wrong magic number");
+		}
+		return code;
+	}
+
 	std::tuple<vk::ShaderModule, vk::PipelineShaderStageCreateInfo> load_shader_and_create_shader_module_and_stage_info(
 		const vk::Device device,
 		const std::string path,
 		const vk::ShaderStageFlagBits shaderStage)
 	{
-		// This code is borrowed from Alexander Overvoorde's Vulkan Tutorial, it has been modified slightly:
-		
-		std::ifstream file(path, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open()) {
-            throw std::runtime_error("failed to open file!");
-        }
-
-        size_t fileSize = (size_t) file.tellg();
-        std::vector<char> buffer(fileSize);
-
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-
-        file.close();
+		const auto code = read_spirv_file(path);
 
         auto moduleCreateInfo = vk::ShaderModuleCreateInfo{}
-			.setCodeSize(buffer.size())
-			.setPCode(reinterpret_cast<const uint32_t*>(buffer.data()));
+			.setCodeSize(code.size() * sizeof(uint32_t))
+			.setPCode(code.data());
 
         auto shaderModule = device.createShaderModule(moduleCreateInfo);
 
@@ -522,11 +901,12 @@ namespace helpers
 		device.destroyShaderModule(shaderModule);
 	}
 
-	std::tuple<vk::Buffer, vk::DeviceMemory> create_host_coherent_buffer_and_memory(
+	std::tuple<vk::Buffer, memory_allocation> create_host_coherent_buffer_and_memory(
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
 		const size_t bufferSize, 
-		const vk::BufferUsageFlags bufferUsageFlags)
+		const vk::BufferUsageFlags bufferUsageFlags,
+		const memory_category category)
 	{
 		// Describe a new buffer:
 		auto createInfo = vk::BufferCreateInfo{}
@@ -535,10 +915,30 @@ namespace helpers
 		auto buffer = device.createBuffer(createInfo);
 
 		// Allocate the memory (we want host-coherent memory):
-		auto memory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, createInfo.size, device.getBufferMemoryRequirements(buffer));
+		auto memory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, createInfo.size, device.getBufferMemoryRequirements(buffer), category);
 
 		// Bind the buffer handle to the memory:
-		device.bindBufferMemory(buffer, memory, 0); 
+		device.bindBufferMemory(buffer, memory.memory, memory.offset); 
+
+		return std::make_tuple(buffer, memory);
+	}
+
+	std::tuple<vk::Buffer, memory_allocation> create_device_local_buffer_and_memory(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		const size_t bufferSize, 
+		const vk::BufferUsageFlags bufferUsageFlags,
+		const memory_category category)
+	{
+		// Describe a new buffer; it will be filled via a transfer:
+		auto createInfo = vk::BufferCreateInfo{}
+			.setSize(static_cast<vk::DeviceSize>(bufferSize))
+			.setUsage(bufferUsageFlags | vk::BufferUsageFlagBits::eTransferDst);
+		auto buffer = device.createBuffer(createInfo);
+
+		// Allocate device-local memory and bind the buffer handle to it:
+		auto memory = helpers::allocate_device_local_memory_for_given_requirements(physicalDevice, device, device.getBufferMemoryRequirements(buffer), resource_tiling::linear, category);
+		device.bindBufferMemory(buffer, memory.memory, memory.offset); 
 
 		return std::make_tuple(buffer, memory);
 	}
@@ -547,11 +947,10 @@ namespace helpers
 		const vk::Device device,
 		const size_t dataSize,
 		const void* data, 
-		vk::DeviceMemory memory)
+		const memory_allocation& memory)
 	{
-		auto clearColorMappedMemory = device.mapMemory(memory, 0, dataSize);
-		memcpy(clearColorMappedMemory, data, dataSize);
-		device.unmapMemory(memory);
+		assert(nullptr != memory.mappedData && dataSize <= memory.size);
+		memcpy(memory.mappedData, data, dataSize);
 	}
 	
 }
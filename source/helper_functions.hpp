@@ -14,6 +14,10 @@ namespace helpers
 	// Initialize Vulkan, and request enable the standard validation layers
 	vk::Instance create_vulkan_instance_with_validation_layers();
 
+	// Initialize Vulkan without any window system integration, e.g. for headless rendering on machines without
+	// a display (software ICDs such as lavapipe work, too). The validation layers are only enabled if they are installed.
+	vk::Instance create_headless_vulkan_instance();
+
 	// Destroy a vulkan instance that has been created with CreateVulkanInstanceWithValidationLayers
 	void destroy_vulkan_instance(vk::Instance vulkanInstance);
 
@@ -26,19 +30,52 @@ namespace helpers
 	// Create a surface that has been created with CreateSurface
 	void destroy_surface(const vk::Instance vulkanInstance, VkSurfaceKHR surface);
 
-	// For the given queue flags, find a suitable queue family
+	// For the given queue flags, find a suitable queue family.
+	// Pass VK_NULL_HANDLE as <surfaceToBeSupported> if presentation is not required (headless rendering).
 	uint32_t find_queue_family_index_for_parameters(
 		const vk::PhysicalDevice physicalDevice,
 		const VkSurfaceKHR surfaceToBeSupported,
 		const vk::QueueFlags operationsToBeSupported
 	);
 
-	// Create a logical device, which will serve as our interface to a physical device
+	// Create a logical device, which will serve as our interface to a physical device.
+	// Without a surface (VK_NULL_HANDLE), the swapchain extension is not enabled.
 	vk::Device create_logical_device(
 		const vk::PhysicalDevice physicalDevice,
 		const VkSurfaceKHR surfaceToBeSupported
 	);
 
+	// The queue families to request queues from. If the device has no dedicated transfer or compute family,
+	// those indices are the same as the graphics family's, i.e. all work goes to one single queue.
+	struct queue_family_indices
+	{
+		uint32_t graphics;	// Graphics, compute, and transfer (and present, if a surface has been given)
+		uint32_t transfer;	// A transfer-only family (usually a DMA engine which runs concurrently to the graphics queue)
+		uint32_t compute;	// A compute family without graphics, for async compute
+	};
+
+	// Find a graphics family as find_queue_family_index_for_parameters does, plus dedicated transfer and compute families
+	// if the device has them. Transfer families are only used if they can copy images at texel granularity.
+	queue_family_indices find_queue_family_indices(
+		const vk::PhysicalDevice physicalDevice,
+		const VkSurfaceKHR surfaceToBeSupported
+	);
+
+	// Does the device support the descriptor indexing features which bindless_texture_table requires?
+	// (Non-uniformly indexed, partially bound, update-after-bind arrays of sampled images.)
+	bool is_descriptor_indexing_supported(const vk::PhysicalDevice physicalDevice);
+
+	// Create a logical device with one queue of each of the (distinct) given families.
+	// Without a surface (VK_NULL_HANDLE), the swapchain extension is not enabled.
+	// With <enableDescriptorIndexing>, VK_EXT_descriptor_indexing and the features which bindless_texture_table requires
+	// are enabled -- if the device supports them (see is_descriptor_indexing_supported), otherwise they are silently left out.
+	vk::Device create_logical_device(
+		const vk::PhysicalDevice physicalDevice,
+		const VkSurfaceKHR surfaceToBeSupported,
+		const queue_family_indices& queueFamilies,
+		const bool enableDescriptorIndexing = false
+	);
+
 	// Destroy a logical device that has been created with CreateLogicalDevice
 	void destroy_logical_device(vk::Device device);
 
@@ -49,6 +86,33 @@ namespace helpers
 		const vk::Device logcialDevice
 	);
 
+	// A queue and the family it belongs to
+	struct device_queue
+	{
+		uint32_t familyIndex;
+		vk::Queue queue;
+	};
+
+	// The queues of a device that has been created with the given queue families. Where there is no dedicated family,
+	// the graphics queue is returned in its place -- the very same vk::Queue, which must not be submitted to from
+	// multiple threads at once. Resources which are used by queues of different families need ownership transfers
+	// (see upload_engine), unless they have been created with vk::SharingMode::eConcurrent.
+	struct device_queues
+	{
+		device_queue graphics;
+		device_queue transfer;
+		device_queue compute;
+
+		bool has_dedicated_transfer() const { return transfer.familyIndex != graphics.familyIndex; }
+		bool has_async_compute() const { return compute.familyIndex != graphics.familyIndex; }
+	};
+
+	// Get one queue of each of the given families
+	device_queues get_device_queues(
+		const vk::Device device,
+		const queue_family_indices& queueFamilies
+	);
+
 	// Allocate a command buffer from the given command pool
 	vk::CommandBuffer allocate_command_buffer(
 		const vk::Device device,
@@ -64,25 +128,40 @@ namespace helpers
 	
 	// Allocate "host coherent" memory, which is accessible from both, the CPU-side (host) and the GPU-side (device).
 	// !! Host coherent memory will automatically be made available on the the device on queue-submits !!
-	vk::DeviceMemory allocate_host_coherent_memory_for_given_requirements(
+	// The memory is sub-allocated from the device's memory arena (see get_memory_arena) and is persistently mapped.
+	// Bind it with: device.bindBufferMemory(buffer, allocation.memory, allocation.offset)
+	// <category> is what the memory arena's telemetry counts the allocation as.
+	memory_allocation allocate_host_coherent_memory_for_given_requirements(
 		const vk::PhysicalDevice physicalDevice,
 		const vk::Device device,
 		const vk::DeviceSize bufferSize,
-		const vk::MemoryRequirements memoryRequirements
+		const vk::MemoryRequirements memoryRequirements,
+		const memory_category category = memory_category::other
 	);
 
-	// Load an image from a file, and copy it into a newly created buffer (backed with memory already):
-	// Returns a tuple with: <0> the buffer handle, <1> the memory handle, <2> width, <3> height
-	std::tuple<vk::Buffer, vk::DeviceMemory, int, int> load_image_into_host_coherent_buffer(
+	// Allocate "device local" memory, which is the fastest kind of memory for the GPU to access,
+	// but usually not accessible from the CPU-side. Sub-allocated from the device's memory arena.
+	memory_allocation allocate_device_local_memory_for_given_requirements(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const vk::MemoryRequirements memoryRequirements,
+		const resource_tiling tiling,
+		const memory_category category = memory_category::other
+	);
+
+	// Load an image from a file, and decode it directly into a newly created buffer (backed with memory already), in BGRA order.
+	// See load_images_into_host_coherent_buffers for loading many images in parallel.
+	// Returns a tuple with: <0> the buffer handle, <1> the memory allocation, <2> width, <3> height
+	std::tuple<vk::Buffer, memory_allocation, int, int> load_image_into_host_coherent_buffer(
 		const vk::PhysicalDevice physicalDevice,
 		const vk::Device device,
 		const std::string pathToImageFile
 	);
 
-	// Free memory that has been allocated with AllocateHostCoherentMemoryForBuffer
+	// Free memory that has been allocated with one of the helper functions, i.e. return it to the memory arena
 	void free_memory(
 		const vk::Device device,
-		vk::DeviceMemory memory
+		const memory_allocation& memory
 	);
 
 	// Destroy buffers that have been created with one of the helper functions
@@ -101,6 +180,7 @@ namespace helpers
 	//  - image
 	//  - oldLayout
 	//  - newLayout
+	//  - subresourceRange (by default, the first mip level of the first array layer)
 	//  
 	// This is a convenience function. Feel free to manually create the barrier using vkCmdPipelineBarrier.
 	// 
@@ -114,18 +194,79 @@ namespace helpers
 		const vk::PipelineStageFlags srcPipelineStage, const vk::PipelineStageFlags dstPipelineStage,
 		const vk::AccessFlags srcAccessMask, const vk::AccessFlags dstAccessMask,
 		const vk::Image image,
-		const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout
+		const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout,
+		const vk::ImageSubresourceRange subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0u, 1u, 0u, 1u }
 	);
 
+	// The aspects of an image of the given format: color, or depth and/or stencil. Use it for subresource ranges
+	// which cover whole images, e.g. in barriers of depth images.
+	vk::ImageAspectFlags get_image_aspect_flags(const vk::Format format);
+
 	// Record copying a buffer to an image into the given command buffer.
 	// !! This function assumes the image to be in vk::ImageLayout::eTransferDstOptimal layout !!
+	// <bufferRowLength> is the number of texels per row in the buffer, if it has more than <width> (0 => <width>).
 	//
 	// This is a convenience function. Feel free to manually perform the copy using vkCmdCopyBufferToImage.
 	// 
 	void copy_buffer_to_image(
 		const vk::CommandBuffer commandBuffer,
 		const vk::Buffer buffer,
-		const vk::Image image, const uint32_t width, const uint32_t height
+		const vk::Image image, const uint32_t width, const uint32_t height,
+		const uint32_t bufferRowLength = 0u
+	);
+
+	// CPU-side vertex data of a 3D model. If <indices> is empty, the mesh is not indexed, i.e. there is
+	// one vertex per face corner; otherwise, <indices> describes a triangle list.
+	struct mesh_data
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> textureCoordinates;
+		std::vector<glm::vec3> normals;
+		std::vector<uint32_t> indices;
+	};
+
+	// A mesh whose vertex (and index) data lives in device-local buffers.
+	// Full-precision meshes (upload_mesh_data) have one buffer per attribute; encoded meshes (upload_encoded_mesh)
+	// store all of their vertex bindings in <vertexBuffer> at <vertexBindingOffsets>. Use bind_device_mesh either way.
+	struct device_mesh
+	{
+		size_t vertexCount = 0;
+		size_t indexCount = 0;	// 0 if the mesh is not indexed
+		vk::IndexType indexType = vk::IndexType::eUint32;
+		vertex_format vertexFormat;
+		glm::vec3 positionScale{ 1.0f };	// Dequantization transform for snorm16 positions
+		glm::vec3 positionOffset{ 0.0f };
+		vk::Buffer positionsBuffer;
+		memory_allocation positionsMemory;
+		vk::Buffer textureCoordinatesBuffer;
+		memory_allocation textureCoordinatesMemory;
+		vk::Buffer normalsBuffer;
+		memory_allocation normalsMemory;
+		vk::Buffer vertexBuffer;
+		memory_allocation vertexMemory;
+		std::vector<vk::DeviceSize> vertexBindingOffsets;
+		vk::Buffer indexBuffer;
+		memory_allocation indexMemory;
+	};
+
+	// Should the submesh (i.e. the .obj group/object) with the given name be skipped when loading a model?
+	bool is_submesh_excluded(const std::string& submeshName, const std::string& submeshNamesToExclude);
+
+	// Write one vertex per face corner of an .obj model into the given, pre-sized output arrays.
+	// <vertices>, <texcoords>, and <normals> are the flat attribute arrays as parsed from the file (3, 2, and 3 floats
+	// per element); the v texture coordinate is flipped to match Vulkan's texture coordinate origin.
+	// Corners without texture coordinates or normals get zeros for them (before flipping).
+	void expand_obj_corners(
+		const tinyobj::index_t* corners, const size_t cornerCount,
+		const float* vertices, const float* texcoords, const float* normals,
+		glm::vec3* outPositions, glm::vec2* outTextureCoordinates, glm::vec3* outNormals
+	);
+
+	// Loads the given 3D .obj model from file into CPU memory (positions, texture coordinates, and normals)
+	// using tinyobj. This is the single-threaded reference for load_mesh_data_of_obj_parallel, which the loaders below use.
+	mesh_data load_mesh_data_of_obj(
+		const std::string modelPath,
+		const std::string submeshNamesToExclude = ""
 	);
 
 	// Loads the given 3D .obj model from file, and load its positions (vec3) and texture
@@ -133,22 +274,111 @@ namespace helpers
 	// Returs a tuple containing:
 	//  <0>: The number of vertices that the loaded model consists of and that have been stored into the buffers
 	//  <1>: the buffer handle to the positions buffer
-	//  <2>: memory handle to the position buffer's backing memory
+	//  <2>: memory allocation of the position buffer's backing memory
 	//  <3>: the buffer handle to the texture coordinates buffer
-	//  <4>: memory handle to the texture coordinates buffer's backing memory
-	std::tuple<size_t, vk::Buffer, vk::DeviceMemory, vk::Buffer, vk::DeviceMemory, vk::Buffer, vk::DeviceMemory> load_positions_and_texture_coordinates_and_normals_of_obj(
+	//  <4>: memory allocation of the texture coordinates buffer's backing memory
+	//  <5>: the buffer handle to the normals buffer
+	//  <6>: memory allocation of the normals buffer's backing memory
+	std::tuple<size_t, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation> load_positions_and_texture_coordinates_and_normals_of_obj(
 		const std::string modelPath,
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
 		const std::string submeshNamesToExclude = ""
 	);
 
-	// Creates a new image with backing memory
-	// Returns a tuple containing <0>: the image handle, <1>: the handle to the image's memory
-	std::tuple<vk::Image, vk::DeviceMemory> create_image(
+	// Loads the given 3D .obj model from file, and uploads its positions, texture coordinates, and normals
+	// into three newly created, device-local vertex buffers through the given upload engine.
+	// Returns the same as the host-coherent variant above, plus:
+	//  <7>: the upload token which must have completed before the buffers may be used
+	std::tuple<size_t, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation, vk::Buffer, memory_allocation, upload_token> load_positions_and_texture_coordinates_and_normals_of_obj(
+		const std::string modelPath,
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
-		const uint32_t width, const uint32_t height, const vk::Format format, const vk::ImageUsageFlags usageFlags
+		upload_engine& uploadEngine,
+		const std::string submeshNamesToExclude = ""
+	);
+
+	// Create device-local buffers for the given mesh data and enqueue their uploads into the upload engine's current batch.
+	// Indices are stored as 16-bit values if the vertex count allows it, and as 32-bit values otherwise.
+	// The uploads are not submitted; the buffers may be used once uploadEngine.current_token() has completed.
+	device_mesh upload_mesh_data(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const mesh_data& mesh
+	);
+
+	// Same as upload_mesh_data, but for vertex streams which are stored anywhere in memory (e.g. in a mapped file).
+	// <indices> may be nullptr if <indexCount> is 0.
+	device_mesh upload_mesh_streams(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const size_t vertexCount,
+		const glm::vec3* positions,
+		const glm::vec2* textureCoordinates,
+		const glm::vec3* normals,
+		const size_t indexCount,
+		const uint32_t* indices
+	);
+
+	// Create one device-local buffer for the given encoded vertices (all bindings in one allocation), plus an index
+	// buffer if <indices> is not empty, and enqueue their uploads into the upload engine's current batch (not submitted).
+	device_mesh upload_encoded_mesh(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const encoded_vertices& vertices,
+		const std::vector<uint32_t>& indices
+	);
+
+	// Bind the mesh's vertex buffers (starting at <firstBinding>, matching get_vertex_input_descriptions of its vertex format)
+	// and its index buffer, if it has one
+	void bind_device_mesh(
+		const vk::CommandBuffer commandBuffer,
+		const device_mesh& mesh,
+		const uint32_t firstBinding = 0u
+	);
+
+	// Destroy the buffers of a mesh that has been created with upload_mesh_data or upload_encoded_mesh, and free their memory
+	void destroy_device_mesh(
+		const vk::Device device,
+		device_mesh& mesh
+	);
+
+	// Load an image from a file into a newly created, device-local image (format eR8G8B8A8Unorm) through the given upload engine.
+	// The upload is enqueued into the upload engine's current batch, but not submitted, s.t. multiple images can be batched.
+	// Level 0 is decoded straight into the upload engine's staging ring, unless it is larger than the ring.
+	// If <generateMipChain> is set, the image gets a full mip chain (get_mip_level_count(width, height) levels), which is generated
+	// on the GPU by blitting, or on the CPU if the format or the upload engine's queue doesn't support linear blits. After the upload, all levels are in
+	// eShaderReadOnlyOptimal layout. If the file can't be decoded, throws without leaving an image or an upload behind.
+	// Returns a tuple with: <0> the image handle, <1> the memory allocation, <2> width, <3> height, <4> the upload token
+	std::tuple<vk::Image, memory_allocation, int, int, upload_token> load_image_into_device_local_image(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		upload_engine& uploadEngine,
+		const std::string pathToImageFile,
+		const vk::ImageUsageFlags usageFlags = vk::ImageUsageFlagBits::eSampled,
+		const bool generateMipChain = true
+	);
+
+	// Can images of the given format (in optimal tiling) be both source and destination of blits with linear filtering?
+	// This is required for generating mip chains on the GPU (see upload_engine::enqueue_mip_chain_generation).
+	bool is_linear_blit_supported(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Format format
+	);
+
+	// Creates a new image with backing memory, optionally with multiple mip levels and/or array layers.
+	// Pass memory_category::render_target for images which are rendered into.
+	// Returns a tuple containing <0>: the image handle, <1>: the image's memory allocation
+	std::tuple<vk::Image, memory_allocation> create_image(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		const uint32_t width, const uint32_t height, const vk::Format format, const vk::ImageUsageFlags usageFlags,
+		const uint32_t mipLevels = 1u,
+		const uint32_t arrayLayers = 1u,
+		const memory_category category = memory_category::texture
 	);
 
 	// Destroy an image that has been created using the helper functions
@@ -157,11 +387,19 @@ namespace helpers
 		vk::Image image
 	);
 
-	// Create an image view to an image
+	// Create an image view to an image, covering the first <mipLevels> mip levels and the first <arrayLayers> array layers.
+	// Pass VK_REMAINING_MIP_LEVELS to cover all mip levels of the image.
+	// Use vk::ImageViewType::e2DArray for array textures (e.g. sampler2DArray in GLSL).
+	// <components> can swizzle the channels for free while sampling, e.g. to read BGRA texels from an RGBA image:
+	//   vk::ComponentMapping{ vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eG, vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eA }
 	vk::ImageView create_image_view(
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
-		const vk::Image image, const vk::Format format, const vk::ImageAspectFlags imageAspectFlags
+		const vk::Image image, const vk::Format format, const vk::ImageAspectFlags imageAspectFlags,
+		const uint32_t mipLevels = 1u,
+		const uint32_t arrayLayers = 1u,
+		const vk::ImageViewType viewType = vk::ImageViewType::e2D,
+		const vk::ComponentMapping components = vk::ComponentMapping{}
 	);
 
 	// Destroy an image view that has been created using the helper functions
@@ -170,6 +408,10 @@ namespace helpers
 		vk::ImageView imageView
 	);
 
+	// Read a SPIR-V binary from file. Throws if the file can't be read, or if it isn't SPIR-V (its size isn't a multiple
+	// of four bytes, or it doesn't start with the SPIR-V magic number).
+	std::vector<uint32_t> read_spirv_file(const std::string& path);
+
 	// Load a shader from file and create a shader module
 	std::tuple<vk::ShaderModule, vk::PipelineShaderStageCreateInfo> load_shader_and_create_shader_module_and_stage_info(
 		const vk::Device device,
@@ -184,19 +426,30 @@ namespace helpers
 	);
 
 	// Create a host coherent buffer with backing memory
-	std::tuple<vk::Buffer, vk::DeviceMemory> create_host_coherent_buffer_and_memory(
+	std::tuple<vk::Buffer, memory_allocation> create_host_coherent_buffer_and_memory(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		const size_t bufferSize, 
+		const vk::BufferUsageFlags bufferUsageFlags,
+		const memory_category category = memory_category::staging
+	);
+
+	// Create a device-local buffer with backing memory. The buffer can be filled via transfers (see upload_engine).
+	std::tuple<vk::Buffer, memory_allocation> create_device_local_buffer_and_memory(
 		const vk::Device device,
 		const vk::PhysicalDevice physicalDevice,
 		const size_t bufferSize, 
-		const vk::BufferUsageFlags bufferUsageFlags
+		const vk::BufferUsageFlags bufferUsageFlags,
+		const memory_category category = memory_category::other
 	);
 
 	// Copy data of the gifen size into the buffer
+	// (Host coherent allocations are persistently mapped, hence, this is just a memcpy)
 	void copy_data_into_host_coherent_memory(
 		const vk::Device device,
 		const size_t dataSize,
 		const void* data, 
-		vk::DeviceMemory memory
+		const memory_allocation& memory
 	);
 	
 }
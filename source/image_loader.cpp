@@ -0,0 +1,194 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// Where the texels of an uncompressed 32-bit TGA file are, and how they are laid out
+		struct tga_layout
+		{
+			image_info info;
+			size_t pixelOffset = 0;
+			bool bottomUp = true;
+		};
+
+		bool has_tga_extension(const std::string& path)
+		{
+			auto extension = std::filesystem::path(path).extension().string();
+			return extension == ".tga" || extension == ".TGA";
+		}
+
+		// TGA files have no magic number => only ever called for files with a .tga extension.
+		// Everything but uncompressed, 32-bit, left-to-right true color images is left to stb_image.
+		bool try_get_uncompressed_tga_layout(const uint8_t* file, const size_t fileSize, tga_layout& outLayout)
+		{
+			constexpr size_t HeaderSize = 18;
+			if (fileSize < HeaderSize) {
+				return false;
+			}
+			const auto idLength = file[0];
+			const auto colorMapType = file[1];
+			const auto imageType = file[2];
+			const auto bitsPerPixel = file[16];
+			const auto descriptor = file[17];
+			if (0 != colorMapType || 2 != imageType || 32 != bitsPerPixel || 0 != (descriptor & 0x10)) {
+				return false;
+			}
+
+			outLayout.info.width = static_cast<uint32_t>(file[12] | (file[13] << 8));
+			outLayout.info.height = static_cast<uint32_t>(file[14] | (file[15] << 8));
+			outLayout.pixelOffset = HeaderSize + idLength;
+			outLayout.bottomUp = 0 == (descriptor & 0x20);
+			return 0 != outLayout.info.width && 0 != outLayout.info.height
+				&& fileSize >= outLayout.pixelOffset + static_cast<size_t>(outLayout.info.width) * outLayout.info.height * 4;
+		}
+	}
+
+	image_info get_image_info(const std::string& path)
+	{
+		if (has_tga_extension(path)) {
+			mapped_file file(path);
+			tga_layout layout;
+			if (try_get_uncompressed_tga_layout(file.data(), file.size(), layout)) {
+				return layout.info;
+			}
+		}
+
+		int width, height, channelsInFile;
+		if (0 == stbi_info(path.c_str(), &width, &height, &channelsInFile)) {
+			throw std::runtime_error("Couldn't load image from '" + path + "'");
+		}
+		return image_info{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	}
+
+	void copy_texels_swapping_red_and_blue(const uint8_t* src, uint8_t* dst, const size_t texelCount)
+	{
+		size_t i = 0;
+#if defined(_M_X64) || defined(__SSE2__)
+		// Four texels at a time: keep green and alpha, and move red and blue 16 bits down/up within each 32-bit texel
+		const auto greenAndAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+		const auto lowestByte = _mm_set1_epi32(0x000000FF);
+		for (; i + 4 <= texelCount; i += 4) {
+			const auto texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			const auto swapped = _mm_or_si128(
+				_mm_and_si128(texels, greenAndAlpha),
+				_mm_or_si128(
+					_mm_and_si128(_mm_srli_epi32(texels, 16), lowestByte),
+					_mm_slli_epi32(_mm_and_si128(texels, lowestByte), 16)
+				)
+			);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), swapped);
+		}
+#endif
+		for (; i < texelCount; ++i) {
+			const auto c0 = src[i * 4 + 0], c1 = src[i * 4 + 1], c2 = src[i * 4 + 2], c3 = src[i * 4 + 3];
+			dst[i * 4 + 0] = c2;
+			dst[i * 4 + 1] = c1;
+			dst[i * 4 + 2] = c0;
+			dst[i * 4 + 3] = c3;
+		}
+	}
+
+	void decode_image(
+		const std::string& path,
+		const image_info& info,
+		const texel_order order,
+		uint8_t* destination)
+	{
+		const auto rowSize = static_cast<size_t>(info.width) * 4;
+
+		if (has_tga_extension(path)) {
+			mapped_file file(path);
+			tga_layout layout;
+			if (try_get_uncompressed_tga_layout(file.data(), file.size(), layout)) {
+				if (layout.info.width != info.width || layout.info.height != info.height) {
+					throw std::runtime_error("The dimensions of '" + path + "' have changed");
+				}
+				// The texels are stored in BGRA order, and usually from the bottom row to the top row:
+				for (uint32_t y = 0; y < info.height; ++y) {
+					const auto srcRow = layout.bottomUp ? info.height - 1 - y : y;
+					const auto src = file.data() + layout.pixelOffset + rowSize * srcRow;
+					if (texel_order::bgra == order) {
+						memcpy(destination + rowSize * y, src, rowSize);
+					}
+					else {
+						helpers::copy_texels_swapping_red_and_blue(src, destination + rowSize * y, info.width);
+					}
+				}
+				return;
+			}
+		}
+
+		int width, height, channelsInFile;
+		stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channelsInFile, STBI_rgb_alpha);
+		if (nullptr == pixels) {
+			throw std::runtime_error("Couldn't load image from '" + path + "'");
+		}
+		if (static_cast<uint32_t>(width) != info.width || static_cast<uint32_t>(height) != info.height) {
+			stbi_image_free(pixels);
+			throw std::runtime_error("The dimensions of '" + path + "' have changed");
+		}
+		// stb_image delivers RGBA:
+		if (texel_order::rgba == order) {
+			memcpy(destination, pixels, rowSize * info.height);
+		}
+		else {
+			helpers::copy_texels_swapping_red_and_blue(pixels, destination, static_cast<size_t>(info.width) * info.height);
+		}
+		stbi_image_free(pixels);
+	}
+
+	std::vector<decoded_image> decode_images(
+		const std::vector<std::string>& paths,
+		const texel_order order,
+		const std::function<uint8_t*(size_t imageIndex, const image_info& info)>& getDestination,
+		thread_pool& threadPool)
+	{
+		std::vector<decoded_image> results(paths.size());
+		threadPool.parallel_for(paths.size(), [&](const size_t i) {
+			results[i].info = helpers::get_image_info(paths[i]);
+		});
+
+		std::vector<uint8_t*> destinations(paths.size());
+		for (size_t i = 0; i < paths.size(); ++i) {
+			destinations[i] = getDestination(i, results[i].info);
+		}
+
+		threadPool.parallel_for(paths.size(), [&](const size_t i) {
+			const auto begin = std::chrono::steady_clock::now();
+			helpers::decode_image(paths[i], results[i].info, order, destinations[i]);
+			const auto end = std::chrono::steady_clock::now();
+			results[i].decodeMs = std::chrono::duration<double, std::milli>(end - begin).count();
+		});
+		return results;
+	}
+
+	std::vector<std::tuple<vk::Buffer, memory_allocation, int, int>> load_images_into_host_coherent_buffers(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const std::vector<std::string>& pathsToImageFiles,
+		thread_pool& threadPool)
+	{
+		std::vector<std::tuple<vk::Buffer, memory_allocation, int, int>> result(pathsToImageFiles.size());
+		try {
+			helpers::decode_images(pathsToImageFiles, texel_order::bgra, [&](const size_t i, const image_info& info) {
+				auto [buffer, memory] = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice,
+					static_cast<size_t>(info.width) * info.height * 4, vk::BufferUsageFlagBits::eTransferSrc
+				);
+				result[i] = std::make_tuple(buffer, memory, static_cast<int>(info.width), static_cast<int>(info.height));
+				return static_cast<uint8_t*>(memory.mappedData);
+			}, threadPool);
+		}
+		catch (...) {
+			// decode_images only rethrows after all images have been processed => release every buffer which has been created:
+			for (auto& [buffer, memory, width, height] : result) {
+				if (buffer) {
+					helpers::destroy_buffer(device, buffer);
+					helpers::free_memory(device, memory);
+				}
+			}
+			throw;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+namespace helpers
+{
+	// Order of the four 8-bit channels of loaded texels
+	enum struct texel_order
+	{
+		rgba,	// Matches eR8G8B8A8Unorm; what stb_image delivers
+		bgra	// Matches eB8G8R8A8Unorm, e.g. the swapchain images; what uncompressed TGA files store
+	};
+
+	// Dimensions of an image file
+	struct image_info
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	// Read the dimensions of an image file from its header, without decoding it. Throws if the file can't be read.
+	image_info get_image_info(const std::string& path);
+
+	// Copy <texelCount> 4-channel texels, swapping the first and the third channel (RGBA <=> BGRA) on the way.
+	// <src> and <dst> may be the same. Uses SSE2, if available.
+	void copy_texels_swapping_red_and_blue(const uint8_t* src, uint8_t* dst, const size_t texelCount);
+
+	// Decode an image file into <destination>, which must have room for <info>.width * <info>.height * 4 bytes (see get_image_info),
+	// with four channels in the given order. Uncompressed 32-bit TGA files are copied straight from a file mapping into
+	// <destination>; other formats are decoded by stb_image, and copied (and swizzled, if required) in a single pass.
+	void decode_image(
+		const std::string& path,
+		const image_info& info,
+		const texel_order order,
+		uint8_t* destination
+	);
+
+	// Dimensions of one image of a batch, and how long it took to decode it
+	struct decoded_image
+	{
+		image_info info;
+		double decodeMs = 0.0;
+	};
+
+	// Decode many images in parallel: First, all headers are read in parallel. Then, <getDestination> is invoked for each image
+	// (sequentially, on the calling thread, s.t. it may allocate), and must return where to decode the image's texels to.
+	// Finally, all images are decoded in parallel, each one directly into its destination.
+	std::vector<decoded_image> decode_images(
+		const std::vector<std::string>& paths,
+		const texel_order order,
+		const std::function<uint8_t*(size_t imageIndex, const image_info& info)>& getDestination,
+		thread_pool& threadPool = get_thread_pool()
+	);
+
+	// Batch variant of load_image_into_host_coherent_buffer: Decodes the images in parallel, directly into the
+	// (persistently mapped) memory of newly created host-coherent buffers, in BGRA order. If any image fails to decode, all
+	// buffers are released again before the exception is rethrown.
+	// Returns one tuple per image, with: <0> the buffer handle, <1> the memory allocation, <2> width, <3> height
+	std::vector<std::tuple<vk::Buffer, memory_allocation, int, int>> load_images_into_host_coherent_buffers(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const std::vector<std::string>& pathsToImageFiles,
+		thread_pool& threadPool = get_thread_pool()
+	);
+}
@@ -0,0 +1,254 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// World space bounding sphere of an instance. The radius is scaled by the largest axis scale of the model
+		// matrix, s.t. the sphere stays conservative under non-uniform scaling. (Same math as cull_instances.comp.)
+		glm::vec4 get_world_bounding_sphere(const instance_data& instance)
+		{
+			const auto center = glm::vec3(instance.model * glm::vec4(glm::vec3(instance.boundingSphere), 1.0f));
+			const auto scale = std::max(std::max(glm::length(glm::vec3(instance.model[0])), glm::length(glm::vec3(instance.model[1]))), glm::length(glm::vec3(instance.model[2])));
+			return glm::vec4(center, instance.boundingSphere.w * scale);
+		}
+	}
+
+	frustum extract_frustum_planes(const glm::mat4& viewProjection)
+	{
+		// Gribb/Hartmann: the planes are sums and differences of the rows of the matrix (glm is column-major => m[column][row]):
+		auto row = [&viewProjection](const int r) {
+			return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+		};
+		frustum result;
+		result.planes[0] = row(3) + row(0);	// Left:   -w <= x
+		result.planes[1] = row(3) - row(0);	// Right:   x <= w
+		result.planes[2] = row(3) + row(1);	// Bottom: -w <= y
+		result.planes[3] = row(3) - row(1);	// Top:     y <= w
+		result.planes[4] = row(2);			// Near:    0 <= z (GLM_FORCE_DEPTH_ZERO_TO_ONE)
+		result.planes[5] = row(3) - row(2);	// Far:     z <= w
+		for (auto& plane : result.planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return result;
+	}
+
+	bool is_sphere_in_frustum(const frustum& frustum, const glm::vec3& center, const float radius)
+	{
+		for (const auto& plane : frustum.planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	glm::vec4 compute_bounding_sphere(const std::vector<glm::vec3>& positions)
+	{
+		if (positions.empty()) {
+			return glm::vec4{ 0.0f };
+		}
+		auto minimum = positions.front();
+		auto maximum = positions.front();
+		for (const auto& p : positions) {
+			minimum = glm::min(minimum, p);
+			maximum = glm::max(maximum, p);
+		}
+		const auto center = (minimum + maximum) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (const auto& p : positions) {
+			const auto d = p - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+		}
+		return glm::vec4(center, std::sqrt(radiusSquared));
+	}
+
+	void cull_instances(
+		const frustum& frustum,
+		const instance_data* instances,
+		const size_t instanceCount,
+		std::vector<uint32_t>& outVisibleInstances)
+	{
+		outVisibleInstances.clear();
+		for (size_t i = 0; i < instanceCount; ++i) {
+			const auto sphere = get_world_bounding_sphere(instances[i]);
+			if (is_sphere_in_frustum(frustum, glm::vec3(sphere), sphere.w)) {
+				outVisibleInstances.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+
+	instance_culler::instance_culler(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		pipeline_cache& pipelineCache,
+		const uint32_t maxInstances,
+		const uint32_t framesInFlight,
+		const uint32_t indexCount,
+		const uint32_t firstIndex,
+		const int32_t vertexOffset)
+		: mDevice{ device }
+		, mMaxInstances{ maxInstances }
+		, mDrawCommand{ indexCount, 0u, firstIndex, vertexOffset, 0u }
+		, mSlots(framesInFlight)
+	{
+		if (0 == framesInFlight) {
+			throw std::invalid_argument("There must be at least one frame in flight.");
+		}
+		if (0 == maxInstances) {
+			throw std::invalid_argument("An instance culler must have room for at least one instance.");
+		}
+
+		std::tie(mInstanceBuffer, mInstanceMemory) = helpers::create_device_local_buffer_and_memory(device, physicalDevice,
+			sizeof(instance_data) * maxInstances, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, memory_category::mesh
+		);
+
+		// The vertex shader reads the instances and the visible list, too => same layout for both stages:
+		const auto stages = vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex;
+		const std::array<vk::DescriptorSetLayoutBinding, 3> bindings = {{
+			{ 0u, vk::DescriptorType::eStorageBuffer, 1u, stages },
+			{ 1u, vk::DescriptorType::eStorageBuffer, 1u, stages },
+			{ 2u, vk::DescriptorType::eStorageBuffer, 1u, vk::ShaderStageFlagBits::eCompute }
+		}};
+		mDescriptorSetLayout = device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{}
+			.setBindingCount(static_cast<uint32_t>(bindings.size()))
+			.setPBindings(bindings.data())
+		);
+		const auto poolSize = vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, 3u * framesInFlight };
+		mDescriptorPool = device.createDescriptorPool(vk::DescriptorPoolCreateInfo{}
+			.setMaxSets(framesInFlight)
+			.setPoolSizeCount(1u)
+			.setPPoolSizes(&poolSize)
+		);
+
+		for (auto& slot : mSlots) {
+			std::tie(slot.visibleInstancesBuffer, slot.visibleInstancesMemory) = helpers::create_device_local_buffer_and_memory(device, physicalDevice,
+				sizeof(uint32_t) * maxInstances, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc
+			);
+			std::tie(slot.drawCommandBuffer, slot.drawCommandMemory) = helpers::create_device_local_buffer_and_memory(device, physicalDevice,
+				sizeof(vk::DrawIndexedIndirectCommand), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer
+					| vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc
+			);
+
+			slot.descriptorSet = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{}
+				.setDescriptorPool(mDescriptorPool)
+				.setDescriptorSetCount(1u)
+				.setPSetLayouts(&mDescriptorSetLayout)
+			).front();
+			const std::array<vk::DescriptorBufferInfo, 3> bufferInfos = {{
+				{ mInstanceBuffer, 0, VK_WHOLE_SIZE },
+				{ slot.visibleInstancesBuffer, 0, VK_WHOLE_SIZE },
+				{ slot.drawCommandBuffer, 0, VK_WHOLE_SIZE }
+			}};
+			std::vector<vk::WriteDescriptorSet> writes;
+			for (uint32_t b = 0; b < bufferInfos.size(); ++b) {
+				writes.push_back(vk::WriteDescriptorSet{}
+					.setDstSet(slot.descriptorSet)
+					.setDstBinding(b)
+					.setDescriptorCount(1u)
+					.setDescriptorType(vk::DescriptorType::eStorageBuffer)
+					.setPBufferInfo(&bufferInfos[b])
+				);
+			}
+			device.updateDescriptorSets(writes, {});
+		}
+
+		const auto pushConstantRange = vk::PushConstantRange{ vk::ShaderStageFlagBits::eCompute, 0u, sizeof(cull_push_constants) };
+		mPipelineLayout = device.createPipelineLayout(vk::PipelineLayoutCreateInfo{}
+			.setSetLayoutCount(1u)
+			.setPSetLayouts(&mDescriptorSetLayout)
+			.setPushConstantRangeCount(1u)
+			.setPPushConstantRanges(&pushConstantRange)
+		);
+		auto [shaderModule, stageInfo] = helpers::load_shader_and_create_shader_module_and_stage_info(device, "shaders/cull_instances.spv", vk::ShaderStageFlagBits::eCompute);
+		mPipeline = pipelineCache.create_compute_pipeline(vk::ComputePipelineCreateInfo{}
+			.setStage(stageInfo)
+			.setLayout(mPipelineLayout)
+		);
+		helpers::destroy_shader_module(device, shaderModule);
+	}
+
+	instance_culler::~instance_culler()
+	{
+		mDevice.destroyPipeline(mPipeline);
+		mDevice.destroyPipelineLayout(mPipelineLayout);
+		// Destroying the pool also frees the sets:
+		mDevice.destroyDescriptorPool(mDescriptorPool);
+		mDevice.destroyDescriptorSetLayout(mDescriptorSetLayout);
+		for (auto& slot : mSlots) {
+			helpers::destroy_buffer(mDevice, slot.visibleInstancesBuffer);
+			helpers::free_memory(mDevice, slot.visibleInstancesMemory);
+			helpers::destroy_buffer(mDevice, slot.drawCommandBuffer);
+			helpers::free_memory(mDevice, slot.drawCommandMemory);
+		}
+		helpers::destroy_buffer(mDevice, mInstanceBuffer);
+		helpers::free_memory(mDevice, mInstanceMemory);
+	}
+
+	void instance_culler::upload_instances(upload_engine& uploadEngine, const std::vector<instance_data>& instances)
+	{
+		if (instances.size() > mMaxInstances) {
+			throw std::invalid_argument("Too many instances: " + std::to_string(instances.size()) + " (the culler has room for " + std::to_string(mMaxInstances) + ")");
+		}
+		if (!instances.empty()) {
+			uploadEngine.enqueue_buffer_upload(instances.data(), sizeof(instance_data) * instances.size(), mInstanceBuffer, 0,
+				vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead
+			);
+		}
+		mInstanceCount = static_cast<uint32_t>(instances.size());
+	}
+
+	void instance_culler::begin_frame()
+	{
+		mCurrentSlot = static_cast<size_t>(mFrameNumber % mSlots.size());
+		++mFrameNumber;
+	}
+
+	void instance_culler::record_cull(const vk::CommandBuffer commandBuffer, const glm::mat4& viewProjection)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		const auto& slot = mSlots[mCurrentSlot];
+
+		// Start with no visible instances; the cull pass counts them up with atomics:
+		commandBuffer.updateBuffer(slot.drawCommandBuffer, 0, sizeof(mDrawCommand), &mDrawCommand);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {},
+			{ vk::MemoryBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite } }, {}, {});
+
+		if (mInstanceCount > 0) {
+			cull_push_constants pushConstants;
+			pushConstants.planes = extract_frustum_planes(viewProjection).planes;
+			pushConstants.instanceCount = mInstanceCount;
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, mPipeline);
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, mPipelineLayout, 0u, { slot.descriptorSet }, {});
+			commandBuffer.pushConstants(mPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0u, sizeof(pushConstants), &pushConstants);
+			commandBuffer.dispatch((mInstanceCount + WorkgroupSize - 1) / WorkgroupSize, 1u, 1u);
+		}
+
+		// The draw reads the command, and the vertex shader the visible list:
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader, {},
+			{ vk::MemoryBarrier{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead } }, {}, {});
+
+		const auto end = std::chrono::steady_clock::now();
+		++mStatistics.cullPasses;
+		mStatistics.instancesTested += mInstanceCount;
+		mStatistics.recordMs += std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	void instance_culler::record_draw(const vk::CommandBuffer commandBuffer)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		commandBuffer.drawIndexedIndirect(mSlots[mCurrentSlot].drawCommandBuffer, 0, 1u, sizeof(vk::DrawIndexedIndirectCommand));
+		const auto end = std::chrono::steady_clock::now();
+		mStatistics.recordMs += std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	void instance_culler::print_statistics(std::ostream& stream) const
+	{
+		stream << "Instance culler: " << mInstanceCount << " of max. " << mMaxInstances << " instances, "
+			<< mStatistics.cullPasses << " cull passes, " << mStatistics.instancesTested << " instances tested";
+		if (mStatistics.cullPasses > 0) {
+			stream << ", " << mStatistics.recordMs / static_cast<double>(mStatistics.cullPasses) << " ms recording per frame";
+		}
+		stream << std::endl;
+	}
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+namespace helpers
+{
+	// One instance of a mesh, as it is stored in the instance buffer (std430, see cull_instances.comp)
+	struct instance_data
+	{
+		glm::mat4 model;
+		glm::vec4 boundingSphere;	// xyz: center in model space, w: radius in model space
+	};
+	static_assert(sizeof(instance_data) == 80, "instance_data must match the shaders' std430 layout");
+
+	// The six planes of a view frustum (left, right, bottom, top, near, far), as (normal, distance) with normalized
+	// normals that point inwards, i.e. a point p is inside if dot(plane.xyz, p) + plane.w >= 0 for all planes
+	struct frustum
+	{
+		std::array<glm::vec4, 6> planes;
+	};
+
+	// Extract the world space frustum planes of the given projection * view matrix (with a depth range of 0..1)
+	frustum extract_frustum_planes(const glm::mat4& viewProjection);
+
+	// Does the sphere intersect the frustum, or is it inside of it? Conservative: spheres near the frustum's corners
+	// are reported as visible even if they are slightly outside.
+	bool is_sphere_in_frustum(const frustum& frustum, const glm::vec3& center, const float radius);
+
+	// The bounding sphere of the given positions (center of their bounding box, and the largest distance from it)
+	glm::vec4 compute_bounding_sphere(const std::vector<glm::vec3>& positions);
+
+	// Reference implementation of the GPU cull (cull_instances.comp), with exactly the same math:
+	// Writes the indices of all visible instances to <outVisibleInstances>, in ascending order.
+	// The GPU produces the same set of indices, but in any order.
+	void cull_instances(
+		const frustum& frustum,
+		const instance_data* instances,
+		const size_t instanceCount,
+		std::vector<uint32_t>& outVisibleInstances
+	);
+
+	// How an instance culler has been used
+	struct instance_culling_statistics
+	{
+		uint64_t cullPasses = 0;
+		uint64_t instancesTested = 0;		// Sum over all cull passes
+		double recordMs = 0.0;				// CPU time spent in record_cull and record_draw
+	};
+
+	// GPU-driven instanced rendering of one (indexed) mesh: the transforms and bounding spheres of all instances live in
+	// a device-local instance buffer. Each frame, a compute pass tests every instance's bounding sphere against the view
+	// frustum and appends the indices of the visible ones to a compacted list. The same pass counts them into the
+	// instanceCount of an indirect draw command, which a single drawIndexedIndirect then consumes. The CPU records the
+	// same handful of commands each frame, however many instances there are.
+	//
+	// Each frame in flight has its own visible list and draw command, s.t. culling a frame doesn't overwrite what an
+	// earlier frame may still be drawing with. The vertex shader reads the instance through the visible list:
+	//   instances[visibleInstances[gl_InstanceIndex]].model   (see vertex_shader_instanced.vert)
+	// For that, add descriptor_set_layout() to the graphics pipeline layout, at the set index which the vertex shader
+	// uses, and bind descriptor_set() there.
+	//
+	// Usage per frame (with the same number of frames in flight as the frame scheduler):
+	//   auto& frame = frameScheduler.begin_frame();
+	//   culler.begin_frame();
+	//   culler.record_cull(frame.commandBuffer, projection * view);    // Outside of render passes
+	//   frame.commandBuffer.beginRenderPass(...);
+	//   bind the pipeline, descriptor sets (incl. culler.descriptor_set()), and the mesh's vertex and index buffers
+	//   culler.record_draw(frame.commandBuffer);
+	//
+	// Requires shaders/cull_instances.spv. The culler is not thread-safe.
+	class instance_culler
+	{
+	public:
+		static constexpr uint32_t WorkgroupSize = 64;	// local_size_x of cull_instances.comp
+
+		// <indexCount>, <firstIndex>, and <vertexOffset> describe the mesh which each instance draws
+		instance_culler(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			pipeline_cache& pipelineCache,
+			const uint32_t maxInstances,
+			const uint32_t framesInFlight,
+			const uint32_t indexCount,
+			const uint32_t firstIndex = 0u,
+			const int32_t vertexOffset = 0
+		);
+		instance_culler(const instance_culler&) = delete;
+		instance_culler& operator=(const instance_culler&) = delete;
+		// The GPU must be done with all frames which have used the culler.
+		~instance_culler();
+
+		// Enqueue uploading <instances> into the instance buffer, replacing all previous instances. The GPU must be done
+		// with all frames which use the previous instances (e.g. only set them up once, or after a device idle).
+		void upload_instances(upload_engine& uploadEngine, const std::vector<instance_data>& instances);
+
+		// Start the next frame. The GPU must be done with the frame which used the same slot before.
+		void begin_frame();
+
+		// Record the compute pass which culls all instances against the frustum of <viewProjection>. Must be recorded
+		// outside of render passes, before record_draw. Includes the barriers towards the indirect draw and the vertex shader.
+		void record_cull(const vk::CommandBuffer commandBuffer, const glm::mat4& viewProjection);
+
+		// Record the indirect draw of all instances which record_cull has found to be visible
+		void record_draw(const vk::CommandBuffer commandBuffer);
+
+		// Instance buffer (binding 0) and the current frame's visible list (binding 1) and draw command (binding 2)
+		vk::DescriptorSetLayout descriptor_set_layout() const { return mDescriptorSetLayout; }
+		vk::DescriptorSet descriptor_set() const { return mSlots[mCurrentSlot].descriptorSet; }
+
+		// The current frame's buffers, e.g. for reading back the results of a cull
+		vk::Buffer visible_instances_buffer() const { return mSlots[mCurrentSlot].visibleInstancesBuffer; }
+		vk::Buffer draw_command_buffer() const { return mSlots[mCurrentSlot].drawCommandBuffer; }
+
+		uint32_t instance_count() const { return mInstanceCount; }
+		uint32_t max_instances() const { return mMaxInstances; }
+
+		instance_culling_statistics get_statistics() const { return mStatistics; }
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		// What cull_instances.comp gets as push constants
+		struct cull_push_constants
+		{
+			std::array<glm::vec4, 6> planes;
+			uint32_t instanceCount;
+		};
+
+		struct frame_resources
+		{
+			vk::Buffer visibleInstancesBuffer;		// One uint32_t per instance
+			memory_allocation visibleInstancesMemory;
+			vk::Buffer drawCommandBuffer;			// One vk::DrawIndexedIndirectCommand
+			memory_allocation drawCommandMemory;
+			vk::DescriptorSet descriptorSet;
+		};
+
+		vk::Device mDevice;
+		uint32_t mMaxInstances;
+		uint32_t mInstanceCount = 0;
+		vk::DrawIndexedIndirectCommand mDrawCommand;	// With an instanceCount of 0, which the cull pass counts up
+		vk::Buffer mInstanceBuffer;
+		memory_allocation mInstanceMemory;
+		vk::DescriptorSetLayout mDescriptorSetLayout;
+		vk::DescriptorPool mDescriptorPool;
+		vk::PipelineLayout mPipelineLayout;
+		vk::Pipeline mPipeline;
+		std::vector<frame_resources> mSlots;
+		size_t mCurrentSlot = 0;
+		uint64_t mFrameNumber = 0;
+		instance_culling_statistics mStatistics;
+	};
+}
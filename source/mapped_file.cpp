@@ -0,0 +1,126 @@
+#include "pch.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace helpers
+{
+	mapped_file::mapped_file(const std::string& path)
+	{
+#ifdef _WIN32
+		mFileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (INVALID_HANDLE_VALUE == mFileHandle) {
+			mFileHandle = nullptr;
+			throw std::runtime_error("Couldn't open file '" + path + "'");
+		}
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(mFileHandle, &fileSize);
+		mSize = static_cast<size_t>(fileSize.QuadPart);
+		mIsOpen = true;
+		if (0 == mSize) {
+			return; // Empty files can not be mapped
+		}
+		mMappingHandle = CreateFileMappingA(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (nullptr == mMappingHandle) {
+			close();
+			throw std::runtime_error("Couldn't create a file mapping for '" + path + "'");
+		}
+		mData = static_cast<const uint8_t*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (nullptr == mData) {
+			close();
+			throw std::runtime_error("Couldn't map file '" + path + "'");
+		}
+#else
+		mFileDescriptor = ::open(path.c_str(), O_RDONLY);
+		if (mFileDescriptor < 0) {
+			throw std::runtime_error("Couldn't open file '" + path + "'");
+		}
+		struct stat fileStatus;
+		fstat(mFileDescriptor, &fileStatus);
+		mSize = static_cast<size_t>(fileStatus.st_size);
+		mIsOpen = true;
+		if (0 == mSize) {
+			return; // Empty files can not be mapped
+		}
+		void* mapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+		if (MAP_FAILED == mapping) {
+			close();
+			throw std::runtime_error("Couldn't map file '" + path + "'");
+		}
+		madvise(mapping, mSize, MADV_SEQUENTIAL);
+		mData = static_cast<const uint8_t*>(mapping);
+#endif
+	}
+
+	mapped_file::mapped_file(mapped_file&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+	{
+		if (this != &other) {
+			close();
+			std::swap(mData, other.mData);
+			std::swap(mSize, other.mSize);
+			std::swap(mIsOpen, other.mIsOpen);
+#ifdef _WIN32
+			std::swap(mFileHandle, other.mFileHandle);
+			std::swap(mMappingHandle, other.mMappingHandle);
+#else
+			std::swap(mFileDescriptor, other.mFileDescriptor);
+#endif
+		}
+		return *this;
+	}
+
+	mapped_file::~mapped_file()
+	{
+		close();
+	}
+
+	void mapped_file::close()
+	{
+#ifdef _WIN32
+		if (nullptr != mData) {
+			UnmapViewOfFile(mData);
+		}
+		if (nullptr != mMappingHandle) {
+			CloseHandle(mMappingHandle);
+		}
+		if (nullptr != mFileHandle) {
+			CloseHandle(mFileHandle);
+		}
+		mMappingHandle = nullptr;
+		mFileHandle = nullptr;
+#else
+		if (nullptr != mData) {
+			munmap(const_cast<uint8_t*>(mData), mSize);
+		}
+		if (mFileDescriptor >= 0) {
+			::close(mFileDescriptor);
+		}
+		mFileDescriptor = -1;
+#endif
+		mData = nullptr;
+		mSize = 0;
+		mIsOpen = false;
+	}
+
+	uint64_t fnv1a_64(const void* data, const size_t size, uint64_t hash)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+}
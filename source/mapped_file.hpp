@@ -0,0 +1,39 @@
+#pragma once
+
+namespace helpers
+{
+	// A read-only memory mapping of a whole file (CreateFileMapping on Windows, mmap elsewhere).
+	// The file's contents can be accessed through data() for as long as the object is alive.
+	class mapped_file
+	{
+	public:
+		mapped_file() = default;
+		// Map the file at the given path; throws if the file can not be opened or mapped
+		explicit mapped_file(const std::string& path);
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		~mapped_file();
+
+		const uint8_t* data() const { return mData; }
+		size_t size() const { return mSize; }
+		bool is_open() const { return mIsOpen; }
+
+	private:
+		void close();
+
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+		bool mIsOpen = false;
+#ifdef _WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#else
+		int mFileDescriptor = -1;
+#endif
+	};
+
+	// 64-bit FNV-1a hash of the given bytes
+	uint64_t fnv1a_64(const void* data, const size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+}
@@ -0,0 +1,434 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		vk::DeviceSize align_up(const vk::DeviceSize value, const vk::DeviceSize alignment)
+		{
+			return alignment <= 1 ? value : (value + alignment - 1) / alignment * alignment;
+		}
+
+		// All arenas that have been created through get_memory_arena, one per logical device:
+		std::unordered_map<VkDevice, std::unique_ptr<memory_arena>>& memory_arena_registry()
+		{
+			static std::unordered_map<VkDevice, std::unique_ptr<memory_arena>> registry;
+			return registry;
+		}
+	}
+
+	std::string to_string(const memory_category category)
+	{
+		switch (category) {
+		case memory_category::mesh:
+			return "mesh";
+		case memory_category::texture:
+			return "texture";
+		case memory_category::staging:
+			return "staging";
+		case memory_category::uniform:
+			return "uniform";
+		case memory_category::render_target:
+			return "render_target";
+		default:
+			return "other";
+		}
+	}
+
+	memory_arena::memory_arena(const vk::PhysicalDevice physicalDevice, const vk::Device device, const vk::DeviceSize preferredBlockSize)
+		: mPhysicalDevice{ physicalDevice }
+		, mDevice{ device }
+		, mMemoryProperties{ physicalDevice.getMemoryProperties() }
+		, mPreferredBlockSize{ preferredBlockSize }
+	{
+		// The budget is physical-device-level functionality, which can be queried without enabling the extension -- through
+		// vkGetPhysicalDeviceMemoryProperties2, which is core in Vulkan 1.1. The instances are created with 1.1, the device
+		// must support it as well:
+		if (physicalDevice.getProperties().apiVersion < VK_API_VERSION_1_1) {
+			return;
+		}
+		const auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
+		mHasMemoryBudget = std::any_of(extensions.begin(), extensions.end(), [](const vk::ExtensionProperties& extension) {
+			return 0 == strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		});
+	}
+
+	memory_arena::~memory_arena()
+	{
+		for (auto& blk : mBlocks) {
+			destroy_block(*blk);
+		}
+		mBlocks.clear();
+	}
+
+	uint32_t memory_arena::find_memory_type_index(const uint32_t memoryTypeBits, const vk::MemoryPropertyFlags requiredProperties) const
+	{
+		for (uint32_t i = 0u; i < mMemoryProperties.memoryTypeCount; ++i) {
+			// Is this kind of memory suitable for our resource?
+			if (0 == (memoryTypeBits & (1u << i))) {
+				continue;
+			}
+			// Does this kind of memory support ALL of the requested properties?
+			if ((mMemoryProperties.memoryTypes[i].propertyFlags & requiredProperties) == requiredProperties) {
+				return i;
+			}
+		}
+		throw std::runtime_error("Couldn't find suitable memory.");
+	}
+
+	memory_arena::block& memory_arena::create_block(const uint32_t memoryTypeIndex, const resource_tiling tiling, const vk::DeviceSize minimumSize)
+	{
+		const auto heapSize = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+		// Don't let a single block take more than an eighth of a (small) heap:
+		auto blockSize = std::max(minimumSize, std::min(mPreferredBlockSize, heapSize / 8));
+		warn_if_over_budget(mMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex, blockSize);
+
+		vk::DeviceMemory memory;
+		for (;;) {
+			try {
+				++mDeviceAllocationCalls;
+				memory = mDevice.allocateMemory(vk::MemoryAllocateInfo{}
+					.setAllocationSize(blockSize)
+					.setMemoryTypeIndex(memoryTypeIndex)
+				);
+				break;
+			}
+			catch (const vk::OutOfDeviceMemoryError&) {
+				// Retry with a smaller block, as long as the request still fits:
+				if (blockSize / 2 < minimumSize) {
+					throw;
+				}
+				blockSize /= 2;
+			}
+		}
+
+		void* mappedData = nullptr;
+		if (mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+			mappedData = mDevice.mapMemory(memory, 0, VK_WHOLE_SIZE);
+		}
+
+		mBlocks.push_back(std::make_unique<block>(block{
+			mNextBlockId++, memory, blockSize, memoryTypeIndex, tiling, mappedData, 0, { free_range{ 0, blockSize } }
+		}));
+		return *mBlocks.back();
+	}
+
+	void memory_arena::destroy_block(block& blk)
+	{
+		if (nullptr != blk.mappedData) {
+			mDevice.unmapMemory(blk.memory);
+		}
+		mDevice.freeMemory(blk.memory);
+	}
+
+	memory_allocation memory_arena::allocate(
+		const vk::MemoryRequirements& memoryRequirements,
+		const vk::MemoryPropertyFlags requiredProperties,
+		const resource_tiling tiling,
+		const memory_category category)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		const auto memoryTypeIndex = find_memory_type_index(memoryRequirements.memoryTypeBits, requiredProperties);
+		const auto size = memoryRequirements.size;
+		const auto alignment = std::max<vk::DeviceSize>(memoryRequirements.alignment, 1);
+
+		// Best fit: find the free range which leaves the least space behind
+		block* bestBlock = nullptr;
+		size_t bestRange = 0;
+		vk::DeviceSize bestLeftover = std::numeric_limits<vk::DeviceSize>::max();
+		for (auto& blk : mBlocks) {
+			if (blk->memoryTypeIndex != memoryTypeIndex || blk->tiling != tiling) {
+				continue;
+			}
+			for (size_t r = 0; r < blk->freeRanges.size(); ++r) {
+				const auto& range = blk->freeRanges[r];
+				const auto alignedOffset = align_up(range.offset, alignment);
+				const auto padding = alignedOffset - range.offset;
+				if (padding + size > range.size) {
+					continue;
+				}
+				const auto leftover = range.size - padding - size;
+				if (leftover < bestLeftover) {
+					bestBlock = blk.get();
+					bestRange = r;
+					bestLeftover = leftover;
+				}
+			}
+		}
+
+		// Nothing fits => get a new block. Requests which are larger than half a block get a block of their own.
+		if (nullptr == bestBlock) {
+			const auto minimumSize = size > mPreferredBlockSize / 2 ? size : mPreferredBlockSize;
+			bestBlock = &create_block(memoryTypeIndex, tiling, std::max(minimumSize, size));
+			bestRange = 0;
+		}
+
+		// Carve the allocation out of the free range. Alignment padding in front of the
+		// allocation remains a free range, so that it can be used by smaller allocations.
+		auto& ranges = bestBlock->freeRanges;
+		const auto range = ranges[bestRange];
+		const auto alignedOffset = align_up(range.offset, alignment);
+		const auto padding = alignedOffset - range.offset;
+		const auto leftover = range.size - padding - size;
+		ranges.erase(ranges.begin() + bestRange);
+		if (leftover > 0) {
+			ranges.insert(ranges.begin() + bestRange, free_range{ alignedOffset + size, leftover });
+		}
+		if (padding > 0) {
+			ranges.insert(ranges.begin() + bestRange, free_range{ range.offset, padding });
+		}
+		++bestBlock->allocationCount;
+		auto& usage = mUsage[static_cast<size_t>(category)][memoryTypeIndex];
+		++usage.allocationCount;
+		usage.bytes += size;
+
+		memory_allocation allocation;
+		allocation.memory = bestBlock->memory;
+		allocation.offset = alignedOffset;
+		allocation.size = size;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.blockId = bestBlock->id;
+		allocation.mappedData = nullptr == bestBlock->mappedData ? nullptr : static_cast<uint8_t*>(bestBlock->mappedData) + alignedOffset;
+		allocation.category = category;
+		return allocation;
+	}
+
+	void memory_arena::free(const memory_allocation& allocation)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		free_locked(allocation);
+	}
+
+	void memory_arena::free(const std::vector<memory_allocation>& allocations)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& allocation : allocations) {
+			free_locked(allocation);
+		}
+	}
+
+	void memory_arena::free_locked(const memory_allocation& allocation)
+	{
+		auto it = std::find_if(std::begin(mBlocks), std::end(mBlocks), [&allocation](const auto& blk) {
+			return blk->id == allocation.blockId;
+		});
+		if (it == std::end(mBlocks) || (*it)->memory != allocation.memory) {
+			throw std::runtime_error("The given allocation does not belong to this memory arena.");
+		}
+		auto& blk = **it;
+
+		// Insert the range at its sorted position and merge it with its neighbours:
+		auto& ranges = blk.freeRanges;
+		auto pos = std::lower_bound(std::begin(ranges), std::end(ranges), allocation.offset, [](const free_range& r, vk::DeviceSize offset) {
+			return r.offset < offset;
+		});
+		pos = ranges.insert(pos, free_range{ allocation.offset, allocation.size });
+		if (pos + 1 != std::end(ranges) && pos->offset + pos->size == (pos + 1)->offset) {
+			pos->size += (pos + 1)->size;
+			ranges.erase(pos + 1);
+		}
+		if (pos != std::begin(ranges) && (pos - 1)->offset + (pos - 1)->size == pos->offset) {
+			(pos - 1)->size += pos->size;
+			ranges.erase(pos);
+		}
+		--blk.allocationCount;
+		auto& usage = mUsage[static_cast<size_t>(allocation.category)][allocation.memoryTypeIndex];
+		--usage.allocationCount;
+		usage.bytes -= allocation.size;
+
+		// Give empty blocks back to the driver, but keep one block per memory type
+		// around so that we don't allocate and free over and over again:
+		if (0 == blk.allocationCount) {
+			const auto sameKindCount = std::count_if(std::begin(mBlocks), std::end(mBlocks), [&blk](const auto& other) {
+				return other->memoryTypeIndex == blk.memoryTypeIndex && other->tiling == blk.tiling;
+			});
+			if (sameKindCount > 1 || blk.size > mPreferredBlockSize) {
+				destroy_block(blk);
+				mBlocks.erase(it);
+			}
+		}
+	}
+
+	memory_arena_statistics memory_arena::get_statistics() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		memory_arena_statistics stats;
+		stats.blockCount = mBlocks.size();
+		stats.deviceAllocationCalls = mDeviceAllocationCalls;
+		for (const auto& blk : mBlocks) {
+			stats.allocationCount += blk->allocationCount;
+			stats.bytesReserved += blk->size;
+			stats.freeRangeCount += blk->freeRanges.size();
+			for (const auto& range : blk->freeRanges) {
+				stats.bytesFree += range.size;
+				stats.largestFreeRange = std::max(stats.largestFreeRange, range.size);
+			}
+		}
+		stats.bytesInUse = stats.bytesReserved - stats.bytesFree;
+		stats.fragmentation = 0 == stats.bytesFree ? 0.0f : 1.0f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(stats.bytesFree);
+		return stats;
+	}
+
+	void memory_arena::print_statistics(std::ostream& stream) const
+	{
+		const auto stats = get_statistics();
+		stream << "Memory arena: " << stats.allocationCount << " allocations in " << stats.blockCount << " blocks"
+			<< " (" << stats.deviceAllocationCalls << " vkAllocateMemory calls in total)\n"
+			<< "  reserved: " << stats.bytesReserved << " bytes, in use: " << stats.bytesInUse << " bytes, free: " << stats.bytesFree << " bytes\n"
+			<< "  free ranges: " << stats.freeRangeCount << ", largest free range: " << stats.largestFreeRange << " bytes, fragmentation: " << stats.fragmentation << "\n";
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& blk : mBlocks) {
+			stream << "  block #" << blk->id << ": memory type " << blk->memoryTypeIndex
+				<< (blk->tiling == resource_tiling::linear ? ", linear" : ", optimal")
+				<< ", " << blk->size << " bytes, " << blk->allocationCount << " allocations, " << blk->freeRanges.size() << " free ranges\n";
+		}
+	}
+
+	void memory_arena::query_budgets(std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS>& outBudgets, std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS>& outUsages) const
+	{
+		if (!mHasMemoryBudget) {
+			return;
+		}
+		const auto properties = mPhysicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		const auto& budget = properties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i) {
+			outBudgets[i] = budget.heapBudget[i];
+			outUsages[i] = budget.heapUsage[i];
+		}
+	}
+
+	void memory_arena::warn_if_over_budget(const uint32_t heapIndex, const vk::DeviceSize additionalBytes)
+	{
+		std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> budgets{};
+		std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> usages{};
+		query_budgets(budgets, usages);
+		if (0 == budgets[heapIndex] || static_cast<double>(usages[heapIndex] + additionalBytes) <= BudgetWarningFraction * static_cast<double>(budgets[heapIndex])) {
+			return;
+		}
+		++mBudgetWarnings;
+		std::cout << "Warning: allocating " << additionalBytes / (1024 * 1024) << " MiB more in memory heap " << heapIndex << " takes its usage to "
+			<< (usages[heapIndex] + additionalBytes) / (1024 * 1024) << " MiB of a budget of " << budgets[heapIndex] / (1024 * 1024) << " MiB" << std::endl;
+	}
+
+	memory_telemetry memory_arena::get_telemetry() const
+	{
+		std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> budgets{};
+		std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> usages{};
+		query_budgets(budgets, usages);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		memory_telemetry telemetry;
+		telemetry.budgetWarnings = mBudgetWarnings;
+		for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i) {
+			memory_heap_telemetry heap;
+			heap.heapIndex = i;
+			heap.flags = mMemoryProperties.memoryHeaps[i].flags;
+			heap.size = mMemoryProperties.memoryHeaps[i].size;
+			heap.hasBudget = mHasMemoryBudget;
+			heap.budget = budgets[i];
+			heap.usage = usages[i];
+			telemetry.heaps.push_back(heap);
+		}
+		for (const auto& blk : mBlocks) {
+			telemetry.heaps[mMemoryProperties.memoryTypes[blk->memoryTypeIndex].heapIndex].bytesReserved += blk->size;
+		}
+		for (size_t c = 0; c < MemoryCategoryCount; ++c) {
+			for (uint32_t t = 0; t < mMemoryProperties.memoryTypeCount; ++t) {
+				const auto& usage = mUsage[c][t];
+				if (0 == usage.allocationCount) {
+					continue;
+				}
+				const auto heapIndex = mMemoryProperties.memoryTypes[t].heapIndex;
+				telemetry.categories.push_back(memory_category_usage{ static_cast<memory_category>(c), t, heapIndex, usage.allocationCount, usage.bytes });
+				telemetry.heaps[heapIndex].bytesInUse += usage.bytes;
+			}
+		}
+		return telemetry;
+	}
+
+	void memory_arena::print_telemetry(std::ostream& stream) const
+	{
+		const auto telemetry = get_telemetry();
+		stream << "Memory telemetry" << (mHasMemoryBudget ? "" : " (VK_EXT_memory_budget is not supported)") << ":\n";
+		for (const auto& heap : telemetry.heaps) {
+			stream << "  heap " << heap.heapIndex << (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal ? " (device local)" : "")
+				<< ": " << heap.size / (1024 * 1024) << " MiB, arena reserved " << heap.bytesReserved / 1024 << " KiB, in use " << heap.bytesInUse / 1024 << " KiB";
+			if (heap.hasBudget) {
+				stream << ", process usage " << heap.usage / (1024 * 1024) << " MiB of a budget of " << heap.budget / (1024 * 1024) << " MiB";
+			}
+			stream << "\n";
+		}
+		for (const auto& c : telemetry.categories) {
+			stream << "  " << to_string(c.category) << " (memory type " << c.memoryTypeIndex << ", heap " << c.heapIndex << "): "
+				<< c.allocationCount << " allocations, " << c.bytes / 1024 << " KiB\n";
+		}
+		if (telemetry.budgetWarnings > 0) {
+			stream << "  " << telemetry.budgetWarnings << " budget warnings\n";
+		}
+	}
+
+	void memory_arena::write_telemetry_json(std::ostream& stream) const
+	{
+		const auto telemetry = get_telemetry();
+		stream << "{\"hasBudget\":" << (mHasMemoryBudget ? "true" : "false") << ",\"budgetWarnings\":" << telemetry.budgetWarnings << ",\n\"heaps\":[";
+		for (size_t i = 0; i < telemetry.heaps.size(); ++i) {
+			const auto& heap = telemetry.heaps[i];
+			stream << (0 == i ? "\n" : ",\n") << "{\"index\":" << heap.heapIndex
+				<< ",\"deviceLocal\":" << (heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal ? "true" : "false")
+				<< ",\"size\":" << heap.size << ",\"reserved\":" << heap.bytesReserved << ",\"inUse\":" << heap.bytesInUse;
+			if (heap.hasBudget) {
+				stream << ",\"budget\":" << heap.budget << ",\"usage\":" << heap.usage;
+			}
+			stream << "}";
+		}
+		stream << "\n],\n\"categories\":[";
+		for (size_t i = 0; i < telemetry.categories.size(); ++i) {
+			const auto& c = telemetry.categories[i];
+			stream << (0 == i ? "\n" : ",\n") << "{\"category\":\"" << to_string(c.category) << "\",\"memoryType\":" << c.memoryTypeIndex
+				<< ",\"heap\":" << c.heapIndex << ",\"allocations\":" << c.allocationCount << ",\"bytes\":" << c.bytes << "}";
+		}
+		stream << "\n]}\n";
+	}
+
+	void memory_arena::write_telemetry_json(const std::string& path) const
+	{
+		std::ofstream stream(path, std::ios::trunc);
+		if (!stream.is_open()) {
+			throw std::runtime_error("Couldn't open '" + path + "' for writing");
+		}
+		write_telemetry_json(stream);
+		if (!stream.good()) {
+			throw std::runtime_error("Couldn't write '" + path + "'");
+		}
+	}
+
+	memory_arena& get_memory_arena(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device)
+	{
+		auto& registry = memory_arena_registry();
+		auto it = registry.find(static_cast<VkDevice>(device));
+		if (it == registry.end()) {
+			it = registry.emplace(static_cast<VkDevice>(device), std::make_unique<memory_arena>(physicalDevice, device)).first;
+		}
+		return *it->second;
+	}
+
+	memory_arena& get_memory_arena(const vk::Device device)
+	{
+		auto& registry = memory_arena_registry();
+		auto it = registry.find(static_cast<VkDevice>(device));
+		if (it == registry.end()) {
+			throw std::runtime_error("There is no memory arena for the given device.");
+		}
+		return *it->second;
+	}
+
+	void destroy_memory_arena(const vk::Device device)
+	{
+		memory_arena_registry().erase(static_cast<VkDevice>(device));
+	}
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+namespace helpers
+{
+	// Describes which kind of resources will be bound to an allocation.
+	// Linear resources (buffers) and optimal-tiling resources (images) are never placed into
+	// the same memory block, so that we don't have to care about bufferImageGranularity.
+	enum struct resource_tiling
+	{
+		linear,
+		optimal
+	};
+
+	// What an allocation is used for. The memory arena tracks the live allocations per category and memory type.
+	// (Swapchain images are allocated by the driver, not by the arena => they only show up in the heaps' budget usage.)
+	enum struct memory_category
+	{
+		other,
+		mesh,			// Vertex and index buffers, instance data
+		texture,		// Sampled images
+		staging,		// Host-visible transfer sources and destinations (uploads, readbacks)
+		uniform,		// Uniform buffers
+		render_target	// Images which are rendered into (offscreen images, transient render graph images)
+	};
+	constexpr size_t MemoryCategoryCount = 6;
+
+	std::string to_string(const memory_category category);
+
+	// A sub-allocation of one of the memory arena's big memory blocks.
+	// Resources must be bound to <memory> at <offset>, i.e. bindBufferMemory(buffer, memory, offset).
+	// If the memory is host-visible, <mappedData> points to the (persistently mapped) first byte of the allocation.
+	struct memory_allocation
+	{
+		vk::DeviceMemory memory;
+		vk::DeviceSize offset = 0;
+		vk::DeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		uint32_t blockId = 0;
+		void* mappedData = nullptr;
+		memory_category category = memory_category::other;
+	};
+
+	// Allocation and fragmentation statistics of a memory arena.
+	struct memory_arena_statistics
+	{
+		size_t blockCount = 0;				// Number of vk::DeviceMemory blocks that are currently alive
+		size_t allocationCount = 0;			// Number of live sub-allocations
+		size_t deviceAllocationCalls = 0;	// Total number of vkAllocateMemory calls that have been issued so far
+		size_t freeRangeCount = 0;			// Number of disjoint free ranges over all blocks
+		vk::DeviceSize bytesReserved = 0;	// Sum of the sizes of all blocks
+		vk::DeviceSize bytesInUse = 0;		// Sum of the sizes of all live sub-allocations
+		vk::DeviceSize bytesFree = 0;		// Sum of the sizes of all free ranges (alignment padding is counted as free)
+		vk::DeviceSize largestFreeRange = 0;
+		// 0 means that all free memory is one contiguous range, values towards 1 mean that the
+		// free memory is scattered over many small ranges: 1 - largestFreeRange / bytesFree
+		float fragmentation = 0.0f;
+	};
+
+	// The live allocations of one category in one memory type
+	struct memory_category_usage
+	{
+		memory_category category = memory_category::other;
+		uint32_t memoryTypeIndex = 0;
+		uint32_t heapIndex = 0;
+		uint64_t allocationCount = 0;
+		vk::DeviceSize bytes = 0;
+	};
+
+	// One memory heap: how much of it the arena uses, and (with VK_EXT_memory_budget) how much the whole process uses
+	// and may use. The budget changes at runtime, e.g. when other applications allocate memory.
+	struct memory_heap_telemetry
+	{
+		uint32_t heapIndex = 0;
+		vk::MemoryHeapFlags flags;
+		vk::DeviceSize size = 0;
+		vk::DeviceSize bytesReserved = 0;		// The arena's blocks in this heap
+		vk::DeviceSize bytesInUse = 0;			// The arena's live sub-allocations in this heap
+		bool hasBudget = false;					// Is VK_EXT_memory_budget supported?
+		vk::DeviceSize budget = 0;				// How much the process can allocate without hurting performance
+		vk::DeviceSize usage = 0;				// How much the process has allocated, incl. the driver's allocations
+	};
+
+	// A snapshot of a memory arena's usage by heap, and by category and memory type
+	struct memory_telemetry
+	{
+		std::vector<memory_heap_telemetry> heaps;
+		std::vector<memory_category_usage> categories;	// Only those with live allocations
+		uint64_t budgetWarnings = 0;
+	};
+
+	// A memory arena which allocates large vk::DeviceMemory blocks per memory type and hands
+	// out alignment-aware sub-allocations from them (best fit over a sorted free list per block).
+	// Freed sub-allocations are merged with adjacent free ranges again.
+	// Blocks of host-visible memory types are mapped once when they are created and stay mapped.
+	class memory_arena
+	{
+	public:
+		static constexpr vk::DeviceSize DefaultBlockSize = 64ull * 1024ull * 1024ull;
+
+		memory_arena(const vk::PhysicalDevice physicalDevice, const vk::Device device, const vk::DeviceSize preferredBlockSize = DefaultBlockSize);
+		memory_arena(const memory_arena&) = delete;
+		memory_arena& operator=(const memory_arena&) = delete;
+		~memory_arena();
+
+		// A warning is printed whenever a new block would take a heap's usage above this fraction of its budget
+		static constexpr double BudgetWarningFraction = 0.9;
+
+		// Sub-allocate memory which satisfies the given requirements and has (at least) the given properties
+		memory_allocation allocate(
+			const vk::MemoryRequirements& memoryRequirements,
+			const vk::MemoryPropertyFlags requiredProperties,
+			const resource_tiling tiling,
+			const memory_category category = memory_category::other
+		);
+
+		// Return a sub-allocation to the arena
+		void free(const memory_allocation& allocation);
+
+		// Return many sub-allocations at once (under one lock), e.g. from a deletion queue
+		void free(const std::vector<memory_allocation>& allocations);
+
+		// Gather statistics over all blocks
+		memory_arena_statistics get_statistics() const;
+
+		// Print the statistics, followed by a per-block breakdown
+		void print_statistics(std::ostream& stream) const;
+
+		// Usage per heap (with the current budgets, if VK_EXT_memory_budget is supported), and per category and memory type
+		memory_telemetry get_telemetry() const;
+
+		// Print the telemetry, one line per heap and category
+		void print_telemetry(std::ostream& stream) const;
+
+		// Write the telemetry as JSON, e.g. to size asset sets for some target hardware
+		void write_telemetry_json(std::ostream& stream) const;
+		void write_telemetry_json(const std::string& path) const;
+
+		bool has_memory_budget() const { return mHasMemoryBudget; }
+
+		vk::Device device() const { return mDevice; }
+
+	private:
+		struct free_range
+		{
+			vk::DeviceSize offset;
+			vk::DeviceSize size;
+		};
+
+		struct block
+		{
+			uint32_t id;
+			vk::DeviceMemory memory;
+			vk::DeviceSize size;
+			uint32_t memoryTypeIndex;
+			resource_tiling tiling;
+			void* mappedData;
+			size_t allocationCount;
+			std::vector<free_range> freeRanges; // sorted by offset, never adjacent
+		};
+
+		uint32_t find_memory_type_index(const uint32_t memoryTypeBits, const vk::MemoryPropertyFlags requiredProperties) const;
+		struct usage_counter
+		{
+			uint64_t allocationCount = 0;
+			vk::DeviceSize bytes = 0;
+		};
+
+		// mMutex must be held
+		void free_locked(const memory_allocation& allocation);
+		// Query VK_EXT_memory_budget; <outBudgets> and <outUsages> stay untouched if it isn't supported
+		void query_budgets(std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS>& outBudgets, std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS>& outUsages) const;
+		void warn_if_over_budget(const uint32_t heapIndex, const vk::DeviceSize additionalBytes);
+		block& create_block(const uint32_t memoryTypeIndex, const resource_tiling tiling, const vk::DeviceSize minimumSize);
+		void destroy_block(block& blk);
+
+		vk::PhysicalDevice mPhysicalDevice;
+		vk::Device mDevice;
+		vk::PhysicalDeviceMemoryProperties mMemoryProperties;
+		vk::DeviceSize mPreferredBlockSize;
+		std::vector<std::unique_ptr<block>> mBlocks;
+		uint32_t mNextBlockId = 0;
+		size_t mDeviceAllocationCalls = 0;
+		bool mHasMemoryBudget = false;
+		std::array<std::array<usage_counter, VK_MAX_MEMORY_TYPES>, MemoryCategoryCount> mUsage{};
+		uint64_t mBudgetWarnings = 0;
+		mutable std::mutex mMutex;
+	};
+
+	// Get the memory arena which serves all of the helper functions' allocations for the given device.
+	// It is created on first use.
+	memory_arena& get_memory_arena(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device
+	);
+
+	// Get the memory arena of a device for which get_memory_arena(physicalDevice, device) has been invoked before
+	memory_arena& get_memory_arena(const vk::Device device);
+
+	// Destroy the memory arena of the given device, which frees all of its memory blocks.
+	// Must be called before the logical device is destroyed.
+	void destroy_memory_arena(const vk::Device device);
+}
@@ -0,0 +1,217 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		constexpr char MeshCacheMagic[8] = { 'V', 'K', 'W', 'M', 'E', 'S', 'H', '\0' };
+		constexpr uint64_t StreamAlignment = 16;
+
+		static_assert(std::is_standard_layout<mesh_cache_header>::value, "mesh_cache_header must be written to disk as is");
+		static_assert(sizeof(mesh_cache_header) == 112, "Unexpected padding in mesh_cache_header");
+
+		uint64_t align_up(const uint64_t value, const uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		uint64_t compute_options_hash(const std::string& submeshNamesToExclude, const bool indexed)
+		{
+			const uint8_t indexedByte = indexed ? 1 : 0;
+			auto hash = fnv1a_64(&indexedByte, 1);
+			return fnv1a_64(submeshNamesToExclude.data(), submeshNamesToExclude.size(), hash);
+		}
+
+		int64_t get_write_time(const std::string& path)
+		{
+			return static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+		}
+
+		uint64_t hash_file_contents(const std::string& path)
+		{
+			mapped_file file(path);
+			return fnv1a_64(file.data(), file.size());
+		}
+
+		// Writes the given mesh into a *.vkmesh file, such that the next try_map_mesh_cache with the same parameters succeeds
+		void write_mesh_cache(
+			const mesh_data& mesh,
+			const std::string& modelPath,
+			const std::string& cachePath,
+			const std::string& submeshNamesToExclude,
+			const bool indexed)
+		{
+			mesh_cache_header header{};
+			std::copy(std::begin(MeshCacheMagic), std::end(MeshCacheMagic), std::begin(header.magic));
+			header.version = mesh_cache_header::CurrentVersion;
+			header.vertexCount = static_cast<uint32_t>(mesh.positions.size());
+			header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			header.optionsHash = compute_options_hash(submeshNamesToExclude, indexed);
+			header.sourceSize = static_cast<uint64_t>(std::filesystem::file_size(modelPath));
+			header.sourceWriteTime = get_write_time(modelPath);
+			header.sourceHash = hash_file_contents(modelPath);
+
+			glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+			glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+			for (const auto& p : mesh.positions) {
+				boundsMin = glm::min(boundsMin, p);
+				boundsMax = glm::max(boundsMax, p);
+			}
+			for (int i = 0; i < 3; ++i) {
+				header.boundsMin[i] = boundsMin[i];
+				header.boundsMax[i] = boundsMax[i];
+			}
+
+			header.positionsOffset = align_up(sizeof(mesh_cache_header), StreamAlignment);
+			header.textureCoordinatesOffset = align_up(header.positionsOffset + sizeof(glm::vec3) * mesh.positions.size(), StreamAlignment);
+			header.normalsOffset = align_up(header.textureCoordinatesOffset + sizeof(glm::vec2) * mesh.textureCoordinates.size(), StreamAlignment);
+			header.indicesOffset = align_up(header.normalsOffset + sizeof(glm::vec3) * mesh.normals.size(), StreamAlignment);
+
+			// Write to a temporary file first, s.t. a crash never leaves a half-written cache behind:
+			const auto tempPath = cachePath + ".tmp";
+			{
+				std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+				if (!stream.is_open()) {
+					throw std::runtime_error("Couldn't open '" + tempPath + "' for writing");
+				}
+				auto write_at = [&stream](const uint64_t offset, const void* data, const size_t size) {
+					static const char Zeros[StreamAlignment] = {};
+					const auto position = static_cast<uint64_t>(stream.tellp());
+					stream.write(Zeros, static_cast<std::streamsize>(offset - position));
+					stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+				};
+				write_at(0, &header, sizeof(header));
+				write_at(header.positionsOffset, mesh.positions.data(), sizeof(glm::vec3) * mesh.positions.size());
+				write_at(header.textureCoordinatesOffset, mesh.textureCoordinates.data(), sizeof(glm::vec2) * mesh.textureCoordinates.size());
+				write_at(header.normalsOffset, mesh.normals.data(), sizeof(glm::vec3) * mesh.normals.size());
+				write_at(header.indicesOffset, mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size());
+				if (!stream.good()) {
+					throw std::runtime_error("Couldn't write '" + tempPath + "'");
+				}
+			}
+			std::filesystem::rename(tempPath, cachePath);
+		}
+
+		mesh_data load_mesh_data_for_cache(const std::string& modelPath, const std::string& submeshNamesToExclude, const bool indexed)
+		{
+			return indexed
+				? helpers::load_indexed_mesh_data_of_obj(modelPath, submeshNamesToExclude)
+				: helpers::load_mesh_data_of_obj_parallel(modelPath, submeshNamesToExclude);
+		}
+	}
+
+	std::string get_mesh_cache_path(const std::string& modelPath)
+	{
+		return std::filesystem::path(modelPath).replace_extension(".vkmesh").string();
+	}
+
+	void bake_mesh_cache(
+		const std::string& modelPath,
+		const std::string& cachePath,
+		const std::string& submeshNamesToExclude,
+		const bool indexed)
+	{
+		const auto mesh = load_mesh_data_for_cache(modelPath, submeshNamesToExclude, indexed);
+		write_mesh_cache(mesh, modelPath, cachePath, submeshNamesToExclude, indexed);
+	}
+
+	bool try_map_mesh_cache(
+		const std::string& cachePath,
+		const std::string& modelPath,
+		const std::string& submeshNamesToExclude,
+		const bool indexed,
+		mapped_mesh_cache& outCache)
+	{
+		if (!std::filesystem::exists(cachePath)) {
+			return false;
+		}
+
+		mapped_mesh_cache cache;
+		try {
+			cache.file = mapped_file(cachePath);
+		}
+		catch (const std::runtime_error&) {
+			return false;
+		}
+
+		// Validate the header and the streams' extents:
+		if (cache.file.size() < sizeof(mesh_cache_header)) {
+			return false;
+		}
+		const auto& header = *reinterpret_cast<const mesh_cache_header*>(cache.file.data());
+		if (!std::equal(std::begin(MeshCacheMagic), std::end(MeshCacheMagic), std::begin(header.magic))
+			|| header.version != mesh_cache_header::CurrentVersion
+			|| header.optionsHash != compute_options_hash(submeshNamesToExclude, indexed)) {
+			return false;
+		}
+		const auto fileSize = static_cast<uint64_t>(cache.file.size());
+		auto stream_fits = [fileSize](const uint64_t offset, const uint64_t elementSize, const uint64_t count) {
+			return 0 == offset % StreamAlignment && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+		};
+		if (!stream_fits(header.positionsOffset, sizeof(glm::vec3), header.vertexCount)
+			|| !stream_fits(header.textureCoordinatesOffset, sizeof(glm::vec2), header.vertexCount)
+			|| !stream_fits(header.normalsOffset, sizeof(glm::vec3), header.vertexCount)
+			|| !stream_fits(header.indicesOffset, sizeof(uint32_t), header.indexCount)) {
+			return false;
+		}
+
+		// Is it stale? Size + write time is cheap to check. Only if the write time differs (e.g. after a fresh
+		// checkout), hash the source's contents. Without the source file, the cache is all we've got.
+		if (std::filesystem::exists(modelPath)) {
+			if (static_cast<uint64_t>(std::filesystem::file_size(modelPath)) != header.sourceSize) {
+				return false;
+			}
+			if (get_write_time(modelPath) != header.sourceWriteTime && hash_file_contents(modelPath) != header.sourceHash) {
+				return false;
+			}
+		}
+
+		const auto base = cache.file.data();
+		cache.header = &header;
+		cache.positions = reinterpret_cast<const glm::vec3*>(base + header.positionsOffset);
+		cache.textureCoordinates = reinterpret_cast<const glm::vec2*>(base + header.textureCoordinatesOffset);
+		cache.normals = reinterpret_cast<const glm::vec3*>(base + header.normalsOffset);
+		cache.indices = 0 == header.indexCount ? nullptr : reinterpret_cast<const uint32_t*>(base + header.indicesOffset);
+		outCache = std::move(cache);
+		return true;
+	}
+
+	device_mesh upload_mesh_cache(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const mapped_mesh_cache& cache)
+	{
+		return helpers::upload_mesh_streams(device, physicalDevice, uploadEngine,
+			cache.header->vertexCount, cache.positions, cache.textureCoordinates, cache.normals,
+			cache.header->indexCount, cache.indices
+		);
+	}
+
+	device_mesh load_mesh_with_cache(
+		const std::string& modelPath,
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const std::string& submeshNamesToExclude,
+		const bool indexed)
+	{
+		const auto cachePath = helpers::get_mesh_cache_path(modelPath);
+
+		mapped_mesh_cache cache;
+		if (helpers::try_map_mesh_cache(cachePath, modelPath, submeshNamesToExclude, indexed, cache)) {
+			// The upload engine copies the streams into its staging memory right away => the mapping can go afterwards
+			return helpers::upload_mesh_cache(device, physicalDevice, uploadEngine, cache);
+		}
+
+		// Fallback: parse the .obj file, and bake the cache for the next time
+		const auto mesh = load_mesh_data_for_cache(modelPath, submeshNamesToExclude, indexed);
+		try {
+			write_mesh_cache(mesh, modelPath, cachePath, submeshNamesToExclude, indexed);
+		}
+		catch (const std::exception& e) {
+			std::cout << "Couldn't write mesh cache '" << cachePath << "': " << e.what() << std::endl;
+		}
+		return helpers::upload_mesh_data(device, physicalDevice, uploadEngine, mesh);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+namespace helpers
+{
+	// Binary, pre-baked mesh format (*.vkmesh). All values are little endian.
+	// The file starts with this header, followed by the vertex streams and the (optional) index stream
+	// at the given byte offsets, each of them 16-byte aligned:
+	//  - positions:           vertexCount x vec3
+	//  - textureCoordinates:  vertexCount x vec2
+	//  - normals:             vertexCount x vec3
+	//  - indices:             indexCount  x uint32
+	struct mesh_cache_header
+	{
+		static constexpr uint32_t CurrentVersion = 3u;	// 2: normals are read via their own indices, 3: vertices deduplicated by bit pattern
+
+		char magic[8];						// "VKWMESH\0"
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;				// 0 if not indexed
+		uint32_t reserved;
+		uint64_t optionsHash;				// Hash of the bake options (submesh exclusion, indexing)
+		uint64_t sourceSize;				// Size of the source .obj file
+		int64_t  sourceWriteTime;			// Last write time of the source .obj file when it was baked
+		uint64_t sourceHash;				// fnv1a_64 of the source .obj file's contents
+		float boundsMin[3];					// Axis aligned bounding box of all positions
+		float boundsMax[3];
+		uint64_t positionsOffset;
+		uint64_t textureCoordinatesOffset;
+		uint64_t normalsOffset;
+		uint64_t indicesOffset;
+	};
+
+	// A memory-mapped *.vkmesh file. The streams point directly into the file mapping.
+	struct mapped_mesh_cache
+	{
+		mapped_file file;
+		const mesh_cache_header* header = nullptr;
+		const glm::vec3* positions = nullptr;
+		const glm::vec2* textureCoordinates = nullptr;
+		const glm::vec3* normals = nullptr;
+		const uint32_t* indices = nullptr;
+	};
+
+	// Returns the path of the cache file which belongs to the given .obj file ("models/x.obj" => "models/x.vkmesh")
+	std::string get_mesh_cache_path(const std::string& modelPath);
+
+	// Offline bake step: load the given .obj file (and optimize it into an indexed mesh, if <indexed> is set),
+	// and write it into a *.vkmesh file. The file is written to a temporary file first, and then renamed.
+	void bake_mesh_cache(
+		const std::string& modelPath,
+		const std::string& cachePath,
+		const std::string& submeshNamesToExclude = "",
+		const bool indexed = true
+	);
+
+	// Memory-map a *.vkmesh file and validate it against its source .obj file, i.e. against the file size and
+	// last write time (or against the contents' hash, if the write time differs). If the source file does not
+	// exist, the cache is used as is. Returns false if the cache is missing, invalid, or stale.
+	bool try_map_mesh_cache(
+		const std::string& cachePath,
+		const std::string& modelPath,
+		const std::string& submeshNamesToExclude,
+		const bool indexed,
+		mapped_mesh_cache& outCache
+	);
+
+	// Create device-local buffers and enqueue copying the streams straight from the file mapping into the
+	// upload engine's staging memory (no parsing, no intermediate vectors). Not submitted.
+	device_mesh upload_mesh_cache(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const mapped_mesh_cache& cache
+	);
+
+	// Load a mesh from its *.vkmesh cache if it is valid; otherwise, fall back to loading the .obj file,
+	// and (re-)bake the cache for the next time. The uploads are enqueued into the upload engine, but not submitted.
+	device_mesh load_mesh_with_cache(
+		const std::string& modelPath,
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const std::string& submeshNamesToExclude = "",
+		const bool indexed = true
+	);
+}
@@ -0,0 +1,236 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// Compared and hashed by bit pattern, not by float equality: -0.0 and +0.0 stay different vertices,
+		// and identical NaNs are merged.
+		struct vertex_key
+		{
+			glm::vec3 position;
+			glm::vec2 textureCoordinate;
+			glm::vec3 normal;
+
+			bool operator==(const vertex_key& other) const
+			{
+				return 0 == memcmp(this, &other, sizeof(vertex_key));
+			}
+		};
+		static_assert(sizeof(vertex_key) == 8 * sizeof(float), "vertex_key must not contain padding bytes");
+
+		struct vertex_key_hash
+		{
+			size_t operator()(const vertex_key& key) const
+			{
+				return static_cast<size_t>(helpers::fnv1a_64(&key, sizeof(vertex_key)));
+			}
+		};
+	}
+
+	mesh_data deduplicate_vertices(const mesh_data& nonIndexedMesh)
+	{
+		const auto cornerCount = nonIndexedMesh.positions.size();
+
+		mesh_data result;
+		result.indices.reserve(cornerCount);
+		std::unordered_map<vertex_key, uint32_t, vertex_key_hash> uniqueVertices;
+		uniqueVertices.reserve(cornerCount);
+
+		for (size_t i = 0; i < cornerCount; ++i) {
+			const vertex_key key{ nonIndexedMesh.positions[i], nonIndexedMesh.textureCoordinates[i], nonIndexedMesh.normals[i] };
+			const auto [it, inserted] = uniqueVertices.emplace(key, static_cast<uint32_t>(result.positions.size()));
+			if (inserted) {
+				result.positions.push_back(key.position);
+				result.textureCoordinates.push_back(key.textureCoordinate);
+				result.normals.push_back(key.normal);
+			}
+			result.indices.push_back(it->second);
+		}
+		return result;
+	}
+
+	std::vector<uint32_t> optimize_vertex_cache(
+		const std::vector<uint32_t>& indices,
+		const size_t vertexCount,
+		const uint32_t cacheSize)
+	{
+		const auto triangleCount = indices.size() / 3;
+		const auto k = static_cast<int64_t>(cacheSize);
+
+		// Vertex -> triangle adjacency in compressed form:
+		std::vector<uint32_t> liveTriangles(vertexCount, 0u);
+		for (auto index : indices) {
+			++liveTriangles[index];
+		}
+		std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; ++v) {
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+		}
+		std::vector<uint32_t> adjacency(adjacencyOffsets.back());
+		{
+			auto fill = adjacencyOffsets;
+			for (size_t t = 0; t < triangleCount; ++t) {
+				for (size_t c = 0; c < 3; ++c) {
+					adjacency[fill[indices[3 * t + c]]++] = static_cast<uint32_t>(t);
+				}
+			}
+		}
+
+		std::vector<int64_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEndStack;
+		std::vector<uint32_t> candidates;
+		int64_t time = k + 1;
+		size_t cursor = 0;
+
+		// When we're stuck: take the most recently used vertex which still has triangles, or the next one in input order
+		auto skip_dead_end = [&]() -> int64_t {
+			while (!deadEndStack.empty()) {
+				const auto d = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[d] > 0) {
+					return d;
+				}
+			}
+			while (cursor < vertexCount) {
+				if (liveTriangles[cursor] > 0) {
+					return static_cast<int64_t>(cursor++);
+				}
+				++cursor;
+			}
+			return -1;
+		};
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		int64_t fanningVertex = skip_dead_end();
+		while (fanningVertex >= 0) {
+			candidates.clear();
+
+			// Emit all remaining triangles around the fanning vertex:
+			const auto f = static_cast<size_t>(fanningVertex);
+			for (auto a = adjacencyOffsets[f]; a < adjacencyOffsets[f + 1]; ++a) {
+				const auto t = adjacency[a];
+				if (emitted[t]) {
+					continue;
+				}
+				for (size_t c = 0; c < 3; ++c) {
+					const auto v = indices[3 * t + c];
+					result.push_back(v);
+					deadEndStack.push_back(v);
+					candidates.push_back(v);
+					--liveTriangles[v];
+					if (time - cacheTimestamps[v] > k) {
+						cacheTimestamps[v] = time++;
+					}
+				}
+				emitted[t] = true;
+			}
+
+			// Pick the next fanning vertex among the candidates: prefer the one which has been in the cache
+			// for the longest time, provided that it is still going to be in the cache when its fan has been emitted.
+			int64_t best = -1;
+			int64_t bestPriority = -1;
+			for (auto v : candidates) {
+				if (0 == liveTriangles[v]) {
+					continue;
+				}
+				int64_t priority = 0;
+				if (time - cacheTimestamps[v] + 2 * static_cast<int64_t>(liveTriangles[v]) <= k) {
+					priority = time - cacheTimestamps[v];
+				}
+				if (priority > bestPriority) {
+					best = v;
+					bestPriority = priority;
+				}
+			}
+			fanningVertex = best >= 0 ? best : skip_dead_end();
+		}
+
+		return result;
+	}
+
+	void optimize_vertex_fetch(mesh_data& mesh)
+	{
+		constexpr auto Unassigned = std::numeric_limits<uint32_t>::max();
+		std::vector<uint32_t> remap(mesh.positions.size(), Unassigned);
+		uint32_t nextVertex = 0;
+		for (auto& index : mesh.indices) {
+			if (Unassigned == remap[index]) {
+				remap[index] = nextVertex++;
+			}
+			index = remap[index];
+		}
+
+		// Unreferenced vertices are dropped:
+		mesh_data reordered;
+		reordered.positions.resize(nextVertex);
+		reordered.textureCoordinates.resize(nextVertex);
+		reordered.normals.resize(nextVertex);
+		for (size_t v = 0; v < remap.size(); ++v) {
+			if (Unassigned == remap[v]) {
+				continue;
+			}
+			reordered.positions[remap[v]] = mesh.positions[v];
+			reordered.textureCoordinates[remap[v]] = mesh.textureCoordinates[v];
+			reordered.normals[remap[v]] = mesh.normals[v];
+		}
+		mesh.positions = std::move(reordered.positions);
+		mesh.textureCoordinates = std::move(reordered.textureCoordinates);
+		mesh.normals = std::move(reordered.normals);
+	}
+
+	float compute_acmr(
+		const std::vector<uint32_t>& indices,
+		const uint32_t cacheSize)
+	{
+		if (indices.size() < 3) {
+			return 0.0f;
+		}
+
+		std::deque<uint32_t> fifo;
+		size_t misses = 0;
+		for (auto index : indices) {
+			if (std::find(fifo.begin(), fifo.end(), index) != fifo.end()) {
+				continue;
+			}
+			++misses;
+			fifo.push_back(index);
+			if (fifo.size() > cacheSize) {
+				fifo.pop_front();
+			}
+		}
+		return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	}
+
+	mesh_data optimize_indexed_mesh(
+		const mesh_data& nonIndexedMesh,
+		const uint32_t cacheSize,
+		mesh_optimization_report* report)
+	{
+		auto mesh = helpers::deduplicate_vertices(nonIndexedMesh);
+		const auto acmrBefore = helpers::compute_acmr(mesh.indices, cacheSize);
+
+		mesh.indices = helpers::optimize_vertex_cache(mesh.indices, mesh.positions.size(), cacheSize);
+		helpers::optimize_vertex_fetch(mesh);
+
+		if (nullptr != report) {
+			report->cornerCount = nonIndexedMesh.positions.size();
+			report->vertexCount = mesh.positions.size();
+			report->cacheSize = cacheSize;
+			report->acmrBefore = acmrBefore;
+			report->acmrAfter = helpers::compute_acmr(mesh.indices, cacheSize);
+		}
+		return mesh;
+	}
+
+	mesh_data load_indexed_mesh_data_of_obj(
+		const std::string modelPath,
+		const std::string submeshNamesToExclude,
+		mesh_optimization_report* report,
+		const uint32_t cacheSize)
+	{
+		return helpers::optimize_indexed_mesh(helpers::load_mesh_data_of_obj_parallel(modelPath, submeshNamesToExclude), cacheSize, report);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+namespace helpers
+{
+	// The post-transform vertex cache size which meshes are optimized for, unless specified otherwise
+	constexpr uint32_t DefaultVertexCacheSize = 16u;
+
+	// Statistics gathered by optimize_indexed_mesh
+	struct mesh_optimization_report
+	{
+		size_t cornerCount = 0;		// Number of vertices before deduplication (= number of indices)
+		size_t vertexCount = 0;		// Number of unique vertices after deduplication
+		uint32_t cacheSize = 0;		// FIFO cache size which has been used for optimization and for the ACMR values
+		float acmrBefore = 0.0f;	// Average cache miss ratio (vertex shader invocations per triangle) before reordering
+		float acmrAfter = 0.0f;		// ... and after reordering the triangles
+	};
+
+	// Turn a non-indexed mesh (one vertex per face corner) into an indexed mesh by merging all
+	// vertices with bit-identical position, texture coordinates, and normal (compared bit by bit, not as floats).
+	// Vertices are numbered in the order of their first occurrence, i.e. the result is deterministic.
+	mesh_data deduplicate_vertices(const mesh_data& nonIndexedMesh);
+
+	// Reorder the triangles of an indexed triangle list for a post-transform vertex cache of the
+	// given size, using the Tipsify algorithm (Sander, Nehab, Barczak: "Fast Triangle Reordering
+	// for Vertex Locality and Reduced Overdraw", 2007). Deterministic for the same input.
+	std::vector<uint32_t> optimize_vertex_cache(
+		const std::vector<uint32_t>& indices,
+		const size_t vertexCount,
+		const uint32_t cacheSize = DefaultVertexCacheSize
+	);
+
+	// Reorder the vertices of an indexed mesh in the order in which they are first referenced by
+	// the index buffer (and remap the indices accordingly), which improves vertex fetch locality.
+	void optimize_vertex_fetch(mesh_data& mesh);
+
+	// Simulate a FIFO post-transform cache of the given size and return the average cache miss ratio,
+	// i.e. the number of vertex shader invocations per triangle. (Best case ~0.5, worst case 3.0)
+	float compute_acmr(
+		const std::vector<uint32_t>& indices,
+		const uint32_t cacheSize = DefaultVertexCacheSize
+	);
+
+	// Deduplicate the vertices of a non-indexed mesh and optimize the result for the post-transform
+	// cache and for vertex fetch. Statistics are written into <report>, if given.
+	mesh_data optimize_indexed_mesh(
+		const mesh_data& nonIndexedMesh,
+		const uint32_t cacheSize = DefaultVertexCacheSize,
+		mesh_optimization_report* report = nullptr
+	);
+
+	// Loads the given 3D .obj model from file and turns it into an optimized, indexed mesh,
+	// reordered for a post-transform vertex cache of <cacheSize> entries
+	mesh_data load_indexed_mesh_data_of_obj(
+		const std::string modelPath,
+		const std::string submeshNamesToExclude = "",
+		mesh_optimization_report* report = nullptr,
+		const uint32_t cacheSize = DefaultVertexCacheSize
+	);
+}
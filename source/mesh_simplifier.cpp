@@ -0,0 +1,665 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// Position (3), texture coordinates (2), normal (3)
+		constexpr size_t Dimensions = 8;
+		constexpr size_t SymmetricElements = Dimensions * (Dimensions + 1) / 2;
+		constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+		using attribute_vector = std::array<double, Dimensions>;
+
+		double dot(const attribute_vector& a, const attribute_vector& b)
+		{
+			double result = 0.0;
+			for (size_t i = 0; i < Dimensions; ++i) {
+				result += a[i] * b[i];
+			}
+			return result;
+		}
+
+		// Generalized quadric over all attributes: error(v) = v^T A v + 2 b^T v + c, with A symmetric (upper triangle stored
+		// row by row), weighted by the area of the triangles it has been built from
+		struct quadric
+		{
+			std::array<double, SymmetricElements> a{};
+			attribute_vector b{};
+			double c = 0.0;
+			double weight = 0.0;
+
+			void add(const quadric& other)
+			{
+				for (size_t i = 0; i < SymmetricElements; ++i) {
+					a[i] += other.a[i];
+				}
+				for (size_t i = 0; i < Dimensions; ++i) {
+					b[i] += other.b[i];
+				}
+				c += other.c;
+				weight += other.weight;
+			}
+
+			double evaluate(const attribute_vector& v) const
+			{
+				double result = c;
+				size_t k = 0;
+				for (size_t i = 0; i < Dimensions; ++i) {
+					result += a[k++] * v[i] * v[i];
+					for (size_t j = i + 1; j < Dimensions; ++j) {
+						result += 2.0 * a[k++] * v[i] * v[j];
+					}
+					result += 2.0 * b[i] * v[i];
+				}
+				return std::max(0.0, result);
+			}
+		};
+
+		// The quadric of the distance to the plane through the triangle in attribute space (Garland, Heckbert 1998, 3.2):
+		// with e1, e2 an orthonormal basis of the plane, A = I - e1 e1^T - e2 e2^T, b = (p.e1) e1 + (p.e2) e2 - p,
+		// and c = p.p - (p.e1)^2 - (p.e2)^2
+		quadric make_triangle_quadric(const attribute_vector& p, const attribute_vector& q, const attribute_vector& r, const double area)
+		{
+			quadric result;
+			attribute_vector e1, e2;
+			for (size_t i = 0; i < Dimensions; ++i) {
+				e1[i] = q[i] - p[i];
+				e2[i] = r[i] - p[i];
+			}
+			const auto length1 = std::sqrt(dot(e1, e1));
+			if (length1 < 1e-12) {
+				return result;
+			}
+			for (auto& x : e1) {
+				x /= length1;
+			}
+			const auto projection = dot(e1, e2);
+			for (size_t i = 0; i < Dimensions; ++i) {
+				e2[i] -= projection * e1[i];
+			}
+			const auto length2 = std::sqrt(dot(e2, e2));
+			if (length2 < 1e-12) {
+				return result;
+			}
+			for (auto& x : e2) {
+				x /= length2;
+			}
+
+			const auto pe1 = dot(p, e1);
+			const auto pe2 = dot(p, e2);
+			size_t k = 0;
+			for (size_t i = 0; i < Dimensions; ++i) {
+				for (size_t j = i; j < Dimensions; ++j) {
+					result.a[k++] = area * ((i == j ? 1.0 : 0.0) - e1[i] * e1[j] - e2[i] * e2[j]);
+				}
+				result.b[i] = area * (pe1 * e1[i] + pe2 * e2[i] - p[i]);
+			}
+			result.c = area * (dot(p, p) - pe1 * pe1 - pe2 * pe2);
+			result.weight = area;
+			return result;
+		}
+
+		// Add the squared distance to a plane (n, d) in position space only: (n.p + d)^2 = p^T (n n^T) p + 2 d n.p + d^2
+		void add_position_plane(quadric& q, const glm::dvec3& n, const double d, const double weight)
+		{
+			size_t k = 0;
+			for (glm::length_t i = 0; i < 3; ++i) {
+				for (glm::length_t j = i; j < static_cast<glm::length_t>(Dimensions); ++j) {
+					q.a[k++] += j < 3 ? weight * n[i] * n[j] : 0.0;
+				}
+				q.b[i] += weight * d * n[i];
+			}
+			q.c += weight * d * d;
+		}
+
+		// Area-weighted sum of squared distances to a set of planes, in model units
+		struct plane_quadric
+		{
+			std::array<double, 10> a{};	// xx xy xz xd yy yz yd zz zd dd
+			double weight = 0.0;
+
+			void add_plane(const glm::dvec3& n, const double d, const double w)
+			{
+				a[0] += w * n.x * n.x; a[1] += w * n.x * n.y; a[2] += w * n.x * n.z; a[3] += w * n.x * d;
+				a[4] += w * n.y * n.y; a[5] += w * n.y * n.z; a[6] += w * n.y * d;
+				a[7] += w * n.z * n.z; a[8] += w * n.z * d;
+				a[9] += w * d * d;
+				weight += w;
+			}
+
+			void add(const plane_quadric& other)
+			{
+				for (size_t i = 0; i < a.size(); ++i) {
+					a[i] += other.a[i];
+				}
+				weight += other.weight;
+			}
+
+			// Root mean square distance to the planes, weighted by their areas
+			double rms_distance(const glm::dvec3& p) const
+			{
+				if (weight <= 0.0) {
+					return 0.0;
+				}
+				const auto sum = a[0] * p.x * p.x + 2.0 * a[1] * p.x * p.y + 2.0 * a[2] * p.x * p.z + 2.0 * a[3] * p.x
+					+ a[4] * p.y * p.y + 2.0 * a[5] * p.y * p.z + 2.0 * a[6] * p.y
+					+ a[7] * p.z * p.z + 2.0 * a[8] * p.z
+					+ a[9];
+				return std::sqrt(std::max(0.0, sum) / weight);
+			}
+		};
+
+		// Border edges get an additional plane through the edge, perpendicular to its triangle, s.t. collapses along the
+		// border are cheap, but pulling the border inwards (or outwards) is not (Garland, Heckbert 1997, 6.1)
+		constexpr double BorderPlaneWeight = 10.0;
+
+		// The plane through the border edge a-b, perpendicular to its triangle a-b-o, and its weight
+		bool get_border_plane(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& o, glm::dvec3& outNormal, double& outWeight)
+		{
+			const auto edge = b - a;
+			const auto normal = glm::cross(edge, glm::cross(edge, o - a));
+			const auto length = glm::length(normal);
+			if (length <= 0.0) {
+				return false;
+			}
+			outNormal = normal / length;
+			outWeight = BorderPlaneWeight * glm::dot(edge, edge);
+			return true;
+		}
+
+		// Moving all vertices at position <from> onto the vertices at position <to>
+		struct collapse_candidate
+		{
+			double cost;
+			uint32_t from;
+			uint32_t to;
+			uint32_t fromVersion;
+			uint32_t toVersion;
+
+			bool operator>(const collapse_candidate& other) const { return cost > other.cost; }
+		};
+
+		// The state of an ongoing simplification. Vertices are never moved; "positions" are the groups of vertices
+		// with bit-identical positions (a vertex per side of a UV seam or hard edge), and edges are collapsed between positions.
+		class simplifier
+		{
+		public:
+			simplifier(const mesh_data& mesh, const simplification_options& options)
+				: mIndices{ mesh.indices }
+				, mTriangleAlive(mesh.indices.size() / 3, true)
+				, mTriangleCount{ mesh.indices.size() / 3 }
+			{
+				const auto vertexCount = mesh.positions.size();
+
+				// Normalize the positions to the mesh's extent, s.t. the attribute weights mean the same for every mesh:
+				glm::vec3 boundsMin{ std::numeric_limits<float>::max() }, boundsMax{ std::numeric_limits<float>::lowest() };
+				for (const auto& p : mesh.positions) {
+					boundsMin = glm::min(boundsMin, p);
+					boundsMax = glm::max(boundsMax, p);
+				}
+				const auto extent = std::max(1e-6f, std::max(boundsMax.x - boundsMin.x, std::max(boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z)));
+
+				mAttributes.resize(vertexCount);
+				mPositionOf.resize(vertexCount);
+				std::unordered_map<glm::vec3, uint32_t> positionIds;
+				for (size_t v = 0; v < vertexCount; ++v) {
+					const auto p = (mesh.positions[v] - boundsMin) / extent;
+					const auto uv = v < mesh.textureCoordinates.size() ? mesh.textureCoordinates[v] * options.textureCoordinatesWeight : glm::vec2{ 0.0f };
+					const auto n = v < mesh.normals.size() ? mesh.normals[v] * options.normalsWeight : glm::vec3{ 0.0f };
+					mAttributes[v] = { p.x, p.y, p.z, uv.x, uv.y, n.x, n.y, n.z };
+
+					const auto [it, inserted] = positionIds.emplace(mesh.positions[v], static_cast<uint32_t>(mPositions.size()));
+					if (inserted) {
+						mPositions.push_back(mesh.positions[v]);
+						mNormalizedPositions.push_back(glm::dvec3(p));
+						mPositionWedges.emplace_back();
+					}
+					mPositionOf[v] = it->second;
+					mPositionWedges[it->second].push_back(static_cast<uint32_t>(v));
+				}
+				const auto positionCount = mPositions.size();
+
+				mVertexTriangles.resize(vertexCount);
+				mVertexQuadrics.resize(vertexCount);
+				mPositionQuadrics.resize(positionCount);
+				mPositionVersions.resize(positionCount, 0u);
+				mLocked.resize(positionCount, false);
+				mBorder.resize(positionCount, false);
+				std::unordered_map<uint64_t, uint32_t> edgeUseCounts;
+				for (size_t t = 0; t < mTriangleAlive.size(); ++t) {
+					const uint32_t* corners = &mIndices[3 * t];
+					for (size_t c = 0; c < 3; ++c) {
+						mVertexTriangles[corners[c]].push_back(static_cast<uint32_t>(t));
+					}
+
+					// Attribute quadric, weighted by the (normalized) area:
+					const auto p0 = mNormalizedPositions[mPositionOf[corners[0]]];
+					const auto p1 = mNormalizedPositions[mPositionOf[corners[1]]];
+					const auto p2 = mNormalizedPositions[mPositionOf[corners[2]]];
+					const auto area = 0.5 * glm::length(glm::cross(p1 - p0, p2 - p0));
+					const auto triangleQuadric = make_triangle_quadric(mAttributes[corners[0]], mAttributes[corners[1]], mAttributes[corners[2]], area);
+					for (size_t c = 0; c < 3; ++c) {
+						mVertexQuadrics[corners[c]].add(triangleQuadric);
+					}
+
+					// Plane quadric in model units, for the geometric error:
+					const auto m0 = glm::dvec3(mPositions[mPositionOf[corners[0]]]);
+					const auto normal = glm::cross(glm::dvec3(mPositions[mPositionOf[corners[1]]]) - m0, glm::dvec3(mPositions[mPositionOf[corners[2]]]) - m0);
+					const auto normalLength = glm::length(normal);
+					if (normalLength > 0.0) {
+						const auto n = normal / normalLength;
+						for (size_t c = 0; c < 3; ++c) {
+							mPositionQuadrics[mPositionOf[corners[c]]].add_plane(n, -glm::dot(n, m0), 0.5 * normalLength);
+						}
+					}
+
+					for (size_t c = 0; c < 3; ++c) {
+						++edgeUseCounts[edge_key(mPositionOf[corners[c]], mPositionOf[corners[(c + 1) % 3]])];
+					}
+				}
+
+				// Vertices on non-manifold edges (more than two triangles) stay where they are; vertices on open borders
+				// (edges of one triangle) may only move along the border:
+				for (const auto& [key, count] : edgeUseCounts) {
+					if (count > 2u) {
+						mLocked[static_cast<uint32_t>(key >> 32)] = true;
+						mLocked[static_cast<uint32_t>(key & 0xffffffffull)] = true;
+					}
+				}
+				for (size_t t = 0; t < mTriangleAlive.size(); ++t) {
+					const uint32_t* corners = &mIndices[3 * t];
+					for (size_t c = 0; c < 3; ++c) {
+						const auto a = mPositionOf[corners[c]];
+						const auto b = mPositionOf[corners[(c + 1) % 3]];
+						if (1u != edgeUseCounts[edge_key(a, b)]) {
+							continue;
+						}
+						mBorder[a] = true;
+						mBorder[b] = true;
+
+						const auto o = mPositionOf[corners[(c + 2) % 3]];
+						glm::dvec3 n;
+						double weight;
+						if (get_border_plane(mNormalizedPositions[a], mNormalizedPositions[b], mNormalizedPositions[o], n, weight)) {
+							for (const auto end : { a, b }) {
+								for (const auto wedge : mPositionWedges[end]) {
+									add_position_plane(mVertexQuadrics[wedge], n, -glm::dot(n, mNormalizedPositions[a]), weight / static_cast<double>(mPositionWedges[end].size()));
+								}
+							}
+						}
+						if (get_border_plane(glm::dvec3(mPositions[a]), glm::dvec3(mPositions[b]), glm::dvec3(mPositions[o]), n, weight)) {
+							for (const auto end : { a, b }) {
+								mPositionQuadrics[end].add_plane(n, -glm::dot(n, glm::dvec3(mPositions[a])), weight);
+							}
+						}
+					}
+				}
+
+				for (uint32_t p = 0; p < positionCount; ++p) {
+					push_candidates(p);
+				}
+			}
+
+			size_t triangle_count() const { return mTriangleCount; }
+			bool seams_relaxed() const { return mSeamsRelaxed; }
+
+			// From now on, allow collapses which don't keep seams intact, and queue all edges again
+			void relax_seams()
+			{
+				mSeamsRelaxed = true;
+				for (uint32_t p = 0; p < mPositionWedges.size(); ++p) {
+					if (!mPositionWedges[p].empty()) {
+						++mPositionVersions[p];
+					}
+				}
+				for (uint32_t p = 0; p < mPositionWedges.size(); ++p) {
+					if (!mPositionWedges[p].empty()) {
+						push_candidates(p);
+					}
+				}
+			}
+			float error() const { return static_cast<float>(mMaxError); }
+			float attribute_error() const { return static_cast<float>(mMaxAttributeError); }
+
+			std::vector<uint32_t> live_indices() const
+			{
+				std::vector<uint32_t> result;
+				result.reserve(3 * mTriangleCount);
+				for (size_t t = 0; t < mTriangleAlive.size(); ++t) {
+					if (mTriangleAlive[t]) {
+						result.insert(result.end(), &mIndices[3 * t], &mIndices[3 * t] + 3);
+					}
+				}
+				return result;
+			}
+
+			// Collapse the cheapest edges until at most <targetTriangleCount> triangles are left.
+			// Returns false if no more edges could be collapsed before reaching the target.
+			bool simplify_to(const size_t targetTriangleCount)
+			{
+				std::vector<std::tuple<uint32_t, uint32_t>> mapping;
+				while (mTriangleCount > targetTriangleCount) {
+					if (mCandidates.empty()) {
+						return false;
+					}
+					const auto candidate = mCandidates.top();
+					mCandidates.pop();
+					if (candidate.fromVersion != mPositionVersions[candidate.from] || candidate.toVersion != mPositionVersions[candidate.to]) {
+						continue; // Stale: the neighborhood has changed since, the edge has been queued again
+					}
+					const auto cost = evaluate_collapse(candidate.from, candidate.to, mapping);
+					if (!cost.has_value()) {
+						continue;
+					}
+					apply_collapse(candidate.from, candidate.to, mapping);
+				}
+				return true;
+			}
+
+		private:
+			static uint64_t edge_key(const uint32_t a, const uint32_t b)
+			{
+				return (static_cast<uint64_t>(std::min(a, b)) << 32) | static_cast<uint64_t>(std::max(a, b));
+			}
+
+			// Positions which share a live triangle with <position>
+			void get_neighbors(const uint32_t position, std::vector<uint32_t>& outNeighbors) const
+			{
+				outNeighbors.clear();
+				for (const auto wedge : mPositionWedges[position]) {
+					for (const auto t : mVertexTriangles[wedge]) {
+						if (!mTriangleAlive[t]) {
+							continue;
+						}
+						for (size_t c = 0; c < 3; ++c) {
+							const auto neighbor = mPositionOf[mIndices[3 * t + c]];
+							if (neighbor != position && std::find(outNeighbors.begin(), outNeighbors.end(), neighbor) == outNeighbors.end()) {
+								outNeighbors.push_back(neighbor);
+							}
+						}
+					}
+				}
+			}
+
+			// Queue the collapses of all edges of <position>, in both directions
+			void push_candidates(const uint32_t position)
+			{
+				std::vector<uint32_t> neighbors;
+				std::vector<std::tuple<uint32_t, uint32_t>> mapping;
+				get_neighbors(position, neighbors);
+				for (const auto neighbor : neighbors) {
+					for (const auto& [from, to] : { std::make_tuple(position, neighbor), std::make_tuple(neighbor, position) }) {
+						const auto cost = evaluate_collapse(from, to, mapping);
+						if (cost.has_value()) {
+							mCandidates.push(collapse_candidate{ *cost, from, to, mPositionVersions[from], mPositionVersions[to] });
+						}
+					}
+				}
+			}
+
+			// The cost of collapsing <from> onto <to>, or nothing if that collapse is not allowed. Writes which vertex
+			// of <from> is going to be replaced by which vertex of <to> into <outMapping>.
+			std::optional<double> evaluate_collapse(const uint32_t from, const uint32_t to, std::vector<std::tuple<uint32_t, uint32_t>>& outMapping) const
+			{
+				if (mLocked[from] || mPositionWedges[from].empty()) {
+					return std::nullopt;
+				}
+
+				// Each vertex at <from> must share a triangle with exactly one vertex at <to> -- its counterpart on the same side
+				// of a seam. Otherwise, the collapse would tear the seam open or drag attributes across it:
+				outMapping.clear();
+				for (const auto wedge : mPositionWedges[from]) {
+					uint32_t target = InvalidIndex;
+					bool used = false;
+					bool ambiguous = false;
+					for (const auto t : mVertexTriangles[wedge]) {
+						if (!mTriangleAlive[t]) {
+							continue;
+						}
+						used = true;
+						for (size_t c = 0; c < 3; ++c) {
+							const auto vertex = mIndices[3 * t + c];
+							if (mPositionOf[vertex] == to) {
+								ambiguous = ambiguous || (InvalidIndex != target && target != vertex);
+								target = vertex;
+							}
+						}
+					}
+					if (!used) {
+						continue; // All of its triangles have collapsed already
+					}
+					if (InvalidIndex == target || ambiguous) {
+						if (!mSeamsRelaxed) {
+							return std::nullopt;
+						}
+						// Across the seam: onto the vertex at <to> whose attributes are the closest
+						auto bestCost = std::numeric_limits<double>::max();
+						for (const auto candidate : mPositionWedges[to]) {
+							const auto cost = mVertexQuadrics[wedge].evaluate(mAttributes[candidate]);
+							if (cost < bestCost) {
+								bestCost = cost;
+								target = candidate;
+							}
+						}
+					}
+					outMapping.emplace_back(wedge, target);
+				}
+				if (outMapping.empty()) {
+					return std::nullopt;
+				}
+
+				// Link condition: the only positions adjacent to both ends must be the third corners of the edge's triangles,
+				// otherwise the collapse would create non-manifold edges (or fold the mesh onto itself):
+				size_t edgeTriangles = 0;
+				std::vector<uint32_t> fromNeighbors, toNeighbors;
+				get_neighbors(from, fromNeighbors);
+				get_neighbors(to, toNeighbors);
+				size_t commonNeighbors = 0;
+				for (const auto n : fromNeighbors) {
+					if (std::find(toNeighbors.begin(), toNeighbors.end(), n) != toNeighbors.end()) {
+						++commonNeighbors;
+					}
+				}
+
+				// Triangles which stay must not flip (or become slivers):
+				const auto& newPosition = mNormalizedPositions[to];
+				for (const auto wedge : mPositionWedges[from]) {
+					for (const auto t : mVertexTriangles[wedge]) {
+						if (!mTriangleAlive[t]) {
+							continue;
+						}
+						std::array<glm::dvec3, 3> corners;
+						bool containsTo = false;
+						size_t movedCorner = 0;
+						for (size_t c = 0; c < 3; ++c) {
+							const auto position = mPositionOf[mIndices[3 * t + c]];
+							containsTo = containsTo || position == to;
+							if (position == from) {
+								movedCorner = c;
+							}
+							corners[c] = mNormalizedPositions[position];
+						}
+						if (containsTo) {
+							++edgeTriangles;
+							continue; // Collapses into a line, i.e. is removed
+						}
+						const auto before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+						corners[movedCorner] = newPosition;
+						const auto after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+						if (glm::dot(before, after) <= 0.25 * glm::length(before) * glm::length(after)) {
+							return std::nullopt;
+						}
+					}
+				}
+				if (commonNeighbors != edgeTriangles) {
+					return std::nullopt;
+				}
+				// Border vertices only move along border edges (which have a single triangle):
+				if (mBorder[from] && (1u != edgeTriangles || !mBorder[to])) {
+					return std::nullopt;
+				}
+
+				double cost = 0.0;
+				for (const auto& [wedge, target] : outMapping) {
+					cost += mVertexQuadrics[wedge].evaluate(mAttributes[target]);
+				}
+				return cost;
+			}
+
+			void apply_collapse(const uint32_t from, const uint32_t to, const std::vector<std::tuple<uint32_t, uint32_t>>& mapping)
+			{
+				double weight = 0.0;
+				double cost = 0.0;
+				for (const auto& [wedge, target] : mapping) {
+					cost += mVertexQuadrics[wedge].evaluate(mAttributes[target]);
+					weight += mVertexQuadrics[wedge].weight + mVertexQuadrics[target].weight;
+					mVertexQuadrics[target].add(mVertexQuadrics[wedge]);
+				}
+				if (weight > 0.0) {
+					mMaxAttributeError = std::max(mMaxAttributeError, std::sqrt(cost / weight));
+				}
+				mPositionQuadrics[to].add(mPositionQuadrics[from]);
+				mMaxError = std::max(mMaxError, mPositionQuadrics[to].rms_distance(glm::dvec3(mPositions[to])));
+
+				for (const auto& [wedge, target] : mapping) {
+					for (const auto t : mVertexTriangles[wedge]) {
+						if (!mTriangleAlive[t]) {
+							continue;
+						}
+						uint32_t* corners = &mIndices[3 * t];
+						for (size_t c = 0; c < 3; ++c) {
+							if (corners[c] == wedge) {
+								corners[c] = target;
+							}
+						}
+						const auto p0 = mPositionOf[corners[0]], p1 = mPositionOf[corners[1]], p2 = mPositionOf[corners[2]];
+						if (p0 == p1 || p1 == p2 || p2 == p0) {
+							mTriangleAlive[t] = false;
+							--mTriangleCount;
+						}
+						else {
+							mVertexTriangles[target].push_back(t);
+						}
+					}
+					mVertexTriangles[wedge].clear();
+				}
+				mPositionWedges[from].clear();
+
+				// Everything around <to> has changed => invalidate and re-queue the edges of <to> and of its neighbors:
+				++mPositionVersions[from];
+				++mPositionVersions[to];
+				std::vector<uint32_t> neighbors;
+				get_neighbors(to, neighbors);
+				for (const auto n : neighbors) {
+					++mPositionVersions[n];
+				}
+				push_candidates(to);
+				for (const auto n : neighbors) {
+					push_candidates(n);
+				}
+			}
+
+			std::vector<uint32_t> mIndices;
+			std::vector<bool> mTriangleAlive;
+			size_t mTriangleCount;
+			std::vector<attribute_vector> mAttributes;				// Per vertex, normalized and weighted
+			std::vector<uint32_t> mPositionOf;						// Vertex => position
+			std::vector<glm::vec3> mPositions;						// Per position, in model units
+			std::vector<glm::dvec3> mNormalizedPositions;
+			std::vector<std::vector<uint32_t>> mPositionWedges;		// Position => its vertices (empty once collapsed)
+			std::vector<std::vector<uint32_t>> mVertexTriangles;	// Vertex => triangles which (have) use(d) it
+			std::vector<quadric> mVertexQuadrics;
+			std::vector<plane_quadric> mPositionQuadrics;
+			std::vector<uint32_t> mPositionVersions;				// Incremented whenever a position's neighborhood changes
+			std::vector<bool> mLocked;
+			std::vector<bool> mBorder;
+			std::priority_queue<collapse_candidate, std::vector<collapse_candidate>, std::greater<collapse_candidate>> mCandidates;
+			double mMaxError = 0.0;
+			double mMaxAttributeError = 0.0;
+			bool mSeamsRelaxed = false;
+		};
+	}
+
+	mesh_lod_chain generate_lod_chain(
+		const mesh_data& indexedMesh,
+		const simplification_options& options)
+	{
+		if (indexedMesh.indices.empty()) {
+			throw std::invalid_argument("Only indexed meshes can be simplified");
+		}
+		const auto begin = std::chrono::steady_clock::now();
+
+		mesh_lod_chain chain;
+		chain.mesh.positions = indexedMesh.positions;
+		chain.mesh.textureCoordinates = indexedMesh.textureCoordinates;
+		chain.mesh.normals = indexedMesh.normals;
+		chain.mesh.indices = indexedMesh.indices;
+		chain.lods.push_back(mesh_lod{ 0u, static_cast<uint32_t>(indexedMesh.indices.size()), 0.0f, 0.0f });
+
+		simplifier state(indexedMesh, options);
+		auto targetTriangleCount = static_cast<double>(state.triangle_count());
+		for (uint32_t level = 1; level < options.levelCount; ++level) {
+			targetTriangleCount *= static_cast<double>(options.reductionPerLevel);
+			const auto previousTriangleCount = state.triangle_count();
+			auto reached = state.simplify_to(static_cast<size_t>(targetTriangleCount));
+			if (!reached && options.relaxSeams && !state.seams_relaxed()) {
+				state.relax_seams();
+				reached = state.simplify_to(static_cast<size_t>(targetTriangleCount));
+			}
+			if (state.triangle_count() == previousTriangleCount) {
+				break; // Nothing left to collapse
+			}
+
+			// All levels index into the same vertices => just append the level's indices, optimized for the vertex cache:
+			const auto levelIndices = helpers::optimize_vertex_cache(state.live_indices(), indexedMesh.positions.size(), options.cacheSize);
+			chain.lods.push_back(mesh_lod{ static_cast<uint32_t>(chain.mesh.indices.size()), static_cast<uint32_t>(levelIndices.size()), state.error(), state.attribute_error() });
+			chain.mesh.indices.insert(chain.mesh.indices.end(), levelIndices.begin(), levelIndices.end());
+			if (!reached) {
+				break;
+			}
+		}
+
+		const auto end = std::chrono::steady_clock::now();
+		chain.generationMs = std::chrono::duration<double, std::milli>(end - begin).count();
+		return chain;
+	}
+
+	float compute_projection_scale(const float fovyRadians, const uint32_t viewportHeight)
+	{
+		return static_cast<float>(viewportHeight) / (2.0f * std::tan(fovyRadians * 0.5f));
+	}
+
+	uint32_t select_lod(
+		const std::vector<mesh_lod>& lods,
+		const glm::vec4& viewSpaceBoundingSphere,
+		const float modelScale,
+		const float projectionScale,
+		const float maxPixelError)
+	{
+		const auto distance = glm::length(glm::vec3(viewSpaceBoundingSphere)) - viewSpaceBoundingSphere.w;
+		if (distance <= 1e-4f) {
+			return 0u; // The camera is inside of the bounding sphere
+		}
+		const auto pixelsPerModelUnit = modelScale * projectionScale / distance;
+		for (auto level = static_cast<uint32_t>(lods.size()); level-- > 1u; ) {
+			if (lods[level].error * pixelsPerModelUnit <= maxPixelError) {
+				return level;
+			}
+		}
+		return 0u;
+	}
+
+	void print_lod_chain(std::ostream& stream, const mesh_lod_chain& chain)
+	{
+		const auto triangles0 = static_cast<double>(chain.lods.front().indexCount / 3);
+		stream << chain.lods.size() << " LODs, generated in " << chain.generationMs << " ms" << std::endl;
+		for (size_t i = 0; i < chain.lods.size(); ++i) {
+			const auto& lod = chain.lods[i];
+			stream << "  LOD " << i << ": " << std::setw(8) << lod.indexCount / 3 << " triangles (" << std::setw(5) << std::fixed << std::setprecision(1)
+				<< 100.0 * static_cast<double>(lod.indexCount / 3) / triangles0 << "%), error " << std::defaultfloat << std::setprecision(4)
+				<< lod.error << " model units, attribute error " << lod.attributeError << std::endl;
+		}
+		stream << std::defaultfloat << std::setprecision(6);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+namespace helpers
+{
+	// How much the attributes count in the simplification error, relative to the positions (which are normalized to
+	// the mesh's extent, i.e. an error of 0.01 is 1% of the mesh's size): texture coordinates are in texture space,
+	// normals are unit vectors. Higher weights preserve UV layouts and shading at the expense of the silhouette.
+	struct simplification_options
+	{
+		float textureCoordinatesWeight = 0.5f;
+		float normalsWeight = 0.25f;
+		uint32_t levelCount = 5;			// Including LOD 0, the original mesh
+		float reductionPerLevel = 0.5f;		// Triangle count of each level relative to the previous level
+		uint32_t cacheSize = DefaultVertexCacheSize;			// Each level's triangles are reordered for a vertex cache of this size
+		bool relaxSeams = true;				// Once no seam-preserving collapse is left, continue with collapses across seams
+	};
+
+	// One level of detail: a range of the LOD chain's index buffer
+	struct mesh_lod
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		float error = 0.0f;					// Largest geometric deviation of a collapse from the original surface, in model units
+		float attributeError = 0.0f;		// Largest combined (position and attribute) error of any collapse, normalized
+	};
+
+	// A mesh with multiple levels of detail, which all share the same vertices. <mesh.indices> contains the indices
+	// of all levels, one after the other, starting with LOD 0. Draw level i with lods[i].firstIndex and lods[i].indexCount.
+	struct mesh_lod_chain
+	{
+		mesh_data mesh;
+		std::vector<mesh_lod> lods;
+		double generationMs = 0.0;
+	};
+
+	// Simplify an indexed mesh (e.g. from optimize_indexed_mesh) into a chain of LODs with quadric error metrics
+	// (Garland, Heckbert: "Simplifying Surfaces with Color and Texture using Quadric Error Metrics", 1998). Each vertex
+	// gets a quadric over its position, texture coordinates and normal; edges are collapsed cheapest first, onto one
+	// of their two existing vertices (half-edge collapses), s.t. no new vertices are created.
+	//
+	// Vertices which share their position but differ in their attributes (UV seams, hard edges) are collapsed together,
+	// and only if every one of them has a counterpart on the other end of the edge, i.e. seams stay closed. Where seams
+	// meet, that is never the case; hard-surface meshes with many hard edges therefore stop early, unless <relaxSeams>
+	// allows the coarser levels to map vertices onto the closest vertex across the seam. Vertices on open borders only
+	// move along the border, vertices on non-manifold edges never, and collapses which would flip a triangle are rejected.
+	// Each level continues where the previous one has stopped; if no collapse is possible anymore, the chain ends early.
+	mesh_lod_chain generate_lod_chain(
+		const mesh_data& indexedMesh,
+		const simplification_options& options = simplification_options{}
+	);
+
+	// Factor from model units at a distance of 1 to pixels on the screen: a sphere of radius r at distance d covers
+	// about r / d * projectionScale pixels.
+	float compute_projection_scale(const float fovyRadians, const uint32_t viewportHeight);
+
+	// Select the coarsest level whose error, projected onto the screen, is at most <maxPixelError> pixels.
+	// <boundingSphere> (center in view space, radius) is the instance's bounding sphere; the error is taken at the
+	// sphere's nearest point. <modelScale> is the largest axis scale of the instance's model matrix. Cheap enough
+	// to be called per draw.
+	uint32_t select_lod(
+		const std::vector<mesh_lod>& lods,
+		const glm::vec4& viewSpaceBoundingSphere,
+		const float modelScale,
+		const float projectionScale,
+		const float maxPixelError = 1.0f
+	);
+
+	// Print each level's triangle count (also relative to LOD 0) and error
+	void print_lod_chain(std::ostream& stream, const mesh_lod_chain& chain);
+}
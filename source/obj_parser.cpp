@@ -0,0 +1,589 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// Chunks smaller than this are not worth a job of their own
+		constexpr size_t MinChunkSize = 256 * 1024;
+		// More chunks than threads, because chunks with many faces take longer than chunks with many vertices
+		constexpr size_t ChunksPerThread = 4;
+
+		// A face which has been parsed from a chunk; its corners are stored in obj_chunk::corners
+		struct obj_face
+		{
+			size_t firstCorner;
+			size_t cornerCount;
+		};
+
+		// A 'g' or 'o' record, i.e. the submesh changes before the face with the given index
+		struct obj_submesh_change
+		{
+			size_t faceIndex;
+			bool excluded;
+		};
+
+		// A negative (= relative) index can only be resolved after the number of elements in all previous
+		// chunks is known. It is resolved relative to the chunk's beginning first, and offset afterwards.
+		struct obj_relative_index
+		{
+			size_t cornerIndex;
+			int tinyobj::index_t::* member;
+		};
+
+		struct obj_chunk
+		{
+			const char* begin = nullptr;
+			const char* end = nullptr;
+
+			// Results of parsing the chunk:
+			std::vector<float> vertices;
+			std::vector<float> texcoords;
+			std::vector<float> normals;
+			std::vector<tinyobj::index_t> corners;
+			std::vector<obj_face> faces;
+			std::vector<obj_submesh_change> submeshChanges;
+			std::vector<obj_relative_index> relativeIndices;
+
+			// Results of merging:
+			size_t verticesOffset = 0;		// Offsets into the merged attribute arrays, in floats
+			size_t texcoordsOffset = 0;
+			size_t normalsOffset = 0;
+			bool excludedAtBegin = false;	// Is the submesh which continues from the previous chunk excluded?
+			std::vector<tinyobj::index_t> triangles;
+			size_t outputOffset = 0;		// Offset of the triangles' corners in the resulting mesh_data
+		};
+
+		bool is_blank(const char c)
+		{
+			return ' ' == c || '\t' == c;
+		}
+
+		char char_at(const char* position, const char* lineEnd)
+		{
+			return position < lineEnd ? *position : '\0';
+		}
+
+		const char* skip_blanks(const char* token, const char* lineEnd)
+		{
+			while (token < lineEnd && is_blank(*token)) {
+				++token;
+			}
+			return token;
+		}
+
+		// Equivalent of tinyobj's tryParseDouble. It is not correctly rounded (and neither is this), but the values
+		// have to match load_mesh_data_of_obj's values bit by bit.
+		bool try_parse_double(const char* s, const char* sEnd, double* result)
+		{
+			static const double PowLut[] = { 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+			constexpr int LutEntries = static_cast<int>(sizeof PowLut / sizeof PowLut[0]);
+			auto is_digit = [sEnd](const char* c) { return c < sEnd && static_cast<unsigned int>(*c - '0') < 10u; };
+
+			if (s >= sEnd) {
+				return false;
+			}
+
+			double mantissa = 0.0;
+			int exponent = 0;
+			char sign = '+';
+			const char* curr = s;
+			bool leadingDecimalDot = false;
+
+			if ('+' == *curr || '-' == *curr) {
+				sign = *curr;
+				++curr;
+				leadingDecimalDot = curr != sEnd && '.' == *curr;
+			}
+			else if (is_digit(curr)) {
+			}
+			else if ('.' == *curr) {
+				leadingDecimalDot = true;
+			}
+			else {
+				return false;
+			}
+
+			// Integer part:
+			if (!leadingDecimalDot) {
+				int read = 0;
+				while (is_digit(curr)) {
+					mantissa *= 10;
+					mantissa += static_cast<int>(*curr - '0');
+					++curr;
+					++read;
+				}
+				if (0 == read) {
+					return false;
+				}
+			}
+
+			if (curr != sEnd) {
+				// Decimal part:
+				bool readExponent = false;
+				if ('.' == *curr) {
+					++curr;
+					int read = 1;
+					while (is_digit(curr)) {
+						mantissa += static_cast<int>(*curr - '0') * (read < LutEntries ? PowLut[read] : std::pow(10.0, -read));
+						++read;
+						++curr;
+					}
+					readExponent = curr != sEnd && ('e' == *curr || 'E' == *curr);
+				}
+				else {
+					readExponent = 'e' == *curr || 'E' == *curr;
+				}
+
+				// Exponent part:
+				if (readExponent) {
+					++curr;
+					char exponentSign = '+';
+					if (curr != sEnd && ('+' == *curr || '-' == *curr)) {
+						exponentSign = *curr;
+						++curr;
+					}
+					else if (!is_digit(curr)) {
+						return false;
+					}
+					int read = 0;
+					while (is_digit(curr)) {
+						exponent *= 10;
+						exponent += static_cast<int>(*curr - '0');
+						++curr;
+						++read;
+					}
+					exponent *= ('+' == exponentSign ? 1 : -1);
+					if (0 == read) {
+						return false;
+					}
+				}
+			}
+
+			*result = ('+' == sign ? 1 : -1) * (0 != exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+			return true;
+		}
+
+		// Equivalent of tinyobj's parseReal: skip blanks, and parse the number up to the next blank (or <defaultValue>)
+		float parse_real(const char*& token, const char* lineEnd, const double defaultValue = 0.0)
+		{
+			token = skip_blanks(token, lineEnd);
+			auto end = token;
+			while (end < lineEnd && !is_blank(*end)) {
+				++end;
+			}
+			double value = defaultValue;
+			try_parse_double(token, end, &value);
+			token = end;
+			return static_cast<float>(value);
+		}
+
+		// Equivalent of atoi (without overflow handling)
+		int parse_int(const char* token, const char* lineEnd)
+		{
+			while (token < lineEnd && (is_blank(*token) || '\v' == *token || '\f' == *token)) {
+				++token;
+			}
+			int sign = 1;
+			if (token < lineEnd && ('+' == *token || '-' == *token)) {
+				sign = '-' == *token ? -1 : 1;
+				++token;
+			}
+			int value = 0;
+			while (token < lineEnd && static_cast<unsigned int>(*token - '0') < 10u) {
+				value = value * 10 + (*token - '0');
+				++token;
+			}
+			return sign * value;
+		}
+
+		// Skip the rest of an index within a face corner, i.e. up to the next '/' or blank
+		const char* skip_index(const char* token, const char* lineEnd)
+		{
+			while (token < lineEnd && '/' != *token && !is_blank(*token)) {
+				++token;
+			}
+			return token;
+		}
+
+		// Turn a 1-based or negative .obj index into a 0-based index. Negative indices are resolved relative to
+		// the chunk's beginning and recorded, s.t. they can be offset once all previous chunks have been counted.
+		bool resolve_index(obj_chunk& chunk, const int index, const size_t countInChunk, tinyobj::index_t& corner, int tinyobj::index_t::* member)
+		{
+			if (index > 0) {
+				corner.*member = index - 1;
+				return true;
+			}
+			if (index < 0) {
+				corner.*member = static_cast<int>(countInChunk) + index;
+				chunk.relativeIndices.push_back(obj_relative_index{ chunk.corners.size(), member });
+				return true;
+			}
+			return false; // Zero is not a valid index
+		}
+
+		// Equivalent of tinyobj's parseTriple: v, v/vt, v//vn, or v/vt/vn
+		bool parse_corner(obj_chunk& chunk, const char*& token, const char* lineEnd, tinyobj::index_t& corner)
+		{
+			corner.vertex_index = corner.normal_index = corner.texcoord_index = -1;
+			const auto vertexCount = chunk.vertices.size() / 3;
+			const auto texcoordCount = chunk.texcoords.size() / 2;
+			const auto normalCount = chunk.normals.size() / 3;
+
+			if (!resolve_index(chunk, parse_int(token, lineEnd), vertexCount, corner, &tinyobj::index_t::vertex_index)) {
+				return false;
+			}
+			token = skip_index(token, lineEnd);
+			if ('/' != char_at(token, lineEnd)) {
+				return true;
+			}
+			++token;
+
+			// v//vn
+			if ('/' == char_at(token, lineEnd)) {
+				++token;
+				if (!resolve_index(chunk, parse_int(token, lineEnd), normalCount, corner, &tinyobj::index_t::normal_index)) {
+					return false;
+				}
+				token = skip_index(token, lineEnd);
+				return true;
+			}
+
+			// v/vt or v/vt/vn
+			if (!resolve_index(chunk, parse_int(token, lineEnd), texcoordCount, corner, &tinyobj::index_t::texcoord_index)) {
+				return false;
+			}
+			token = skip_index(token, lineEnd);
+			if ('/' != char_at(token, lineEnd)) {
+				return true;
+			}
+			++token;
+			if (!resolve_index(chunk, parse_int(token, lineEnd), normalCount, corner, &tinyobj::index_t::normal_index)) {
+				return false;
+			}
+			token = skip_index(token, lineEnd);
+			return true;
+		}
+
+		// Parse one line (without line break) into the chunk's arrays
+		void parse_line(obj_chunk& chunk, const char* token, const char* lineEnd, const std::string& submeshNamesToExclude)
+		{
+			token = skip_blanks(token, lineEnd);
+			const auto c0 = char_at(token, lineEnd);
+			const auto c1 = char_at(token + 1, lineEnd);
+
+			if ('v' == c0 && is_blank(c1)) {
+				token += 2;
+				chunk.vertices.push_back(parse_real(token, lineEnd));
+				chunk.vertices.push_back(parse_real(token, lineEnd));
+				chunk.vertices.push_back(parse_real(token, lineEnd));
+				return;
+			}
+			if ('v' == c0 && 'n' == c1 && is_blank(char_at(token + 2, lineEnd))) {
+				token += 3;
+				chunk.normals.push_back(parse_real(token, lineEnd));
+				chunk.normals.push_back(parse_real(token, lineEnd));
+				chunk.normals.push_back(parse_real(token, lineEnd));
+				return;
+			}
+			if ('v' == c0 && 't' == c1 && is_blank(char_at(token + 2, lineEnd))) {
+				token += 3;
+				chunk.texcoords.push_back(parse_real(token, lineEnd));
+				chunk.texcoords.push_back(parse_real(token, lineEnd));
+				return;
+			}
+			if ('f' == c0 && is_blank(c1)) {
+				token = skip_blanks(token + 2, lineEnd);
+				const auto firstCorner = chunk.corners.size();
+				while (token < lineEnd) {
+					tinyobj::index_t corner;
+					if (!parse_corner(chunk, token, lineEnd, corner)) {
+						throw std::runtime_error("Failed to parse a face (e.g. zero value for a face index)");
+					}
+					chunk.corners.push_back(corner);
+					token = skip_blanks(token, lineEnd);
+				}
+				const auto cornerCount = chunk.corners.size() - firstCorner;
+				if (cornerCount >= 3) { // Like tinyobj, skip faces with less than three corners
+					chunk.faces.push_back(obj_face{ firstCorner, cornerCount });
+				}
+				return;
+			}
+			if ('g' == c0 && is_blank(c1)) {
+				// Multiple group names are concatenated with spaces, like tinyobj does:
+				std::string name;
+				token = skip_blanks(token + 1, lineEnd);
+				while (token < lineEnd) {
+					auto end = token;
+					while (end < lineEnd && !is_blank(*end)) {
+						++end;
+					}
+					name += (name.empty() ? "" : " ") + std::string(token, end);
+					token = skip_blanks(end, lineEnd);
+				}
+				chunk.submeshChanges.push_back(obj_submesh_change{ chunk.faces.size(), helpers::is_submesh_excluded(name, submeshNamesToExclude) });
+				return;
+			}
+			if ('o' == c0 && is_blank(c1)) {
+				const std::string name(token + 2, lineEnd);
+				chunk.submeshChanges.push_back(obj_submesh_change{ chunk.faces.size(), helpers::is_submesh_excluded(name, submeshNamesToExclude) });
+				return;
+			}
+			// Comments, materials, lines, points, and everything else do not contribute to the mesh
+		}
+
+		void parse_chunk(obj_chunk& chunk, const std::string& submeshNamesToExclude)
+		{
+			// Like tinyobj, accept "\n", "\r\n", and "\r" as line breaks:
+			auto line = chunk.begin;
+			while (line < chunk.end) {
+				auto lineEnd = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(chunk.end - line)));
+				if (nullptr == lineEnd) {
+					lineEnd = chunk.end;
+				}
+				auto carriageReturn = static_cast<const char*>(memchr(line, '\r', static_cast<size_t>(lineEnd - line)));
+				if (nullptr != carriageReturn) {
+					lineEnd = carriageReturn;
+				}
+				if (lineEnd != line && '#' != *line) {
+					parse_line(chunk, line, lineEnd, submeshNamesToExclude);
+				}
+				line = lineEnd + 1;
+			}
+		}
+
+		// tinyobj's point-in-polygon test (https://wrf.ecse.rpi.edu//Research/Short_Notes/pnpoly.html)
+		bool point_in_triangle(const float* vertx, const float* verty, const float testx, const float testy)
+		{
+			bool inside = false;
+			for (int i = 0, j = 2; i < 3; j = i++) {
+				if (((verty[i] > testy) != (verty[j] > testy)) &&
+					(testx < (vertx[j] - vertx[i]) * (testy - verty[i]) / (verty[j] - verty[i]) + vertx[i])) {
+					inside = !inside;
+				}
+			}
+			return inside;
+		}
+
+		// Triangulate a polygon by ear clipping in the same way tinyobj does (see tinyobj's exportGroupsToShape),
+		// including its handling of invalid indices, s.t. the resulting triangles are exactly the same.
+		void triangulate_polygon(
+			const tinyobj::index_t* polygon,
+			const size_t cornerCount,
+			const std::vector<float>& v,
+			std::vector<tinyobj::index_t>& remaining,
+			std::vector<tinyobj::index_t>& outTriangles)
+		{
+			if (3 == cornerCount) {
+				outTriangles.insert(outTriangles.end(), polygon, polygon + 3);
+				return;
+			}
+
+			// Find the two axes to work in:
+			size_t axes[2] = { 1, 2 };
+			for (size_t k = 0; k < cornerCount; ++k) {
+				const auto vi0 = static_cast<size_t>(polygon[(k + 0) % cornerCount].vertex_index);
+				const auto vi1 = static_cast<size_t>(polygon[(k + 1) % cornerCount].vertex_index);
+				const auto vi2 = static_cast<size_t>(polygon[(k + 2) % cornerCount].vertex_index);
+				if (3 * vi0 + 2 >= v.size() || 3 * vi1 + 2 >= v.size() || 3 * vi2 + 2 >= v.size()) {
+					continue;
+				}
+				const float e0x = v[vi1 * 3 + 0] - v[vi0 * 3 + 0];
+				const float e0y = v[vi1 * 3 + 1] - v[vi0 * 3 + 1];
+				const float e0z = v[vi1 * 3 + 2] - v[vi0 * 3 + 2];
+				const float e1x = v[vi2 * 3 + 0] - v[vi1 * 3 + 0];
+				const float e1y = v[vi2 * 3 + 1] - v[vi1 * 3 + 1];
+				const float e1z = v[vi2 * 3 + 2] - v[vi1 * 3 + 2];
+				const float cx = std::fabs(e0y * e1z - e0z * e1y);
+				const float cy = std::fabs(e0z * e1x - e0x * e1z);
+				const float cz = std::fabs(e0x * e1y - e0y * e1x);
+				const float epsilon = std::numeric_limits<float>::epsilon();
+				if (cx > epsilon || cy > epsilon || cz > epsilon) {
+					if (!(cx > cy && cx > cz)) {
+						axes[0] = 0;
+						if (cz > cx && cz > cy) {
+							axes[1] = 1;
+						}
+					}
+					break;
+				}
+			}
+
+			float area = 0.0f;
+			for (size_t k = 0; k < cornerCount; ++k) {
+				const auto vi0 = static_cast<size_t>(polygon[(k + 0) % cornerCount].vertex_index);
+				const auto vi1 = static_cast<size_t>(polygon[(k + 1) % cornerCount].vertex_index);
+				if (vi0 * 3 + axes[0] >= v.size() || vi0 * 3 + axes[1] >= v.size() ||
+					vi1 * 3 + axes[0] >= v.size() || vi1 * 3 + axes[1] >= v.size()) {
+					continue;
+				}
+				area += (v[vi0 * 3 + axes[0]] * v[vi1 * 3 + axes[1]] - v[vi0 * 3 + axes[1]] * v[vi1 * 3 + axes[0]]) * 0.5f;
+			}
+
+			remaining.assign(polygon, polygon + cornerCount);
+			size_t guessVert = 0;
+			tinyobj::index_t ind[3];
+			float vx[3];
+			float vy[3];
+
+			// How many iterations can we do without decreasing the number of remaining vertices?
+			size_t remainingIterations = cornerCount;
+			size_t previousRemainingVertices = remaining.size();
+
+			while (remaining.size() > 3 && remainingIterations > 0) {
+				const auto npolys = remaining.size();
+				if (guessVert >= npolys) {
+					guessVert -= npolys;
+				}
+				if (previousRemainingVertices != npolys) {
+					previousRemainingVertices = npolys;
+					remainingIterations = npolys;
+				}
+				else {
+					--remainingIterations;
+				}
+
+				for (size_t k = 0; k < 3; ++k) {
+					ind[k] = remaining[(guessVert + k) % npolys];
+					const auto vi = static_cast<size_t>(ind[k].vertex_index);
+					const bool valid = vi * 3 + axes[0] < v.size() && vi * 3 + axes[1] < v.size();
+					vx[k] = valid ? v[vi * 3 + axes[0]] : 0.0f;
+					vy[k] = valid ? v[vi * 3 + axes[1]] : 0.0f;
+				}
+				const float e0x = vx[1] - vx[0];
+				const float e0y = vy[1] - vy[0];
+				const float e1x = vx[2] - vx[1];
+				const float e1y = vy[2] - vy[1];
+				const float cross = e0x * e1y - e0y * e1x;
+				// An internal angle?
+				if (cross * area < 0.0f) {
+					guessVert += 1;
+					continue;
+				}
+
+				// Is any of the other vertices inside this triangle?
+				bool overlap = false;
+				for (size_t otherVert = 3; otherVert < npolys; ++otherVert) {
+					const auto ovi = static_cast<size_t>(remaining[(guessVert + otherVert) % npolys].vertex_index);
+					if (ovi * 3 + axes[0] >= v.size() || ovi * 3 + axes[1] >= v.size()) {
+						continue;
+					}
+					if (point_in_triangle(vx, vy, v[ovi * 3 + axes[0]], v[ovi * 3 + axes[1]])) {
+						overlap = true;
+						break;
+					}
+				}
+				if (overlap) {
+					guessVert += 1;
+					continue;
+				}
+
+				// This triangle is an ear:
+				outTriangles.insert(outTriangles.end(), std::begin(ind), std::end(ind));
+				remaining.erase(remaining.begin() + static_cast<ptrdiff_t>((guessVert + 1) % npolys));
+			}
+
+			if (3 == remaining.size()) {
+				outTriangles.insert(outTriangles.end(), remaining.begin(), remaining.end());
+			}
+		}
+	}
+
+	mesh_data load_mesh_data_of_obj_parallel(
+		const std::string modelPath,
+		const std::string submeshNamesToExclude,
+		thread_pool& threadPool)
+	{
+		const mapped_file file(modelPath);
+		const auto data = reinterpret_cast<const char*>(file.data());
+		const auto size = file.size();
+
+		// 1. Split the file into line-aligned chunks:
+		const auto chunkCount = std::max(size_t{ 1 }, std::min(size / MinChunkSize, size_t{ threadPool.thread_count() } * ChunksPerThread));
+		std::vector<obj_chunk> chunks(chunkCount);
+		for (size_t i = 0; i < chunkCount; ++i) {
+			auto begin = data + size * i / chunkCount;
+			if (i > 0) {
+				begin = std::max(begin, chunks[i - 1].begin);
+				auto lineBreak = static_cast<const char*>(memchr(begin, '\n', static_cast<size_t>(data + size - begin)));
+				begin = nullptr == lineBreak ? data + size : lineBreak + 1;
+				chunks[i - 1].end = begin;
+			}
+			chunks[i].begin = begin;
+		}
+		chunks.back().end = data + size;
+
+		// 2. Parse all chunks in parallel:
+		threadPool.parallel_for(chunkCount, [&](const size_t i) {
+			parse_chunk(chunks[i], submeshNamesToExclude);
+		});
+
+		// 3. Determine where each chunk's attributes go, and which submesh each chunk begins with:
+		size_t verticesCount = 0, texcoordsCount = 0, normalsCount = 0;
+		bool excluded = helpers::is_submesh_excluded("", submeshNamesToExclude);
+		for (auto& chunk : chunks) {
+			chunk.verticesOffset = verticesCount;
+			chunk.texcoordsOffset = texcoordsCount;
+			chunk.normalsOffset = normalsCount;
+			chunk.excludedAtBegin = excluded;
+			verticesCount += chunk.vertices.size();
+			texcoordsCount += chunk.texcoords.size();
+			normalsCount += chunk.normals.size();
+			if (!chunk.submeshChanges.empty()) {
+				excluded = chunk.submeshChanges.back().excluded;
+			}
+		}
+
+		// 4. Merge the attributes, and resolve relative indices:
+		std::vector<float> vertices(verticesCount), texcoords(texcoordsCount), normals(normalsCount);
+		threadPool.parallel_for(chunkCount, [&](const size_t i) {
+			auto& chunk = chunks[i];
+			std::copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + chunk.verticesOffset);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + chunk.texcoordsOffset);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalsOffset);
+			for (const auto& relativeIndex : chunk.relativeIndices) {
+				const auto offset = &tinyobj::index_t::vertex_index == relativeIndex.member ? chunk.verticesOffset / 3
+					: &tinyobj::index_t::texcoord_index == relativeIndex.member ? chunk.texcoordsOffset / 2
+					: chunk.normalsOffset / 3;
+				chunk.corners[relativeIndex.cornerIndex].*relativeIndex.member += static_cast<int>(offset);
+			}
+		});
+
+		// 5. Triangulate the faces of all included submeshes:
+		threadPool.parallel_for(chunkCount, [&](const size_t i) {
+			auto& chunk = chunks[i];
+			chunk.triangles.reserve(chunk.corners.size() * 3 / 2);
+			std::vector<tinyobj::index_t> scratch;
+			auto isExcluded = chunk.excludedAtBegin;
+			size_t nextSubmeshChange = 0;
+			for (size_t f = 0; f < chunk.faces.size(); ++f) {
+				while (nextSubmeshChange < chunk.submeshChanges.size() && chunk.submeshChanges[nextSubmeshChange].faceIndex <= f) {
+					isExcluded = chunk.submeshChanges[nextSubmeshChange++].excluded;
+				}
+				if (!isExcluded) {
+					triangulate_polygon(chunk.corners.data() + chunk.faces[f].firstCorner, chunk.faces[f].cornerCount, vertices, scratch, chunk.triangles);
+				}
+			}
+		});
+
+		// 6. Expand the corners into pre-sized output arrays:
+		size_t cornerCount = 0;
+		for (auto& chunk : chunks) {
+			chunk.outputOffset = cornerCount;
+			cornerCount += chunk.triangles.size();
+		}
+		mesh_data mesh;
+		mesh.positions.resize(cornerCount);
+		mesh.textureCoordinates.resize(cornerCount);
+		mesh.normals.resize(cornerCount);
+		threadPool.parallel_for(chunkCount, [&](const size_t i) {
+			const auto& chunk = chunks[i];
+			helpers::expand_obj_corners(chunk.triangles.data(), chunk.triangles.size(),
+				vertices.data(), texcoords.data(), normals.data(),
+				mesh.positions.data() + chunk.outputOffset, mesh.textureCoordinates.data() + chunk.outputOffset, mesh.normals.data() + chunk.outputOffset
+			);
+		});
+
+		return mesh;
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace helpers
+{
+	// Loads the given 3D .obj model from file into CPU memory, like load_mesh_data_of_obj, but multi-threaded:
+	// The file is memory-mapped and split into line-aligned chunks. The chunks' v/vt/vn/f records are parsed
+	// in parallel on the given thread pool, and the results are merged into pre-sized output arrays.
+	//
+	// The result is bit-identical to load_mesh_data_of_obj: numbers are parsed and polygons are triangulated
+	// exactly like tinyobj does. Lines, points, materials, and other record types are ignored.
+	mesh_data load_mesh_data_of_obj_parallel(
+		const std::string modelPath,
+		const std::string submeshNamesToExclude = "",
+		thread_pool& threadPool = get_thread_pool()
+	);
+}
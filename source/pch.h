@@ -18,16 +18,65 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <array>
 #include <vector>
 #include <list>
+#include <deque>
+#include <queue>
 #include <iostream>
 #include <functional>
+#include <memory>
+#include <new>
+#include <cstdlib>
+#include <optional>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <condition_variable>
+#include <sstream>
+#include <iomanip>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <stb_image.h>
 #include <tiny_obj_loader.h>
 
+#include "memory_arena.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+#include "upload_engine.hpp"
+#include "vertex_format.hpp"
+#include "image_loader.hpp"
 #include "helper_functions.hpp"
+#include "obj_parser.hpp"
+#include "frame_scheduler.hpp"
+#include "deletion_queue.hpp"
+#include "flipbook_streamer.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "mesh_cache.hpp"
+#include "texture_compression.hpp"
+#include "texture_file.hpp"
+#include "pipeline_cache.hpp"
+#include "gpu_profiler.hpp"
+#include "swapchain_manager.hpp"
+#include "recording_scheduler.hpp"
+#include "descriptor_allocator.hpp"
+#include "uniform_ring.hpp"
+#include "bindless_texture_table.hpp"
+#include "instance_culling.hpp"
+#include "render_graph.hpp"
 
 #endif //PCH_H
@@ -0,0 +1,231 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		constexpr char PipelineCacheMagic[8] = { 'V', 'K', 'W', 'P', 'S', 'O', '\0', '\0' };
+
+		static_assert(std::is_standard_layout<pipeline_cache_file_header>::value, "pipeline_cache_file_header must be written to disk as is");
+		static_assert(sizeof(pipeline_cache_file_header) == 56, "Unexpected padding in pipeline_cache_file_header");
+
+		// The header which every driver puts at the beginning of its blob (VkPipelineCacheHeaderVersionOne)
+		struct driver_cache_header
+		{
+			uint32_t headerSize;
+			uint32_t headerVersion;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		};
+		static_assert(sizeof(driver_cache_header) == 32, "Unexpected padding in driver_cache_header");
+
+		bool matches_uuid(const uint8_t* uuid, const vk::PhysicalDeviceProperties& properties)
+		{
+			return std::equal(uuid, uuid + VK_UUID_SIZE, properties.pipelineCacheUUID.begin());
+		}
+
+		std::string to_string(const pipeline_cache_load_result result)
+		{
+			switch (result) {
+			case pipeline_cache_load_result::loaded: return "warm";
+			case pipeline_cache_load_result::not_found: return "cold (no file)";
+			case pipeline_cache_load_result::invalid: return "cold (invalid file discarded)";
+			case pipeline_cache_load_result::foreign: return "cold (file of another device or driver discarded)";
+			}
+			return "unknown";
+		}
+	}
+
+	std::string get_pipeline_cache_path(
+		const vk::PhysicalDevice physicalDevice,
+		const std::string& directory)
+	{
+		const auto properties = physicalDevice.getProperties();
+		std::ostringstream fileName;
+		fileName << "pipeline_cache_" << std::hex << properties.vendorID << "_" << properties.deviceID << ".vkpso";
+		return (std::filesystem::path(directory) / fileName.str()).string();
+	}
+
+	pipeline_cache::pipeline_cache(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		std::string path)
+		: mDevice{ device }
+		, mProperties{ physicalDevice.getProperties() }
+		, mPath{ std::move(path) }
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		const auto blob = load_validated_blob();
+		try {
+			mCache = device.createPipelineCache(vk::PipelineCacheCreateInfo{}
+				.setInitialDataSize(blob.size())
+				.setPInitialData(blob.empty() ? nullptr : blob.data())
+			);
+		}
+		catch (const vk::SystemError&) {
+			// The driver may still reject a blob that looked fine to us => start out empty
+			mCache = device.createPipelineCache(vk::PipelineCacheCreateInfo{});
+			mStatistics.loadResult = pipeline_cache_load_result::invalid;
+			mStatistics.loadedBytes = 0;
+		}
+		const auto end = std::chrono::steady_clock::now();
+		mStatistics.loadMs = std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	pipeline_cache::~pipeline_cache()
+	{
+		try {
+			save();
+		}
+		catch (const std::exception& e) {
+			std::cout << "Couldn't save the pipeline cache: " << e.what() << std::endl;
+		}
+		mDevice.destroyPipelineCache(mCache);
+	}
+
+	std::vector<uint8_t> pipeline_cache::load_validated_blob()
+	{
+		if (!std::filesystem::exists(mPath)) {
+			mStatistics.loadResult = pipeline_cache_load_result::not_found;
+			return {};
+		}
+
+		mapped_file file;
+		try {
+			file = mapped_file(mPath);
+		}
+		catch (const std::runtime_error&) {
+			mStatistics.loadResult = pipeline_cache_load_result::invalid;
+			return {};
+		}
+
+		// Our header: is it complete, and does the blob have the size and hash it had when it was written?
+		if (file.size() < sizeof(pipeline_cache_file_header)) {
+			mStatistics.loadResult = pipeline_cache_load_result::invalid;
+			return {};
+		}
+		const auto& header = *reinterpret_cast<const pipeline_cache_file_header*>(file.data());
+		const auto data = file.data() + sizeof(pipeline_cache_file_header);
+		if (!std::equal(std::begin(PipelineCacheMagic), std::end(PipelineCacheMagic), std::begin(header.magic))
+			|| header.version != pipeline_cache_file_header::CurrentVersion
+			|| header.dataSize != file.size() - sizeof(pipeline_cache_file_header)
+			|| header.dataSize < sizeof(driver_cache_header)
+			|| header.dataHash != fnv1a_64(data, static_cast<size_t>(header.dataSize))) {
+			mStatistics.loadResult = pipeline_cache_load_result::invalid;
+			return {};
+		}
+
+		// Was it written for this device and driver? Drivers are supposed to reject foreign blobs themselves,
+		// but not all of them do so gracefully.
+		driver_cache_header driverHeader;
+		memcpy(&driverHeader, data, sizeof(driverHeader));
+		if (driverHeader.headerSize < sizeof(driver_cache_header) || driverHeader.headerSize > header.dataSize
+			|| driverHeader.headerVersion != static_cast<uint32_t>(vk::PipelineCacheHeaderVersion::eOne)) {
+			mStatistics.loadResult = pipeline_cache_load_result::invalid;
+			return {};
+		}
+		if (header.vendorID != mProperties.vendorID || header.deviceID != mProperties.deviceID
+			|| header.driverVersion != mProperties.driverVersion || !matches_uuid(header.pipelineCacheUUID, mProperties)
+			|| driverHeader.vendorID != mProperties.vendorID || driverHeader.deviceID != mProperties.deviceID
+			|| !matches_uuid(driverHeader.pipelineCacheUUID, mProperties)) {
+			mStatistics.loadResult = pipeline_cache_load_result::foreign;
+			return {};
+		}
+
+		mStatistics.loadResult = pipeline_cache_load_result::loaded;
+		mStatistics.loadedBytes = static_cast<size_t>(header.dataSize);
+		mPersistedHash = header.dataHash;
+		mPersistedSize = static_cast<size_t>(header.dataSize);
+		return std::vector<uint8_t>(data, data + header.dataSize);
+	}
+
+	void pipeline_cache::record_pipeline_creation(const std::chrono::steady_clock::time_point begin)
+	{
+		const auto end = std::chrono::steady_clock::now();
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mStatistics.pipelinesCreated;
+		mStatistics.pipelineCreationMs += std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	vk::Pipeline pipeline_cache::create_graphics_pipeline(const vk::GraphicsPipelineCreateInfo& createInfo)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		auto result = mDevice.createGraphicsPipeline(mCache, createInfo);
+		if (vk::Result::eSuccess != result.result) {
+			throw std::runtime_error("Couldn't create a graphics pipeline: " + vk::to_string(result.result));
+		}
+		record_pipeline_creation(begin);
+		return result.value;
+	}
+
+	vk::Pipeline pipeline_cache::create_compute_pipeline(const vk::ComputePipelineCreateInfo& createInfo)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		auto result = mDevice.createComputePipeline(mCache, createInfo);
+		if (vk::Result::eSuccess != result.result) {
+			throw std::runtime_error("Couldn't create a compute pipeline: " + vk::to_string(result.result));
+		}
+		record_pipeline_creation(begin);
+		return result.value;
+	}
+
+	bool pipeline_cache::save()
+	{
+		const auto data = mDevice.getPipelineCacheData(mCache);
+		const auto hash = fnv1a_64(data.data(), data.size());
+		if (data.size() < sizeof(driver_cache_header) || (data.size() == mPersistedSize && hash == mPersistedHash)) {
+			return false;
+		}
+
+		pipeline_cache_file_header header{};
+		std::copy(std::begin(PipelineCacheMagic), std::end(PipelineCacheMagic), std::begin(header.magic));
+		header.version = pipeline_cache_file_header::CurrentVersion;
+		header.vendorID = mProperties.vendorID;
+		header.deviceID = mProperties.deviceID;
+		header.driverVersion = mProperties.driverVersion;
+		std::copy(mProperties.pipelineCacheUUID.begin(), mProperties.pipelineCacheUUID.end(), std::begin(header.pipelineCacheUUID));
+		header.dataSize = static_cast<uint64_t>(data.size());
+		header.dataHash = hash;
+
+		// Write to a temporary file first, s.t. a crash never leaves a half-written cache behind:
+		const auto tempPath = mPath + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open()) {
+				throw std::runtime_error("Couldn't open '" + tempPath + "' for writing");
+			}
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+			if (!stream.good()) {
+				throw std::runtime_error("Couldn't write '" + tempPath + "'");
+			}
+		}
+		std::filesystem::rename(tempPath, mPath);
+
+		mPersistedHash = hash;
+		mPersistedSize = data.size();
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mStatistics.saves;
+		mStatistics.savedBytes = data.size();
+		return true;
+	}
+
+	pipeline_cache_statistics pipeline_cache::get_statistics() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mStatistics;
+	}
+
+	void pipeline_cache::print_statistics(std::ostream& stream) const
+	{
+		const auto statistics = get_statistics();
+		stream << "Pipeline cache '" << mPath << "': " << to_string(statistics.loadResult)
+			<< ", loaded " << statistics.loadedBytes << " bytes in " << statistics.loadMs << " ms, "
+			<< statistics.pipelinesCreated << " pipelines created in " << statistics.pipelineCreationMs << " ms";
+		if (statistics.saves > 0) {
+			stream << ", saved " << statistics.saves << "x (" << statistics.savedBytes << " bytes)";
+		}
+		stream << std::endl;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+namespace helpers
+{
+	// On-disk pipeline cache format (*.vkpso). All values are little endian.
+	// The header is followed by <dataSize> bytes, which are exactly what vkGetPipelineCacheData returned.
+	// The driver's blob has its own header as well, which is validated in addition (see VkPipelineCacheHeaderVersionOne).
+	struct pipeline_cache_file_header
+	{
+		static constexpr uint32_t CurrentVersion = 1u;
+
+		char magic[8];						// "VKWPSO\0\0"
+		uint32_t version;
+		uint32_t vendorID;					// vk::PhysicalDeviceProperties of the device that produced the blob
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;					// fnv1a_64 of the blob, to detect truncated or corrupted files
+	};
+
+	// Why a pipeline cache started out empty, or how it has been loaded
+	enum struct pipeline_cache_load_result
+	{
+		loaded,			// Warm: the blob has been passed to the driver
+		not_found,		// Cold: there was no file
+		invalid,		// Cold: the file was truncated, corrupted, or of an older version
+		foreign			// Cold: the file was written for another device or driver
+	};
+
+	// Timings of a pipeline cache
+	struct pipeline_cache_statistics
+	{
+		pipeline_cache_load_result loadResult = pipeline_cache_load_result::not_found;
+		size_t loadedBytes = 0;
+		double loadMs = 0.0;				// Reading, validating and creating the vk::PipelineCache
+		uint32_t pipelinesCreated = 0;
+		double pipelineCreationMs = 0.0;	// Total time spent in create_graphics_pipeline and create_compute_pipeline
+		uint32_t saves = 0;					// How often the cache has been written back
+		size_t savedBytes = 0;				// Size of the blob that has been written last
+	};
+
+	// Returns the path of the pipeline cache file for the given physical device, in the given directory.
+	// The file name contains the vendor and device IDs, s.t. multiple GPUs don't evict each other's caches.
+	std::string get_pipeline_cache_path(
+		const vk::PhysicalDevice physicalDevice,
+		const std::string& directory = ""
+	);
+
+	// A vk::PipelineCache which is loaded from disk at startup, and written back when it has changed.
+	//
+	// The file is only passed to the driver if both our header and the driver's own header match the physical device's
+	// vendorID, deviceID and pipelineCacheUUID (and our header also the driverVersion). Otherwise, the cache starts out empty.
+	// It is written back in the destructor, and whenever save() is called (e.g. periodically, or after loading a level).
+	// Writes go to a temporary file first, which is then renamed.
+	//
+	// Pass handle() to all vkCreate*Pipelines calls, or use create_graphics_pipeline/create_compute_pipeline, which
+	// also measure how long pipeline creation takes -- i.e. the difference between a cold and a warm cache.
+	class pipeline_cache
+	{
+	public:
+		pipeline_cache(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			std::string path
+		);
+		pipeline_cache(const pipeline_cache&) = delete;
+		pipeline_cache& operator=(const pipeline_cache&) = delete;
+		~pipeline_cache();
+
+		vk::PipelineCache handle() const { return mCache; }
+
+		// Has a valid blob been loaded from disk?
+		bool is_warm() const { return pipeline_cache_load_result::loaded == mStatistics.loadResult; }
+
+		// Create a pipeline through the cache. Thread-safe.
+		vk::Pipeline create_graphics_pipeline(const vk::GraphicsPipelineCreateInfo& createInfo);
+		vk::Pipeline create_compute_pipeline(const vk::ComputePipelineCreateInfo& createInfo);
+
+		// Write the cache's current contents to disk, unless they haven't changed since they have been loaded or saved.
+		// Returns true if the file has been written.
+		bool save();
+
+		pipeline_cache_statistics get_statistics() const;
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		// Returns the blob to create the cache with, or an empty vector (setting mStatistics.loadResult accordingly)
+		std::vector<uint8_t> load_validated_blob();
+		void record_pipeline_creation(const std::chrono::steady_clock::time_point begin);
+
+		vk::Device mDevice;
+		vk::PhysicalDeviceProperties mProperties;
+		std::string mPath;
+		vk::PipelineCache mCache;
+		uint64_t mPersistedHash = 0;	// fnv1a_64 of the blob as it is on disk (0 if there is none)
+		size_t mPersistedSize = 0;
+
+		mutable std::mutex mMutex;		// Guards mStatistics
+		pipeline_cache_statistics mStatistics;
+	};
+}
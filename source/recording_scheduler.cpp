@@ -0,0 +1,118 @@
+#include "pch.h"
+
+namespace helpers
+{
+	recording_scheduler::recording_scheduler(
+		const vk::Device device,
+		const uint32_t queueFamilyIndex,
+		const uint32_t framesInFlight,
+		thread_pool& threadPool,
+		const uint32_t workerCount)
+		: mDevice{ device }
+		, mThreadPool{ threadPool }
+		, mWorkerCount{ 0u == workerCount ? threadPool.thread_count() + 1u : workerCount }
+		, mSlots(framesInFlight)
+	{
+		if (0 == framesInFlight) {
+			throw std::invalid_argument("There must be at least one frame in flight.");
+		}
+
+		for (auto& slot : mSlots) {
+			slot.workers.resize(mWorkerCount);
+			for (auto& worker : slot.workers) {
+				// Transient, because the buffers are re-recorded every frame; the pool is reset as a whole:
+				worker.commandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}
+					.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+					.setQueueFamilyIndex(queueFamilyIndex)
+				);
+			}
+		}
+	}
+
+	recording_scheduler::~recording_scheduler()
+	{
+		for (auto& slot : mSlots) {
+			for (auto& worker : slot.workers) {
+				// Destroying the pool also frees its command buffers:
+				mDevice.destroyCommandPool(worker.commandPool);
+			}
+		}
+	}
+
+	void recording_scheduler::begin_frame()
+	{
+		mCurrentSlot = static_cast<size_t>(mFrameNumber % mSlots.size());
+		for (auto& worker : mSlots[mCurrentSlot].workers) {
+			mDevice.resetCommandPool(worker.commandPool, vk::CommandPoolResetFlags{});
+		}
+		mRecordCallsThisFrame = 0;
+		++mFrameNumber;
+	}
+
+	void recording_scheduler::record(
+		const vk::CommandBuffer primaryCommandBuffer,
+		const size_t itemCount,
+		const record_range_function& recordRange,
+		const vk::CommandBufferInheritanceInfo& inheritanceInfo)
+	{
+		if (0 == itemCount) {
+			return;
+		}
+		const auto begin = std::chrono::steady_clock::now();
+
+		// Contiguous ranges of (almost) equal size; the first <remainder> ranges get one item more:
+		const auto rangeCount = std::min(static_cast<size_t>(mWorkerCount), itemCount);
+		const auto itemsPerRange = itemCount / rangeCount;
+		const auto remainder = itemCount % rangeCount;
+		auto rangeBegin = [itemsPerRange, remainder](const size_t r) { return r * itemsPerRange + std::min(r, remainder); };
+
+		// Allocating from a pool must be externally synchronized as well => allocate all buffers up front, on this thread:
+		auto& workers = mSlots[mCurrentSlot].workers;
+		std::vector<vk::CommandBuffer> secondaryCommandBuffers(rangeCount);
+		for (size_t r = 0; r < rangeCount; ++r) {
+			auto& buffers = workers[r].secondaryCommandBuffers;
+			if (buffers.size() <= mRecordCallsThisFrame) {
+				const auto allocated = mDevice.allocateCommandBuffers(vk::CommandBufferAllocateInfo{}
+					.setCommandPool(workers[r].commandPool)
+					.setLevel(vk::CommandBufferLevel::eSecondary)
+					.setCommandBufferCount(1u)
+				);
+				buffers.push_back(allocated.front());
+			}
+			secondaryCommandBuffers[r] = buffers[mRecordCallsThisFrame];
+		}
+		++mRecordCallsThisFrame;
+
+		auto usage = vk::CommandBufferUsageFlags{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
+		if (inheritanceInfo.renderPass) {
+			usage |= vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+		}
+
+		// Range r is always recorded into the pool of worker r => no two threads ever use the same pool at once:
+		mThreadPool.parallel_for(rangeCount, [&](const size_t r) {
+			auto commandBuffer = secondaryCommandBuffers[r];
+			commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(usage).setPInheritanceInfo(&inheritanceInfo));
+			recordRange(commandBuffer, rangeBegin(r), rangeBegin(r + 1));
+			commandBuffer.end();
+		});
+
+		primaryCommandBuffer.executeCommands(secondaryCommandBuffers);
+
+		const auto end = std::chrono::steady_clock::now();
+		++mStatistics.recordCalls;
+		mStatistics.itemsRecorded += itemCount;
+		mStatistics.secondaryBuffersRecorded += rangeCount;
+		mStatistics.recordMs += std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	void recording_scheduler::print_statistics(std::ostream& stream) const
+	{
+		stream << "Recording scheduler: " << mWorkerCount << " workers, " << mSlots.size() << " frames in flight, "
+			<< mStatistics.recordCalls << " record calls, " << mStatistics.itemsRecorded << " items in "
+			<< mStatistics.secondaryBuffersRecorded << " secondary command buffers";
+		if (mStatistics.recordCalls > 0) {
+			stream << ", " << mStatistics.recordMs / static_cast<double>(mStatistics.recordCalls) << " ms per record call";
+		}
+		stream << std::endl;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+namespace helpers
+{
+	// Timings of a recording scheduler, accumulated over all record calls
+	struct recording_statistics
+	{
+		uint64_t recordCalls = 0;
+		uint64_t itemsRecorded = 0;
+		uint64_t secondaryBuffersRecorded = 0;
+		double recordMs = 0.0;				// Wall clock time spent in record(), including vkCmdExecuteCommands
+	};
+
+	// Records command buffers on multiple threads: a list of items (e.g. draw calls) is split into contiguous ranges, and
+	// each range is recorded into a secondary command buffer on a worker of a thread pool. The primary command buffer
+	// then executes the secondary ones in the order of their ranges, i.e. the GPU sees the commands in the same order
+	// as if they had been recorded sequentially, regardless of which thread finished first.
+	//
+	// Every worker has its own command pool per frame in flight (command pools must not be used by multiple threads
+	// at once). The pools are reset as a whole at the beginning of each frame; their secondary command buffers are
+	// allocated once and reused, never freed individually.
+	//
+	// Usage per frame (with the same number of frames in flight as the frame scheduler):
+	//   auto& frame = frameScheduler.begin_frame();
+	//   recorder.begin_frame();
+	//   frame.commandBuffer.beginRenderPass(..., vk::SubpassContents::eSecondaryCommandBuffers);
+	//   recorder.record(frame.commandBuffer, draws.size(), [&](vk::CommandBuffer cb, size_t begin, size_t end) {
+	//       for (auto i = begin; i < end; ++i) { record draws[i] into cb }
+	//   }, inheritanceInfo);
+	//   frame.commandBuffer.endRenderPass();
+	class recording_scheduler
+	{
+	public:
+		// Records ranges for the given function: (secondary command buffer, first item, one past the last item)
+		using record_range_function = std::function<void(vk::CommandBuffer, size_t, size_t)>;
+
+		// <workerCount> is the maximum number of ranges per record call (0 => the thread pool's threads + the calling thread)
+		recording_scheduler(
+			const vk::Device device,
+			const uint32_t queueFamilyIndex,
+			const uint32_t framesInFlight,
+			thread_pool& threadPool = get_thread_pool(),
+			const uint32_t workerCount = 0u
+		);
+		recording_scheduler(const recording_scheduler&) = delete;
+		recording_scheduler& operator=(const recording_scheduler&) = delete;
+		// The GPU must be done with all frames which have been recorded with this scheduler.
+		~recording_scheduler();
+
+		// Start the next frame: reset the command pools of its slot. The GPU must be done with the frame which
+		// used the same slot before (i.e. call this after frame_scheduler::begin_frame).
+		void begin_frame();
+
+		// Record <itemCount> items in parallel into secondary command buffers, and execute them in <primaryCommandBuffer>.
+		// If <inheritanceInfo> has a render pass, the secondary command buffers continue that render pass, and the primary
+		// command buffer must be inside it, begun with vk::SubpassContents::eSecondaryCommandBuffers.
+		// May be called multiple times per frame. Rethrows the first exception thrown by <recordRange>.
+		void record(
+			const vk::CommandBuffer primaryCommandBuffer,
+			const size_t itemCount,
+			const record_range_function& recordRange,
+			const vk::CommandBufferInheritanceInfo& inheritanceInfo = vk::CommandBufferInheritanceInfo{}
+		);
+
+		uint32_t worker_count() const { return mWorkerCount; }
+
+		recording_statistics get_statistics() const { return mStatistics; }
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		struct worker_pool
+		{
+			vk::CommandPool commandPool;
+			std::vector<vk::CommandBuffer> secondaryCommandBuffers;	// Allocated on demand; the i-th is used by the i-th record call of a frame
+		};
+
+		struct frame_pools
+		{
+			std::vector<worker_pool> workers;
+		};
+
+		vk::Device mDevice;
+		thread_pool& mThreadPool;
+		uint32_t mWorkerCount;
+		std::vector<frame_pools> mSlots;
+		size_t mCurrentSlot = 0;
+		uint64_t mFrameNumber = 0;
+		size_t mRecordCallsThisFrame = 0;
+		recording_statistics mStatistics;
+	};
+}
@@ -0,0 +1,564 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		constexpr uint32_t NoPass = std::numeric_limits<uint32_t>::max();
+		constexpr uint32_t NoMemoryBlock = std::numeric_limits<uint32_t>::max();
+
+		// What an image_usage implies
+		struct usage_info
+		{
+			vk::ImageLayout layout;
+			vk::PipelineStageFlags stages;
+			vk::AccessFlags readAccess;		// Empty => the usage can't read
+			vk::AccessFlags writeAccess;	// Empty => the usage can't write
+			vk::ImageUsageFlags imageUsage;
+		};
+
+		usage_info get_usage_info(const image_usage usage)
+		{
+			switch (usage) {
+			case image_usage::transfer_src:
+				return { vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits::eTransfer,
+					vk::AccessFlagBits::eTransferRead, {}, vk::ImageUsageFlagBits::eTransferSrc };
+			case image_usage::transfer_dst:
+				return { vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits::eTransfer,
+					{}, vk::AccessFlagBits::eTransferWrite, vk::ImageUsageFlagBits::eTransferDst };
+			case image_usage::color_attachment:
+				return { vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+					vk::AccessFlagBits::eColorAttachmentRead, vk::AccessFlagBits::eColorAttachmentWrite, vk::ImageUsageFlagBits::eColorAttachment };
+			case image_usage::depth_stencil_attachment:
+				return { vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+					vk::AccessFlagBits::eDepthStencilAttachmentRead, vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::ImageUsageFlagBits::eDepthStencilAttachment };
+			case image_usage::depth_stencil_read:
+				return { vk::ImageLayout::eDepthStencilReadOnlyOptimal, vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+					vk::AccessFlagBits::eDepthStencilAttachmentRead, {}, vk::ImageUsageFlagBits::eDepthStencilAttachment };
+			case image_usage::sampled_fragment:
+				return { vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader,
+					vk::AccessFlagBits::eShaderRead, {}, vk::ImageUsageFlagBits::eSampled };
+			case image_usage::sampled_compute:
+				return { vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eComputeShader,
+					vk::AccessFlagBits::eShaderRead, {}, vk::ImageUsageFlagBits::eSampled };
+			case image_usage::storage_read_compute:
+				return { vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits::eComputeShader,
+					vk::AccessFlagBits::eShaderRead, {}, vk::ImageUsageFlagBits::eStorage };
+			case image_usage::storage_write_compute:
+				return { vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits::eComputeShader,
+					vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eShaderWrite, vk::ImageUsageFlagBits::eStorage };
+			}
+			throw std::invalid_argument("Unknown image usage");
+		}
+
+		template <typename T>
+		uint64_t hash_value(const T& value, const uint64_t hash)
+		{
+			return fnv1a_64(&value, sizeof(value), hash);
+		}
+
+		// Where an image is at, while the barriers are derived
+		struct tracked_state
+		{
+			vk::ImageLayout layout;
+			vk::PipelineStageFlags writeStages;		// Of the last write (or layout transition) => every later access waits for them
+			vk::AccessFlags writeAccess;			// Of the last write, which hasn't been made available yet
+			vk::PipelineStageFlags readStages;		// Of all reads since the last write => later writes wait for them
+			vk::PipelineStageFlags visibleStages;	// The last write has been made visible to these stages...
+			vk::AccessFlags visibleAccess;			// ...and access types
+		};
+	}
+
+	void render_graph_pass_builder::read(const render_graph_image image, const image_usage usage)
+	{
+		mGraph.declare_access(mPassIndex, image, usage, false);
+	}
+
+	void render_graph_pass_builder::write(const render_graph_image image, const image_usage usage)
+	{
+		mGraph.declare_access(mPassIndex, image, usage, true);
+	}
+
+	render_graph::render_graph(const vk::PhysicalDevice physicalDevice, const vk::Device device, const uint32_t framesInFlight)
+		: mPhysicalDevice{ physicalDevice }
+		, mDevice{ device }
+		, mFramesInFlight{ framesInFlight }
+	{
+		if (0 == framesInFlight) {
+			throw std::invalid_argument("There must be at least one frame in flight.");
+		}
+	}
+
+	render_graph::~render_graph()
+	{
+		retire_transient_images();
+		destroy_retired_resources(true);
+	}
+
+	void render_graph::reset()
+	{
+		mPasses.clear();
+		mImages.clear();
+		mBarriers.clear();
+		mFinalBarriers.clear();
+		mCompiled = false;
+		destroy_retired_resources(false);
+	}
+
+	render_graph_image render_graph::import_image(
+		const vk::Image image,
+		const vk::Format format,
+		const image_state& initialState,
+		const image_state& finalState,
+		const vk::ImageView imageView,
+		const uint32_t mipLevels,
+		const uint32_t arrayLayers)
+	{
+		if (!image) {
+			throw std::invalid_argument("Can't import a null image into the render graph");
+		}
+		image_resource resource{};
+		resource.image = image;
+		resource.imageView = imageView;
+		resource.format = format;
+		resource.mipLevels = mipLevels;
+		resource.arrayLayers = arrayLayers;
+		resource.imported = true;
+		resource.initialState = initialState;
+		resource.finalState = finalState;
+		mImages.push_back(resource);
+		mCompiled = false;
+		return render_graph_image{ static_cast<uint32_t>(mImages.size() - 1) };
+	}
+
+	render_graph_image render_graph::create_image(const transient_image_description& description)
+	{
+		if (0 == description.width || 0 == description.height || 0 == description.mipLevels || 0 == description.arrayLayers
+			|| vk::Format::eUndefined == description.format) {
+			throw std::invalid_argument("Invalid transient image description");
+		}
+		image_resource resource{};
+		resource.format = description.format;
+		resource.mipLevels = description.mipLevels;
+		resource.arrayLayers = description.arrayLayers;
+		resource.imported = false;
+		resource.description = description;
+		resource.transientIndex = static_cast<uint32_t>(std::count_if(mImages.begin(), mImages.end(), [](const image_resource& r) { return !r.imported; }));
+		mImages.push_back(resource);
+		mCompiled = false;
+		return render_graph_image{ static_cast<uint32_t>(mImages.size() - 1) };
+	}
+
+	void render_graph::add_pass(const std::string& name, const setup_function& setup, execute_function execute)
+	{
+		mPasses.push_back(pass{});
+		mPasses.back().name = name;
+		mPasses.back().execute = std::move(execute);
+		render_graph_pass_builder builder{ *this, static_cast<uint32_t>(mPasses.size() - 1) };
+		setup(builder);
+		mPasses.back().hasSideEffects = builder.mHasSideEffects;
+		mCompiled = false;
+	}
+
+	void render_graph::declare_access(const uint32_t passIndex, const render_graph_image image, const image_usage usage, const bool writes)
+	{
+		if (!image.is_valid() || image.index >= mImages.size()) {
+			throw std::invalid_argument("Pass '" + mPasses[passIndex].name + "' uses an image which doesn't belong to the render graph");
+		}
+		const auto info = get_usage_info(usage);
+		const auto access = writes ? info.writeAccess : info.readAccess;
+		if (!access) {
+			throw std::invalid_argument("Pass '" + mPasses[passIndex].name + "' " + (writes ? "writes" : "reads") + " an image with a usage which can't " + (writes ? "write" : "read"));
+		}
+
+		auto& accesses = mPasses[passIndex].accesses;
+		auto it = std::find_if(accesses.begin(), accesses.end(), [&](const image_access& a) { return a.image == image.index; });
+		if (accesses.end() == it) {
+			accesses.push_back(image_access{ image.index, info.layout, {}, {}, {}, {}, false, false });
+			it = accesses.end() - 1;
+		}
+		else if (it->layout != info.layout) {
+			throw std::invalid_argument("Pass '" + mPasses[passIndex].name + "' uses an image in two different layouts: "
+				+ vk::to_string(it->layout) + " and " + vk::to_string(info.layout));
+		}
+		it->stages |= info.stages;
+		it->access |= access;
+		it->imageUsage |= info.imageUsage;
+		if (writes) {
+			it->writeAccess |= access;
+			it->writes = true;
+		}
+		else {
+			it->reads = true;
+		}
+	}
+
+	void render_graph::compile()
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		cull_passes();
+		create_transient_images();
+		derive_barriers();
+		mCompiled = true;
+
+		mStatistics.passes = static_cast<uint32_t>(mPasses.size());
+		mStatistics.culledPasses = static_cast<uint32_t>(std::count_if(mPasses.begin(), mPasses.end(), [](const pass& p) { return p.culled; }));
+		mStatistics.barrierCalls = static_cast<uint32_t>(std::count_if(mPasses.begin(), mPasses.end(), [](const pass& p) { return !p.culled && p.barrierCount > 0; }))
+			+ (mFinalBarriers.empty() ? 0u : 1u);
+		mStatistics.imageBarriers = static_cast<uint32_t>(mBarriers.size() + mFinalBarriers.size());
+		++mStatistics.compiledFrames;
+		mStatistics.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	void render_graph::cull_passes()
+	{
+		// Backwards: a pass is needed if it has side effects, writes an imported image, or writes an image which a later
+		// needed pass reads. Earlier writes of an image which is written again are kept, too, since writes may be partial.
+		std::vector<bool> isRead(mImages.size(), false);
+		for (auto p = mPasses.rbegin(); p != mPasses.rend(); ++p) {
+			bool needed = p->hasSideEffects;
+			for (const auto& a : p->accesses) {
+				needed = needed || (a.writes && (mImages[a.image].imported || isRead[a.image]));
+			}
+			p->culled = !needed;
+			if (needed) {
+				for (const auto& a : p->accesses) {
+					isRead[a.image] = isRead[a.image] || a.reads;
+				}
+			}
+		}
+
+		// Lifetimes, image usage flags and accesses over the remaining passes:
+		for (auto& image : mImages) {
+			image.firstPass = NoPass;
+			image.lastPass = 0;
+			image.usage = vk::ImageUsageFlags{};
+			image.stages = vk::PipelineStageFlags{};
+			image.access = vk::AccessFlags{};
+		}
+		for (uint32_t i = 0; i < mPasses.size(); ++i) {
+			if (mPasses[i].culled) {
+				continue;
+			}
+			for (const auto& a : mPasses[i].accesses) {
+				auto& image = mImages[a.image];
+				image.firstPass = std::min(image.firstPass, i);
+				image.lastPass = std::max(image.lastPass, i);
+				image.usage |= a.imageUsage;
+				image.stages |= a.stages;
+				image.access |= a.access;
+			}
+		}
+	}
+
+	void render_graph::create_transient_images()
+	{
+		uint64_t key = 0xcbf29ce484222325ull;
+		uint32_t transientCount = 0;
+		for (const auto& image : mImages) {
+			if (image.imported) {
+				continue;
+			}
+			++transientCount;
+			key = hash_value(image.description.width, key);
+			key = hash_value(image.description.height, key);
+			key = hash_value(image.description.format, key);
+			key = hash_value(image.description.mipLevels, key);
+			key = hash_value(image.description.arrayLayers, key);
+			key = hash_value(static_cast<VkImageUsageFlags>(image.usage), key);
+			key = hash_value(image.firstPass, key);
+			key = hash_value(image.lastPass, key);
+			// The first barrier of an aliased image only waits for the stages which access its memory block in this frame.
+			// If they change, the previous frame's accesses may not be covered => the memory must not be reused:
+			key = hash_value(static_cast<VkPipelineStageFlags>(image.stages), key);
+			key = hash_value(static_cast<VkAccessFlags>(image.access), key);
+		}
+
+		if (key != mTransientKey || transientCount != mPhysicalImages.size()) {
+			retire_transient_images();
+			mTransientKey = key;
+			++mStatistics.transientRebuilds;
+
+			// Create the images, in order to get their memory requirements:
+			std::vector<vk::MemoryRequirements> requirements(transientCount);
+			std::vector<uint32_t> order;
+			mPhysicalImages.resize(transientCount, physical_image{ nullptr, nullptr, NoMemoryBlock });
+			for (uint32_t i = 0; i < mImages.size(); ++i) {
+				const auto& image = mImages[i];
+				if (image.imported || NoPass == image.firstPass) {
+					continue; // Not used by any remaining pass => not created at all
+				}
+				mPhysicalImages[image.transientIndex].image = mDevice.createImage(vk::ImageCreateInfo{}
+					.setImageType(vk::ImageType::e2D)
+					.setExtent({ image.description.width, image.description.height, 1u })
+					.setMipLevels(image.description.mipLevels)
+					.setArrayLayers(image.description.arrayLayers)
+					.setFormat(image.description.format)
+					.setTiling(vk::ImageTiling::eOptimal)
+					.setInitialLayout(vk::ImageLayout::eUndefined)
+					.setUsage(image.usage)
+					.setSamples(vk::SampleCountFlagBits::e1)
+					.setSharingMode(vk::SharingMode::eExclusive)
+				);
+				requirements[image.transientIndex] = mDevice.getImageMemoryRequirements(mPhysicalImages[image.transientIndex].image);
+				order.push_back(i);
+			}
+
+			// Greedy aliasing, largest images first: put each image into the first memory block whose images' lifetimes
+			// don't overlap with its own, and whose memory types are compatible.
+			std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) {
+				return requirements[mImages[a].transientIndex].size > requirements[mImages[b].transientIndex].size;
+			});
+			struct block_assignment
+			{
+				vk::MemoryRequirements requirements;
+				std::vector<uint32_t> images;
+			};
+			std::vector<block_assignment> blocks;
+			vk::DeviceSize bytesRequired = 0;
+			for (const auto i : order) {
+				const auto& image = mImages[i];
+				const auto& r = requirements[image.transientIndex];
+				bytesRequired += r.size;
+				auto block = std::find_if(blocks.begin(), blocks.end(), [&](const block_assignment& b) {
+					return 0 != (b.requirements.memoryTypeBits & r.memoryTypeBits) && std::none_of(b.images.begin(), b.images.end(), [&](const uint32_t other) {
+						return mImages[other].firstPass <= image.lastPass && image.firstPass <= mImages[other].lastPass;
+					});
+				});
+				if (blocks.end() == block) {
+					blocks.push_back(block_assignment{ r, {} });
+					block = blocks.end() - 1;
+				}
+				block->requirements.size = std::max(block->requirements.size, r.size);
+				block->requirements.alignment = std::max(block->requirements.alignment, r.alignment);
+				block->requirements.memoryTypeBits &= r.memoryTypeBits;
+				block->images.push_back(i);
+			}
+
+			vk::DeviceSize bytesAllocated = 0;
+			for (const auto& b : blocks) {
+				const auto blockIndex = static_cast<uint32_t>(mMemoryBlocks.size());
+				mMemoryBlocks.push_back(memory_block{ allocate_device_local_memory_for_given_requirements(mPhysicalDevice, mDevice, b.requirements, resource_tiling::optimal, memory_category::render_target), {}, {} });
+				bytesAllocated += b.requirements.size;
+				const auto& memory = mMemoryBlocks.back().memory;
+				for (const auto i : b.images) {
+					const auto& image = mImages[i];
+					auto& physicalImage = mPhysicalImages[image.transientIndex];
+					mDevice.bindImageMemory(physicalImage.image, memory.memory, memory.offset);
+					physicalImage.memoryBlock = blockIndex;
+					physicalImage.imageView = create_image_view(mDevice, mPhysicalDevice, physicalImage.image, image.format, get_image_aspect_flags(image.format),
+						image.mipLevels, image.arrayLayers, image.arrayLayers > 1u ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D);
+				}
+			}
+			mStatistics.transientImages = static_cast<uint32_t>(order.size());
+			mStatistics.transientMemoryBlocks = static_cast<uint32_t>(blocks.size());
+			mStatistics.transientBytesRequired = bytesRequired;
+			mStatistics.transientBytesAllocated = bytesAllocated;
+		}
+
+		for (auto& image : mImages) {
+			if (!image.imported) {
+				image.image = mPhysicalImages[image.transientIndex].image;
+				image.imageView = mPhysicalImages[image.transientIndex].imageView;
+			}
+		}
+	}
+
+	void render_graph::derive_barriers()
+	{
+		mBarriers.clear();
+		mFinalBarriers.clear();
+
+		// Which stages access each memory block, over all images which share it:
+		for (auto& block : mMemoryBlocks) {
+			block.stages = vk::PipelineStageFlags{};
+			block.writeAccess = vk::AccessFlags{};
+		}
+		for (const auto& p : mPasses) {
+			if (p.culled) {
+				continue;
+			}
+			for (const auto& a : p.accesses) {
+				const auto& image = mImages[a.image];
+				if (!image.imported) {
+					auto& block = mMemoryBlocks[mPhysicalImages[image.transientIndex].memoryBlock];
+					block.stages |= a.stages;
+					block.writeAccess |= a.writeAccess;
+				}
+			}
+		}
+
+		std::vector<tracked_state> states(mImages.size());
+		for (size_t i = 0; i < mImages.size(); ++i) {
+			const auto& image = mImages[i];
+			auto& state = states[i];
+			if (image.imported) {
+				// Nothing to wait for, if the initial state is at the top of the pipe:
+				const bool nothingPending = image.initialState.stages == vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eTopOfPipe } && !image.initialState.access;
+				state = tracked_state{ image.initialState.layout, nothingPending ? vk::PipelineStageFlags{} : image.initialState.stages, image.initialState.access, {}, {}, {} };
+			}
+			else if (NoPass != image.firstPass) {
+				// The previous contents are discarded, but the accesses to the aliased images (also those of the previous
+				// frame) must be complete before the layout transition:
+				const auto& block = mMemoryBlocks[mPhysicalImages[image.transientIndex].memoryBlock];
+				state = tracked_state{ vk::ImageLayout::eUndefined, block.stages, block.writeAccess, {}, {}, {} };
+			}
+		}
+
+		const auto make_barrier = [this](const uint32_t imageIndex, const vk::AccessFlags srcAccess, const vk::AccessFlags dstAccess, const vk::ImageLayout oldLayout, const vk::ImageLayout newLayout) {
+			const auto& image = mImages[imageIndex];
+			return vk::ImageMemoryBarrier{ srcAccess, dstAccess, oldLayout, newLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image.image,
+				vk::ImageSubresourceRange{ get_image_aspect_flags(image.format), 0u, image.mipLevels, 0u, image.arrayLayers } };
+		};
+
+		for (auto& p : mPasses) {
+			p.firstBarrier = mBarriers.size();
+			p.barrierCount = 0;
+			p.srcStages = vk::PipelineStageFlags{};
+			p.dstStages = vk::PipelineStageFlags{};
+			if (p.culled) {
+				continue;
+			}
+			for (const auto& a : p.accesses) {
+				auto& state = states[a.image];
+				const bool transition = state.layout != a.layout;
+				vk::PipelineStageFlags srcStages;
+				bool needsBarrier = false;
+				if (transition || a.writes) {
+					// Layout transitions and writes must wait for all previous reads and writes:
+					srcStages = state.writeStages | state.readStages;
+					needsBarrier = transition || srcStages;
+				}
+				else {
+					// Reads only have to wait for the last write, unless it has been made visible to them already:
+					srcStages = state.writeStages;
+					needsBarrier = srcStages && ((a.stages & ~state.visibleStages) || (a.access & ~state.visibleAccess));
+				}
+
+				if (needsBarrier) {
+					mBarriers.push_back(make_barrier(a.image, state.writeAccess, a.access, state.layout, a.layout));
+					++p.barrierCount;
+					p.srcStages |= srcStages ? srcStages : vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eTopOfPipe };
+					p.dstStages |= a.stages;
+				}
+
+				state.layout = a.layout;
+				if (a.writes) {
+					state = tracked_state{ a.layout, a.stages, a.writeAccess, {}, {}, {} };
+				}
+				else if (needsBarrier && transition) {
+					// The transition is a write, which has been made visible to this access:
+					state = tracked_state{ a.layout, a.stages, {}, {}, a.stages, a.access };
+				}
+				else {
+					state.readStages |= a.stages;
+					if (needsBarrier) {
+						state.visibleStages |= a.stages;
+						state.visibleAccess |= a.access;
+					}
+				}
+			}
+		}
+
+		// Hand the imported images over in their final state:
+		mFinalSrcStages = vk::PipelineStageFlags{};
+		mFinalDstStages = vk::PipelineStageFlags{};
+		for (uint32_t i = 0; i < mImages.size(); ++i) {
+			const auto& image = mImages[i];
+			const auto& state = states[i];
+			if (!image.imported) {
+				continue;
+			}
+			const bool transition = state.layout != image.finalState.layout;
+			if (!transition && !state.writeAccess) {
+				continue; // Nothing to transition, nothing to make available
+			}
+			mFinalBarriers.push_back(make_barrier(i, state.writeAccess, image.finalState.access, state.layout, image.finalState.layout));
+			const auto srcStages = state.writeStages | state.readStages;
+			mFinalSrcStages |= srcStages ? srcStages : vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eTopOfPipe };
+			mFinalDstStages |= image.finalState.stages ? image.finalState.stages : vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eBottomOfPipe };
+		}
+	}
+
+	void render_graph::execute(const vk::CommandBuffer commandBuffer)
+	{
+		if (!mCompiled) {
+			compile();
+		}
+		for (const auto& p : mPasses) {
+			if (p.culled) {
+				continue;
+			}
+			if (p.barrierCount > 0) {
+				commandBuffer.pipelineBarrier(p.srcStages, p.dstStages, {}, {}, {},
+					vk::ArrayProxy<const vk::ImageMemoryBarrier>{ static_cast<uint32_t>(p.barrierCount), mBarriers.data() + p.firstBarrier });
+			}
+			if (p.execute) {
+				p.execute(commandBuffer, *this);
+			}
+		}
+		if (!mFinalBarriers.empty()) {
+			commandBuffer.pipelineBarrier(mFinalSrcStages, mFinalDstStages, {}, {}, {}, mFinalBarriers);
+		}
+		++mFrameNumber;
+	}
+
+	vk::Image render_graph::image(const render_graph_image image) const
+	{
+		if (!image.is_valid() || image.index >= mImages.size()) {
+			throw std::invalid_argument("The image doesn't belong to the render graph");
+		}
+		return mImages[image.index].image;
+	}
+
+	vk::ImageView render_graph::image_view(const render_graph_image image) const
+	{
+		if (!image.is_valid() || image.index >= mImages.size()) {
+			throw std::invalid_argument("The image doesn't belong to the render graph");
+		}
+		return mImages[image.index].imageView;
+	}
+
+	bool render_graph::is_culled(const std::string& passName) const
+	{
+		const auto it = std::find_if(mPasses.begin(), mPasses.end(), [&](const pass& p) { return p.name == passName; });
+		return mPasses.end() != it && it->culled;
+	}
+
+	void render_graph::retire_transient_images()
+	{
+		if (mPhysicalImages.empty() && mMemoryBlocks.empty()) {
+			return;
+		}
+		mRetired.push_back(retired_resources{ mFrameNumber, std::move(mPhysicalImages), std::move(mMemoryBlocks) });
+		mPhysicalImages.clear();
+		mMemoryBlocks.clear();
+	}
+
+	void render_graph::destroy_retired_resources(const bool all)
+	{
+		// The resources have been used by frame frameNumber - 1 at the latest:
+		while (!mRetired.empty() && (all || mRetired.front().frameNumber + mFramesInFlight <= mFrameNumber)) {
+			for (const auto& image : mRetired.front().images) {
+				if (image.image) {
+					destroy_image_view(mDevice, image.imageView);
+					destroy_image(mDevice, image.image);
+				}
+			}
+			for (const auto& block : mRetired.front().memoryBlocks) {
+				free_memory(mDevice, block.memory);
+			}
+			mRetired.pop_front();
+		}
+	}
+
+	void render_graph::print_statistics(std::ostream& stream) const
+	{
+		stream << "Render graph: " << mStatistics.passes << " passes (" << mStatistics.culledPasses << " culled), "
+			<< mStatistics.imageBarriers << " image barriers in " << mStatistics.barrierCalls << " barrier calls, "
+			<< mStatistics.transientImages << " transient images in " << mStatistics.transientMemoryBlocks << " memory blocks ("
+			<< mStatistics.transientBytesAllocated / 1024 << " KiB instead of " << mStatistics.transientBytesRequired / 1024 << " KiB), "
+			<< mStatistics.transientRebuilds << " rebuilds over " << mStatistics.compiledFrames << " frames, last compile "
+			<< mStatistics.compileMs << " ms" << std::endl;
+	}
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+namespace helpers
+{
+	// How a pass uses an image. Each usage implies the pipeline stages, access types, and the image layout of the access.
+	enum struct image_usage
+	{
+		transfer_src,				// Read by copies/blits:                    eTransferSrcOptimal
+		transfer_dst,				// Written by copies/blits/clears:          eTransferDstOptimal
+		color_attachment,			// Color attachment:                        eColorAttachmentOptimal
+		depth_stencil_attachment,	// Depth/stencil attachment:                eDepthStencilAttachmentOptimal
+		depth_stencil_read,			// Read-only depth attachment (depth test): eDepthStencilReadOnlyOptimal
+		sampled_fragment,			// Sampled in fragment shaders:             eShaderReadOnlyOptimal
+		sampled_compute,			// Sampled in compute shaders:              eShaderReadOnlyOptimal
+		storage_read_compute,		// Storage image, read in compute shaders:  eGeneral
+		storage_write_compute		// Storage image, written in compute shaders: eGeneral
+	};
+
+	// The synchronization state of an image outside of the graph, i.e. which stages/accesses have to be waited for
+	// before the graph's first access (initial state), or have to wait for the graph's last access (final state)
+	struct image_state
+	{
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eTopOfPipe;
+		vk::AccessFlags access = {};
+	};
+
+	// An image of a render graph, as returned by render_graph::import_image and render_graph::create_image.
+	// Only valid for the render graph which has returned it, until its next reset.
+	struct render_graph_image
+	{
+		uint32_t index = std::numeric_limits<uint32_t>::max();
+		bool is_valid() const { return std::numeric_limits<uint32_t>::max() != index; }
+	};
+
+	// A transient image: created, owned, and (possibly) memory-aliased by the render graph. Its contents are undefined
+	// at the beginning of each frame.
+	struct transient_image_description
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		vk::Format format = vk::Format::eUndefined;
+		uint32_t mipLevels = 1u;
+		uint32_t arrayLayers = 1u;
+	};
+
+	// How a render graph has been compiled the last time, and how it has been doing overall
+	struct render_graph_statistics
+	{
+		uint32_t passes = 0;					// Declared in the last compiled frame
+		uint32_t culledPasses = 0;				// Of which didn't contribute to any output
+		uint32_t barrierCalls = 0;				// vkCmdPipelineBarrier calls of the last compiled frame
+		uint32_t imageBarriers = 0;				// Image memory barriers in these calls (incl. layout transitions)
+		uint32_t transientImages = 0;
+		uint32_t transientMemoryBlocks = 0;		// Allocations which the transient images are aliased into
+		vk::DeviceSize transientBytesRequired = 0;	// Sum of the transient images' memory requirements
+		vk::DeviceSize transientBytesAllocated = 0;	// After aliasing
+		uint64_t compiledFrames = 0;
+		uint64_t transientRebuilds = 0;			// How often the transient images had to be recreated
+		double compileMs = 0.0;					// CPU time of the last compile
+	};
+
+	class render_graph;
+
+	// Passed to a pass' setup function, to declare which images the pass reads and writes
+	class render_graph_pass_builder
+	{
+	public:
+		// Declare an access. Passes which also depend on the previous contents of what they write (attachments with a
+		// load op of eLoad, blending, read-modify-write of storage images) declare both. An image can be declared multiple
+		// times per pass, but all of its usages within one pass must have the same image layout. Throws if the usage
+		// can't read or write, respectively (e.g. writing with image_usage::sampled_fragment).
+		void read(const render_graph_image image, const image_usage usage);
+		void write(const render_graph_image image, const image_usage usage);
+
+		// Never cull this pass, even if nothing reads what it writes (e.g. it writes to buffers or reads back data)
+		void set_side_effects() { mHasSideEffects = true; }
+
+	private:
+		friend class render_graph;
+		render_graph_pass_builder(render_graph& graph, const uint32_t passIndex) : mGraph{ graph }, mPassIndex{ passIndex } {}
+
+		render_graph& mGraph;
+		uint32_t mPassIndex;
+		bool mHasSideEffects = false;
+	};
+
+	// A frame graph: a frame is described as a sequence of passes which declare what they read and write. From these
+	// declarations, the graph derives the barriers and image layout transitions between the passes -- all barriers
+	// which are due before a pass are batched into one vkCmdPipelineBarrier, and accesses which don't need any
+	// synchronization (e.g. a second pass which reads an image in the same layout) don't get any. Passes whose results
+	// are neither read by a later pass, nor end up in an imported image, are culled.
+	//
+	// Transient images (create_image) are owned by the graph. Transient images whose lifetimes (first to last pass which
+	// accesses them) don't overlap share the same memory. The first access of a transient image in a frame waits for
+	// all stages in which the images sharing its memory are accessed, which also covers the accesses of the previous
+	// frame (on the same queue). The transient images are only recreated if their descriptions or lifetimes change.
+	//
+	// Usage per frame:
+	//   graph.reset();
+	//   auto backbuffer = graph.import_image(swapchainImage, format, { vk::ImageLayout::eUndefined, waitStage },
+	//       { vk::ImageLayout::ePresentSrcKHR, vk::PipelineStageFlagBits::eBottomOfPipe });
+	//   auto hdr = graph.create_image(transient_image_description{ width, height, vk::Format::eR16G16B16A16Sfloat });
+	//   graph.add_pass("lighting", [&](render_graph_pass_builder& pass) { pass.write(hdr, image_usage::storage_write_compute); },
+	//       [&](vk::CommandBuffer cb, const render_graph& g) { ... g.image_view(hdr) ... });
+	//   graph.add_pass("tonemap", ...reads hdr, writes backbuffer...);
+	//   graph.execute(frame.commandBuffer);   // Compiles, then records all passes which haven't been culled
+	//
+	// Passes which use attachments begin their own render passes, with the attachments' initial and final layouts
+	// set to the layout of the declared usage (the graph has done the transition already). The images' layouts after
+	// the graph are the final layouts of the imported images. The render graph is not thread-safe.
+	class render_graph
+	{
+	public:
+		using setup_function = std::function<void(render_graph_pass_builder&)>;
+		using execute_function = std::function<void(vk::CommandBuffer, const render_graph&)>;
+
+		// <framesInFlight>: transient images which are replaced are only destroyed after that many further frames
+		render_graph(const vk::PhysicalDevice physicalDevice, const vk::Device device, const uint32_t framesInFlight);
+		render_graph(const render_graph&) = delete;
+		render_graph& operator=(const render_graph&) = delete;
+		// The GPU must be done with all frames which have been recorded with the graph.
+		~render_graph();
+
+		// Remove all passes and images, in order to describe the next frame. Keeps the transient images and their memory.
+		// Call it after the frame scheduler's begin_frame, i.e. once the GPU is done with the frame framesInFlight frames ago.
+		void reset();
+
+		// Use an image which lives outside of the graph (e.g. a swapchain image). All mip levels and array layers are
+		// tracked as a whole. <initialState> is waited for before the first access; after the last access, the image is
+		// transitioned into <finalState.layout>, and made available to <finalState.stages>/<finalState.access>.
+		render_graph_image import_image(
+			const vk::Image image,
+			const vk::Format format,
+			const image_state& initialState,
+			const image_state& finalState,
+			const vk::ImageView imageView = nullptr,
+			const uint32_t mipLevels = 1u,
+			const uint32_t arrayLayers = 1u
+		);
+
+		// Declare a transient image, see render_graph. It gets an image view over all of its mip levels and array layers.
+		render_graph_image create_image(const transient_image_description& description);
+
+		// Add a pass. <setup> is invoked immediately and declares the pass' accesses; <execute> is invoked by execute,
+		// unless the pass is culled.
+		void add_pass(const std::string& name, const setup_function& setup, execute_function execute);
+
+		// Cull passes, derive the barriers, and (re)create the transient images if necessary. Invoked by execute,
+		// if the graph has been changed since the last compile.
+		void compile();
+
+		// Record the passes which haven't been culled, with their barriers, and the final transitions of the imported images
+		void execute(const vk::CommandBuffer commandBuffer);
+
+		// The image and image view of a render graph image, e.g. for use in execute functions. Transient images are only
+		// available after compile.
+		vk::Image image(const render_graph_image image) const;
+		vk::ImageView image_view(const render_graph_image image) const;
+
+		// Has the pass with the given name been culled in the last compile?
+		bool is_culled(const std::string& passName) const;
+
+		render_graph_statistics get_statistics() const { return mStatistics; }
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		friend class render_graph_pass_builder;
+
+		struct image_access
+		{
+			uint32_t image;
+			vk::ImageLayout layout;
+			vk::PipelineStageFlags stages;
+			vk::AccessFlags access;			// Reads and writes
+			vk::AccessFlags writeAccess;
+			vk::ImageUsageFlags imageUsage;
+			bool reads;
+			bool writes;
+		};
+
+		struct pass
+		{
+			std::string name;
+			execute_function execute;
+			std::vector<image_access> accesses;		// At most one per image
+			bool hasSideEffects = false;
+			bool culled = false;
+			size_t firstBarrier = 0;				// Range of mBarriers which is recorded before the pass
+			size_t barrierCount = 0;
+			vk::PipelineStageFlags srcStages;
+			vk::PipelineStageFlags dstStages;
+		};
+
+		struct image_resource
+		{
+			vk::Image image;
+			vk::ImageView imageView;
+			vk::Format format;
+			uint32_t mipLevels;
+			uint32_t arrayLayers;
+			bool imported;
+			image_state initialState;
+			image_state finalState;
+			transient_image_description description;	// Transient images only
+			uint32_t transientIndex;					// Into mPhysicalImages
+			vk::ImageUsageFlags usage;					// Of the passes which haven't been culled
+			vk::PipelineStageFlags stages;				// Of the passes which haven't been culled
+			vk::AccessFlags access;
+			uint32_t firstPass = std::numeric_limits<uint32_t>::max();	// Lifetime, over the passes which haven't been culled
+			uint32_t lastPass = 0;
+		};
+
+		// A transient image which has actually been created, and the memory it is bound to
+		struct physical_image
+		{
+			vk::Image image;
+			vk::ImageView imageView;
+			uint32_t memoryBlock;
+		};
+
+		struct memory_block
+		{
+			memory_allocation memory;
+			vk::PipelineStageFlags stages;		// Of all accesses to the images in this block
+			vk::AccessFlags writeAccess;
+		};
+
+		// Transient images and memory which have been replaced, to be destroyed once the GPU is done with them
+		struct retired_resources
+		{
+			uint64_t frameNumber;
+			std::vector<physical_image> images;
+			std::vector<memory_block> memoryBlocks;
+		};
+
+		void declare_access(const uint32_t passIndex, const render_graph_image image, const image_usage usage, const bool writes);
+		void cull_passes();
+		void create_transient_images();
+		void derive_barriers();
+		void retire_transient_images();
+		void destroy_retired_resources(const bool all);
+
+		vk::PhysicalDevice mPhysicalDevice;
+		vk::Device mDevice;
+		uint32_t mFramesInFlight;
+		std::vector<pass> mPasses;
+		std::vector<image_resource> mImages;
+		std::vector<vk::ImageMemoryBarrier> mBarriers;
+		std::vector<vk::ImageMemoryBarrier> mFinalBarriers;
+		vk::PipelineStageFlags mFinalSrcStages;
+		vk::PipelineStageFlags mFinalDstStages;
+		bool mCompiled = false;
+
+		// The transient images of the last compile, in the order of their create_image calls:
+		uint64_t mTransientKey = 0;			// Hash over the descriptions, lifetimes and accesses of the transient images
+		std::vector<physical_image> mPhysicalImages;
+		std::vector<memory_block> mMemoryBlocks;
+		std::deque<retired_resources> mRetired;
+		uint64_t mFrameNumber = 0;
+		render_graph_statistics mStatistics;
+	};
+}
@@ -0,0 +1,328 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		double milliseconds_between(const std::chrono::steady_clock::time_point from, const std::chrono::steady_clock::time_point to)
+		{
+			return std::chrono::duration<double, std::milli>(to - from).count();
+		}
+
+		bool contains(const std::vector<vk::PresentModeKHR>& presentModes, const vk::PresentModeKHR presentMode)
+		{
+			return presentModes.end() != std::find(presentModes.begin(), presentModes.end(), presentMode);
+		}
+
+		// FIFO is the only present mode which is guaranteed to be supported
+		vk::PresentModeKHR select_present_mode(const std::vector<vk::PresentModeKHR>& supported, const present_mode_preference preference)
+		{
+			if (present_mode_preference::low_latency == preference) {
+				for (const auto candidate : { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eFifoRelaxed }) {
+					if (contains(supported, candidate)) {
+						return candidate;
+					}
+				}
+			}
+			return vk::PresentModeKHR::eFifo;
+		}
+
+		uint32_t select_image_count(const vk::SurfaceCapabilitiesKHR& capabilities, const vk::PresentModeKHR presentMode, const present_mode_preference preference)
+		{
+			auto imageCount = capabilities.minImageCount;
+			if (present_mode_preference::power_saving == preference) {
+				imageCount = std::max(imageCount, 2u);
+			}
+			else if (vk::PresentModeKHR::eMailbox == presentMode) {
+				// One image on screen, one queued, and one to render into:
+				imageCount = std::max(imageCount + 1u, 3u);
+			}
+			else if (vk::PresentModeKHR::eImmediate != presentMode) {
+				imageCount = imageCount + 1u;
+			}
+			if (0u != capabilities.maxImageCount) {
+				imageCount = std::min(imageCount, capabilities.maxImageCount);
+			}
+			return imageCount;
+		}
+
+		vk::SurfaceFormatKHR select_surface_format(const std::vector<vk::SurfaceFormatKHR>& supported, const std::vector<vk::SurfaceFormatKHR>& preferred)
+		{
+			if (supported.empty()) {
+				throw std::runtime_error("The surface doesn't support any formats");
+			}
+			// Some (old) drivers report a single eUndefined format, which means that any format can be used:
+			if (1 == supported.size() && vk::Format::eUndefined == supported.front().format && !preferred.empty()) {
+				return preferred.front();
+			}
+			for (const auto& candidate : preferred) {
+				for (const auto& format : supported) {
+					if (candidate.format == format.format && candidate.colorSpace == format.colorSpace) {
+						return format;
+					}
+				}
+			}
+			return supported.front();
+		}
+
+		vk::CompositeAlphaFlagBitsKHR select_composite_alpha(const vk::SurfaceCapabilitiesKHR& capabilities)
+		{
+			for (const auto candidate : { vk::CompositeAlphaFlagBitsKHR::eOpaque, vk::CompositeAlphaFlagBitsKHR::eInherit,
+				vk::CompositeAlphaFlagBitsKHR::ePreMultiplied, vk::CompositeAlphaFlagBitsKHR::ePostMultiplied }) {
+				if (capabilities.supportedCompositeAlpha & candidate) {
+					return candidate;
+				}
+			}
+			return vk::CompositeAlphaFlagBitsKHR::eOpaque;
+		}
+
+		double percentile(std::vector<double> samples, const double p)
+		{
+			if (samples.empty()) {
+				return 0.0;
+			}
+			std::sort(samples.begin(), samples.end());
+			const auto index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+			return samples[std::min(index, samples.size() - 1)];
+		}
+
+		double mean(const std::vector<double>& samples)
+		{
+			if (samples.empty()) {
+				return 0.0;
+			}
+			double sum = 0.0;
+			for (const auto s : samples) {
+				sum += s;
+			}
+			return sum / static_cast<double>(samples.size());
+		}
+
+		void add_to_ring_buffer(std::vector<double>& ringBuffer, size_t& next, const size_t capacity, const double value)
+		{
+			if (ringBuffer.size() < capacity) {
+				ringBuffer.push_back(value);
+			}
+			else {
+				ringBuffer[next] = value;
+			}
+			next = (next + 1) % capacity;
+		}
+	}
+
+	std::string to_string(const present_mode_preference preference)
+	{
+		switch (preference) {
+		case present_mode_preference::throughput: return "throughput";
+		case present_mode_preference::low_latency: return "low-latency";
+		case present_mode_preference::power_saving: return "power-saving";
+		}
+		return "unknown";
+	}
+
+	swapchain_manager::swapchain_manager(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const VkSurfaceKHR surface,
+		const uint32_t framesInFlight,
+		const present_mode_preference preference,
+		std::function<vk::Extent2D()> getFramebufferExtent,
+		const vk::ImageUsageFlags imageUsage,
+		std::vector<vk::SurfaceFormatKHR> preferredFormats)
+		: mPhysicalDevice{ physicalDevice }
+		, mDevice{ device }
+		, mSurface{ surface }
+		, mFramesInFlight{ framesInFlight }
+		, mPreference{ preference }
+		, mGetFramebufferExtent{ std::move(getFramebufferExtent) }
+		, mImageUsage{ imageUsage }
+		, mPreferredFormats{ std::move(preferredFormats) }
+	{
+		// If the window is minimized already, the swapchain is created by the first acquire_next_image after it has been restored:
+		mRecreationRequested = !recreate();
+	}
+
+	swapchain_manager::~swapchain_manager()
+	{
+		destroy_retired_swapchains(true);
+		if (mSwapchain) {
+			mDevice.destroySwapchainKHR(mSwapchain);
+		}
+	}
+
+	bool swapchain_manager::recreate()
+	{
+		const auto capabilities = mPhysicalDevice.getSurfaceCapabilitiesKHR(mSurface);
+
+		// The surface either dictates the extent, or leaves it up to us (within its limits):
+		auto extent = capabilities.currentExtent;
+		if (std::numeric_limits<uint32_t>::max() == extent.width) {
+			const auto framebufferExtent = mGetFramebufferExtent();
+			extent.width = std::clamp(framebufferExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+			extent.height = std::clamp(framebufferExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+		}
+		if (0u == extent.width || 0u == extent.height) {
+			return false;
+		}
+
+		if ((capabilities.supportedUsageFlags & mImageUsage) != mImageUsage) {
+			throw std::runtime_error("The surface doesn't support the requested image usage: " + vk::to_string(mImageUsage));
+		}
+
+		const auto surfaceFormat = select_surface_format(mPhysicalDevice.getSurfaceFormatsKHR(mSurface), mPreferredFormats);
+		const auto presentMode = select_present_mode(mPhysicalDevice.getSurfacePresentModesKHR(mSurface), mPreference);
+		const auto imageCount = select_image_count(capabilities, presentMode, mPreference);
+
+		// Passing the old swapchain allows the driver to reuse its resources, and to keep presenting its images
+		// until the new one takes over => no device.waitIdle():
+		const auto oldSwapchain = mSwapchain;
+		mSwapchain = mDevice.createSwapchainKHR(vk::SwapchainCreateInfoKHR{}
+			.setSurface(mSurface)
+			.setMinImageCount(imageCount)
+			.setImageFormat(surfaceFormat.format)
+			.setImageColorSpace(surfaceFormat.colorSpace)
+			.setImageExtent(extent)
+			.setImageArrayLayers(1u)
+			.setImageUsage(mImageUsage)
+			.setImageSharingMode(vk::SharingMode::eExclusive)
+			.setPreTransform(capabilities.currentTransform)
+			.setCompositeAlpha(select_composite_alpha(capabilities))
+			.setPresentMode(presentMode)
+			.setClipped(VK_TRUE)
+			.setOldSwapchain(oldSwapchain)
+		);
+		if (oldSwapchain) {
+			mRetiredSwapchains.push_back(retired_swapchain{ oldSwapchain, mPresentCount });
+		}
+
+		mImages = mDevice.getSwapchainImagesKHR(mSwapchain);
+		mSurfaceFormat = surfaceFormat;
+		mExtent = extent;
+		mPresentMode = presentMode;
+		mRecreationRequested = false;
+		mLastPresent.reset();
+		++mGeneration;
+		current_history().imageCount = static_cast<uint32_t>(mImages.size());
+		return true;
+	}
+
+	void swapchain_manager::destroy_retired_swapchains(const bool all)
+	{
+		auto it = mRetiredSwapchains.begin();
+		while (mRetiredSwapchains.end() != it) {
+			if (all || mPresentCount >= it->retiredAtPresent + mFramesInFlight) {
+				mDevice.destroySwapchainKHR(it->swapchain);
+				it = mRetiredSwapchains.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	void swapchain_manager::set_preference(const present_mode_preference preference)
+	{
+		if (mPreference != preference) {
+			mPreference = preference;
+			mRecreationRequested = true;
+		}
+	}
+
+	std::optional<uint32_t> swapchain_manager::acquire_next_image(const vk::Semaphore imageAvailableSemaphore)
+	{
+		destroy_retired_swapchains(false);
+		while (true) {
+			if (mRecreationRequested && !recreate()) {
+				return {};
+			}
+
+			const auto waitBegin = std::chrono::steady_clock::now();
+			try {
+				const auto result = mDevice.acquireNextImageKHR(mSwapchain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphore, nullptr);
+				auto& history = current_history();
+				add_to_ring_buffer(history.acquireWaitsMs, history.nextAcquireWait, StatisticsWindowSize,
+					milliseconds_between(waitBegin, std::chrono::steady_clock::now()));
+				// Suboptimal: the image has been acquired and the semaphore will be signalled => use it, recreate afterwards
+				if (vk::Result::eSuboptimalKHR == result.result) {
+					mRecreationRequested = true;
+				}
+				return result.value;
+			}
+			catch (const vk::OutOfDateKHRError&) {
+				// Nothing has been acquired, and the semaphore is left untouched => recreate and try again
+				mRecreationRequested = true;
+			}
+		}
+	}
+
+	void swapchain_manager::present(const vk::Queue queue, const uint32_t imageIndex, const vk::Semaphore waitSemaphore)
+	{
+		auto presentInfo = vk::PresentInfoKHR{}
+			.setSwapchainCount(1u)
+			.setPSwapchains(&mSwapchain)
+			.setPImageIndices(&imageIndex)
+			.setWaitSemaphoreCount(1u)
+			.setPWaitSemaphores(&waitSemaphore);
+		auto result = vk::Result::eSuccess;
+		try {
+			result = queue.presentKHR(presentInfo);
+		}
+		catch (const vk::OutOfDateKHRError&) {
+			result = vk::Result::eErrorOutOfDateKHR;
+		}
+		if (vk::Result::eSuccess != result) {
+			mRecreationRequested = true;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		++mPresentCount;
+		auto& history = current_history();
+		++history.presentCount;
+		if (mLastPresent.has_value()) {
+			add_to_ring_buffer(history.intervalsMs, history.nextInterval, StatisticsWindowSize, milliseconds_between(*mLastPresent, now));
+		}
+		mLastPresent = now;
+	}
+
+	swapchain_manager::present_mode_history& swapchain_manager::current_history()
+	{
+		for (auto& history : mHistories) {
+			if (history.presentMode == mPresentMode) {
+				return history;
+			}
+		}
+		mHistories.emplace_back();
+		mHistories.back().presentMode = mPresentMode;
+		return mHistories.back();
+	}
+
+	std::vector<swapchain_present_statistics> swapchain_manager::get_statistics() const
+	{
+		std::vector<swapchain_present_statistics> result;
+		for (const auto& history : mHistories) {
+			swapchain_present_statistics statistics;
+			statistics.presentMode = history.presentMode;
+			statistics.imageCount = history.imageCount;
+			statistics.presentCount = history.presentCount;
+			statistics.meanIntervalMs = mean(history.intervalsMs);
+			statistics.p50IntervalMs = percentile(history.intervalsMs, 0.5);
+			statistics.p99IntervalMs = percentile(history.intervalsMs, 0.99);
+			statistics.maxIntervalMs = history.intervalsMs.empty() ? 0.0 : *std::max_element(history.intervalsMs.begin(), history.intervalsMs.end());
+			statistics.meanAcquireWaitMs = mean(history.acquireWaitsMs);
+			result.push_back(statistics);
+		}
+		return result;
+	}
+
+	void swapchain_manager::print_statistics(std::ostream& stream) const
+	{
+		stream << "Swapchain: " << mExtent.width << "x" << mExtent.height << ", " << vk::to_string(mSurfaceFormat.format)
+			<< ", " << to_string(mPreference) << " => " << vk::to_string(mPresentMode) << " with " << mImages.size() << " images, "
+			<< (mGeneration > 0 ? mGeneration - 1 : 0) << " recreations\n";
+		for (const auto& s : get_statistics()) {
+			stream << "  " << vk::to_string(s.presentMode) << " (" << s.imageCount << " images, " << s.presentCount << " presents): "
+				<< "present-to-present mean " << s.meanIntervalMs << " ms, p50 " << s.p50IntervalMs << " ms, p99 " << s.p99IntervalMs
+				<< " ms, max " << s.maxIntervalMs << " ms, acquire wait " << s.meanAcquireWaitMs << " ms\n";
+		}
+	}
+}
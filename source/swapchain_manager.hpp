@@ -0,0 +1,148 @@
+#pragma once
+
+namespace helpers
+{
+	// What the swapchain should be optimized for
+	enum struct present_mode_preference
+	{
+		throughput,		// FIFO with one image more than the minimum: never tears, the GPU never has to wait for an image
+		low_latency,	// MAILBOX (or IMMEDIATE, which may tear): the most recently finished frame is shown at the next vblank
+		power_saving	// FIFO with as few images as possible: the CPU and GPU are throttled to the refresh rate early
+	};
+
+	std::string to_string(const present_mode_preference preference);
+
+	// Present-to-present intervals of one present mode, measured on the CPU around vkQueuePresentKHR
+	struct swapchain_present_statistics
+	{
+		vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
+		uint32_t imageCount = 0;
+		uint64_t presentCount = 0;		// All presents in this mode; the intervals only cover the most recent ones
+		double meanIntervalMs = 0.0;
+		double p50IntervalMs = 0.0;
+		double p99IntervalMs = 0.0;
+		double maxIntervalMs = 0.0;
+		double meanAcquireWaitMs = 0.0;	// How long vkAcquireNextImageKHR blocked, on average
+	};
+
+	// Owns the swapchain of a surface, and recreates it whenever it has to be.
+	//
+	// The format, present mode, image count and extent are negotiated with the surface's capabilities, according to a
+	// present_mode_preference (which can be changed at runtime). The swapchain is recreated with oldSwapchain set --
+	// without waiting for the device to become idle -- when acquire or present report eErrorOutOfDateKHR or
+	// eSuboptimalKHR, or after request_recreation() (e.g. from a window resize callback). Recreation happens at the
+	// beginning of acquire_next_image, i.e. never while an image is acquired.
+	//
+	// Retired swapchains are destroyed once <framesInFlight> further images have been presented: by then, the frame
+	// scheduler has waited for all frames which have rendered into their images. (Without VK_EXT_swapchain_maintenance1
+	// there is no way to know when the presentation engine is done with them; this is the usual compromise.)
+	//
+	// Usage per frame:
+	//   auto& frame = frameScheduler.begin_frame();
+	//   auto imageIndex = swapchain.acquire_next_image(frame.imageAvailableSemaphore);
+	//   if (!imageIndex) { frameScheduler.submit_frame(queue); wait for the window to be restored; continue; }
+	//   if (swapchain.generation() changed) { recreate resources which depend on the images or the extent }
+	//   record, frameScheduler.submit_frame(queue, waitStage);
+	//   swapchain.present(queue, *imageIndex, frame.renderFinishedSemaphore);
+	class swapchain_manager
+	{
+	public:
+		// <getFramebufferExtent> is only queried if the surface leaves the extent up to the swapchain (e.g. on Wayland).
+		// The first supported format of <preferredFormats> is used; if none is supported, the surface's first one.
+		swapchain_manager(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			const VkSurfaceKHR surface,
+			const uint32_t framesInFlight,
+			const present_mode_preference preference,
+			std::function<vk::Extent2D()> getFramebufferExtent,
+			const vk::ImageUsageFlags imageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst,
+			std::vector<vk::SurfaceFormatKHR> preferredFormats = {
+				vk::SurfaceFormatKHR{ vk::Format::eB8G8R8A8Unorm, vk::ColorSpaceKHR::eSrgbNonlinear },
+				vk::SurfaceFormatKHR{ vk::Format::eR8G8B8A8Unorm, vk::ColorSpaceKHR::eSrgbNonlinear }
+			}
+		);
+		swapchain_manager(const swapchain_manager&) = delete;
+		swapchain_manager& operator=(const swapchain_manager&) = delete;
+		// The GPU must be done with all frames (e.g. device.waitIdle()) before the swapchain manager is destroyed.
+		~swapchain_manager();
+
+		// Acquire the next image, which signals <imageAvailableSemaphore>. Recreates the swapchain first if necessary.
+		// Returns no image if the surface has a zero extent (i.e. the window is minimized); <imageAvailableSemaphore> is
+		// not signalled in that case.
+		std::optional<uint32_t> acquire_next_image(const vk::Semaphore imageAvailableSemaphore);
+
+		// Present the acquired image as soon as <waitSemaphore> is signalled.
+		// If the swapchain turns out to be out of date or suboptimal, it is recreated by the next acquire_next_image.
+		void present(const vk::Queue queue, const uint32_t imageIndex, const vk::Semaphore waitSemaphore);
+
+		// Recreate the swapchain at the next acquire_next_image, e.g. because the window has been resized
+		void request_recreation() { mRecreationRequested = true; }
+
+		// Recreate the swapchain with another present mode (and image count) at the next acquire_next_image
+		void set_preference(const present_mode_preference preference);
+		present_mode_preference preference() const { return mPreference; }
+
+		vk::SwapchainKHR handle() const { return mSwapchain; }
+		const std::vector<vk::Image>& images() const { return mImages; }
+		uint32_t image_count() const { return static_cast<uint32_t>(mImages.size()); }
+		vk::SurfaceFormatKHR surface_format() const { return mSurfaceFormat; }
+		vk::Format format() const { return mSurfaceFormat.format; }
+		vk::Extent2D extent() const { return mExtent; }
+		vk::PresentModeKHR present_mode() const { return mPresentMode; }
+
+		// Incremented whenever the swapchain is recreated => resources which depend on its images must be recreated too
+		uint64_t generation() const { return mGeneration; }
+
+		// Present statistics of each present mode which has been used, in the order in which they have been used
+		std::vector<swapchain_present_statistics> get_statistics() const;
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		static constexpr size_t StatisticsWindowSize = 512;
+
+		struct retired_swapchain
+		{
+			vk::SwapchainKHR swapchain;
+			uint64_t retiredAtPresent;		// mPresentCount when it has been retired
+		};
+
+		struct present_mode_history
+		{
+			vk::PresentModeKHR presentMode;
+			uint32_t imageCount = 0;
+			uint64_t presentCount = 0;
+			std::vector<double> intervalsMs;	// Ring buffers of the most recent samples
+			std::vector<double> acquireWaitsMs;
+			size_t nextInterval = 0;
+			size_t nextAcquireWait = 0;
+		};
+
+		// Returns false if the surface currently has a zero extent
+		bool recreate();
+		void destroy_retired_swapchains(const bool all);
+		present_mode_history& current_history();
+
+		vk::PhysicalDevice mPhysicalDevice;
+		vk::Device mDevice;
+		VkSurfaceKHR mSurface;
+		uint32_t mFramesInFlight;
+		present_mode_preference mPreference;
+		std::function<vk::Extent2D()> mGetFramebufferExtent;
+		vk::ImageUsageFlags mImageUsage;
+		std::vector<vk::SurfaceFormatKHR> mPreferredFormats;
+
+		vk::SwapchainKHR mSwapchain;
+		std::vector<vk::Image> mImages;
+		vk::SurfaceFormatKHR mSurfaceFormat;
+		vk::Extent2D mExtent;
+		vk::PresentModeKHR mPresentMode = vk::PresentModeKHR::eFifo;
+		uint64_t mGeneration = 0;
+		bool mRecreationRequested = false;
+		std::vector<retired_swapchain> mRetiredSwapchains;
+
+		uint64_t mPresentCount = 0;
+		std::optional<std::chrono::steady_clock::time_point> mLastPresent;	// Reset on recreation, s.t. it doesn't count as an interval
+		std::vector<present_mode_history> mHistories;
+	};
+}
@@ -0,0 +1,696 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// The texels of one 4x4 block, stored per channel (r, g, b, a), with values in [0, 255]
+		struct texel_block
+		{
+			float channels[4][16];
+		};
+
+		// The colors which the texels of a block can choose from, e.g. the interpolations between two endpoints
+		struct block_palette
+		{
+			float colors[16][4];
+			int size = 0;
+		};
+
+		// Which channels count towards the error of an encoding
+		constexpr float ColorWeights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+		constexpr float AlphaWeights[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		constexpr float RgbaWeights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+		// Interpolation weights of BC7's 4-bit indices (out of 64)
+		constexpr int Bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// Read a 4x4 block; texels outside of the image repeat the last column/row
+		void load_block(const uint8_t* rgba, const uint32_t width, const uint32_t height, const uint32_t blockX, const uint32_t blockY, texel_block& outBlock)
+		{
+			for (uint32_t y = 0; y < 4; ++y) {
+				const auto sy = std::min(blockY * 4 + y, height - 1);
+				for (uint32_t x = 0; x < 4; ++x) {
+					const auto sx = std::min(blockX * 4 + x, width - 1);
+					const auto texel = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+					for (int c = 0; c < 4; ++c) {
+						outBlock.channels[c][y * 4 + x] = static_cast<float>(texel[c]);
+					}
+				}
+			}
+		}
+
+		// Write a decoded 4x4 block; texels outside of the image are skipped
+		void store_block(const uint8_t (&texels)[16][4], uint8_t* rgba, const uint32_t width, const uint32_t height, const uint32_t blockX, const uint32_t blockY)
+		{
+			for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+				for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; ++x) {
+					memcpy(rgba + ((static_cast<size_t>(blockY) * 4 + y) * width + blockX * 4 + x) * 4, texels[y * 4 + x], 4);
+				}
+			}
+		}
+
+		// For every texel, find the palette color with the smallest weighted squared distance.
+		// Returns the sum of the smallest distances, i.e. the error of the block when encoded with this palette.
+		float find_nearest_palette_colors(const texel_block& block, const block_palette& palette, const float (&weights)[4], uint8_t (&outIndices)[16])
+		{
+			float error = 0.0f;
+#if defined(_M_X64) || defined(__SSE2__)
+			// Four texels at a time:
+			for (int i = 0; i < 16; i += 4) {
+				__m128 texels[4];
+				for (int c = 0; c < 4; ++c) {
+					texels[c] = _mm_loadu_ps(&block.channels[c][i]);
+				}
+				auto best = _mm_set1_ps(std::numeric_limits<float>::max());
+				auto bestIndex = _mm_setzero_si128();
+				for (int e = 0; e < palette.size; ++e) {
+					auto distance = _mm_setzero_ps();
+					for (int c = 0; c < 4; ++c) {
+						const auto d = _mm_sub_ps(texels[c], _mm_set1_ps(palette.colors[e][c]));
+						distance = _mm_add_ps(distance, _mm_mul_ps(_mm_mul_ps(d, d), _mm_set1_ps(weights[c])));
+					}
+					const auto isCloser = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+					best = _mm_min_ps(distance, best);
+					bestIndex = _mm_or_si128(_mm_and_si128(isCloser, _mm_set1_epi32(e)), _mm_andnot_si128(isCloser, bestIndex));
+				}
+				alignas(16) int32_t indices[4];
+				alignas(16) float distances[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+				_mm_store_ps(distances, best);
+				for (int j = 0; j < 4; ++j) {
+					outIndices[i + j] = static_cast<uint8_t>(indices[j]);
+					error += distances[j];
+				}
+			}
+#else
+			for (int i = 0; i < 16; ++i) {
+				auto best = std::numeric_limits<float>::max();
+				int bestIndex = 0;
+				for (int e = 0; e < palette.size; ++e) {
+					float distance = 0.0f;
+					for (int c = 0; c < 4; ++c) {
+						const auto d = block.channels[c][i] - palette.colors[e][c];
+						distance += d * d * weights[c];
+					}
+					if (distance < best) {
+						best = distance;
+						bestIndex = e;
+					}
+				}
+				outIndices[i] = static_cast<uint8_t>(bestIndex);
+				error += best;
+			}
+#endif
+			return error;
+		}
+
+		// Find the line through the block's texels (over the first <channelCount> channels) which fits them best,
+		// i.e. the principal axis of their covariance matrix (by power iteration), and return the extreme points
+		// of the texels' projections onto it.
+		void find_endpoints_on_principal_axis(const texel_block& block, const int channelCount, float (&outE0)[4], float (&outE1)[4])
+		{
+			float mean[4] = {};
+			for (int c = 0; c < channelCount; ++c) {
+				for (int i = 0; i < 16; ++i) {
+					mean[c] += block.channels[c][i];
+				}
+				mean[c] /= 16.0f;
+			}
+
+			float covariance[4][4] = {};
+			for (int i = 0; i < 16; ++i) {
+				for (int a = 0; a < channelCount; ++a) {
+					for (int b = 0; b < channelCount; ++b) {
+						covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+					}
+				}
+			}
+
+			// Start with the covariance matrix' column of the channel with the largest variance:
+			int start = 0;
+			for (int c = 1; c < channelCount; ++c) {
+				if (covariance[c][c] > covariance[start][start]) {
+					start = c;
+				}
+			}
+			float axis[4] = {};
+			for (int c = 0; c < channelCount; ++c) {
+				axis[c] = covariance[c][start];
+			}
+			for (int iteration = 0; iteration < 8; ++iteration) {
+				float next[4] = {};
+				float largest = 0.0f;
+				for (int a = 0; a < channelCount; ++a) {
+					for (int b = 0; b < channelCount; ++b) {
+						next[a] += covariance[a][b] * axis[b];
+					}
+					largest = std::max(largest, std::abs(next[a]));
+				}
+				if (largest < 1e-6f) {
+					break;
+				}
+				for (int c = 0; c < channelCount; ++c) {
+					axis[c] = next[c] / largest;
+				}
+			}
+			float length = 0.0f;
+			for (int c = 0; c < channelCount; ++c) {
+				length += axis[c] * axis[c];
+			}
+			length = std::sqrt(length);
+			if (length > 1e-6f) {
+				for (int c = 0; c < channelCount; ++c) {
+					axis[c] /= length;
+				}
+			}
+
+			float tMin = std::numeric_limits<float>::max(), tMax = std::numeric_limits<float>::lowest();
+			for (int i = 0; i < 16; ++i) {
+				float t = 0.0f;
+				for (int c = 0; c < channelCount; ++c) {
+					t += (block.channels[c][i] - mean[c]) * axis[c];
+				}
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+			for (int c = 0; c < 4; ++c) {
+				outE0[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+				outE1[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+			}
+		}
+
+		// Least squares fit of two endpoints to the texels, given their indices. Index i interpolates the endpoints as
+		// (1 - w) * e0 + w * e1 with w = indexWeights[i]. Returns false if the system is degenerate (e.g. all indices equal).
+		bool fit_endpoints_to_indices(const texel_block& block, const uint8_t (&indices)[16], const float* indexWeights, float (&outE0)[4], float (&outE1)[4])
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[4] = {}, bx[4] = {};
+			for (int i = 0; i < 16; ++i) {
+				const auto b = indexWeights[indices[i]];
+				const auto a = 1.0f - b;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (int c = 0; c < 4; ++c) {
+					ax[c] += a * block.channels[c][i];
+					bx[c] += b * block.channels[c][i];
+				}
+			}
+			const auto determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f) {
+				return false;
+			}
+			for (int c = 0; c < 4; ++c) {
+				outE0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+				outE1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+			}
+			return true;
+		}
+
+		void write_bits(uint8_t* block, uint32_t& bitPosition, const uint32_t value, const uint32_t bitCount)
+		{
+			for (uint32_t b = 0; b < bitCount; ++b, ++bitPosition) {
+				if (0 != ((value >> b) & 1u)) {
+					block[bitPosition / 8] |= static_cast<uint8_t>(1u << (bitPosition % 8));
+				}
+			}
+		}
+
+		uint32_t read_bits(const uint8_t* block, uint32_t& bitPosition, const uint32_t bitCount)
+		{
+			uint32_t value = 0;
+			for (uint32_t b = 0; b < bitCount; ++b, ++bitPosition) {
+				value |= static_cast<uint32_t>((block[bitPosition / 8] >> (bitPosition % 8)) & 1u) << b;
+			}
+			return value;
+		}
+
+		// ---------------------------------------- BC1 ----------------------------------------
+
+		uint16_t pack_rgb565(const float (&color)[4])
+		{
+			const auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+			const auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+			const auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		// The palette as a decoder computes it. If <fourColorsAlways> is not set (BC1), c0 <= c1 selects the mode
+		// with three colors plus transparent black; BC3's color blocks always use four colors.
+		void get_bc1_palette(const uint16_t c0, const uint16_t c1, const bool fourColorsAlways, block_palette& outPalette)
+		{
+			int endpoints[2][3];
+			for (int e = 0; e < 2; ++e) {
+				const auto c = 0 == e ? c0 : c1;
+				const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+				endpoints[e][0] = (r << 3) | (r >> 2);
+				endpoints[e][1] = (g << 2) | (g >> 4);
+				endpoints[e][2] = (b << 3) | (b >> 2);
+			}
+			const bool fourColors = fourColorsAlways || c0 > c1;
+			for (int c = 0; c < 3; ++c) {
+				const auto e0 = endpoints[0][c], e1 = endpoints[1][c];
+				outPalette.colors[0][c] = static_cast<float>(e0);
+				outPalette.colors[1][c] = static_cast<float>(e1);
+				outPalette.colors[2][c] = static_cast<float>(fourColors ? (2 * e0 + e1) / 3 : (e0 + e1) / 2);
+				outPalette.colors[3][c] = static_cast<float>(fourColors ? (e0 + 2 * e1) / 3 : 0);
+			}
+			for (int i = 0; i < 4; ++i) {
+				outPalette.colors[i][3] = (fourColors || i < 3) ? 255.0f : 0.0f;
+			}
+			outPalette.size = 4;
+		}
+
+		// Encode the block's colors into 8 bytes of a BC1 block (or of a BC3 block's color part), always in four-color mode
+		void encode_bc1_color_block(const texel_block& block, uint8_t* outBlock)
+		{
+			static constexpr float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+			float e0[4], e1[4];
+			find_endpoints_on_principal_axis(block, 3, e0, e1);
+
+			auto bestError = std::numeric_limits<float>::max();
+			uint16_t bestC0 = 0, bestC1 = 0;
+			uint8_t bestIndices[16] = {};
+			for (int iteration = 0; iteration < 3; ++iteration) {
+				auto c0 = pack_rgb565(e0);
+				auto c1 = pack_rgb565(e1);
+				if (c0 < c1) {
+					std::swap(c0, c1);
+				}
+
+				block_palette palette;
+				get_bc1_palette(c0, c1, false, palette);
+				if (c0 == c1) {
+					palette.size = 1;	// Only index 0 denotes the same color in both modes
+				}
+				uint8_t indices[16];
+				const auto error = find_nearest_palette_colors(block, palette, ColorWeights, indices);
+				if (error < bestError) {
+					bestError = error;
+					bestC0 = c0;
+					bestC1 = c1;
+					std::copy(std::begin(indices), std::end(indices), std::begin(bestIndices));
+				}
+				if (0.0f == error || !fit_endpoints_to_indices(block, indices, IndexWeights, e0, e1)) {
+					break;
+				}
+			}
+
+			uint32_t bitPosition = 0;
+			std::fill(outBlock, outBlock + 8, uint8_t{ 0 });
+			write_bits(outBlock, bitPosition, bestC0, 16);
+			write_bits(outBlock, bitPosition, bestC1, 16);
+			for (int i = 0; i < 16; ++i) {
+				write_bits(outBlock, bitPosition, bestIndices[i], 2);
+			}
+		}
+
+		void decode_bc1_color_block(const uint8_t* block, const bool fourColorsAlways, uint8_t (&outTexels)[16][4])
+		{
+			uint32_t bitPosition = 0;
+			const auto c0 = static_cast<uint16_t>(read_bits(block, bitPosition, 16));
+			const auto c1 = static_cast<uint16_t>(read_bits(block, bitPosition, 16));
+			block_palette palette;
+			get_bc1_palette(c0, c1, fourColorsAlways, palette);
+			for (int i = 0; i < 16; ++i) {
+				const auto index = read_bits(block, bitPosition, 2);
+				for (int c = 0; c < 4; ++c) {
+					outTexels[i][c] = static_cast<uint8_t>(palette.colors[index][c]);
+				}
+			}
+		}
+
+		// ---------------------------------------- BC4 (BC3's alpha) ----------------------------------------
+
+		void get_bc4_palette(const int a0, const int a1, block_palette& outPalette)
+		{
+			int values[8] = { a0, a1 };
+			if (a0 > a1) {
+				for (int i = 1; i <= 6; ++i) {
+					values[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+				}
+			}
+			else {
+				for (int i = 1; i <= 4; ++i) {
+					values[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+				}
+				values[6] = 0;
+				values[7] = 255;
+			}
+			for (int i = 0; i < 8; ++i) {
+				outPalette.colors[i][0] = outPalette.colors[i][1] = outPalette.colors[i][2] = 0.0f;
+				outPalette.colors[i][3] = static_cast<float>(values[i]);
+			}
+			outPalette.size = 8;
+		}
+
+		// Encode the block's alpha values into 8 bytes, in the mode with eight interpolated values
+		void encode_bc4_alpha_block(const texel_block& block, uint8_t* outBlock)
+		{
+			const auto [minAlpha, maxAlpha] = std::minmax_element(std::begin(block.channels[3]), std::end(block.channels[3]));
+			const auto a0 = static_cast<int>(*maxAlpha);
+			const auto a1 = static_cast<int>(*minAlpha);
+
+			block_palette palette;
+			get_bc4_palette(a0, a1, palette);
+			if (a0 == a1) {
+				palette.size = 1;
+			}
+			uint8_t indices[16];
+			find_nearest_palette_colors(block, palette, AlphaWeights, indices);
+
+			uint32_t bitPosition = 0;
+			std::fill(outBlock, outBlock + 8, uint8_t{ 0 });
+			write_bits(outBlock, bitPosition, static_cast<uint32_t>(a0), 8);
+			write_bits(outBlock, bitPosition, static_cast<uint32_t>(a1), 8);
+			for (int i = 0; i < 16; ++i) {
+				write_bits(outBlock, bitPosition, indices[i], 3);
+			}
+		}
+
+		void decode_bc4_alpha_block(const uint8_t* block, uint8_t (&outTexels)[16][4])
+		{
+			uint32_t bitPosition = 0;
+			const auto a0 = static_cast<int>(read_bits(block, bitPosition, 8));
+			const auto a1 = static_cast<int>(read_bits(block, bitPosition, 8));
+			block_palette palette;
+			get_bc4_palette(a0, a1, palette);
+			for (int i = 0; i < 16; ++i) {
+				outTexels[i][3] = static_cast<uint8_t>(palette.colors[read_bits(block, bitPosition, 3)][3]);
+			}
+		}
+
+		// ---------------------------------------- BC7 (mode 6) ----------------------------------------
+
+		// Mode 6 endpoints have 7 bits per channel, plus one p-bit per endpoint which becomes the 8th (lowest) bit
+		void get_bc7_mode6_palette(const int (&e0)[4], const int (&e1)[4], block_palette& outPalette)
+		{
+			for (int i = 0; i < 16; ++i) {
+				for (int c = 0; c < 4; ++c) {
+					outPalette.colors[i][c] = static_cast<float>(((64 - Bc7Weights4[i]) * e0[c] + Bc7Weights4[i] * e1[c] + 32) >> 6);
+				}
+			}
+			outPalette.size = 16;
+		}
+
+		void quantize_bc7_mode6_endpoint(const float (&color)[4], const int pBit, int (&outQuantized)[4], int (&outValue)[4])
+		{
+			for (int c = 0; c < 4; ++c) {
+				outQuantized[c] = std::clamp(static_cast<int>(std::lround((color[c] - static_cast<float>(pBit)) * 0.5f)), 0, 127);
+				outValue[c] = (outQuantized[c] << 1) | pBit;
+			}
+		}
+
+		void encode_bc7_mode6_block(const texel_block& block, uint8_t* outBlock)
+		{
+			float indexWeights[16];
+			for (int i = 0; i < 16; ++i) {
+				indexWeights[i] = static_cast<float>(Bc7Weights4[i]) / 64.0f;
+			}
+
+			float e0[4], e1[4];
+			find_endpoints_on_principal_axis(block, 4, e0, e1);
+
+			auto bestError = std::numeric_limits<float>::max();
+			int bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+			uint8_t bestIndices[16] = {};
+			for (int iteration = 0; iteration < 3; ++iteration) {
+				// Try all p-bit combinations for the current endpoints:
+				auto iterationError = std::numeric_limits<float>::max();
+				uint8_t iterationIndices[16] = {};
+				for (int p0 = 0; p0 < 2; ++p0) {
+					for (int p1 = 0; p1 < 2; ++p1) {
+						int q0[4], q1[4], v0[4], v1[4];
+						quantize_bc7_mode6_endpoint(e0, p0, q0, v0);
+						quantize_bc7_mode6_endpoint(e1, p1, q1, v1);
+						block_palette palette;
+						get_bc7_mode6_palette(v0, v1, palette);
+						uint8_t indices[16];
+						const auto error = find_nearest_palette_colors(block, palette, RgbaWeights, indices);
+						if (error < iterationError) {
+							iterationError = error;
+							std::copy(std::begin(indices), std::end(indices), std::begin(iterationIndices));
+						}
+						if (error < bestError) {
+							bestError = error;
+							std::copy(std::begin(q0), std::end(q0), std::begin(bestQ0));
+							std::copy(std::begin(q1), std::end(q1), std::begin(bestQ1));
+							bestP0 = p0;
+							bestP1 = p1;
+							std::copy(std::begin(indices), std::end(indices), std::begin(bestIndices));
+						}
+					}
+				}
+				if (0.0f == iterationError || !fit_endpoints_to_indices(block, iterationIndices, indexWeights, e0, e1)) {
+					break;
+				}
+			}
+
+			// The first texel's index is stored with 3 bits only, i.e. its highest bit must be zero => swap the endpoints if it isn't:
+			if (0 != (bestIndices[0] & 8)) {
+				std::swap(bestQ0, bestQ1);
+				std::swap(bestP0, bestP1);
+				for (auto& index : bestIndices) {
+					index = static_cast<uint8_t>(15 - index);
+				}
+			}
+
+			uint32_t bitPosition = 0;
+			std::fill(outBlock, outBlock + 16, uint8_t{ 0 });
+			write_bits(outBlock, bitPosition, 1u << 6, 7);	// Mode 6
+			for (int c = 0; c < 4; ++c) {
+				write_bits(outBlock, bitPosition, static_cast<uint32_t>(bestQ0[c]), 7);
+				write_bits(outBlock, bitPosition, static_cast<uint32_t>(bestQ1[c]), 7);
+			}
+			write_bits(outBlock, bitPosition, static_cast<uint32_t>(bestP0), 1);
+			write_bits(outBlock, bitPosition, static_cast<uint32_t>(bestP1), 1);
+			for (int i = 0; i < 16; ++i) {
+				write_bits(outBlock, bitPosition, bestIndices[i], 0 == i ? 3 : 4);
+			}
+		}
+
+		void decode_bc7_block(const uint8_t* block, uint8_t (&outTexels)[16][4])
+		{
+			if (0x40 != (block[0] & 0x7F)) {
+				int mode = 0;
+				while (mode < 8 && 0 == (block[0] & (1 << mode))) {
+					++mode;
+				}
+				throw std::runtime_error("BC7 mode " + std::to_string(mode) + " blocks can't be decoded on the CPU; only mode 6 is supported.");
+			}
+
+			uint32_t bitPosition = 7;
+			int q[2][4];
+			for (int c = 0; c < 4; ++c) {
+				q[0][c] = static_cast<int>(read_bits(block, bitPosition, 7));
+				q[1][c] = static_cast<int>(read_bits(block, bitPosition, 7));
+			}
+			const auto p0 = static_cast<int>(read_bits(block, bitPosition, 1));
+			const auto p1 = static_cast<int>(read_bits(block, bitPosition, 1));
+			int v0[4], v1[4];
+			for (int c = 0; c < 4; ++c) {
+				v0[c] = (q[0][c] << 1) | p0;
+				v1[c] = (q[1][c] << 1) | p1;
+			}
+			block_palette palette;
+			get_bc7_mode6_palette(v0, v1, palette);
+			for (int i = 0; i < 16; ++i) {
+				const auto index = read_bits(block, bitPosition, 0 == i ? 3 : 4);
+				for (int c = 0; c < 4; ++c) {
+					outTexels[i][c] = static_cast<uint8_t>(palette.colors[index][c]);
+				}
+			}
+		}
+
+		// One row of a 2x2 box-filtered mip level: averages rows <src0> and <src1> (which may be the same row) of the source level.
+		// Source columns beyond <srcWidth> are clamped, which only happens if the source level is one texel wide.
+		void downsample_row_rgba8(const uint8_t* src0, const uint8_t* src1, const uint32_t srcWidth, uint8_t* dst, const uint32_t dstWidth)
+		{
+			uint32_t x = 0;
+#if defined(_M_X64) || defined(__SSE2__)
+			// Two destination texels from four source texels of each row at a time:
+			if (srcWidth > 1) {
+				const auto zero = _mm_setzero_si128();
+				const auto rounding = _mm_set1_epi16(2);
+				for (; x + 2 <= dstWidth; x += 2) {
+					const auto row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 8));
+					const auto row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 8));
+					// Vertical sums of texels 0,1 and of texels 2,3 with 16 bits per channel:
+					const auto sum01 = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+					const auto sum23 = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+					// ...plus the horizontal neighbor, which is in the upper 64 bits:
+					const auto sums = _mm_unpacklo_epi64(
+						_mm_add_epi16(sum01, _mm_srli_si128(sum01, 8)),
+						_mm_add_epi16(sum23, _mm_srli_si128(sum23, 8))
+					);
+					const auto averages = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(averages, zero));
+				}
+			}
+#endif
+			for (; x < dstWidth; ++x) {
+				const size_t x0 = std::min(2 * x, srcWidth - 1), x1 = std::min(2 * x + 1, srcWidth - 1);
+				for (size_t c = 0; c < 4; ++c) {
+					const auto sum = src0[x0 * 4 + c] + src0[x1 * 4 + c] + src1[x0 * 4 + c] + src1[x1 * 4 + c];
+					dst[static_cast<size_t>(x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	std::string to_string(const texture_encoding encoding)
+	{
+		switch (encoding) {
+		case texture_encoding::rgba8: return "rgba8";
+		case texture_encoding::bc1:   return "bc1";
+		case texture_encoding::bc3:   return "bc3";
+		case texture_encoding::bc7:   return "bc7";
+		}
+		return "unknown";
+	}
+
+	texture_encoding parse_texture_encoding(const std::string& name)
+	{
+		for (const auto encoding : { texture_encoding::rgba8, texture_encoding::bc1, texture_encoding::bc3, texture_encoding::bc7 }) {
+			if (to_string(encoding) == name) {
+				return encoding;
+			}
+		}
+		throw std::runtime_error("Unknown texture encoding '" + name + "'");
+	}
+
+	vk::Format get_vk_format(const texture_encoding encoding)
+	{
+		switch (encoding) {
+		case texture_encoding::bc1: return vk::Format::eBc1RgbUnormBlock;
+		case texture_encoding::bc3: return vk::Format::eBc3UnormBlock;
+		case texture_encoding::bc7: return vk::Format::eBc7UnormBlock;
+		default:                    return vk::Format::eR8G8B8A8Unorm;
+		}
+	}
+
+	uint32_t get_block_extent(const texture_encoding encoding)
+	{
+		return texture_encoding::rgba8 == encoding ? 1u : 4u;
+	}
+
+	uint32_t get_bytes_per_block(const texture_encoding encoding)
+	{
+		return texture_encoding::bc1 == encoding ? 8u : texture_encoding::rgba8 == encoding ? 4u : 16u;
+	}
+
+	size_t get_encoded_size(const texture_encoding encoding, const uint32_t width, const uint32_t height)
+	{
+		const auto blockExtent = get_block_extent(encoding);
+		const auto blocksWide = static_cast<size_t>((width + blockExtent - 1) / blockExtent);
+		const auto blocksHigh = static_cast<size_t>((height + blockExtent - 1) / blockExtent);
+		return blocksWide * blocksHigh * get_bytes_per_block(encoding);
+	}
+
+	std::vector<uint8_t> encode_texels(
+		const uint8_t* rgba, const uint32_t width, const uint32_t height,
+		const texture_encoding encoding,
+		thread_pool& threadPool)
+	{
+		if (texture_encoding::rgba8 == encoding) {
+			return std::vector<uint8_t>(rgba, rgba + static_cast<size_t>(width) * height * 4);
+		}
+
+		std::vector<uint8_t> result(get_encoded_size(encoding, width, height));
+		const auto blocksWide = (width + 3) / 4;
+		const auto blocksHigh = (height + 3) / 4;
+		const auto bytesPerBlock = get_bytes_per_block(encoding);
+
+		// One job per row of blocks:
+		threadPool.parallel_for(blocksHigh, [&](const size_t blockY) {
+			texel_block block;
+			for (uint32_t blockX = 0; blockX < blocksWide; ++blockX) {
+				load_block(rgba, width, height, blockX, static_cast<uint32_t>(blockY), block);
+				auto out = result.data() + (blockY * blocksWide + blockX) * bytesPerBlock;
+				switch (encoding) {
+				case texture_encoding::bc1:
+					encode_bc1_color_block(block, out);
+					break;
+				case texture_encoding::bc3:
+					encode_bc4_alpha_block(block, out);
+					encode_bc1_color_block(block, out + 8);
+					break;
+				default:
+					encode_bc7_mode6_block(block, out);
+					break;
+				}
+			}
+		});
+		return result;
+	}
+
+	std::vector<uint8_t> decode_texels(
+		const uint8_t* data, const uint32_t width, const uint32_t height,
+		const texture_encoding encoding,
+		thread_pool& threadPool)
+	{
+		if (texture_encoding::rgba8 == encoding) {
+			return std::vector<uint8_t>(data, data + static_cast<size_t>(width) * height * 4);
+		}
+
+		std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4);
+		const auto blocksWide = (width + 3) / 4;
+		const auto blocksHigh = (height + 3) / 4;
+		const auto bytesPerBlock = get_bytes_per_block(encoding);
+
+		threadPool.parallel_for(blocksHigh, [&](const size_t blockY) {
+			uint8_t texels[16][4];
+			for (uint32_t blockX = 0; blockX < blocksWide; ++blockX) {
+				const auto in = data + (blockY * blocksWide + blockX) * bytesPerBlock;
+				switch (encoding) {
+				case texture_encoding::bc1:
+					decode_bc1_color_block(in, false, texels);
+					break;
+				case texture_encoding::bc3:
+					decode_bc1_color_block(in + 8, true, texels);
+					decode_bc4_alpha_block(in, texels);
+					break;
+				default:
+					decode_bc7_block(in, texels);
+					break;
+				}
+				store_block(texels, result.data(), width, height, blockX, static_cast<uint32_t>(blockY));
+			}
+		});
+		return result;
+	}
+
+	uint32_t get_mip_level_count(const uint32_t width, const uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (auto size = std::max(width, height); size > 1; size /= 2) {
+			++levels;
+		}
+		return levels;
+	}
+
+	std::vector<std::vector<uint8_t>> generate_mip_chain_rgba8(const uint8_t* rgba, const uint32_t width, const uint32_t height, thread_pool& threadPool)
+	{
+		std::vector<std::vector<uint8_t>> levels;
+		levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+		auto srcWidth = width, srcHeight = height;
+		while (srcWidth > 1 || srcHeight > 1) {
+			const auto dstWidth = std::max(1u, srcWidth / 2);
+			const auto dstHeight = std::max(1u, srcHeight / 2);
+			const auto& src = levels.back();
+			std::vector<uint8_t> dst(static_cast<size_t>(dstWidth) * dstHeight * 4);
+			threadPool.parallel_for(dstHeight, [&](const size_t y) {
+				const size_t y0 = std::min<size_t>(2 * y, srcHeight - 1), y1 = std::min<size_t>(2 * y + 1, srcHeight - 1);
+				downsample_row_rgba8(src.data() + y0 * srcWidth * 4, src.data() + y1 * srcWidth * 4, srcWidth,
+					dst.data() + y * dstWidth * 4, dstWidth);
+			});
+			levels.push_back(std::move(dst));
+			srcWidth = dstWidth;
+			srcHeight = dstHeight;
+		}
+		return levels;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace helpers
+{
+	// How the texels of a texture are stored on the GPU
+	enum struct texture_encoding : uint32_t
+	{
+		rgba8 = 0,	// R8G8B8A8_UNORM, 4 bytes per texel, not compressed
+		bc1 = 1,	// BC1_RGB_UNORM_BLOCK, 8 bytes per 4x4 block. Opaque: alpha is ignored.
+		bc3 = 2,	// BC3_UNORM_BLOCK, 16 bytes per 4x4 block: a BC1 color block plus a BC4 alpha block
+		bc7 = 3		// BC7_UNORM_BLOCK, 16 bytes per 4x4 block. The encoder writes mode 6 blocks (one subset, RGBA endpoints).
+	};
+
+	// Human readable name, e.g. "bc7"
+	std::string to_string(const texture_encoding encoding);
+
+	// Parse a name as returned by to_string; throws if it is unknown
+	texture_encoding parse_texture_encoding(const std::string& name);
+
+	// The Vulkan format which stores texels in the given encoding
+	vk::Format get_vk_format(const texture_encoding encoding);
+
+	// Width and height of one block, in texels (1 for uncompressed encodings)
+	uint32_t get_block_extent(const texture_encoding encoding);
+
+	// Size of one block, in bytes
+	uint32_t get_bytes_per_block(const texture_encoding encoding);
+
+	// Size of a whole image of the given dimensions, in bytes
+	size_t get_encoded_size(const texture_encoding encoding, const uint32_t width, const uint32_t height);
+
+	// Encode tightly packed RGBA8 texels into the given encoding. Blocks at the right and bottom borders of
+	// images whose dimensions are not multiples of four are padded by repeating the last column and row.
+	// The blocks are encoded in parallel on the given thread pool (SSE2-accelerated, if available).
+	std::vector<uint8_t> encode_texels(
+		const uint8_t* rgba, const uint32_t width, const uint32_t height,
+		const texture_encoding encoding,
+		thread_pool& threadPool = get_thread_pool()
+	);
+
+	// Decode encoded texels back into tightly packed RGBA8 texels, e.g. if the device doesn't support a block-compressed
+	// format. BC1 and BC3 blocks are decoded completely; of BC7, only mode 6 blocks are supported (see encode_texels).
+	std::vector<uint8_t> decode_texels(
+		const uint8_t* data, const uint32_t width, const uint32_t height,
+		const texture_encoding encoding,
+		thread_pool& threadPool = get_thread_pool()
+	);
+
+	// Number of levels of a full mip chain for the given dimensions, down to 1x1
+	uint32_t get_mip_level_count(const uint32_t width, const uint32_t height);
+
+	// Generate the full mip chain of an RGBA8 image with a 2x2 box filter. Element 0 is a copy of the given image.
+	// The rows of each level are filtered in parallel on the given thread pool (SSE2-accelerated, if available).
+	std::vector<std::vector<uint8_t>> generate_mip_chain_rgba8(
+		const uint8_t* rgba, const uint32_t width, const uint32_t height,
+		thread_pool& threadPool = get_thread_pool()
+	);
+}
@@ -0,0 +1,263 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		constexpr char TextureFileMagic[8] = { 'V', 'K', 'W', 'T', 'E', 'X', '\0', '\0' };
+		constexpr uint64_t LevelAlignment = 16;
+
+		static_assert(std::is_standard_layout<texture_file_header>::value, "texture_file_header must be written to disk as is");
+		static_assert(sizeof(texture_file_header) == 32, "Unexpected padding in texture_file_header");
+		static_assert(sizeof(texture_file_level) == 16, "Unexpected padding in texture_file_level");
+
+		uint64_t align_up(const uint64_t value, const uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		uint32_t get_level_dimension(const uint32_t size, const uint32_t level)
+		{
+			return std::max(1u, size >> level);
+		}
+	}
+
+	std::string get_texture_file_path(const std::string& imagePath)
+	{
+		return std::filesystem::path(imagePath).replace_extension(".vktex").string();
+	}
+
+	void bake_texture_file(
+		const std::string& imagePath,
+		const std::string& texturePath,
+		const texture_bake_options& options,
+		thread_pool& threadPool)
+	{
+		int width, height, channelsInFile;
+		stbi_uc* pixels = stbi_load(imagePath.c_str(), &width, &height, &channelsInFile, STBI_rgb_alpha);
+		if (nullptr == pixels) {
+			throw std::runtime_error("Couldn't load image from '" + imagePath + "'");
+		}
+		auto sourceLevels = options.mipmaps
+			? helpers::generate_mip_chain_rgba8(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), threadPool)
+			: std::vector<std::vector<uint8_t>>{ std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * STBI_rgb_alpha) };
+		stbi_image_free(pixels);
+
+		texture_file_header header{};
+		std::copy(std::begin(TextureFileMagic), std::end(TextureFileMagic), std::begin(header.magic));
+		header.version = texture_file_header::CurrentVersion;
+		header.vkFormat = static_cast<int32_t>(helpers::get_vk_format(options.encoding));
+		header.encoding = static_cast<uint32_t>(options.encoding);
+		header.width = static_cast<uint32_t>(width);
+		header.height = static_cast<uint32_t>(height);
+		header.levelCount = static_cast<uint32_t>(sourceLevels.size());
+
+		// Each level's blocks are encoded in parallel:
+		std::vector<std::vector<uint8_t>> encodedLevels;
+		std::vector<texture_file_level> levelIndex;
+		auto offset = align_up(sizeof(texture_file_header) + sizeof(texture_file_level) * sourceLevels.size(), LevelAlignment);
+		for (uint32_t level = 0; level < header.levelCount; ++level) {
+			encodedLevels.push_back(helpers::encode_texels(sourceLevels[level].data(),
+				get_level_dimension(header.width, level), get_level_dimension(header.height, level), options.encoding, threadPool));
+			levelIndex.push_back(texture_file_level{ offset, encodedLevels.back().size() });
+			offset = align_up(offset + encodedLevels.back().size(), LevelAlignment);
+		}
+
+		// Write to a temporary file first, s.t. a crash never leaves a half-written file behind:
+		const auto tempPath = texturePath + ".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open()) {
+				throw std::runtime_error("Couldn't open '" + tempPath + "' for writing");
+			}
+			auto write_at = [&stream](const uint64_t offset, const void* data, const size_t size) {
+				static const char Zeros[LevelAlignment] = {};
+				const auto position = static_cast<uint64_t>(stream.tellp());
+				stream.write(Zeros, static_cast<std::streamsize>(offset - position));
+				stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			};
+			write_at(0, &header, sizeof(header));
+			write_at(sizeof(header), levelIndex.data(), sizeof(texture_file_level) * levelIndex.size());
+			for (uint32_t level = 0; level < header.levelCount; ++level) {
+				write_at(levelIndex[level].byteOffset, encodedLevels[level].data(), encodedLevels[level].size());
+			}
+			if (!stream.good()) {
+				throw std::runtime_error("Couldn't write '" + tempPath + "'");
+			}
+		}
+		std::filesystem::rename(tempPath, texturePath);
+	}
+
+	bool try_map_texture_file(
+		const std::string& texturePath,
+		mapped_texture_file& outTexture)
+	{
+		if (!std::filesystem::exists(texturePath)) {
+			return false;
+		}
+
+		mapped_texture_file texture;
+		try {
+			texture.file = mapped_file(texturePath);
+		}
+		catch (const std::runtime_error&) {
+			return false;
+		}
+
+		// Validate the header:
+		if (texture.file.size() < sizeof(texture_file_header)) {
+			return false;
+		}
+		const auto& header = *reinterpret_cast<const texture_file_header*>(texture.file.data());
+		if (!std::equal(std::begin(TextureFileMagic), std::end(TextureFileMagic), std::begin(header.magic))
+			|| header.version != texture_file_header::CurrentVersion
+			|| header.encoding > static_cast<uint32_t>(texture_encoding::bc7)
+			|| header.vkFormat != static_cast<int32_t>(helpers::get_vk_format(static_cast<texture_encoding>(header.encoding)))
+			|| 0 == header.width || 0 == header.height
+			|| 0 == header.levelCount || header.levelCount > helpers::get_mip_level_count(header.width, header.height)) {
+			return false;
+		}
+
+		// ...and the level index:
+		const auto fileSize = static_cast<uint64_t>(texture.file.size());
+		if (sizeof(texture_file_header) + sizeof(texture_file_level) * header.levelCount > fileSize) {
+			return false;
+		}
+		const auto levels = reinterpret_cast<const texture_file_level*>(texture.file.data() + sizeof(texture_file_header));
+		for (uint32_t level = 0; level < header.levelCount; ++level) {
+			const auto expectedLength = helpers::get_encoded_size(static_cast<texture_encoding>(header.encoding),
+				get_level_dimension(header.width, level), get_level_dimension(header.height, level));
+			if (0 != levels[level].byteOffset % LevelAlignment || levels[level].byteLength != expectedLength
+				|| levels[level].byteOffset > fileSize || levels[level].byteLength > fileSize - levels[level].byteOffset) {
+				return false;
+			}
+		}
+
+		texture.header = &header;
+		texture.levels = levels;
+		outTexture = std::move(texture);
+		return true;
+	}
+
+	bool is_texture_format_supported(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Format format)
+	{
+		const auto properties = physicalDevice.getFormatProperties(format);
+		return static_cast<bool>(properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+	}
+
+	device_texture upload_texture_file(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const mapped_texture_file& texture,
+		const vk::ImageUsageFlags usageFlags)
+	{
+		const auto& header = *texture.header;
+		const auto encoding = static_cast<texture_encoding>(header.encoding);
+
+		device_texture result;
+		result.format = static_cast<vk::Format>(header.vkFormat);
+		result.width = header.width;
+		result.height = header.height;
+		result.mipLevels = header.levelCount;
+
+		// Without support for the block-compressed format, there's no way around decoding:
+		const bool decode = !helpers::is_texture_format_supported(physicalDevice, result.format);
+		if (decode) {
+			result.format = vk::Format::eR8G8B8A8Unorm;
+		}
+
+		std::tie(result.image, result.memory) = helpers::create_image(device, physicalDevice,
+			result.width, result.height, result.format, usageFlags | vk::ImageUsageFlagBits::eTransferDst,
+			result.mipLevels
+		);
+
+		for (uint32_t level = 0; level < header.levelCount; ++level) {
+			const auto levelWidth = get_level_dimension(header.width, level);
+			const auto levelHeight = get_level_dimension(header.height, level);
+			const auto blocks = texture.file.data() + texture.levels[level].byteOffset;
+			if (decode) {
+				const auto texels = helpers::decode_texels(blocks, levelWidth, levelHeight, encoding);
+				uploadEngine.enqueue_image_level_upload(texels.data(), texels.size(), result.image, level, 0u,
+					levelWidth, levelHeight, 1u, 4u,
+					vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+				);
+			}
+			else {
+				uploadEngine.enqueue_image_level_upload(blocks, static_cast<size_t>(texture.levels[level].byteLength), result.image, level, 0u,
+					levelWidth, levelHeight, helpers::get_block_extent(encoding), helpers::get_bytes_per_block(encoding),
+					vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead
+				);
+			}
+		}
+		return result;
+	}
+
+	device_texture load_texture(
+		const std::string& imagePath,
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const vk::ImageUsageFlags usageFlags)
+	{
+		const auto texturePath = helpers::get_texture_file_path(imagePath);
+
+		mapped_texture_file texture;
+		const bool isUpToDate = std::filesystem::exists(texturePath)
+			&& (!std::filesystem::exists(imagePath) || std::filesystem::last_write_time(texturePath) >= std::filesystem::last_write_time(imagePath));
+		if (isUpToDate && helpers::try_map_texture_file(texturePath, texture)) {
+			// The upload engine copies the blocks into its staging memory right away => the mapping can go afterwards
+			return helpers::upload_texture_file(device, physicalDevice, uploadEngine, texture, usageFlags);
+		}
+
+		// Fallback: decode the image
+		device_texture result;
+		int width, height;
+		std::tie(result.image, result.memory, width, height, std::ignore) = helpers::load_image_into_device_local_image(
+			physicalDevice, device, uploadEngine, imagePath, usageFlags
+		);
+		result.width = static_cast<uint32_t>(width);
+		result.height = static_cast<uint32_t>(height);
+		result.mipLevels = helpers::get_mip_level_count(result.width, result.height);
+		return result;
+	}
+
+	vk::ImageView create_texture_view(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		const device_texture& texture)
+	{
+		return helpers::create_image_view(device, physicalDevice, texture.image, texture.format, vk::ImageAspectFlagBits::eColor, texture.mipLevels);
+	}
+
+	vk::Sampler create_texture_sampler(
+		const vk::Device device,
+		const uint32_t mipLevels,
+		const vk::SamplerAddressMode addressMode)
+	{
+		// Without maxLod > 0, only level 0 would ever be sampled, no matter how many levels the view covers:
+		return device.createSampler(vk::SamplerCreateInfo{}
+			.setMagFilter(vk::Filter::eLinear)
+			.setMinFilter(vk::Filter::eLinear)
+			.setMipmapMode(vk::SamplerMipmapMode::eLinear)
+			.setAddressModeU(addressMode)
+			.setAddressModeV(addressMode)
+			.setAddressModeW(addressMode)
+			.setMinLod(0.0f)
+			.setMaxLod(static_cast<float>(mipLevels))
+		);
+	}
+
+	void destroy_device_texture(
+		const vk::Device device,
+		device_texture& texture)
+	{
+		if (texture.image) {
+			helpers::destroy_image(device, texture.image);
+			helpers::free_memory(device, texture.memory);
+		}
+		texture = device_texture{};
+	}
+}
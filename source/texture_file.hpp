@@ -0,0 +1,121 @@
+#pragma once
+
+namespace helpers
+{
+	// Binary, pre-baked texture format (*.vktex), modelled after KTX2: the header is followed by the level index
+	// (one texture_file_level per mip level, level 0 first), which is followed by the levels' texel blocks.
+	// The blocks are stored exactly as vkCmdCopyBufferToImage expects them for an image of format <vkFormat>.
+	// All values are little endian, and every level starts at a 16-byte aligned offset.
+	struct texture_file_header
+	{
+		static constexpr uint32_t CurrentVersion = 1u;
+
+		char magic[8];						// "VKWTEX\0\0"
+		uint32_t version;
+		int32_t vkFormat;					// VkFormat of the texel blocks
+		uint32_t encoding;					// texture_encoding of the texel blocks (tells how to decode them on the CPU)
+		uint32_t width;						// Dimensions of mip level 0, in texels
+		uint32_t height;
+		uint32_t levelCount;
+	};
+
+	struct texture_file_level
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+	};
+
+	// A memory-mapped *.vktex file. The level index and the texel blocks point directly into the file mapping.
+	struct mapped_texture_file
+	{
+		mapped_file file;
+		const texture_file_header* header = nullptr;
+		const texture_file_level* levels = nullptr;
+	};
+
+	// A texture which lives in a device-local image
+	struct device_texture
+	{
+		vk::Image image;
+		memory_allocation memory;
+		vk::Format format = vk::Format::eR8G8B8A8Unorm;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipLevels = 1;
+	};
+
+	// Options of the offline texture bake step
+	struct texture_bake_options
+	{
+		texture_encoding encoding = texture_encoding::bc7;
+		bool mipmaps = true;	// Store a full mip chain, or only level 0
+	};
+
+	// Returns the path of the baked texture which belongs to the given image ("images/x.png" => "images/x.vktex")
+	std::string get_texture_file_path(const std::string& imagePath);
+
+	// Offline bake step: load the given image (any format that stb_image supports), optionally generate its mip chain,
+	// encode all levels, and write them into a *.vktex file. The file is written to a temporary file first, and then renamed.
+	void bake_texture_file(
+		const std::string& imagePath,
+		const std::string& texturePath,
+		const texture_bake_options& options = texture_bake_options{},
+		thread_pool& threadPool = get_thread_pool()
+	);
+
+	// Memory-map a *.vktex file and validate its header and level index. Returns false if it is missing or invalid.
+	bool try_map_texture_file(
+		const std::string& texturePath,
+		mapped_texture_file& outTexture
+	);
+
+	// Can images of the given format be sampled from, if created with optimal tiling?
+	bool is_texture_format_supported(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Format format
+	);
+
+	// Create a device-local image with all of the file's mip levels, and enqueue copying the texel blocks straight from
+	// the file mapping into the upload engine's staging memory (not submitted). If the device doesn't support the
+	// file's block-compressed format, the levels are decoded on the CPU and uploaded as eR8G8B8A8Unorm instead.
+	// After the upload, all levels are in eShaderReadOnlyOptimal layout.
+	device_texture upload_texture_file(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const mapped_texture_file& texture,
+		const vk::ImageUsageFlags usageFlags = vk::ImageUsageFlagBits::eSampled
+	);
+
+	// Load a texture from its baked *.vktex file (see get_texture_file_path) if there is one which is not older than
+	// the image; otherwise, fall back to decoding the image (see load_image_into_device_local_image), and generating its mip chain.
+	// The uploads are enqueued into the upload engine, but not submitted.
+	device_texture load_texture(
+		const std::string& imagePath,
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		upload_engine& uploadEngine,
+		const vk::ImageUsageFlags usageFlags = vk::ImageUsageFlagBits::eSampled
+	);
+
+	// Create an image view which covers all mip levels of the texture
+	vk::ImageView create_texture_view(
+		const vk::Device device,
+		const vk::PhysicalDevice physicalDevice,
+		const device_texture& texture
+	);
+
+	// Create a trilinear sampler which can access all mip levels of a texture with <mipLevels> levels.
+	// Destroy it with vk::Device::destroySampler.
+	vk::Sampler create_texture_sampler(
+		const vk::Device device,
+		const uint32_t mipLevels,
+		const vk::SamplerAddressMode addressMode = vk::SamplerAddressMode::eRepeat
+	);
+
+	// Destroy the image of a texture that has been created with upload_texture_file or load_texture, and free its memory
+	void destroy_device_texture(
+		const vk::Device device,
+		device_texture& texture
+	);
+}
@@ -0,0 +1,111 @@
+#include "pch.h"
+
+namespace helpers
+{
+	thread_pool::thread_pool(const uint32_t threadCount)
+	{
+		const auto count = std::max(1u, threadCount);
+		mThreads.reserve(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			mThreads.emplace_back([this]() { worker_loop(); });
+		}
+	}
+
+	thread_pool::~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mJobAvailable.notify_all();
+		for (auto& thread : mThreads) {
+			thread.join();
+		}
+	}
+
+	std::future<void> thread_pool::enqueue(std::function<void()> job)
+	{
+		std::packaged_task<void()> task(std::move(job));
+		auto future = task.get_future();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mJobs.push_back(std::move(task));
+		}
+		mJobAvailable.notify_one();
+		return future;
+	}
+
+	void thread_pool::parallel_for(const size_t count, const std::function<void(size_t)>& job)
+	{
+		if (0 == count) {
+			return;
+		}
+
+		// Shared with the helper jobs, because helpers which start late (e.g. when all workers are busy in
+		// nested parallel_for calls) may only run after this call has returned. They find no work left then.
+		struct parallel_for_state
+		{
+			std::atomic<size_t> nextIndex{ 0 };
+			size_t completedCount = 0;
+			std::exception_ptr firstException;
+			std::mutex mutex;
+			std::condition_variable allCompleted;
+		};
+		auto state = std::make_shared<parallel_for_state>();
+
+		// Every participant grabs indices until there are none left:
+		auto work = [state, count, &job]() {
+			for (auto i = state->nextIndex.fetch_add(1); i < count; i = state->nextIndex.fetch_add(1)) {
+				std::exception_ptr exception;
+				try {
+					job(i);
+				}
+				catch (...) {
+					exception = std::current_exception();
+				}
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (exception && !state->firstException) {
+					state->firstException = exception;
+				}
+				if (++state->completedCount == count) {
+					state->allCompleted.notify_all();
+				}
+			}
+		};
+
+		const auto helperCount = std::min(count - 1, mThreads.size());
+		for (size_t i = 0; i < helperCount; ++i) {
+			enqueue(work);
+		}
+		work();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->allCompleted.wait(lock, [&state, count]() { return state->completedCount == count; });
+		if (state->firstException) {
+			std::rethrow_exception(state->firstException);
+		}
+	}
+
+	void thread_pool::worker_loop()
+	{
+		for (;;) {
+			std::packaged_task<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mJobAvailable.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+				if (mJobs.empty()) {
+					return; // => stopping, and all jobs have been finished
+				}
+				task = std::move(mJobs.front());
+				mJobs.pop_front();
+			}
+			task();
+		}
+	}
+
+	thread_pool& get_thread_pool()
+	{
+		static thread_pool sThreadPool;
+		return sThreadPool;
+	}
+}
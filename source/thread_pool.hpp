@@ -0,0 +1,39 @@
+#pragma once
+
+namespace helpers
+{
+	// A fixed set of worker threads which execute jobs from a shared FIFO queue.
+	// Used for CPU-heavy asset processing (parsing, decoding, encoding) and for parallel command recording.
+	class thread_pool
+	{
+	public:
+		// Start <threadCount> worker threads (at least one)
+		explicit thread_pool(const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()));
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+		// Finishes all enqueued jobs, then joins the worker threads
+		~thread_pool();
+
+		// Enqueue a job. Exceptions thrown by the job are rethrown by the returned future's get().
+		std::future<void> enqueue(std::function<void()> job);
+
+		// Invoke job(i) for every i in [0, count) and block until all of them have completed.
+		// The calling thread works on the jobs as well, therefore it is safe to call parallel_for
+		// from within a job. If jobs throw, the first exception is rethrown after all jobs have finished.
+		void parallel_for(const size_t count, const std::function<void(size_t)>& job);
+
+		uint32_t thread_count() const { return static_cast<uint32_t>(mThreads.size()); }
+
+	private:
+		void worker_loop();
+
+		std::vector<std::thread> mThreads;
+		std::deque<std::packaged_task<void()>> mJobs;
+		std::mutex mMutex;
+		std::condition_variable mJobAvailable;
+		bool mStopping = false;
+	};
+
+	// The process-wide thread pool with one thread per hardware thread, created on first use
+	thread_pool& get_thread_pool();
+}
@@ -0,0 +1,71 @@
+#include "pch.h"
+
+namespace helpers
+{
+	vk::PushConstantRange get_draw_push_constant_range()
+	{
+		return vk::PushConstantRange{ vk::ShaderStageFlagBits::eVertex, 0u, sizeof(draw_push_constants) };
+	}
+
+	void push_draw_constants(const vk::CommandBuffer commandBuffer, const vk::PipelineLayout pipelineLayout, const draw_push_constants& constants)
+	{
+		commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0u, sizeof(constants), &constants);
+	}
+
+	uniform_ring::uniform_ring(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const uint32_t framesInFlight,
+		const vk::DeviceSize bytesPerFrame)
+		: mDevice{ device }
+		, mAlignment{ std::max(vk::DeviceSize{ 1 }, physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment) }
+		, mBytesPerFrame{ (bytesPerFrame + mAlignment - 1) / mAlignment * mAlignment }
+		, mFramesInFlight{ framesInFlight }
+	{
+		if (0 == framesInFlight) {
+			throw std::invalid_argument("There must be at least one frame in flight.");
+		}
+		// Host coherent allocations are persistently mapped by the memory arena => no flushes, no map/unmap:
+		std::tie(mBuffer, mMemory) = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice,
+			static_cast<size_t>(mBytesPerFrame * framesInFlight), vk::BufferUsageFlagBits::eUniformBuffer, memory_category::uniform
+		);
+		if (nullptr == mMemory.mappedData) {
+			throw std::runtime_error("The uniform ring's memory is not mapped");
+		}
+	}
+
+	uniform_ring::~uniform_ring()
+	{
+		helpers::destroy_buffer(mDevice, mBuffer);
+		helpers::free_memory(mDevice, mMemory);
+	}
+
+	void uniform_ring::begin_frame()
+	{
+		mCurrentSlot = static_cast<size_t>(mFrameNumber % mFramesInFlight);
+		mFrameOffset = 0;
+		++mFrameNumber;
+	}
+
+	uniform_allocation uniform_ring::allocate(const vk::DeviceSize size)
+	{
+		const auto alignedSize = (size + mAlignment - 1) / mAlignment * mAlignment;
+		if (mFrameOffset + alignedSize > mBytesPerFrame) {
+			throw std::runtime_error("The uniform ring is full: " + std::to_string(mFrameOffset) + " of " + std::to_string(mBytesPerFrame)
+				+ " bytes have been allocated this frame, " + std::to_string(size) + " more have been requested");
+		}
+		const auto offset = mBytesPerFrame * mCurrentSlot + mFrameOffset;
+		mFrameOffset += alignedSize;
+
+		++mStatistics.allocations;
+		mStatistics.bytesAllocated += alignedSize;
+		mStatistics.peakBytesPerFrame = std::max(mStatistics.peakBytesPerFrame, mFrameOffset);
+		return uniform_allocation{ static_cast<uint8_t*>(mMemory.mappedData) + offset, static_cast<uint32_t>(offset), size };
+	}
+
+	void uniform_ring::print_statistics(std::ostream& stream) const
+	{
+		stream << "Uniform ring: " << mFramesInFlight << " x " << mBytesPerFrame << " bytes (alignment " << mAlignment << "), "
+			<< mStatistics.allocations << " allocations, peak " << mStatistics.peakBytesPerFrame << " bytes per frame" << std::endl;
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+namespace helpers
+{
+	// The per-frame uniforms of vertex_shader_push_constants.vert (binding 0, a dynamic uniform buffer)
+	struct frame_uniforms
+	{
+		glm::mat4 view;
+		glm::mat4 proj;
+	};
+
+	// Per-draw data which is small enough for push constants (vertex_shader_push_constants.vert), s.t. draws don't
+	// need any uniform buffer memory or descriptor updates at all
+	struct draw_push_constants
+	{
+		glm::mat4 model;
+	};
+	static_assert(sizeof(draw_push_constants) <= 128, "Vulkan only guarantees 128 bytes of push constants");
+
+	// The push constant range of draw_push_constants, to be put into pipeline layouts
+	vk::PushConstantRange get_draw_push_constant_range();
+
+	// Record pushing the draw's push constants
+	void push_draw_constants(const vk::CommandBuffer commandBuffer, const vk::PipelineLayout pipelineLayout, const draw_push_constants& constants);
+
+	// A sub-allocation of a uniform ring: write the data to <mappedData>, and bind the ring's descriptor with <dynamicOffset>
+	struct uniform_allocation
+	{
+		void* mappedData = nullptr;
+		uint32_t dynamicOffset = 0;
+		vk::DeviceSize size = 0;
+	};
+
+	// How a uniform ring is doing
+	struct uniform_ring_statistics
+	{
+		uint64_t allocations = 0;
+		uint64_t bytesAllocated = 0;			// Including alignment padding
+		vk::DeviceSize peakBytesPerFrame = 0;
+	};
+
+	// A linear allocator for uniform data which changes every frame, over one persistently mapped, host-coherent buffer.
+	// The buffer is split into one region per frame in flight; begin_frame moves on to the next region and starts allocating
+	// at its beginning again. Data which has been written for a frame therefore stays untouched until that frame's slot
+	// comes around again, i.e. until the GPU is done with it -- unlike a single uniform buffer, which would be overwritten
+	// while earlier frames still read it. Writing is a memcpy; there are no map/unmap calls after construction.
+	//
+	// Allocations are aligned to minUniformBufferOffsetAlignment, and are meant to be bound through a single
+	// eUniformBufferDynamic descriptor (see descriptor_info), whose offset is given at bind time:
+	//   auto set = descriptorAllocator.get_set(layout, { descriptor_write::buffer(0, vk::DescriptorType::eUniformBufferDynamic,
+	//       uniformRing.buffer(), 0, sizeof(frame_uniforms)) });
+	//   const auto uniforms = uniformRing.push(frame_uniforms{ view, proj });
+	//   commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0u, { set }, { uniforms.dynamicOffset });
+	//   for each draw: helpers::push_draw_constants(commandBuffer, pipelineLayout, { model }); commandBuffer.draw(...);
+	//
+	// Use the same number of frames in flight as the frame scheduler, and call begin_frame after its begin_frame.
+	// The uniform ring is not thread-safe.
+	class uniform_ring
+	{
+	public:
+		static constexpr vk::DeviceSize DefaultBytesPerFrame = 256 * 1024;
+
+		uniform_ring(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			const uint32_t framesInFlight,
+			const vk::DeviceSize bytesPerFrame = DefaultBytesPerFrame
+		);
+		uniform_ring(const uniform_ring&) = delete;
+		uniform_ring& operator=(const uniform_ring&) = delete;
+		// The GPU must be done with all frames which have used the ring.
+		~uniform_ring();
+
+		// Start the next frame: allocate from the beginning of its region. The GPU must be done with the frame which
+		// used the same region before.
+		void begin_frame();
+
+		// Allocate <size> bytes in the current frame's region. Throws if the region is full.
+		uniform_allocation allocate(const vk::DeviceSize size);
+
+		// Allocate and write <data>
+		template <typename T>
+		uniform_allocation push(const T& data)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Uniform data must be trivially copyable");
+			auto allocation = allocate(sizeof(T));
+			memcpy(allocation.mappedData, &data, sizeof(T));
+			return allocation;
+		}
+
+		vk::Buffer buffer() const { return mBuffer; }
+
+		// For an eUniformBufferDynamic descriptor which covers allocations of up to <range> bytes
+		vk::DescriptorBufferInfo descriptor_info(const vk::DeviceSize range) const { return vk::DescriptorBufferInfo{ mBuffer, 0, range }; }
+
+		vk::DeviceSize alignment() const { return mAlignment; }
+		vk::DeviceSize bytes_per_frame() const { return mBytesPerFrame; }
+
+		uniform_ring_statistics get_statistics() const { return mStatistics; }
+		void print_statistics(std::ostream& stream) const;
+
+	private:
+		vk::Device mDevice;
+		vk::DeviceSize mAlignment;
+		vk::DeviceSize mBytesPerFrame;		// Multiple of mAlignment
+		uint32_t mFramesInFlight;
+		vk::Buffer mBuffer;
+		memory_allocation mMemory;
+		size_t mCurrentSlot = 0;
+		uint64_t mFrameNumber = 0;
+		vk::DeviceSize mFrameOffset = 0;	// Next free byte within the current frame's region
+		uniform_ring_statistics mStatistics;
+	};
+}
@@ -0,0 +1,532 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		// Staging allocations are aligned such that they are valid buffer offsets for all of our
+		// copies (multiple of 4 and of any texel block size up to 16 bytes):
+		constexpr vk::DeviceSize StagingAlignment = 16;
+
+		vk::DeviceSize align_up(const vk::DeviceSize value, const vk::DeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	upload_engine::upload_engine(
+		const vk::PhysicalDevice physicalDevice,
+		const vk::Device device,
+		const uint32_t queueFamilyIndex,
+		const vk::Queue queue,
+		const vk::DeviceSize stagingBufferSize,
+		const uint32_t dstQueueFamilyIndex)
+		: mDevice{ device }
+		, mQueue{ queue }
+		, mQueueFamilyIndex{ queueFamilyIndex }
+		, mDstQueueFamilyIndex{ dstQueueFamilyIndex == queueFamilyIndex ? VK_QUEUE_FAMILY_IGNORED : dstQueueFamilyIndex }
+		, mSupportsBlits{ static_cast<bool>(physicalDevice.getQueueFamilyProperties()[queueFamilyIndex].queueFlags & vk::QueueFlagBits::eGraphics) }
+		, mStagingSize{ align_up(stagingBufferSize, StagingAlignment) }
+	{
+		// Command buffers are re-recorded individually whenever a batch is reused:
+		mCommandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}
+			.setFlags(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+			.setQueueFamilyIndex(queueFamilyIndex)
+		);
+
+		// The staging ring lives in (persistently mapped) host-coherent memory:
+		std::tie(mStagingBuffer, mStagingMemory) = helpers::create_host_coherent_buffer_and_memory(
+			device, physicalDevice, static_cast<size_t>(mStagingSize), vk::BufferUsageFlagBits::eTransferSrc
+		);
+	}
+
+	upload_engine::~upload_engine()
+	{
+		submit();
+		while (!mInFlight.empty()) {
+			retire_completed_batches(true);
+		}
+		for (auto& b : mFreeBatches) {
+			mDevice.destroyFence(b.fence);
+		}
+		mDevice.destroyCommandPool(mCommandPool);
+		helpers::destroy_buffer(mDevice, mStagingBuffer);
+		helpers::free_memory(mDevice, mStagingMemory);
+	}
+
+	bool upload_engine::try_allocate_staging_memory(const vk::DeviceSize size, vk::DeviceSize& outOffset)
+	{
+		if (0 == mBytesInUse) {
+			mHead = mTail = 0;
+		}
+
+		vk::DeviceSize consumed = 0;
+		if (mHead >= mTail && mBytesInUse < mStagingSize) {
+			// Free space is [mHead, end) and [0, mTail)
+			if (mStagingSize - mHead >= size) {
+				outOffset = mHead;
+				consumed = size;
+			}
+			else if (mTail >= size) {
+				// Wrap around; the rest at the end of the ring is wasted until this batch completes
+				outOffset = 0;
+				consumed = (mStagingSize - mHead) + size;
+			}
+			else {
+				return false;
+			}
+		}
+		else if (mHead < mTail && mTail - mHead >= size) {
+			outOffset = mHead;
+			consumed = size;
+		}
+		else {
+			return false;
+		}
+
+		mLastAllocationHead = mHead;
+		mLastAllocationConsumed = consumed;
+		mHead = outOffset + size;
+		mBytesInUse += consumed;
+		mCurrent.stagingBytes += consumed;
+		return true;
+	}
+
+	vk::DeviceSize upload_engine::allocate_staging_memory(const vk::DeviceSize size)
+	{
+		const auto alignedSize = align_up(size, StagingAlignment);
+		assert(alignedSize <= mStagingSize);
+		if (mReservation) {
+			throw std::runtime_error("A reserved upload must be committed or cancelled before anything else is enqueued.");
+		}
+
+		vk::DeviceSize offset;
+		while (!try_allocate_staging_memory(alignedSize, offset)) {
+			// The ring is full. If only the current batch is occupying it, we have to submit it first:
+			if (mInFlight.empty()) {
+				submit();
+			}
+			retire_completed_batches(true);
+		}
+		return offset;
+	}
+
+	vk::CommandBuffer upload_engine::current_command_buffer()
+	{
+		if (!mRecording) {
+			if (!mFreeBatches.empty()) {
+				mCurrent.commandBuffer = mFreeBatches.back().commandBuffer;
+				mCurrent.fence = mFreeBatches.back().fence;
+				mFreeBatches.pop_back();
+			}
+			else {
+				mCurrent.commandBuffer = helpers::allocate_command_buffer(mDevice, mCommandPool);
+				mCurrent.fence = mDevice.createFence(vk::FenceCreateInfo{});
+			}
+			mCurrent.commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+			mRecording = true;
+		}
+		return mCurrent.commandBuffer;
+	}
+
+	void upload_engine::enqueue_buffer_upload(
+		const void* data, const size_t dataSize,
+		const vk::Buffer dstBuffer, const vk::DeviceSize dstOffset,
+		const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+	{
+		// Nothing to copy => no barrier either (a buffer barrier of size 0 would be invalid):
+		if (0 == dataSize) {
+			return;
+		}
+
+		auto src = static_cast<const uint8_t*>(data);
+		vk::DeviceSize remaining = dataSize;
+		vk::DeviceSize dst = dstOffset;
+		while (remaining > 0) {
+			const auto chunkSize = std::min(remaining, mStagingSize);
+			const auto stagingOffset = allocate_staging_memory(chunkSize);
+			memcpy(static_cast<uint8_t*>(mStagingMemory.mappedData) + stagingOffset, src, static_cast<size_t>(chunkSize));
+			current_command_buffer().copyBuffer(mStagingBuffer, dstBuffer, { vk::BufferCopy{ stagingOffset, dst, chunkSize } });
+
+			src += chunkSize;
+			dst += chunkSize;
+			remaining -= chunkSize;
+			mTotalBytesUploaded += chunkSize;
+		}
+
+		// One global memory barrier at the end of the batch makes all buffer copies visible -- unless the buffer
+		// changes its owner, which requires a buffer barrier:
+		if (transfers_ownership()) {
+			mPendingBufferBarriers.push_back(vk::BufferMemoryBarrier{}
+				.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+				.setDstAccessMask(dstAccess)
+				.setSrcQueueFamilyIndex(mQueueFamilyIndex)
+				.setDstQueueFamilyIndex(mDstQueueFamilyIndex)
+				.setBuffer(dstBuffer)
+				.setOffset(dstOffset)
+				.setSize(dataSize)
+			);
+		}
+		else {
+			mPendingDstAccess |= dstAccess;
+		}
+		mPendingDstStages |= dstStages;
+	}
+
+	void upload_engine::enqueue_image_upload(
+		const void* data, const size_t dataSize,
+		const vk::Image dstImage, const uint32_t width, const uint32_t height, const uint32_t bytesPerTexel,
+		const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess,
+		const uint32_t arrayLayer)
+	{
+		enqueue_image_level_upload(data, dataSize, dstImage, 0u, arrayLayer, width, height, 1u, bytesPerTexel, finalLayout, dstStages, dstAccess);
+	}
+
+	void upload_engine::enqueue_image_level_upload(
+		const void* data, const size_t dataSize,
+		const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+		const uint32_t width, const uint32_t height, const uint32_t blockExtent, const uint32_t bytesPerBlock,
+		const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+	{
+		const auto blocksWide = (width + blockExtent - 1) / blockExtent;
+		const auto blocksHigh = (height + blockExtent - 1) / blockExtent;
+		const auto rowPitch = static_cast<vk::DeviceSize>(blocksWide) * bytesPerBlock;
+		assert(dataSize == rowPitch * blocksHigh);
+		if (rowPitch > mStagingSize) {
+			throw std::runtime_error("A single row of the image does not fit into the staging buffer.");
+		}
+		const auto rowsPerChunk = static_cast<uint32_t>(std::min<vk::DeviceSize>(blocksHigh, mStagingSize / rowPitch));
+
+		// Chunks consist of whole rows of blocks. Only the last one may extend to a partial block at the image's bottom border.
+		auto src = static_cast<const uint8_t*>(data);
+		for (uint32_t blockY = 0; blockY < blocksHigh; blockY += rowsPerChunk) {
+			const auto rows = std::min(rowsPerChunk, blocksHigh - blockY);
+			const auto chunkSize = rowPitch * rows;
+			const auto stagingOffset = allocate_staging_memory(chunkSize);
+			memcpy(static_cast<uint8_t*>(mStagingMemory.mappedData) + stagingOffset, src + rowPitch * blockY, static_cast<size_t>(chunkSize));
+			const auto y = blockY * blockExtent;
+			record_image_chunk_copy(stagingOffset, dstImage, mipLevel, arrayLayer, y, width, std::min(rows * blockExtent, height - y));
+			mTotalBytesUploaded += chunkSize;
+		}
+		enqueue_final_image_level_transition(dstImage, mipLevel, arrayLayer, finalLayout, dstStages, dstAccess);
+	}
+
+	void* upload_engine::reserve_image_level_upload(
+		const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+		const uint32_t width, const uint32_t height, const uint32_t blockExtent, const uint32_t bytesPerBlock,
+		const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+	{
+		const auto blocksWide = (width + blockExtent - 1) / blockExtent;
+		const auto blocksHigh = (height + blockExtent - 1) / blockExtent;
+		const auto dataSize = static_cast<vk::DeviceSize>(blocksWide) * bytesPerBlock * blocksHigh;
+		if (dataSize > mStagingSize) {
+			throw std::runtime_error("The image level does not fit into the staging buffer as a whole.");
+		}
+
+		const auto stagingOffset = allocate_staging_memory(dataSize);
+		mReservation = image_level_reservation{
+			stagingOffset, dataSize, mLastAllocationHead, mLastAllocationConsumed,
+			dstImage, mipLevel, arrayLayer, width, height, finalLayout, dstStages, dstAccess
+		};
+		return static_cast<uint8_t*>(mStagingMemory.mappedData) + stagingOffset;
+	}
+
+	void upload_engine::commit_reserved_upload()
+	{
+		if (!mReservation) {
+			throw std::runtime_error("There is no reserved upload to commit.");
+		}
+		const auto r = *mReservation;
+		mReservation.reset();
+		record_image_chunk_copy(r.stagingOffset, r.dstImage, r.mipLevel, r.arrayLayer, 0u, r.width, r.height);
+		mTotalBytesUploaded += r.size;
+		enqueue_final_image_level_transition(r.dstImage, r.mipLevel, r.arrayLayer, r.finalLayout, r.dstStages, r.dstAccess);
+	}
+
+	void upload_engine::cancel_reserved_upload()
+	{
+		if (!mReservation) {
+			throw std::runtime_error("There is no reserved upload to cancel.");
+		}
+		// The reservation is the ring's most recent allocation => it can simply be undone:
+		mHead = mReservation->headBefore;
+		mBytesInUse -= mReservation->consumed;
+		mCurrent.stagingBytes -= mReservation->consumed;
+		mReservation.reset();
+	}
+
+	void upload_engine::record_image_chunk_copy(
+		const vk::DeviceSize stagingOffset, const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+		const uint32_t y, const uint32_t width, const uint32_t height)
+	{
+		auto commandBuffer = current_command_buffer();
+		if (0 == y) {
+			// Discard the previous contents and get the subresource ready for being copied into:
+			helpers::establish_pipeline_barrier_with_image_layout_transition(commandBuffer,
+				vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+				vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+				dstImage,
+				vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+				vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, mipLevel, 1, arrayLayer, 1 }
+			);
+		}
+		commandBuffer.copyBufferToImage(mStagingBuffer, dstImage, vk::ImageLayout::eTransferDstOptimal, {
+			vk::BufferImageCopy{
+				stagingOffset, 0, 0,
+				vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, mipLevel, arrayLayer, 1 },
+				vk::Offset3D{ 0, static_cast<int32_t>(y), 0 }, vk::Extent3D{ width, height, 1 }
+			}
+		});
+	}
+
+	void upload_engine::enqueue_final_image_level_transition(
+		const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+		const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+	{
+		// The transition into the final layout is recorded at the end of the batch, together with all the others.
+		// (If the batch has been submitted in between the chunks, the image simply stays in eTransferDstOptimal.)
+		const auto subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, mipLevel, 1, arrayLayer, 1 };
+		auto barrier = vk::ImageMemoryBarrier{}
+			.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+			.setDstAccessMask(dstAccess)
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(finalLayout)
+			.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setImage(dstImage)
+			.setSubresourceRange(subresourceRange);
+		mPendingImageBarriers.push_back(barrier);
+		mPendingDstStages |= dstStages;
+	}
+
+	void upload_engine::enqueue_mip_chain_generation(
+		const vk::Image dstImage, const uint32_t width, const uint32_t height, const uint32_t mipLevels,
+		const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess,
+		const uint32_t arrayLayer)
+	{
+		// Level 0 is still in eTransferDstOptimal, because its transition into the final layout has not been recorded yet.
+		// Take that transition over; the whole chain is transitioned at the end of the batch instead:
+		auto level0 = std::find_if(mPendingImageBarriers.begin(), mPendingImageBarriers.end(), [&](const vk::ImageMemoryBarrier& b) {
+			return b.image == dstImage && 0 == b.subresourceRange.baseMipLevel && arrayLayer == b.subresourceRange.baseArrayLayer
+				&& vk::ImageLayout::eTransferDstOptimal == b.oldLayout;
+		});
+		if (mPendingImageBarriers.end() == level0) {
+			throw std::runtime_error("Mip chain generation must directly follow the upload of level 0 in the same batch.");
+		}
+		if (!mSupportsBlits) {
+			throw std::runtime_error("Mip chain generation requires blits, which the upload engine's queue family doesn't support.");
+		}
+		mPendingImageBarriers.erase(level0);
+
+		auto commandBuffer = current_command_buffer();
+		auto level_range = [arrayLayer](const uint32_t level, const uint32_t levelCount) {
+			return vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level, levelCount, arrayLayer, 1 };
+		};
+
+		// Level 0 becomes the first blit source; all other levels are discarded and become blit destinations:
+		helpers::establish_pipeline_barrier_with_image_layout_transition(commandBuffer,
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+			dstImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal, level_range(0, 1)
+		);
+		if (mipLevels > 1) {
+			helpers::establish_pipeline_barrier_with_image_layout_transition(commandBuffer,
+				vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+				vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+				dstImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, level_range(1, mipLevels - 1)
+			);
+		}
+
+		// Each level is read from the previous one, which must have been written completely before:
+		for (uint32_t level = 1; level < mipLevels; ++level) {
+			const auto srcWidth = static_cast<int32_t>(std::max(1u, width >> (level - 1)));
+			const auto srcHeight = static_cast<int32_t>(std::max(1u, height >> (level - 1)));
+			const auto dstWidth = static_cast<int32_t>(std::max(1u, width >> level));
+			const auto dstHeight = static_cast<int32_t>(std::max(1u, height >> level));
+			const auto blit = vk::ImageBlit{}
+				.setSrcSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level - 1, arrayLayer, 1 })
+				.setSrcOffsets({ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ srcWidth, srcHeight, 1 } })
+				.setDstSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, arrayLayer, 1 })
+				.setDstOffsets({ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ dstWidth, dstHeight, 1 } });
+			commandBuffer.blitImage(
+				dstImage, vk::ImageLayout::eTransferSrcOptimal,
+				dstImage, vk::ImageLayout::eTransferDstOptimal,
+				{ blit }, vk::Filter::eLinear
+			);
+			helpers::establish_pipeline_barrier_with_image_layout_transition(commandBuffer,
+				vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+				vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+				dstImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal, level_range(level, 1)
+			);
+		}
+
+		// All levels are in eTransferSrcOptimal now => one transition into the final layout at the end of the batch:
+		auto barrier = vk::ImageMemoryBarrier{}
+			.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+			.setDstAccessMask(dstAccess)
+			.setOldLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setNewLayout(finalLayout)
+			.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setImage(dstImage)
+			.setSubresourceRange(level_range(0, mipLevels));
+		mPendingImageBarriers.push_back(barrier);
+		mPendingDstStages |= dstStages;
+	}
+
+	void upload_engine::enqueue_image_layout_transition(
+		const vk::Image dstImage, const vk::ImageSubresourceRange subresourceRange,
+		const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess)
+	{
+		// There is nothing to wait for, since the previous contents are discarded. The transition is recorded
+		// at the end of the batch, together with the uploads' transitions; just make sure that there is a batch:
+		current_command_buffer();
+		auto barrier = vk::ImageMemoryBarrier{}
+			.setSrcAccessMask(vk::AccessFlags{})
+			.setDstAccessMask(dstAccess)
+			.setOldLayout(vk::ImageLayout::eUndefined)
+			.setNewLayout(finalLayout)
+			.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setImage(dstImage)
+			.setSubresourceRange(subresourceRange);
+		mPendingImageBarriers.push_back(barrier);
+		mPendingDstStages |= dstStages;
+	}
+
+	upload_token upload_engine::submit()
+	{
+		if (mReservation) {
+			throw std::runtime_error("A reserved upload must be committed or cancelled before the batch is submitted.");
+		}
+		if (!mRecording) {
+			return mNextToken - 1;
+		}
+
+		if (transfers_ownership()) {
+			record_ownership_release();
+		}
+		else {
+			// Make all the copies of this batch available and visible to their consumers, and transition
+			// all images into their final layouts -- all with one single pipeline barrier:
+			std::vector<vk::MemoryBarrier> memoryBarriers;
+			if (mPendingDstAccess) {
+				memoryBarriers.push_back(vk::MemoryBarrier{ vk::AccessFlagBits::eTransferWrite, mPendingDstAccess });
+			}
+			if (!memoryBarriers.empty() || !mPendingImageBarriers.empty()) {
+				mCurrent.commandBuffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eTransfer,
+					mPendingDstStages ? mPendingDstStages : vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eBottomOfPipe },
+					{}, memoryBarriers, {}, mPendingImageBarriers
+				);
+			}
+		}
+		mCurrent.commandBuffer.end();
+
+		auto submitInfo = vk::SubmitInfo{}
+			.setCommandBufferCount(1u)
+			.setPCommandBuffers(&mCurrent.commandBuffer);
+		mQueue.submit({ submitInfo }, mCurrent.fence);
+
+		mCurrent.token = mNextToken++;
+		mCurrent.stagingEnd = mHead;
+		mInFlight.push_back(mCurrent);
+
+		mCurrent = batch{};
+		mRecording = false;
+		mPendingImageBarriers.clear();
+		mPendingBufferBarriers.clear();
+		mPendingDstStages = vk::PipelineStageFlags{};
+		mPendingDstAccess = vk::AccessFlags{};
+		return mInFlight.back().token;
+	}
+
+	void upload_engine::record_ownership_release()
+	{
+		// The release and the acquire barrier of an ownership transfer must specify the same queue families and layouts.
+		// The release half only makes the writes available (the destination's stages and accesses are meaningless on this
+		// queue); the acquire half makes them visible to the destination's stages:
+		for (auto& b : mPendingImageBarriers) {
+			b.setSrcQueueFamilyIndex(mQueueFamilyIndex).setDstQueueFamilyIndex(mDstQueueFamilyIndex);
+			mCurrent.acquireImageBarriers.push_back(vk::ImageMemoryBarrier{ b }.setSrcAccessMask(vk::AccessFlags{}));
+			b.setDstAccessMask(vk::AccessFlags{});
+		}
+		for (auto& b : mPendingBufferBarriers) {
+			mCurrent.acquireBufferBarriers.push_back(vk::BufferMemoryBarrier{ b }.setSrcAccessMask(vk::AccessFlags{}));
+			b.setDstAccessMask(vk::AccessFlags{});
+		}
+		mCurrent.acquireDstStages = mPendingDstStages;
+
+		if (!mPendingBufferBarriers.empty() || !mPendingImageBarriers.empty()) {
+			mCurrent.commandBuffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+				{}, {}, mPendingBufferBarriers, mPendingImageBarriers
+			);
+		}
+	}
+
+	bool upload_engine::record_acquire_barriers(const vk::CommandBuffer commandBuffer)
+	{
+		retire_completed_batches(false);
+		if (mAcquirableBufferBarriers.empty() && mAcquirableImageBarriers.empty()) {
+			return false;
+		}
+
+		// The batches have completed on the GPU (their fences have been signalled) => there is nothing to wait for:
+		commandBuffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eTopOfPipe,
+			mAcquirableDstStages ? mAcquirableDstStages : vk::PipelineStageFlags{ vk::PipelineStageFlagBits::eBottomOfPipe },
+			{}, {}, mAcquirableBufferBarriers, mAcquirableImageBarriers
+		);
+		mAcquirableBufferBarriers.clear();
+		mAcquirableImageBarriers.clear();
+		mAcquirableDstStages = vk::PipelineStageFlags{};
+		return true;
+	}
+
+	void upload_engine::retire_completed_batches(const bool waitForOldest)
+	{
+		if (waitForOldest && !mInFlight.empty()) {
+			const auto result = mDevice.waitForFences({ mInFlight.front().fence }, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			if (vk::Result::eSuccess != result) {
+				throw std::runtime_error("Waiting for an upload batch's fence failed: " + vk::to_string(result));
+			}
+		}
+
+		// Batches complete in submission order => free their staging memory from the tail of the ring:
+		while (!mInFlight.empty() && vk::Result::eSuccess == mDevice.getFenceStatus(mInFlight.front().fence)) {
+			auto& b = mInFlight.front();
+			mTail = b.stagingEnd;
+			mBytesInUse -= b.stagingBytes;
+			mLastCompletedToken = b.token;
+
+			// Only now may the destination family acquire the batch's resources:
+			mAcquirableBufferBarriers.insert(mAcquirableBufferBarriers.end(), b.acquireBufferBarriers.begin(), b.acquireBufferBarriers.end());
+			mAcquirableImageBarriers.insert(mAcquirableImageBarriers.end(), b.acquireImageBarriers.begin(), b.acquireImageBarriers.end());
+			mAcquirableDstStages |= b.acquireDstStages;
+			b.acquireBufferBarriers.clear();
+			b.acquireImageBarriers.clear();
+			b.acquireDstStages = vk::PipelineStageFlags{};
+
+			mDevice.resetFences({ b.fence });
+			mFreeBatches.push_back(b);
+			mInFlight.pop_front();
+		}
+	}
+
+	bool upload_engine::is_complete(const upload_token token)
+	{
+		retire_completed_batches(false);
+		return token <= mLastCompletedToken;
+	}
+
+	void upload_engine::wait(const upload_token token)
+	{
+		if (token >= mNextToken) {
+			submit();
+		}
+		while (token > mLastCompletedToken && !mInFlight.empty()) {
+			retire_completed_batches(true);
+		}
+	}
+}
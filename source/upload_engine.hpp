@@ -0,0 +1,216 @@
+#pragma once
+
+namespace helpers
+{
+	// Identifies one submitted batch of uploads. Tokens increase monotonically, i.e. if a token
+	// is complete, all smaller tokens are complete as well.
+	using upload_token = uint64_t;
+
+	// Moves data from the CPU into (device-local) buffers and images through a reusable,
+	// persistently mapped staging ring buffer.
+	//
+	// Uploads are enqueued into the current batch, which is recorded into a single command buffer.
+	// submit() submits the whole batch at once and returns a token that can be polled (is_complete)
+	// or waited on (wait). After a batch has completed, the destination resources are in their
+	// requested final state: all necessary barriers and layout transitions are recorded by the engine.
+	// Later submissions to the same queue can use the resources without further synchronization.
+	//
+	// Uploads larger than the staging ring are split into multiple chunks. When the ring is full,
+	// the current batch is submitted and the engine waits for the oldest batch in flight.
+	//
+	// Uploads can run on a dedicated transfer queue (see device_queues), concurrently to rendering. If the resources are
+	// used by another queue family than the engine's, pass that family as <dstQueueFamilyIndex>: each batch then releases
+	// the ownership of its resources at its end, and the destination family has to acquire it with record_acquire_barriers
+	// before it uses them. Only resources of completed batches can be acquired => use them once is_complete(token) says so.
+	//
+	// The upload engine is not thread-safe.
+	class upload_engine
+	{
+	public:
+		static constexpr vk::DeviceSize DefaultStagingBufferSize = 32ull * 1024ull * 1024ull;
+
+		upload_engine(
+			const vk::PhysicalDevice physicalDevice,
+			const vk::Device device,
+			const uint32_t queueFamilyIndex,
+			const vk::Queue queue,
+			const vk::DeviceSize stagingBufferSize = DefaultStagingBufferSize,
+			const uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED
+		);
+		upload_engine(const upload_engine&) = delete;
+		upload_engine& operator=(const upload_engine&) = delete;
+		~upload_engine();
+
+		// Enqueue copying <dataSize> bytes into <dstBuffer> at <dstOffset>. The data is copied into
+		// the staging ring immediately, i.e. <data> does not have to outlive this call.
+		// <dstStages> and <dstAccess> describe how the buffer is going to be used afterwards. A <dataSize> of 0 is a no-op.
+		void enqueue_buffer_upload(
+			const void* data, const size_t dataSize,
+			const vk::Buffer dstBuffer, const vk::DeviceSize dstOffset,
+			const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess
+		);
+
+		// Enqueue copying tightly packed texel data into mip level 0 of array layer <arrayLayer> of <dstImage>, which
+		// must have been created with eTransferDst usage. The layer's previous contents are discarded. After the upload,
+		// the layer will be in <finalLayout>; the image's other layers are not touched.
+		void enqueue_image_upload(
+			const void* data, const size_t dataSize,
+			const vk::Image dstImage, const uint32_t width, const uint32_t height, const uint32_t bytesPerTexel,
+			const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess,
+			const uint32_t arrayLayer = 0u
+		);
+
+		// Like enqueue_image_upload, but for any mip level, and for block-compressed formats: <data> contains the level's
+		// blocks of <blockExtent> x <blockExtent> texels with <bytesPerBlock> bytes each, tightly packed, row by row.
+		// <width> and <height> are the level's dimensions in texels. For uncompressed formats, pass blockExtent = 1 and
+		// bytesPerBlock = bytes per texel. Only the given subresource is transitioned into <finalLayout>.
+		void enqueue_image_level_upload(
+			const void* data, const size_t dataSize,
+			const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+			const uint32_t width, const uint32_t height, const uint32_t blockExtent, const uint32_t bytesPerBlock,
+			const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess
+		);
+
+		// Like enqueue_image_level_upload, but without any data to copy from: reserves the level's tightly packed blocks in the
+		// staging ring and returns a pointer to them, s.t. the level can be written (e.g. decoded) straight into the persistently
+		// mapped staging memory. Nothing is recorded yet: once the level has been written completely, commit_reserved_upload
+		// enqueues it; if writing it fails, cancel_reserved_upload returns the staging memory, and <dstImage> may be destroyed.
+		// Exactly one of the two must be called before any other call into the engine. Throws if the level doesn't fit into
+		// the staging ring as a whole (see staging_buffer_size).
+		void* reserve_image_level_upload(
+			const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+			const uint32_t width, const uint32_t height, const uint32_t blockExtent, const uint32_t bytesPerBlock,
+			const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess
+		);
+		void commit_reserved_upload();
+		void cancel_reserved_upload();
+
+		// Enqueue generating mip levels 1 to <mipLevels>-1 of array layer <arrayLayer> of <dstImage> on the GPU, by blitting each level
+		// into the next one with linear filtering. Must be called right after level 0 of that layer has been enqueued with
+		// enqueue_image_upload. <dstImage> must have been created with eTransferSrc and eTransferDst usage, and its format must
+		// support linear blits (see is_linear_blit_supported), and the engine's queue must support blits (see supports_blits).
+		// After the upload, all levels will be in <finalLayout>.
+		void enqueue_mip_chain_generation(
+			const vk::Image dstImage, const uint32_t width, const uint32_t height, const uint32_t mipLevels,
+			const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess,
+			const uint32_t arrayLayer = 0u
+		);
+
+		// Enqueue transitioning the given subresources of <dstImage> from eUndefined into <finalLayout>, discarding their contents.
+		// Useful for subresources which are not uploaded right away, but which must be in a defined layout (e.g. when bound).
+		void enqueue_image_layout_transition(
+			const vk::Image dstImage, const vk::ImageSubresourceRange subresourceRange,
+			const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess
+		);
+
+		// Submit the current batch, if it contains any uploads.
+		// Returns the token of the batch (or of the last submitted batch, if there was nothing to submit).
+		upload_token submit();
+
+		// Non-blocking: Has the batch with the given token completed on the GPU?
+		bool is_complete(const upload_token token);
+
+		// Block until the batch with the given token has completed. Submits the current batch if required.
+		void wait(const upload_token token);
+
+		// The token which the current (not yet submitted) batch will get
+		upload_token current_token() const { return mNextToken; }
+
+		// The largest upload which reserve_image_level_upload can take
+		vk::DeviceSize staging_buffer_size() const { return mStagingSize; }
+
+		// Total number of bytes which went through the staging ring so far
+		vk::DeviceSize total_bytes_uploaded() const { return mTotalBytesUploaded; }
+
+		// Can enqueue_mip_chain_generation be used? Blits require a graphics queue, i.e. not on dedicated transfer queues.
+		bool supports_blits() const { return mSupportsBlits; }
+
+		// Does the engine transfer the ownership of its resources to another queue family?
+		bool transfers_ownership() const { return mDstQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED; }
+
+		// Record the acquire halves of the ownership transfers of all batches which have completed so far, and which have
+		// not been acquired yet, into <commandBuffer>, which must be submitted to a queue of <dstQueueFamilyIndex>. Call it
+		// e.g. once per frame, before using resources whose tokens are complete. Returns false if there was nothing to acquire.
+		bool record_acquire_barriers(const vk::CommandBuffer commandBuffer);
+
+	private:
+		// An upload which has been reserved with reserve_image_level_upload, but not committed yet
+		struct image_level_reservation
+		{
+			vk::DeviceSize stagingOffset;
+			vk::DeviceSize size;
+			vk::DeviceSize headBefore;		// To roll the staging allocation back on cancel
+			vk::DeviceSize consumed;
+			vk::Image dstImage;
+			uint32_t mipLevel;
+			uint32_t arrayLayer;
+			uint32_t width;
+			uint32_t height;
+			vk::ImageLayout finalLayout;
+			vk::PipelineStageFlags dstStages;
+			vk::AccessFlags dstAccess;
+		};
+
+		struct batch
+		{
+			vk::CommandBuffer commandBuffer;
+			vk::Fence fence;
+			upload_token token = 0;
+			vk::DeviceSize stagingEnd = 0;		// Ring position right after this batch's last staging allocation
+			vk::DeviceSize stagingBytes = 0;	// Bytes of the ring that this batch occupies (including padding)
+			std::vector<vk::BufferMemoryBarrier> acquireBufferBarriers;	// Only if ownership is transferred
+			std::vector<vk::ImageMemoryBarrier> acquireImageBarriers;
+			vk::PipelineStageFlags acquireDstStages;
+		};
+
+		// Reserve space in the staging ring. May submit the current batch and wait for older ones.
+		// Returns the offset into the staging buffer.
+		vk::DeviceSize allocate_staging_memory(const vk::DeviceSize size);
+		bool try_allocate_staging_memory(const vk::DeviceSize size, vk::DeviceSize& outOffset);
+		vk::CommandBuffer current_command_buffer();
+		// Record copying rows [y, y + height) of a subresource from the staging buffer; discards its contents at y = 0
+		void record_image_chunk_copy(
+			const vk::DeviceSize stagingOffset, const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+			const uint32_t y, const uint32_t width, const uint32_t height
+		);
+		void enqueue_final_image_level_transition(
+			const vk::Image dstImage, const uint32_t mipLevel, const uint32_t arrayLayer,
+			const vk::ImageLayout finalLayout, const vk::PipelineStageFlags dstStages, const vk::AccessFlags dstAccess
+		);
+		void retire_completed_batches(const bool waitForOldest);
+		void record_ownership_release();
+
+		vk::Device mDevice;
+		vk::Queue mQueue;
+		uint32_t mQueueFamilyIndex;
+		uint32_t mDstQueueFamilyIndex;		// VK_QUEUE_FAMILY_IGNORED if the resources are used by the engine's queue family
+		bool mSupportsBlits;
+		vk::CommandPool mCommandPool;
+		vk::Buffer mStagingBuffer;
+		memory_allocation mStagingMemory;
+		vk::DeviceSize mStagingSize;
+		vk::DeviceSize mHead = 0;
+		vk::DeviceSize mTail = 0;
+		vk::DeviceSize mBytesInUse = 0;
+		vk::DeviceSize mLastAllocationHead = 0;		// mHead before, and the bytes consumed by, the last staging allocation
+		vk::DeviceSize mLastAllocationConsumed = 0;
+		std::optional<image_level_reservation> mReservation;
+
+		bool mRecording = false;
+		batch mCurrent;
+		std::vector<vk::ImageMemoryBarrier> mPendingImageBarriers;	// Transitions into the final layouts, recorded at submit
+		std::vector<vk::BufferMemoryBarrier> mPendingBufferBarriers;	// Only if ownership is transferred (global memory barrier otherwise)
+		vk::PipelineStageFlags mPendingDstStages;
+		vk::AccessFlags mPendingDstAccess;
+
+		std::deque<batch> mInFlight;
+		std::vector<batch> mFreeBatches;
+		upload_token mNextToken = 1;
+		upload_token mLastCompletedToken = 0;
+		vk::DeviceSize mTotalBytesUploaded = 0;
+
+		std::vector<vk::BufferMemoryBarrier> mAcquirableBufferBarriers;	// Of completed batches, to be recorded by record_acquire_barriers
+		std::vector<vk::ImageMemoryBarrier> mAcquirableImageBarriers;
+		vk::PipelineStageFlags mAcquirableDstStages;
+	};
+}
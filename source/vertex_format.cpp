@@ -0,0 +1,356 @@
+#include "pch.h"
+
+namespace helpers
+{
+	namespace
+	{
+		constexpr size_t BindingAlignment = 16;
+
+		// Where one attribute lives within the encoded data
+		struct attribute_layout
+		{
+			vk::Format format = vk::Format::eUndefined;
+			uint32_t size = 0u;		// in bytes
+			uint32_t binding = 0u;	// relative to the first binding
+			uint32_t offset = 0u;	// within a vertex of the binding
+			uint32_t stride = 0u;	// of the binding
+		};
+
+		enum attribute_index { PositionAttribute = 0, TextureCoordinatesAttribute = 1, NormalAttribute = 2, AttributeCount = 3 };
+
+		std::array<attribute_layout, AttributeCount> get_attribute_layouts(const vertex_format& format)
+		{
+			std::array<attribute_layout, AttributeCount> layouts;
+			layouts[PositionAttribute] = position_encoding::snorm16 == format.positions
+				? attribute_layout{ vk::Format::eR16G16B16A16Snorm, 8u }
+				: attribute_layout{ vk::Format::eR32G32B32Sfloat, 12u };
+			layouts[TextureCoordinatesAttribute] = texture_coordinates_encoding::float16 == format.textureCoordinates
+				? attribute_layout{ vk::Format::eR16G16Sfloat, 4u }
+				: attribute_layout{ vk::Format::eR32G32Sfloat, 8u };
+			switch (format.normals) {
+			case normal_encoding::octahedral_snorm16:
+				layouts[NormalAttribute] = attribute_layout{ vk::Format::eR16G16Snorm, 4u };
+				break;
+			case normal_encoding::octahedral_snorm8:
+				layouts[NormalAttribute] = attribute_layout{ vk::Format::eR8G8Snorm, 2u };
+				break;
+			default:
+				layouts[NormalAttribute] = attribute_layout{ vk::Format::eR32G32B32Sfloat, 12u };
+				break;
+			}
+
+			if (vertex_layout::interleaved == format.layout) {
+				uint32_t offset = 0u;
+				for (auto& layout : layouts) {
+					layout.binding = 0u;
+					layout.offset = offset;
+					offset += layout.size;
+				}
+				// Keep every vertex 4-byte aligned:
+				const auto stride = (offset + 3u) / 4u * 4u;
+				for (auto& layout : layouts) {
+					layout.stride = stride;
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < AttributeCount; ++i) {
+					layouts[i].binding = i;
+					layouts[i].offset = 0u;
+					layouts[i].stride = layouts[i].size;
+				}
+			}
+			return layouts;
+		}
+
+		uint32_t get_binding_count(const vertex_format& format)
+		{
+			return vertex_layout::interleaved == format.layout ? 1u : static_cast<uint32_t>(AttributeCount);
+		}
+
+		int16_t to_snorm16(const float value)
+		{
+			return static_cast<int16_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		float from_snorm(const int value, const float maxValue)
+		{
+			return std::max(static_cast<float>(value) / maxValue, -1.0f);
+		}
+
+		glm::vec3 decode_octahedral(const glm::vec2 encoded)
+		{
+			glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+			const float t = std::max(-n.z, 0.0f);
+			n.x += n.x >= 0.0f ? -t : t;
+			n.y += n.y >= 0.0f ? -t : t;
+			return glm::normalize(n);
+		}
+
+		// Octahedral encoding, quantized to signed normalized integers with the given maximum value (32767 or 127).
+		// Instead of just rounding, pick the neighboring grid point which decodes closest to the original normal.
+		glm::ivec2 encode_octahedral(const glm::vec3 normal, const int maxValue)
+		{
+			const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			if (0.0f == sum) {
+				return glm::ivec2{ 0 }; // No normal => whatever
+			}
+			glm::vec2 p = glm::vec2(normal) / sum;
+			if (normal.z < 0.0f) {
+				p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * glm::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+			}
+
+			const auto n = glm::normalize(normal);
+			const auto base = glm::ivec2(glm::floor(p * static_cast<float>(maxValue)));
+			glm::ivec2 best = glm::clamp(base, -maxValue, maxValue);
+			float bestDot = -2.0f;
+			for (int dy = 0; dy <= 1; ++dy) {
+				for (int dx = 0; dx <= 1; ++dx) {
+					const auto candidate = glm::clamp(base + glm::ivec2(dx, dy), -maxValue, maxValue);
+					const auto decoded = decode_octahedral(glm::vec2(from_snorm(candidate.x, static_cast<float>(maxValue)), from_snorm(candidate.y, static_cast<float>(maxValue))));
+					const auto d = glm::dot(n, decoded);
+					if (d > bestDot) {
+						bestDot = d;
+						best = candidate;
+					}
+				}
+			}
+			return best;
+		}
+	}
+
+	vertex_format get_full_precision_vertex_format()
+	{
+		return vertex_format{};
+	}
+
+	vertex_format get_compact_vertex_format()
+	{
+		return vertex_format{ vertex_layout::interleaved, position_encoding::snorm16, texture_coordinates_encoding::float16, normal_encoding::octahedral_snorm16 };
+	}
+
+	std::string to_string(const vertex_format& format)
+	{
+		std::string result = vertex_layout::interleaved == format.layout ? "interleaved" : "separate";
+		result += position_encoding::snorm16 == format.positions ? " pos:snorm16" : " pos:float32";
+		result += texture_coordinates_encoding::float16 == format.textureCoordinates ? " uv:float16" : " uv:float32";
+		result += normal_encoding::octahedral_snorm16 == format.normals ? " nrm:oct16"
+			: normal_encoding::octahedral_snorm8 == format.normals ? " nrm:oct8"
+			: " nrm:float32";
+		return result;
+	}
+
+	uint32_t get_bytes_per_vertex(const vertex_format& format)
+	{
+		const auto layouts = get_attribute_layouts(format);
+		if (vertex_layout::interleaved == format.layout) {
+			return layouts[0].stride;
+		}
+		uint32_t bytes = 0u;
+		for (const auto& layout : layouts) {
+			bytes += layout.stride;
+		}
+		return bytes;
+	}
+
+	std::tuple<std::vector<vk::VertexInputBindingDescription>, std::vector<vk::VertexInputAttributeDescription>> get_vertex_input_descriptions(
+		const vertex_format& format,
+		const uint32_t firstBinding)
+	{
+		const auto layouts = get_attribute_layouts(format);
+
+		std::vector<vk::VertexInputBindingDescription> bindings;
+		for (uint32_t binding = 0; binding < get_binding_count(format); ++binding) {
+			const auto& layout = *std::find_if(layouts.begin(), layouts.end(), [binding](const attribute_layout& l) { return l.binding == binding; });
+			bindings.push_back(vk::VertexInputBindingDescription{}
+				.setBinding(firstBinding + binding)
+				.setStride(layout.stride)
+				.setInputRate(vk::VertexInputRate::eVertex)
+			);
+		}
+
+		std::vector<vk::VertexInputAttributeDescription> attributes;
+		for (uint32_t location = 0; location < AttributeCount; ++location) {
+			attributes.push_back(vk::VertexInputAttributeDescription{}
+				.setLocation(location)
+				.setBinding(firstBinding + layouts[location].binding)
+				.setFormat(layouts[location].format)
+				.setOffset(layouts[location].offset)
+			);
+		}
+
+		return std::make_tuple(std::move(bindings), std::move(attributes));
+	}
+
+	encoded_vertices encode_vertices(const mesh_data& mesh, const vertex_format& format)
+	{
+		const auto layouts = get_attribute_layouts(format);
+		const auto vertexCount = mesh.positions.size();
+
+		encoded_vertices result;
+		result.format = format;
+		result.vertexCount = vertexCount;
+		size_t size = 0;
+		for (uint32_t binding = 0; binding < get_binding_count(format); ++binding) {
+			result.bindingOffsets.push_back(size);
+			const auto stride = std::find_if(layouts.begin(), layouts.end(), [binding](const attribute_layout& l) { return l.binding == binding; })->stride;
+			size = (size + stride * vertexCount + BindingAlignment - 1) / BindingAlignment * BindingAlignment;
+		}
+		result.data.resize(size);
+
+		auto attribute_pointer = [&](const attribute_index attribute, const size_t vertex) {
+			const auto& layout = layouts[attribute];
+			return result.data.data() + result.bindingOffsets[layout.binding] + vertex * layout.stride + layout.offset;
+		};
+
+		// Positions are normalized into the mesh's bounding box:
+		if (position_encoding::snorm16 == format.positions && vertexCount > 0) {
+			glm::vec3 boundsMin = mesh.positions.front(), boundsMax = mesh.positions.front();
+			for (const auto& p : mesh.positions) {
+				boundsMin = glm::min(boundsMin, p);
+				boundsMax = glm::max(boundsMax, p);
+			}
+			result.positionOffset = (boundsMin + boundsMax) * 0.5f;
+			result.positionScale = (boundsMax - boundsMin) * 0.5f;
+		}
+		const glm::vec3 inversePositionScale(
+			result.positionScale.x > 0.0f ? 1.0f / result.positionScale.x : 0.0f,
+			result.positionScale.y > 0.0f ? 1.0f / result.positionScale.y : 0.0f,
+			result.positionScale.z > 0.0f ? 1.0f / result.positionScale.z : 0.0f
+		);
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			if (position_encoding::snorm16 == format.positions) {
+				const auto p = (mesh.positions[i] - result.positionOffset) * inversePositionScale;
+				const int16_t value[4] = { to_snorm16(p.x), to_snorm16(p.y), to_snorm16(p.z), 32767 };
+				memcpy(attribute_pointer(PositionAttribute, i), value, sizeof(value));
+			}
+			else {
+				memcpy(attribute_pointer(PositionAttribute, i), &mesh.positions[i], sizeof(glm::vec3));
+			}
+
+			if (texture_coordinates_encoding::float16 == format.textureCoordinates) {
+				const uint16_t value[2] = { glm::packHalf1x16(mesh.textureCoordinates[i].x), glm::packHalf1x16(mesh.textureCoordinates[i].y) };
+				memcpy(attribute_pointer(TextureCoordinatesAttribute, i), value, sizeof(value));
+			}
+			else {
+				memcpy(attribute_pointer(TextureCoordinatesAttribute, i), &mesh.textureCoordinates[i], sizeof(glm::vec2));
+			}
+
+			if (normal_encoding::octahedral_snorm16 == format.normals) {
+				const auto encoded = encode_octahedral(mesh.normals[i], 32767);
+				const int16_t value[2] = { static_cast<int16_t>(encoded.x), static_cast<int16_t>(encoded.y) };
+				memcpy(attribute_pointer(NormalAttribute, i), value, sizeof(value));
+			}
+			else if (normal_encoding::octahedral_snorm8 == format.normals) {
+				const auto encoded = encode_octahedral(mesh.normals[i], 127);
+				const int8_t value[2] = { static_cast<int8_t>(encoded.x), static_cast<int8_t>(encoded.y) };
+				memcpy(attribute_pointer(NormalAttribute, i), value, sizeof(value));
+			}
+			else {
+				memcpy(attribute_pointer(NormalAttribute, i), &mesh.normals[i], sizeof(glm::vec3));
+			}
+		}
+
+		return result;
+	}
+
+	mesh_data decode_vertices(const encoded_vertices& encoded)
+	{
+		const auto& format = encoded.format;
+		const auto layouts = get_attribute_layouts(format);
+		auto attribute_pointer = [&](const attribute_index attribute, const size_t vertex) {
+			const auto& layout = layouts[attribute];
+			return encoded.data.data() + encoded.bindingOffsets[layout.binding] + vertex * layout.stride + layout.offset;
+		};
+
+		mesh_data mesh;
+		mesh.positions.resize(encoded.vertexCount);
+		mesh.textureCoordinates.resize(encoded.vertexCount);
+		mesh.normals.resize(encoded.vertexCount);
+		for (size_t i = 0; i < encoded.vertexCount; ++i) {
+			if (position_encoding::snorm16 == format.positions) {
+				int16_t value[4];
+				memcpy(value, attribute_pointer(PositionAttribute, i), sizeof(value));
+				const glm::vec3 p(from_snorm(value[0], 32767.0f), from_snorm(value[1], 32767.0f), from_snorm(value[2], 32767.0f));
+				mesh.positions[i] = p * encoded.positionScale + encoded.positionOffset;
+			}
+			else {
+				memcpy(&mesh.positions[i], attribute_pointer(PositionAttribute, i), sizeof(glm::vec3));
+			}
+
+			if (texture_coordinates_encoding::float16 == format.textureCoordinates) {
+				uint16_t value[2];
+				memcpy(value, attribute_pointer(TextureCoordinatesAttribute, i), sizeof(value));
+				mesh.textureCoordinates[i] = glm::vec2(glm::unpackHalf1x16(value[0]), glm::unpackHalf1x16(value[1]));
+			}
+			else {
+				memcpy(&mesh.textureCoordinates[i], attribute_pointer(TextureCoordinatesAttribute, i), sizeof(glm::vec2));
+			}
+
+			if (normal_encoding::octahedral_snorm16 == format.normals) {
+				int16_t value[2];
+				memcpy(value, attribute_pointer(NormalAttribute, i), sizeof(value));
+				mesh.normals[i] = decode_octahedral(glm::vec2(from_snorm(value[0], 32767.0f), from_snorm(value[1], 32767.0f)));
+			}
+			else if (normal_encoding::octahedral_snorm8 == format.normals) {
+				int8_t value[2];
+				memcpy(value, attribute_pointer(NormalAttribute, i), sizeof(value));
+				mesh.normals[i] = decode_octahedral(glm::vec2(from_snorm(value[0], 127.0f), from_snorm(value[1], 127.0f)));
+			}
+			else {
+				memcpy(&mesh.normals[i], attribute_pointer(NormalAttribute, i), sizeof(glm::vec3));
+			}
+		}
+		return mesh;
+	}
+
+	vertex_format_report measure_vertex_format(const mesh_data& mesh, const vertex_format& format)
+	{
+		const auto encoded = helpers::encode_vertices(mesh, format);
+		const auto decoded = helpers::decode_vertices(encoded);
+
+		vertex_format_report report;
+		report.format = format;
+		report.bytesPerVertex = helpers::get_bytes_per_vertex(format);
+		report.totalBytes = encoded.data.size();
+
+		float maxTextureCoordinate = 0.0f;
+		for (size_t i = 0; i < encoded.vertexCount; ++i) {
+			report.maxPositionError = std::max(report.maxPositionError, glm::length(decoded.positions[i] - mesh.positions[i]));
+
+			const auto uvError = glm::abs(decoded.textureCoordinates[i] - mesh.textureCoordinates[i]);
+			report.maxTextureCoordinatesError = std::max(report.maxTextureCoordinatesError, std::max(uvError.x, uvError.y));
+			maxTextureCoordinate = std::max(maxTextureCoordinate, std::max(std::abs(mesh.textureCoordinates[i].x), std::abs(mesh.textureCoordinates[i].y)));
+
+			const auto length = glm::length(mesh.normals[i]);
+			if (length > 0.0f) {
+				// atan2 instead of acos, which is imprecise for small angles:
+				const auto original = mesh.normals[i] / length;
+				const auto angle = std::atan2(glm::length(glm::cross(original, decoded.normals[i])), glm::dot(original, decoded.normals[i]));
+				report.maxNormalErrorDegrees = std::max(report.maxNormalErrorDegrees, glm::degrees(angle));
+			}
+		}
+
+		// Rounding to the nearest representable value is off by at most half a step:
+		if (position_encoding::snorm16 == format.positions) {
+			report.positionErrorBound = glm::length(encoded.positionScale) * 0.5f / 32767.0f;
+		}
+		if (texture_coordinates_encoding::float16 == format.textureCoordinates) {
+			// 11 significant bits => relative error of at most 2^-11 (and 2^-25 for subnormal values)
+			report.textureCoordinatesErrorBound = std::max(maxTextureCoordinate * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25));
+		}
+		return report;
+	}
+
+	void print_vertex_format_reports(std::ostream& stream, const std::vector<vertex_format_report>& reports)
+	{
+		for (const auto& report : reports) {
+			stream << to_string(report.format) << ":\n"
+				<< "  " << report.bytesPerVertex << " bytes per vertex, " << report.totalBytes << " bytes in total\n"
+				<< "  position error:            max " << report.maxPositionError << " (bound " << report.positionErrorBound << ")\n"
+				<< "  texture coordinates error: max " << report.maxTextureCoordinatesError << " (bound " << report.textureCoordinatesErrorBound << ")\n"
+				<< "  normal error:              max " << report.maxNormalErrorDegrees << " degrees\n";
+		}
+		stream.flush();
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+namespace helpers
+{
+	struct mesh_data;
+
+	// How the vertex attributes are distributed over vertex buffer bindings
+	enum struct vertex_layout
+	{
+		separate_streams,	// One binding per attribute (structure of arrays)
+		interleaved			// One binding which contains all attributes (array of structures)
+	};
+
+	enum struct position_encoding
+	{
+		float32,			// R32G32B32_SFLOAT, 12 bytes
+		snorm16				// R16G16B16A16_SNORM, 8 bytes. Dequantize in the shader: position = value.xyz * positionScale + positionOffset
+	};
+
+	enum struct texture_coordinates_encoding
+	{
+		float32,			// R32G32_SFLOAT, 8 bytes
+		float16				// R16G16_SFLOAT, 4 bytes. The shader gets a vec2 as usual.
+	};
+
+	// Octahedral normals (Cigolle et al.: "A Survey of Efficient Representations for Independent Unit Vectors", 2014)
+	// are decoded in the shader like follows:
+	//   vec3 n = vec3(value.xy, 1.0 - abs(value.x) - abs(value.y));
+	//   float t = max(-n.z, 0.0);
+	//   n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	//   n = normalize(n);
+	enum struct normal_encoding
+	{
+		float32,			// R32G32B32_SFLOAT, 12 bytes
+		octahedral_snorm16,	// R16G16_SNORM, 4 bytes
+		octahedral_snorm8	// R8G8_SNORM, 2 bytes
+	};
+
+	// Layout and encoding of a mesh's vertex data. Attribute locations are always
+	// 0 = position, 1 = texture coordinates, 2 = normal.
+	struct vertex_format
+	{
+		vertex_layout layout = vertex_layout::separate_streams;
+		position_encoding positions = position_encoding::float32;
+		texture_coordinates_encoding textureCoordinates = texture_coordinates_encoding::float32;
+		normal_encoding normals = normal_encoding::float32;
+	};
+
+	// Three full-float streams (32 bytes per vertex), which is what the loaders produce
+	vertex_format get_full_precision_vertex_format();
+
+	// Interleaved, 16-bit normalized positions, half-float texture coordinates, and 16-bit octahedral normals (16 bytes per vertex)
+	vertex_format get_compact_vertex_format();
+
+	// Human readable description, e.g. "interleaved pos:snorm16 uv:float16 nrm:oct16"
+	std::string to_string(const vertex_format& format);
+
+	// Size of one vertex over all bindings, in bytes
+	uint32_t get_bytes_per_vertex(const vertex_format& format);
+
+	// Get the vertex input descriptions for a pipeline that consumes vertex data in the given format.
+	// Bindings are numbered starting at <firstBinding>, in the order in which encoded_vertices stores them.
+	std::tuple<std::vector<vk::VertexInputBindingDescription>, std::vector<vk::VertexInputAttributeDescription>> get_vertex_input_descriptions(
+		const vertex_format& format,
+		const uint32_t firstBinding = 0u
+	);
+
+	// Vertex data in a given vertex_format, ready to be copied into a vertex buffer as is.
+	// All bindings are stored back to back in <data>, each of them starting at a 16-byte aligned offset.
+	struct encoded_vertices
+	{
+		vertex_format format;
+		size_t vertexCount = 0;
+		std::vector<uint8_t> data;
+		std::vector<size_t> bindingOffsets;		// Byte offset of each binding within <data>
+		glm::vec3 positionScale{ 1.0f };		// Dequantization transform for snorm16 positions
+		glm::vec3 positionOffset{ 0.0f };
+	};
+
+	// Encode the vertices of the given mesh (not its indices) into the given format
+	encoded_vertices encode_vertices(const mesh_data& mesh, const vertex_format& format);
+
+	// Decode encoded vertices back into full-float vertex data (without indices), the same way the GPU would
+	mesh_data decode_vertices(const encoded_vertices& encoded);
+
+	// Size and precision of a vertex format, measured on a specific mesh
+	struct vertex_format_report
+	{
+		vertex_format format;
+		uint32_t bytesPerVertex = 0;
+		size_t totalBytes = 0;
+		float maxPositionError = 0.0f;				// Largest distance between an original and a decoded position (in model units)
+		float positionErrorBound = 0.0f;			// Upper bound of the position error, given the mesh's dequantization transform
+		float maxTextureCoordinatesError = 0.0f;	// Largest absolute error of a texture coordinate component
+		float textureCoordinatesErrorBound = 0.0f;
+		float maxNormalErrorDegrees = 0.0f;			// Largest angle between an original and a decoded normal
+	};
+
+	// Encode the mesh into the given format, decode it again, and compare the result against the original vertices
+	vertex_format_report measure_vertex_format(const mesh_data& mesh, const vertex_format& format);
+
+	// Print a table with one row per report
+	void print_vertex_format_reports(std::ostream& stream, const std::vector<vertex_format_report>& reports);
+}
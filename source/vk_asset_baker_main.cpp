@@ -0,0 +1,248 @@
+#include "pch.h"
+
+// Offline asset baker: converts source assets into formats which can be loaded without parsing or decoding.
+//
+// Usage:
+//   vk_asset_baker mesh <model.obj> [<output.vkmesh>] [--non-indexed] [--exclude <submesh names>]
+//   vk_asset_baker vertex-formats <model.obj>
+//   vk_asset_baker lods <model.obj> [--levels <n>] [--reduction <r>] [--uv-weight <w>] [--normal-weight <w>] [--keep-seams]
+//   vk_asset_baker texture <image>... [--format rgba8|bc1|bc3|bc7] [--no-mipmaps]
+//
+// mesh: If no output path is given, the cache is written next to the model (see helpers::get_mesh_cache_path),
+//       which is where helpers::load_mesh_with_cache looks for it.
+// vertex-formats: Print the size and the precision of the candidate vertex formats for the given model.
+// lods: Generate a LOD chain for the given model (see helpers::generate_lod_chain), and print each level's triangle count
+//       and error, and from which distance on it is selected for a 1080p viewport with a 60 degree field of view.
+// texture: Encode the given images (default: bc7 with mipmaps), and write each one next to its source
+//          (see helpers::get_texture_file_path), which is where helpers::load_texture looks for it.
+//          The images are baked in parallel, e.g.: vk_asset_baker texture images/explosion02HD-frame*.tga
+
+namespace
+{
+	void print_usage()
+	{
+		std::cout << "Usage:\n"
+			<< "  vk_asset_baker mesh <model.obj> [<output.vkmesh>] [--non-indexed] [--exclude <submesh names>]\n"
+			<< "  vk_asset_baker vertex-formats <model.obj>\n"
+			<< "  vk_asset_baker lods <model.obj> [--levels <n>] [--reduction <r>] [--uv-weight <w>] [--normal-weight <w>] [--keep-seams]\n"
+			<< "  vk_asset_baker texture <image>... [--format rgba8|bc1|bc3|bc7] [--no-mipmaps]\n";
+	}
+
+	int bake_mesh(const std::vector<std::string>& args)
+	{
+		std::string modelPath, cachePath, submeshNamesToExclude;
+		bool indexed = true;
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "--non-indexed") {
+				indexed = false;
+			}
+			else if (args[i] == "--exclude" && i + 1 < args.size()) {
+				submeshNamesToExclude = args[++i];
+			}
+			else if (modelPath.empty()) {
+				modelPath = args[i];
+			}
+			else if (cachePath.empty()) {
+				cachePath = args[i];
+			}
+			else {
+				print_usage();
+				return 1;
+			}
+		}
+		if (modelPath.empty()) {
+			print_usage();
+			return 1;
+		}
+		if (cachePath.empty()) {
+			cachePath = helpers::get_mesh_cache_path(modelPath);
+		}
+
+		const auto begin = std::chrono::steady_clock::now();
+		helpers::bake_mesh_cache(modelPath, cachePath, submeshNamesToExclude, indexed);
+		const auto end = std::chrono::steady_clock::now();
+
+		std::cout << "Baked '" << modelPath << "' into '" << cachePath << "' (" << std::filesystem::file_size(cachePath) << " bytes) in "
+			<< std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << std::endl;
+		return 0;
+	}
+
+	int report_vertex_formats(const std::vector<std::string>& args)
+	{
+		if (1 != args.size()) {
+			print_usage();
+			return 1;
+		}
+
+		const auto mesh = helpers::load_indexed_mesh_data_of_obj(args[0]);
+		std::vector<helpers::vertex_format_report> reports;
+		for (const auto layout : { helpers::vertex_layout::separate_streams, helpers::vertex_layout::interleaved }) {
+			for (const auto& format : {
+					helpers::vertex_format{ layout, helpers::position_encoding::float32, helpers::texture_coordinates_encoding::float32, helpers::normal_encoding::float32 },
+					helpers::vertex_format{ layout, helpers::position_encoding::snorm16, helpers::texture_coordinates_encoding::float16, helpers::normal_encoding::octahedral_snorm16 },
+					helpers::vertex_format{ layout, helpers::position_encoding::snorm16, helpers::texture_coordinates_encoding::float16, helpers::normal_encoding::octahedral_snorm8 } }) {
+				reports.push_back(helpers::measure_vertex_format(mesh, format));
+			}
+		}
+
+		std::cout << "'" << args[0] << "': " << mesh.positions.size() << " vertices" << std::endl;
+		helpers::print_vertex_format_reports(std::cout, reports);
+		return 0;
+	}
+
+	int report_lods(const std::vector<std::string>& args)
+	{
+		std::string modelPath;
+		helpers::simplification_options options;
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "--levels" && i + 1 < args.size()) {
+				options.levelCount = static_cast<uint32_t>(std::max(1, std::stoi(args[++i])));
+			}
+			else if (args[i] == "--reduction" && i + 1 < args.size()) {
+				options.reductionPerLevel = std::clamp(std::stof(args[++i]), 0.01f, 0.99f);
+			}
+			else if (args[i] == "--uv-weight" && i + 1 < args.size()) {
+				options.textureCoordinatesWeight = std::stof(args[++i]);
+			}
+			else if (args[i] == "--normal-weight" && i + 1 < args.size()) {
+				options.normalsWeight = std::stof(args[++i]);
+			}
+			else if (args[i] == "--keep-seams") {
+				options.relaxSeams = false;
+			}
+			else if (modelPath.empty() && args[i].rfind("--", 0) != 0) {
+				modelPath = args[i];
+			}
+			else {
+				print_usage();
+				return 1;
+			}
+		}
+		if (modelPath.empty()) {
+			print_usage();
+			return 1;
+		}
+
+		const auto mesh = helpers::load_indexed_mesh_data_of_obj(modelPath);
+		const auto chain = helpers::generate_lod_chain(mesh, options);
+		std::cout << "'" << modelPath << "': " << mesh.positions.size() << " vertices, ";
+		helpers::print_lod_chain(std::cout, chain);
+
+		// The distance from which on each level is good enough for an error of at most one pixel:
+		const auto projectionScale = helpers::compute_projection_scale(glm::radians(60.0f), 1080u);
+		const auto radius = helpers::compute_bounding_sphere(mesh.positions).w;
+		std::cout << "Selected for an error of at most 1 pixel at 1080p, 60 degrees field of view (bounding sphere radius " << radius << "):" << std::endl;
+		for (size_t i = 1; i < chain.lods.size(); ++i) {
+			const auto distance = chain.lods[i].error * projectionScale + radius;
+			std::cout << "  LOD " << i << " from a distance of " << distance << " (" << radius / (distance - radius) * projectionScale * 2.0f
+				<< " pixels tall)" << std::endl;
+		}
+		return 0;
+	}
+
+	// Peak signal-to-noise ratio between two RGBA8 images of the same size, over all four channels, in dB
+	double compute_psnr(const uint8_t* a, const uint8_t* b, const size_t byteCount)
+	{
+		double squaredError = 0.0;
+		for (size_t i = 0; i < byteCount; ++i) {
+			const auto d = static_cast<double>(a[i]) - static_cast<double>(b[i]);
+			squaredError += d * d;
+		}
+		const auto meanSquaredError = squaredError / static_cast<double>(byteCount);
+		return meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+	}
+
+	int bake_textures(const std::vector<std::string>& args)
+	{
+		std::vector<std::string> imagePaths;
+		helpers::texture_bake_options options;
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "--format" && i + 1 < args.size()) {
+				options.encoding = helpers::parse_texture_encoding(args[++i]);
+			}
+			else if (args[i] == "--no-mipmaps") {
+				options.mipmaps = false;
+			}
+			else if (args[i].rfind("--", 0) == 0) {
+				print_usage();
+				return 1;
+			}
+			else {
+				imagePaths.push_back(args[i]);
+			}
+		}
+		if (imagePaths.empty()) {
+			print_usage();
+			return 1;
+		}
+
+		// One job per image; each of them encodes its blocks in parallel, too:
+		auto& threadPool = helpers::get_thread_pool();
+		std::vector<std::string> results(imagePaths.size());
+		std::atomic<uint64_t> totalTexels{ 0 };
+		const auto begin = std::chrono::steady_clock::now();
+		threadPool.parallel_for(imagePaths.size(), [&](const size_t i) {
+			const auto texturePath = helpers::get_texture_file_path(imagePaths[i]);
+			helpers::bake_texture_file(imagePaths[i], texturePath, options, threadPool);
+
+			// Measure the quality of level 0:
+			helpers::mapped_texture_file texture;
+			if (!helpers::try_map_texture_file(texturePath, texture)) {
+				throw std::runtime_error("Couldn't read back '" + texturePath + "'");
+			}
+			const auto& header = *texture.header;
+			const auto decoded = helpers::decode_texels(texture.file.data() + texture.levels[0].byteOffset, header.width, header.height, options.encoding, threadPool);
+			int width, height, channelsInFile;
+			stbi_uc* pixels = stbi_load(imagePaths[i].c_str(), &width, &height, &channelsInFile, STBI_rgb_alpha);
+			const auto psnr = compute_psnr(decoded.data(), pixels, decoded.size());
+			stbi_image_free(pixels);
+
+			std::ostringstream line;
+			line << "  '" << texturePath << "': " << header.width << "x" << header.height << ", " << header.levelCount << " levels, "
+				<< texture.file.size() << " bytes, PSNR of level 0: " << psnr << " dB";
+			results[i] = line.str();
+			totalTexels += static_cast<uint64_t>(header.width) * header.height;
+		});
+		const auto end = std::chrono::steady_clock::now();
+
+		for (const auto& line : results) {
+			std::cout << line << "\n";
+		}
+		const auto seconds = std::chrono::duration<double>(end - begin).count();
+		std::cout << "Baked " << imagePaths.size() << " images into " << helpers::to_string(options.encoding) << (options.mipmaps ? " with" : " without")
+			<< " mipmaps in " << seconds * 1000.0 << " ms (" << static_cast<double>(totalTexels) / seconds / 1.0e6 << " M texels/s, "
+			<< threadPool.thread_count() << " threads)" << std::endl;
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		print_usage();
+		return 1;
+	}
+
+	const std::string command = argv[1];
+	const std::vector<std::string> args(argv + 2, argv + argc);
+	try {
+		if (command == "mesh") {
+			return bake_mesh(args);
+		}
+		if (command == "vertex-formats") {
+			return report_vertex_formats(args);
+		}
+		if (command == "lods") {
+			return report_lods(args);
+		}
+		if (command == "texture") {
+			return bake_textures(args);
+		}
+		print_usage();
+		return 1;
+	}
+	catch (const std::exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,1064 @@
+#include "pch.h"
+
+// CPU benchmarks for the asset loading paths and for command recording, and a GPU culling benchmark. Only the recording
+// and culling benchmarks need a Vulkan device (a software driver such as lavapipe works, too).
+// Run it from the output directory, where the build copies the resources to.
+//
+// Usage:
+//   vk_benchmarks obj [<model.obj>] [--iterations <n>] [--threads <n>]
+//   vk_benchmarks indexed [<model.obj>] [--iterations <n>]
+//   vk_benchmarks images [<image>...] [--iterations <n>] [--threads <n>]
+//   vk_benchmarks recording [--draws <n>] [--iterations <n>] [--threads <n>]
+//   vk_benchmarks culling [--instances <n>] [--iterations <n>]
+//   vk_benchmarks render_graph [--iterations <n>]
+//   vk_benchmarks churn [--iterations <n>]
+//   vk_benchmarks flipbook [--iterations <n>]
+//   vk_benchmarks assets [--iterations <n>] [--threads <n>] [--json <path>]
+//
+// obj:    Compares loading an .obj file with tinyobj (helpers::load_mesh_data_of_obj) against the parallel
+//         parser (helpers::load_mesh_data_of_obj_parallel), and verifies that both produce identical results.
+// indexed: Loads an .obj file as an optimized, indexed mesh (helpers::load_indexed_mesh_data_of_obj: deduplication,
+//         Tipsify, vertex fetch reordering) <iterations> times. Verifies that all loads produce bit-identical vertex and
+//         index buffers, and that the ACMR after reordering is no higher than before.
+// images: Compares loading a batch of images into BGRA staging memory one after the other (stb_image, scalar swizzle,
+//         copy) against helpers::decode_images, and verifies that both produce identical results.
+//         Defaults to all frames of the explosion flipbook.
+// recording: Records the commands of <draws> draw calls into one frame, on a single thread into the primary command
+//         buffer, and with helpers::recording_scheduler on 1, 2, 4, ... threads (up to --threads, default: all hardware
+//         threads). Verifies that the commands of all draws have been executed.
+// culling: Frustum culls 1, 10, 100, ... instances (up to <instances>) with helpers::cull_instances on the CPU, and with
+//         helpers::instance_culler on the GPU. Prints both times and the CPU time it takes to record the GPU cull and the
+//         indirect draw, and verifies that the GPU has found the same visible instances as the CPU.
+// render_graph: Describes a deferred-shading-like frame (G-buffer, SSAO, lighting, bloom, tonemapping, plus a debug pass
+//         whose output nobody reads) with helpers::render_graph, and records it. The passes don't record any work, only
+//         the graph's barriers. Prints how many barriers and how much transient memory the graph needs, compared to one
+//         barrier call per image access and one allocation per transient image, and the CPU time of describing,
+//         compiling, and recording a frame.
+// churn:  Renders 30 * <iterations> frames with 3 frames in flight, each of which keeps the GPU busy and replaces one
+//         buffer (an "asset") with a new one. The replaced buffers are destroyed after device.waitIdle(), and with
+//         helpers::deletion_queue. Prints the frame times of both.
+// flipbook: Plays the explosion flipbook (100 frames) <iterations> times at 30 frames per second through a
+//         helpers::flipbook_streamer with 16 slots, rendering (empty) frames at 60 Hz with 2 frames in flight. Verifies
+//         that frames are uploaded, that few updates show a late frame and few decoded frames are discarded, and that
+//         the memory arena's texture memory stays at the 16 slots' array image throughout.
+// assets: Runs the CPU stages of asset loading on the bundled resources, without a Vulkan device: parsing the pod .obj
+//         with tinyobj and with the parallel parser (incl. the expansion into per-corner vertices), decoding the diffuse
+//         JPG, the PNGs, and the TGA frames of the explosion into BGRA, and reading the SPIR-V files of shaders/ (if
+//         the shaders have been built). Prints the throughput of each stage in MB/s of input files and in vertices,
+//         pixels, or SPIR-V words per second (of the fastest iteration), and the allocations per iteration. With --json,
+//         also writes these results to <path>, for tracking regressions. Allocations are counted by replacing the global
+//         operator new => stb_image's mallocs aren't counted.
+
+namespace
+{
+	const std::string DefaultModelPath = "models/hextraction_pod.obj";
+	const std::string DefaultImageDirectory = "images";
+	const std::string DefaultImagePrefix = "explosion02HD-frame";
+	constexpr uint32_t DefaultDrawCount = 20000;
+	constexpr uint32_t DefaultInstanceCount = 100000;
+
+	const std::string DefaultDiffuseTexturePath = "models/p_pod_diffuse.jpg";
+	const std::vector<std::string> DefaultPngPaths = { "images/black_white_lines.png", "images/checkerboard.png" };
+	const std::string ShaderDirectory = "shaders";
+
+	struct benchmark_options
+	{
+		std::vector<std::string> paths;
+		uint32_t iterations = 10;
+		uint32_t threads = 0;	// 0 => the process-wide thread pool
+		uint32_t draws = DefaultDrawCount;
+		uint32_t instances = DefaultInstanceCount;
+		std::string jsonPath;	// Empty => no JSON output
+	};
+
+	// Counted by the replacement of the global operator new below
+	std::atomic<uint64_t> gAllocationCount{ 0 };
+	std::atomic<uint64_t> gAllocatedBytes{ 0 };
+
+	struct allocation_counts
+	{
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+	};
+
+	allocation_counts get_allocation_counts()
+	{
+		return allocation_counts{ gAllocationCount.load(std::memory_order_relaxed), gAllocatedBytes.load(std::memory_order_relaxed) };
+	}
+
+	// Wall clock durations of the iterations of one benchmark, in milliseconds
+	struct benchmark_result
+	{
+		std::vector<double> durationsMs;
+
+		double min_ms() const { return *std::min_element(durationsMs.begin(), durationsMs.end()); }
+		double max_ms() const { return *std::max_element(durationsMs.begin(), durationsMs.end()); }
+		double mean_ms() const
+		{
+			double sum = 0.0;
+			for (auto d : durationsMs) {
+				sum += d;
+			}
+			return sum / static_cast<double>(durationsMs.size());
+		}
+	};
+
+	void print_usage()
+	{
+		std::cout << "Usage:\n"
+			<< "  vk_benchmarks obj [<model.obj>] [--iterations <n>] [--threads <n>]\n"
+			<< "  vk_benchmarks indexed [<model.obj>] [--iterations <n>]\n"
+			<< "  vk_benchmarks images [<image>...] [--iterations <n>] [--threads <n>]\n"
+			<< "  vk_benchmarks recording [--draws <n>] [--iterations <n>] [--threads <n>]\n"
+			<< "  vk_benchmarks culling [--instances <n>] [--iterations <n>]\n"
+			<< "  vk_benchmarks render_graph [--iterations <n>]\n"
+			<< "  vk_benchmarks churn [--iterations <n>]\n"
+			<< "  vk_benchmarks flipbook [--iterations <n>]\n"
+			<< "  vk_benchmarks assets [--iterations <n>] [--threads <n>] [--json <path>]\n";
+	}
+
+	bool parse_options(const std::vector<std::string>& args, benchmark_options& outOptions)
+	{
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "--iterations" && i + 1 < args.size()) {
+				outOptions.iterations = std::max(1, std::stoi(args[++i]));
+			}
+			else if (args[i] == "--threads" && i + 1 < args.size()) {
+				outOptions.threads = static_cast<uint32_t>(std::max(1, std::stoi(args[++i])));
+			}
+			else if (args[i] == "--draws" && i + 1 < args.size()) {
+				outOptions.draws = static_cast<uint32_t>(std::max(1, std::stoi(args[++i])));
+			}
+			else if (args[i] == "--instances" && i + 1 < args.size()) {
+				outOptions.instances = static_cast<uint32_t>(std::max(1, std::stoi(args[++i])));
+			}
+			else if (args[i] == "--json" && i + 1 < args.size()) {
+				outOptions.jsonPath = args[++i];
+			}
+			else if (args[i].rfind("--", 0) == 0) {
+				return false;
+			}
+			else {
+				outOptions.paths.push_back(args[i]);
+			}
+		}
+		return true;
+	}
+
+	template <typename F>
+	benchmark_result run_benchmark(const uint32_t iterations, F&& func)
+	{
+		benchmark_result result;
+		for (uint32_t i = 0; i < iterations; ++i) {
+			const auto begin = std::chrono::steady_clock::now();
+			func();
+			const auto end = std::chrono::steady_clock::now();
+			result.durationsMs.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+		}
+		return result;
+	}
+
+	template <typename T>
+	bool are_bit_identical(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || 0 == memcmp(a.data(), b.data(), sizeof(T) * a.size()));
+	}
+
+	void print_result(const std::string& name, const benchmark_result& result, const double megabytes, const double itemCount, const std::string& itemUnit)
+	{
+		std::cout << "  " << name << ": min " << result.min_ms() << " ms, mean " << result.mean_ms() << " ms, "
+			<< megabytes / (result.min_ms() / 1000.0) << " MB/s, "
+			<< itemCount / (result.min_ms() / 1000.0) << " " << itemUnit << "/s" << std::endl;
+	}
+
+	// Without validation layers, which would dominate the recording times. Vulkan 1.1, like the workshop's instances,
+	// for vkGetPhysicalDeviceMemoryProperties2 (memory budgets, see helpers::memory_arena):
+	vk::Instance create_benchmark_instance()
+	{
+		const auto appInfo = vk::ApplicationInfo{}.setApiVersion(VK_API_VERSION_1_1);
+		return vk::createInstance(vk::InstanceCreateInfo{}.setPApplicationInfo(&appInfo));
+	}
+
+	// The thread pool to run a benchmark on: a dedicated one, if a thread count has been requested
+	helpers::thread_pool& get_benchmark_thread_pool(const benchmark_options& options, std::unique_ptr<helpers::thread_pool>& ownThreadPool)
+	{
+		if (0 != options.threads) {
+			ownThreadPool = std::make_unique<helpers::thread_pool>(options.threads);
+		}
+		return ownThreadPool ? *ownThreadPool : helpers::get_thread_pool();
+	}
+
+	int benchmark_obj(const benchmark_options& options)
+	{
+		const auto modelPath = options.paths.empty() ? DefaultModelPath : options.paths.front();
+		std::unique_ptr<helpers::thread_pool> ownThreadPool;
+		auto& threadPool = get_benchmark_thread_pool(options, ownThreadPool);
+		const auto megabytes = static_cast<double>(std::filesystem::file_size(modelPath)) / (1024.0 * 1024.0);
+
+		helpers::mesh_data reference, parallel;
+		const auto tinyobjResult = run_benchmark(options.iterations, [&]() {
+			reference = helpers::load_mesh_data_of_obj(modelPath);
+		});
+		const auto parallelResult = run_benchmark(options.iterations, [&]() {
+			parallel = helpers::load_mesh_data_of_obj_parallel(modelPath, "", threadPool);
+		});
+
+		const bool identical = are_bit_identical(reference.positions, parallel.positions)
+			&& are_bit_identical(reference.textureCoordinates, parallel.textureCoordinates)
+			&& are_bit_identical(reference.normals, parallel.normals);
+
+		std::cout << "obj: '" << modelPath << "' (" << megabytes << " MB, " << reference.positions.size() << " vertices), "
+			<< options.iterations << " iterations, " << threadPool.thread_count() << " threads" << std::endl;
+		print_result("tinyobj ", tinyobjResult, megabytes, reference.positions.size() / 1.0e6, "M vertices");
+		print_result("parallel", parallelResult, megabytes, parallel.positions.size() / 1.0e6, "M vertices");
+		std::cout << "  speedup: " << tinyobjResult.min_ms() / parallelResult.min_ms() << "x, results "
+			<< (identical ? "are bit-identical" : "DIFFER") << std::endl;
+		return identical ? 0 : 1;
+	}
+
+	int benchmark_indexed(const benchmark_options& options)
+	{
+		const auto modelPath = options.paths.empty() ? DefaultModelPath : options.paths.front();
+		const auto megabytes = static_cast<double>(std::filesystem::file_size(modelPath)) / (1024.0 * 1024.0);
+
+		// The first load is the reference, which all the others must reproduce exactly:
+		helpers::mesh_optimization_report report;
+		const auto reference = helpers::load_indexed_mesh_data_of_obj(modelPath, "", &report);
+		helpers::mesh_data mesh;
+		helpers::mesh_optimization_report meshReport;
+		bool deterministic = true;
+		const auto result = run_benchmark(options.iterations, [&]() {
+			mesh = helpers::load_indexed_mesh_data_of_obj(modelPath, "", &meshReport);
+			deterministic = deterministic
+				&& are_bit_identical(reference.positions, mesh.positions)
+				&& are_bit_identical(reference.textureCoordinates, mesh.textureCoordinates)
+				&& are_bit_identical(reference.normals, mesh.normals)
+				&& are_bit_identical(reference.indices, mesh.indices);
+		});
+
+		// The reordering must never make the cache behaviour worse, and the report must match the final index buffer:
+		const bool acmrImproved = report.acmrAfter <= report.acmrBefore;
+		const bool acmrMatches = helpers::compute_acmr(reference.indices, report.cacheSize) == report.acmrAfter;
+
+		std::cout << "indexed: '" << modelPath << "' (" << megabytes << " MB, " << report.cornerCount << " corners => "
+			<< report.vertexCount << " vertices, " << reference.indices.size() / 3 << " triangles), " << options.iterations << " iterations" << std::endl;
+		std::cout << "  load+optimize: min " << result.min_ms() << " ms, mean " << result.mean_ms() << " ms, "
+			<< megabytes / (result.min_ms() / 1000.0) << " MB/s, "
+			<< static_cast<double>(report.cornerCount) / (result.min_ms() / 1000.0) / 1.0e6 << " M corners/s" << std::endl;
+		std::cout << "  ACMR (cache size " << report.cacheSize << "): " << report.acmrBefore << " before, " << report.acmrAfter << " after reordering"
+			<< (acmrImproved ? "" : " -- WORSE") << (acmrMatches ? "" : ", report DIFFERS from the index buffer") << std::endl;
+		std::cout << "  vertex and index buffers " << (deterministic ? "are bit-identical across all loads" : "DIFFER between loads") << std::endl;
+		return deterministic && acmrImproved && acmrMatches ? 0 : 1;
+	}
+
+	int benchmark_images(const benchmark_options& options)
+	{
+		const auto imagePaths = options.paths.empty()
+			? helpers::get_flipbook_frame_paths(DefaultImageDirectory, DefaultImagePrefix)
+			: options.paths;
+		std::unique_ptr<helpers::thread_pool> ownThreadPool;
+		auto& threadPool = get_benchmark_thread_pool(options, ownThreadPool);
+
+		// Stand-ins for the staging buffers, allocated once, s.t. only decoding is measured:
+		std::vector<helpers::image_info> infos;
+		size_t totalSize = 0;
+		for (const auto& path : imagePaths) {
+			infos.push_back(helpers::get_image_info(path));
+			totalSize += static_cast<size_t>(infos.back().width) * infos.back().height * 4;
+		}
+		std::vector<std::vector<uint8_t>> reference(imagePaths.size()), batch(imagePaths.size());
+		for (size_t i = 0; i < imagePaths.size(); ++i) {
+			reference[i].resize(static_cast<size_t>(infos[i].width) * infos[i].height * 4);
+			batch[i].resize(reference[i].size());
+		}
+		const auto megabytes = static_cast<double>(totalSize) / (1024.0 * 1024.0);
+
+		// What load_image_into_host_coherent_buffer used to do, one image after the other:
+		const auto sequentialResult = run_benchmark(options.iterations, [&]() {
+			for (size_t i = 0; i < imagePaths.size(); ++i) {
+				int width, height, channelsInFile;
+				stbi_uc* pixels = stbi_load(imagePaths[i].c_str(), &width, &height, &channelsInFile, STBI_rgb_alpha);
+				if (nullptr == pixels) {
+					throw std::runtime_error("Couldn't load image from '" + imagePaths[i] + "'");
+				}
+				const size_t imageDataSize = static_cast<size_t>(width) * height * STBI_rgb_alpha;
+				for (size_t t = 0; t < imageDataSize; t += STBI_rgb_alpha) {
+					std::swap(pixels[t], pixels[t + 2]);
+				}
+				memcpy(reference[i].data(), pixels, imageDataSize);
+				stbi_image_free(pixels);
+			}
+		});
+
+		std::vector<helpers::decoded_image> decoded;
+		const auto batchResult = run_benchmark(options.iterations, [&]() {
+			decoded = helpers::decode_images(imagePaths, helpers::texel_order::bgra, [&](const size_t i, const helpers::image_info&) {
+				return batch[i].data();
+			}, threadPool);
+		});
+
+		bool identical = true;
+		for (size_t i = 0; i < imagePaths.size(); ++i) {
+			identical = identical && reference[i] == batch[i];
+		}
+
+		// Per-image decode times of the last batch:
+		benchmark_result perImage;
+		for (const auto& image : decoded) {
+			perImage.durationsMs.push_back(image.decodeMs);
+		}
+
+		std::cout << "images: " << imagePaths.size() << " images (" << megabytes << " MB decoded), "
+			<< options.iterations << " iterations, " << threadPool.thread_count() << " threads" << std::endl;
+		print_result("sequential", sequentialResult, megabytes, static_cast<double>(imagePaths.size()), "images");
+		print_result("batch     ", batchResult, megabytes, static_cast<double>(imagePaths.size()), "images");
+		std::cout << "  per image: min " << perImage.min_ms() << " ms, mean " << perImage.mean_ms() << " ms, max " << perImage.max_ms() << " ms" << std::endl;
+		std::cout << "  speedup: " << sequentialResult.min_ms() / batchResult.min_ms() << "x, results "
+			<< (identical ? "are bit-identical" : "DIFFER") << std::endl;
+		return identical ? 0 : 1;
+	}
+
+	// One CPU stage of asset loading, measured by benchmark_assets
+	struct asset_stage_result
+	{
+		std::string name;
+		benchmark_result timings;
+		double megabytes = 0.0;			// Of the input files, per iteration
+		double items = 0.0;				// Per iteration
+		std::string itemUnit;
+		double allocationsPerIteration = 0.0;
+		double allocatedBytesPerIteration = 0.0;
+	};
+
+	template <typename F>
+	asset_stage_result run_asset_stage(const std::string& name, const uint32_t iterations, const double megabytes, const double items, const std::string& itemUnit, F&& func)
+	{
+		asset_stage_result stage;
+		stage.name = name;
+		stage.megabytes = megabytes;
+		stage.items = items;
+		stage.itemUnit = itemUnit;
+		const auto before = get_allocation_counts();
+		stage.timings = run_benchmark(iterations, std::forward<F>(func));
+		const auto after = get_allocation_counts();
+		stage.allocationsPerIteration = static_cast<double>(after.allocations - before.allocations) / iterations;
+		stage.allocatedBytesPerIteration = static_cast<double>(after.bytes - before.bytes) / iterations;
+
+		print_result(name, stage.timings, megabytes, items / 1.0e6, "M " + itemUnit);
+		std::cout << "    " << stage.allocationsPerIteration << " allocations (" << stage.allocatedBytesPerIteration / 1024.0 << " KiB) per iteration" << std::endl;
+		return stage;
+	}
+
+	double get_file_megabytes(const std::vector<std::string>& paths)
+	{
+		uintmax_t bytes = 0;
+		for (const auto& path : paths) {
+			bytes += std::filesystem::file_size(path);
+		}
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+	void write_asset_results_json(const std::string& path, const benchmark_options& options, const uint32_t threadCount, const std::vector<asset_stage_result>& stages)
+	{
+		std::ofstream stream(path, std::ios::trunc);
+		if (!stream.is_open()) {
+			throw std::runtime_error("Couldn't open '" + path + "' for writing");
+		}
+
+		// Throughputs refer to the fastest iteration, like the printed ones:
+		stream << "{\n\"benchmark\":\"assets\",\"iterations\":" << options.iterations << ",\"threads\":" << threadCount << ",\n\"stages\":[";
+		stream << std::fixed << std::setprecision(3);
+		for (size_t i = 0; i < stages.size(); ++i) {
+			const auto& s = stages[i];
+			const auto seconds = s.timings.min_ms() / 1000.0;
+			stream << (0 == i ? "\n" : ",\n")
+				<< "{\"name\":\"" << s.name << "\",\"min_ms\":" << s.timings.min_ms() << ",\"mean_ms\":" << s.timings.mean_ms()
+				<< ",\"max_ms\":" << s.timings.max_ms() << ",\"megabytes\":" << s.megabytes << ",\"mb_per_s\":" << s.megabytes / seconds
+				<< ",\"items\":" << s.items << ",\"item_unit\":\"" << s.itemUnit << "\",\"items_per_s\":" << s.items / seconds
+				<< ",\"allocations_per_iteration\":" << s.allocationsPerIteration
+				<< ",\"allocated_bytes_per_iteration\":" << s.allocatedBytesPerIteration << "}";
+		}
+		stream << "\n]}\n";
+		if (!stream.good()) {
+			throw std::runtime_error("Couldn't write '" + path + "'");
+		}
+	}
+
+	int benchmark_assets(const benchmark_options& options)
+	{
+		std::unique_ptr<helpers::thread_pool> ownThreadPool;
+		auto& threadPool = get_benchmark_thread_pool(options, ownThreadPool);
+		std::cout << "assets: " << options.iterations << " iterations, " << threadPool.thread_count() << " threads" << std::endl;
+		std::vector<asset_stage_result> stages;
+
+		// .obj: tinyobj plus the expansion into per-corner vertices, and the parallel parser which the loaders use
+		{
+			const auto megabytes = get_file_megabytes({ DefaultModelPath });
+			const auto vertexCount = static_cast<double>(helpers::load_mesh_data_of_obj(DefaultModelPath).positions.size());
+			helpers::mesh_data mesh;
+			stages.push_back(run_asset_stage("obj_tinyobj", options.iterations, megabytes, vertexCount, "vertices", [&]() {
+				mesh = helpers::load_mesh_data_of_obj(DefaultModelPath);
+			}));
+			stages.push_back(run_asset_stage("obj_parallel", options.iterations, megabytes, vertexCount, "vertices", [&]() {
+				mesh = helpers::load_mesh_data_of_obj_parallel(DefaultModelPath, "", threadPool);
+			}));
+		}
+
+		// Images: what load_image_into_host_coherent_buffer does after creating the staging buffer, one image after the
+		// other. The staging buffers are stand-ins, allocated once, s.t. only decoding (and swizzling) is measured.
+		const auto decodeStage = [&](const std::string& name, const std::vector<std::string>& imagePaths) {
+			std::vector<std::vector<uint8_t>> staging(imagePaths.size());
+			double pixelCount = 0.0;
+			for (size_t i = 0; i < imagePaths.size(); ++i) {
+				const auto info = helpers::get_image_info(imagePaths[i]);
+				staging[i].resize(static_cast<size_t>(info.width) * info.height * 4);
+				pixelCount += static_cast<double>(info.width) * info.height;
+			}
+			stages.push_back(run_asset_stage(name, options.iterations, get_file_megabytes(imagePaths), pixelCount, "pixels", [&]() {
+				for (size_t i = 0; i < imagePaths.size(); ++i) {
+					const auto info = helpers::get_image_info(imagePaths[i]);
+					helpers::decode_image(imagePaths[i], info, helpers::texel_order::bgra, staging[i].data());
+				}
+			}));
+		};
+		decodeStage("decode_jpg", { DefaultDiffuseTexturePath });
+		decodeStage("decode_png", DefaultPngPaths);
+		decodeStage("decode_tga", helpers::get_flipbook_frame_paths(DefaultImageDirectory, DefaultImagePrefix));
+
+		// SPIR-V: only available in the output directory, after the shaders have been compiled
+		std::vector<std::string> shaderPaths;
+		if (std::filesystem::is_directory(ShaderDirectory)) {
+			for (const auto& entry : std::filesystem::directory_iterator(ShaderDirectory)) {
+				if (entry.is_regular_file() && entry.path().extension() == ".spv") {
+					shaderPaths.push_back(entry.path().string());
+				}
+			}
+		}
+		if (shaderPaths.empty()) {
+			std::cout << "  spirv_read: skipped, no .spv files in '" << ShaderDirectory << "'" << std::endl;
+		}
+		else {
+			std::sort(shaderPaths.begin(), shaderPaths.end());
+			const auto megabytes = get_file_megabytes(shaderPaths);
+			const auto wordCount = megabytes * 1024.0 * 1024.0 / sizeof(uint32_t);
+			size_t wordsRead = 0;
+			stages.push_back(run_asset_stage("spirv_read", options.iterations, megabytes, wordCount, "words", [&]() {
+				for (const auto& path : shaderPaths) {
+					wordsRead += helpers::read_spirv_file(path).size();
+				}
+			}));
+		}
+
+		if (!options.jsonPath.empty()) {
+			write_asset_results_json(options.jsonPath, options, threadPool.thread_count(), stages);
+			std::cout << "  results written to '" << options.jsonPath << "'" << std::endl;
+		}
+		return 0;
+	}
+
+	// What the recording benchmark records its draws with
+	struct recording_resources
+	{
+		vk::PipelineLayout pipelineLayout;
+		vk::Buffer vertexBuffer;
+		vk::Buffer indexBuffer;
+		vk::Buffer resultBuffer;		// One uint32_t per draw
+		helpers::memory_allocation vertexMemory, indexMemory, resultMemory;
+	};
+
+	// A stand-in for the commands of one draw call: the state changes of a typical draw, followed by a tiny transfer
+	// command instead of the draw itself (which would need a render pass, a framebuffer and a pipeline). Each draw
+	// writes its index into its own element of the result buffer, s.t. it can be verified that all draws have been executed.
+	void record_draw(const vk::CommandBuffer commandBuffer, const recording_resources& resources, const size_t drawIndex)
+	{
+		const auto modelMatrix = glm::translate(glm::mat4{ 1.0f }, glm::vec3{ static_cast<float>(drawIndex % 100), static_cast<float>(drawIndex / 100), 0.0f });
+		const auto offset = static_cast<vk::DeviceSize>(drawIndex % 1024) * 64;
+		commandBuffer.pushConstants(resources.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0u, sizeof(modelMatrix), &modelMatrix);
+		commandBuffer.bindVertexBuffers(0u, { resources.vertexBuffer }, { offset });
+		commandBuffer.bindIndexBuffer(resources.indexBuffer, offset, vk::IndexType::eUint32);
+		commandBuffer.setScissor(0u, { vk::Rect2D{ vk::Offset2D{ 0, 0 }, vk::Extent2D{ 800u, 800u } } });
+		commandBuffer.fillBuffer(resources.resultBuffer, static_cast<vk::DeviceSize>(drawIndex) * 4, 4, static_cast<uint32_t>(drawIndex));
+	}
+
+	int benchmark_recording(const benchmark_options& options)
+	{
+		const auto drawCount = static_cast<size_t>(options.draws);
+		const auto maxThreads = 0 != options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+		// Without validation layers, which would dominate the recording times:
+		auto vkInst = create_benchmark_instance();
+		const auto physicalDevices = vkInst.enumeratePhysicalDevices();
+		if (physicalDevices.empty()) {
+			throw std::runtime_error("No Vulkan device found");
+		}
+		const auto physicalDevice = physicalDevices.front();
+		auto device = helpers::create_logical_device(physicalDevice, VK_NULL_HANDLE);
+		auto [queueFamilyIndex, queue] = helpers::get_queue_on_logical_device(physicalDevice, VK_NULL_HANDLE, device);
+
+		recording_resources resources;
+		const auto pushConstantRange = vk::PushConstantRange{ vk::ShaderStageFlagBits::eVertex, 0u, sizeof(glm::mat4) };
+		resources.pipelineLayout = device.createPipelineLayout(vk::PipelineLayoutCreateInfo{}
+			.setPushConstantRangeCount(1u)
+			.setPPushConstantRanges(&pushConstantRange)
+		);
+		std::tie(resources.vertexBuffer, resources.vertexMemory) = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, 1024 * 64, vk::BufferUsageFlagBits::eVertexBuffer);
+		std::tie(resources.indexBuffer, resources.indexMemory) = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, 1024 * 64, vk::BufferUsageFlagBits::eIndexBuffer);
+		std::tie(resources.resultBuffer, resources.resultMemory) = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, drawCount * 4, vk::BufferUsageFlagBits::eTransferDst);
+
+		auto primaryCommandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}
+			.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(queueFamilyIndex)
+		);
+		auto primaryCommandBuffer = helpers::allocate_command_buffer(device, primaryCommandPool);
+
+		// Record one frame, either sequentially into the primary command buffer, or with the given recording scheduler:
+		auto recordFrame = [&](helpers::recording_scheduler* recorder) {
+			device.resetCommandPool(primaryCommandPool, vk::CommandPoolResetFlags{});
+			primaryCommandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+			if (nullptr == recorder) {
+				for (size_t i = 0; i < drawCount; ++i) {
+					record_draw(primaryCommandBuffer, resources, i);
+				}
+			}
+			else {
+				recorder->begin_frame();
+				recorder->record(primaryCommandBuffer, drawCount, [&](const vk::CommandBuffer commandBuffer, const size_t begin, const size_t end) {
+					for (auto i = begin; i < end; ++i) {
+						record_draw(commandBuffer, resources, i);
+					}
+				});
+			}
+			primaryCommandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+				{ vk::MemoryBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead } }, {}, {});
+			primaryCommandBuffer.end();
+		};
+
+		// Execute the frame which has been recorded last, and check that every draw has written its index:
+		auto verifyFrame = [&]() {
+			auto results = static_cast<uint32_t*>(resources.resultMemory.mappedData);
+			std::fill(results, results + drawCount, std::numeric_limits<uint32_t>::max());
+			queue.submit({ vk::SubmitInfo{}.setCommandBufferCount(1u).setPCommandBuffers(&primaryCommandBuffer) }, nullptr);
+			queue.waitIdle();
+			for (size_t i = 0; i < drawCount; ++i) {
+				if (results[i] != static_cast<uint32_t>(i)) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		std::cout << "recording: " << drawCount << " draws per frame, " << options.iterations << " iterations, on '"
+			<< physicalDevice.getProperties().deviceName << "'" << std::endl;
+		const auto sequentialResult = run_benchmark(options.iterations, [&]() { recordFrame(nullptr); });
+		bool allExecuted = verifyFrame();
+		const auto drawsInMillions = static_cast<double>(drawCount) / 1.0e6;
+		std::cout << "  sequential:    min " << sequentialResult.min_ms() << " ms, mean " << sequentialResult.mean_ms() << " ms, "
+			<< drawsInMillions / (sequentialResult.min_ms() / 1000.0) << " M draws/s" << std::endl;
+
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2) {
+			threadCounts.push_back(threads);
+		}
+		threadCounts.push_back(maxThreads);
+		double singleThreadMs = 0.0;
+		for (const auto threads : threadCounts) {
+			// The calling thread participates in recording => <threads> - 1 pool threads:
+			helpers::thread_pool threadPool(std::max(1u, threads - 1));
+			helpers::recording_scheduler recorder(device, queueFamilyIndex, 1u, threadPool, threads);
+			const auto result = run_benchmark(options.iterations, [&]() { recordFrame(&recorder); });
+			allExecuted = verifyFrame() && allExecuted;
+			if (1 == threads) {
+				singleThreadMs = result.min_ms();
+			}
+			std::cout << "  " << std::setw(3) << threads << " threads:   min " << result.min_ms() << " ms, mean " << result.mean_ms() << " ms, "
+				<< drawsInMillions / (result.min_ms() / 1000.0) << " M draws/s, scaling " << singleThreadMs / result.min_ms() << "x" << std::endl;
+		}
+		std::cout << "  results: " << (allExecuted ? "all draws have been executed" : "DRAWS MISSING") << std::endl;
+
+		device.destroyCommandPool(primaryCommandPool);
+		device.destroyPipelineLayout(resources.pipelineLayout);
+		helpers::destroy_buffer(device, resources.vertexBuffer);
+		helpers::destroy_buffer(device, resources.indexBuffer);
+		helpers::destroy_buffer(device, resources.resultBuffer);
+		helpers::free_memory(device, resources.vertexMemory);
+		helpers::free_memory(device, resources.indexMemory);
+		helpers::free_memory(device, resources.resultMemory);
+		helpers::destroy_memory_arena(device);
+		helpers::destroy_logical_device(device);
+		helpers::destroy_vulkan_instance(vkInst);
+		return allExecuted ? 0 : 1;
+	}
+
+	// Instances of a unit sphere on a cubic grid around the origin, with varying scales. The culling benchmark looks
+	// at them from the origin, i.e. from the middle of the grid => only a fraction of them is visible.
+	std::vector<helpers::instance_data> generate_instances(const uint32_t count, float& outGridExtent)
+	{
+		const auto side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+		constexpr float Spacing = 4.0f;
+		outGridExtent = static_cast<float>(side) * Spacing;
+		std::vector<helpers::instance_data> instances(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			const auto cell = glm::vec3(static_cast<float>(i % side), static_cast<float>((i / side) % side), static_cast<float>(i / (side * side)));
+			const auto position = (cell - glm::vec3(static_cast<float>(side - 1) * 0.5f)) * Spacing;
+			const auto scale = 0.5f + static_cast<float>(i % 7) * 0.25f;
+			instances[i].model = glm::scale(glm::translate(glm::mat4{ 1.0f }, position), glm::vec3(scale));
+			instances[i].boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		return instances;
+	}
+
+	// Is the instance so close to one of the frustum's planes that the CPU's and the GPU's rounding may disagree about it?
+	bool is_on_frustum_boundary(const helpers::frustum& frustum, const helpers::instance_data& instance)
+	{
+		constexpr float Tolerance = 1.0e-3f;
+		std::vector<uint32_t> inner, outer;
+		auto shrunk = instance;
+		shrunk.boundingSphere.w = std::max(0.0f, instance.boundingSphere.w - Tolerance);
+		auto grown = instance;
+		grown.boundingSphere.w = instance.boundingSphere.w + Tolerance;
+		helpers::cull_instances(frustum, &shrunk, 1, inner);
+		helpers::cull_instances(frustum, &grown, 1, outer);
+		return inner.size() != outer.size();
+	}
+
+	int benchmark_culling(const benchmark_options& options)
+	{
+		// Without validation layers, which would dominate the recording times:
+		auto vkInst = create_benchmark_instance();
+		const auto physicalDevices = vkInst.enumeratePhysicalDevices();
+		if (physicalDevices.empty()) {
+			throw std::runtime_error("No Vulkan device found");
+		}
+		const auto physicalDevice = physicalDevices.front();
+		auto device = helpers::create_logical_device(physicalDevice, VK_NULL_HANDLE);
+		auto [queueFamilyIndex, queue] = helpers::get_queue_on_logical_device(physicalDevice, VK_NULL_HANDLE, device);
+
+		auto commandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}
+			.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(queueFamilyIndex)
+		);
+		auto commandBuffer = helpers::allocate_command_buffer(device, commandPool);
+		auto pipelineCache = std::make_unique<helpers::pipeline_cache>(physicalDevice, device, helpers::get_pipeline_cache_path(physicalDevice));
+		auto uploadEngine = std::make_unique<helpers::upload_engine>(physicalDevice, device, queueFamilyIndex, queue);
+
+		// The visible list, followed by the draw command:
+		const auto readbackSize = sizeof(uint32_t) * options.instances + sizeof(vk::DrawIndexedIndirectCommand);
+		auto [readbackBuffer, readbackMemory] = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, readbackSize, vk::BufferUsageFlagBits::eTransferDst);
+
+		std::vector<uint32_t> instanceCounts;
+		for (uint32_t count = 1; count < options.instances; count *= 10) {
+			instanceCounts.push_back(count);
+		}
+		instanceCounts.push_back(options.instances);
+
+		std::cout << "culling: up to " << options.instances << " instances, " << options.iterations << " iterations, on '"
+			<< physicalDevice.getProperties().deviceName << "'" << std::endl;
+		bool allMatch = true;
+		for (const auto count : instanceCounts) {
+			float gridExtent = 0.0f;
+			const auto instances = generate_instances(count, gridExtent);
+			const auto viewProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, gridExtent * 0.5f)
+				* glm::lookAt(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+			const auto frustum = helpers::extract_frustum_planes(viewProjection);
+
+			std::vector<uint32_t> cpuVisible;
+			cpuVisible.reserve(count);
+			const auto cpuResult = run_benchmark(options.iterations, [&]() {
+				helpers::cull_instances(frustum, instances.data(), instances.size(), cpuVisible);
+			});
+
+			// Nothing is drawn => the mesh's index count doesn't matter:
+			helpers::instance_culler culler(physicalDevice, device, *pipelineCache, count, 1u, 36u);
+			culler.upload_instances(*uploadEngine, instances);
+			uploadEngine->wait(uploadEngine->submit());
+
+			// A new profiler per instance count, s.t. each count gets its own statistics:
+			helpers::gpu_profiler profiler(physicalDevice, device, queueFamilyIndex, queue, 1u);
+			benchmark_result recordResult;
+			for (uint32_t i = 0; i <= options.iterations; ++i) {
+				device.resetCommandPool(commandPool, vk::CommandPoolResetFlags{});
+				commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+				profiler.begin_frame(commandBuffer); // Resolves the previous iteration
+				if (i < options.iterations) {
+					culler.begin_frame();
+					const auto begin = std::chrono::steady_clock::now();
+					{
+						auto scope = profiler.scope(commandBuffer, "cull");
+						culler.record_cull(commandBuffer, viewProjection);
+					}
+					const auto end = std::chrono::steady_clock::now();
+					recordResult.durationsMs.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+
+					commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {},
+						{ vk::MemoryBarrier{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead } }, {}, {});
+					commandBuffer.copyBuffer(culler.visible_instances_buffer(), readbackBuffer, { vk::BufferCopy{ 0, 0, sizeof(uint32_t) * count } });
+					commandBuffer.copyBuffer(culler.draw_command_buffer(), readbackBuffer, { vk::BufferCopy{ 0, sizeof(uint32_t) * options.instances, sizeof(vk::DrawIndexedIndirectCommand) } });
+					commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+						{ vk::MemoryBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead } }, {}, {});
+				}
+				commandBuffer.end();
+				queue.submit({ vk::SubmitInfo{}.setCommandBufferCount(1u).setPCommandBuffers(&commandBuffer) }, nullptr);
+				queue.waitIdle();
+			}
+
+			// Same set of instances as on the CPU? (In any order, apart from instances right on one of the planes.)
+			const auto readback = static_cast<const uint8_t*>(readbackMemory.mappedData);
+			vk::DrawIndexedIndirectCommand drawCommand;
+			memcpy(&drawCommand, readback + sizeof(uint32_t) * options.instances, sizeof(drawCommand));
+			std::vector<uint32_t> gpuVisible(std::min(drawCommand.instanceCount, count));
+			memcpy(gpuVisible.data(), readback, sizeof(uint32_t) * gpuVisible.size());
+			std::sort(gpuVisible.begin(), gpuVisible.end());
+			std::vector<uint32_t> differences;
+			std::set_symmetric_difference(cpuVisible.begin(), cpuVisible.end(), gpuVisible.begin(), gpuVisible.end(), std::back_inserter(differences));
+			const bool match = drawCommand.instanceCount <= count && std::all_of(differences.begin(), differences.end(), [&](const uint32_t index) {
+				return is_on_frustum_boundary(frustum, instances[index]);
+			});
+			allMatch = allMatch && match;
+
+			double gpuMs = 0.0;
+			for (const auto& scope : profiler.get_statistics()) {
+				if (scope.gpu && scope.name == "cull") {
+					gpuMs = scope.minMs;
+				}
+			}
+			std::cout << "  " << std::setw(7) << count << " instances (" << std::setw(6) << cpuVisible.size() << " visible): CPU min "
+				<< cpuResult.min_ms() << " ms, GPU min " << gpuMs << " ms, recording min " << recordResult.min_ms() * 1000.0 << " us, "
+				<< (match ? "results match" : "RESULTS DIFFER") << std::endl;
+		}
+		std::cout << "  results: " << (allMatch ? "the GPU has found the same visible instances" : "MISMATCH") << std::endl;
+
+		uploadEngine.reset();
+		pipelineCache.reset();
+		helpers::destroy_buffer(device, readbackBuffer);
+		helpers::free_memory(device, readbackMemory);
+		device.destroyCommandPool(commandPool);
+		helpers::destroy_memory_arena(device);
+		helpers::destroy_logical_device(device);
+		helpers::destroy_vulkan_instance(vkInst);
+		return allMatch ? 0 : 1;
+	}
+
+	// Describe a deferred-shading-like frame into <graph>, which ends up in <output>. Returns the number of image accesses.
+	uint32_t describe_deferred_frame(helpers::render_graph& graph, const vk::Image output, const uint32_t width, const uint32_t height)
+	{
+		using helpers::image_usage;
+		const auto target = graph.import_image(output, vk::Format::eR8G8B8A8Unorm, helpers::image_state{ vk::ImageLayout::eUndefined },
+			helpers::image_state{ vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead });
+		const auto albedo = graph.create_image({ width, height, vk::Format::eR8G8B8A8Unorm });
+		const auto normals = graph.create_image({ width, height, vk::Format::eR16G16B16A16Sfloat });
+		const auto depth = graph.create_image({ width, height, vk::Format::eD16Unorm });
+		const auto occlusion = graph.create_image({ width, height, vk::Format::eR8G8B8A8Unorm });
+		const auto hdr = graph.create_image({ width, height, vk::Format::eR16G16B16A16Sfloat });
+		const auto bloom = graph.create_image({ width / 2, height / 2, vk::Format::eR16G16B16A16Sfloat });
+		const auto debug = graph.create_image({ width, height, vk::Format::eR8G8B8A8Unorm });
+
+		uint32_t accessCount = 0;
+		const auto add_pass = [&](const std::string& name, std::vector<std::pair<helpers::render_graph_image, image_usage>> reads, std::vector<std::pair<helpers::render_graph_image, image_usage>> writes) {
+			accessCount += static_cast<uint32_t>(reads.size() + writes.size());
+			graph.add_pass(name, [&](helpers::render_graph_pass_builder& pass) {
+				for (const auto& r : reads) {
+					pass.read(r.first, r.second);
+				}
+				for (const auto& w : writes) {
+					pass.write(w.first, w.second);
+				}
+			}, nullptr);
+		};
+		add_pass("gbuffer", {}, { { albedo, image_usage::color_attachment }, { normals, image_usage::color_attachment }, { depth, image_usage::depth_stencil_attachment } });
+		add_pass("ssao", { { depth, image_usage::sampled_compute }, { normals, image_usage::sampled_compute } }, { { occlusion, image_usage::storage_write_compute } });
+		add_pass("lighting", { { albedo, image_usage::sampled_compute }, { normals, image_usage::sampled_compute }, { depth, image_usage::sampled_compute }, { occlusion, image_usage::sampled_compute } },
+			{ { hdr, image_usage::storage_write_compute } });
+		add_pass("debug_normals", { { normals, image_usage::sampled_compute } }, { { debug, image_usage::storage_write_compute } });
+		add_pass("bloom", { { hdr, image_usage::sampled_compute } }, { { bloom, image_usage::storage_write_compute } });
+		add_pass("tonemap", { { hdr, image_usage::sampled_compute }, { bloom, image_usage::sampled_compute } }, { { target, image_usage::storage_write_compute } });
+		return accessCount + 1; // + the final transition of the output
+	}
+
+	int benchmark_render_graph(const benchmark_options& options)
+	{
+		const uint32_t Width = 1920;
+		const uint32_t Height = 1080;
+
+		auto vkInst = create_benchmark_instance();
+		const auto physicalDevices = vkInst.enumeratePhysicalDevices();
+		if (physicalDevices.empty()) {
+			throw std::runtime_error("No Vulkan device found");
+		}
+		const auto physicalDevice = physicalDevices.front();
+		auto device = helpers::create_logical_device(physicalDevice, VK_NULL_HANDLE);
+		auto [queueFamilyIndex, queue] = helpers::get_queue_on_logical_device(physicalDevice, VK_NULL_HANDLE, device);
+
+		auto commandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}
+			.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(queueFamilyIndex)
+		);
+		auto commandBuffer = helpers::allocate_command_buffer(device, commandPool);
+		auto [output, outputMemory] = helpers::create_image(device, physicalDevice, Width, Height, vk::Format::eR8G8B8A8Unorm,
+			vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc, 1u, 1u, helpers::memory_category::render_target);
+		auto graph = std::make_unique<helpers::render_graph>(physicalDevice, device, 1u);
+
+		uint32_t accessCount = 0;
+		const auto result = run_benchmark(options.iterations, [&]() {
+			device.resetCommandPool(commandPool, vk::CommandPoolResetFlags{});
+			commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+			graph->reset();
+			accessCount = describe_deferred_frame(*graph, output, Width, Height);
+			graph->execute(commandBuffer);
+			commandBuffer.end();
+		});
+		queue.submit({ vk::SubmitInfo{}.setCommandBufferCount(1u).setPCommandBuffers(&commandBuffer) }, nullptr);
+		queue.waitIdle();
+
+		const auto stats = graph->get_statistics();
+		const bool debugCulled = graph->is_culled("debug_normals");
+		std::cout << "render_graph: " << Width << "x" << Height << ", " << options.iterations << " iterations, on '"
+			<< physicalDevice.getProperties().deviceName << "'" << std::endl;
+		std::cout << "  passes: " << stats.passes << ", culled: " << stats.culledPasses << (debugCulled ? " (debug_normals)" : "") << std::endl;
+		std::cout << "  barriers: " << stats.imageBarriers << " image barriers in " << stats.barrierCalls << " calls, instead of "
+			<< accessCount << " calls with one barrier per image access" << std::endl;
+		std::cout << "  transient memory: " << stats.transientBytesAllocated / (1024 * 1024) << " MiB in " << stats.transientMemoryBlocks
+			<< " blocks, instead of " << stats.transientBytesRequired / (1024 * 1024) << " MiB in " << stats.transientImages << " allocations" << std::endl;
+		std::cout << "  describe, compile, and record a frame: min " << result.min_ms() * 1000.0 << " us, mean " << result.mean_ms() * 1000.0
+			<< " us (last compile " << stats.compileMs * 1000.0 << " us, " << stats.transientRebuilds << " transient rebuilds)" << std::endl;
+
+		graph.reset();
+		helpers::destroy_image(device, output);
+		helpers::free_memory(device, outputMemory);
+		device.destroyCommandPool(commandPool);
+		helpers::destroy_memory_arena(device);
+		helpers::destroy_logical_device(device);
+		helpers::destroy_vulkan_instance(vkInst);
+		return debugCulled ? 0 : 1;
+	}
+
+	int benchmark_churn(const benchmark_options& options)
+	{
+		const uint32_t FramesInFlight = 3;
+		const vk::DeviceSize WorkBufferSize = 64ull * 1024ull * 1024ull;
+		const vk::DeviceSize AssetSize = 4ull * 1024ull * 1024ull;
+		const uint32_t FrameCount = 30 * options.iterations;
+
+		auto vkInst = create_benchmark_instance();
+		const auto physicalDevices = vkInst.enumeratePhysicalDevices();
+		if (physicalDevices.empty()) {
+			throw std::runtime_error("No Vulkan device found");
+		}
+		const auto physicalDevice = physicalDevices.front();
+		auto device = helpers::create_logical_device(physicalDevice, VK_NULL_HANDLE);
+		auto [queueFamilyIndex, queue] = helpers::get_queue_on_logical_device(physicalDevice, VK_NULL_HANDLE, device);
+		auto [workBuffer, workMemory] = helpers::create_device_local_buffer_and_memory(device, physicalDevice, static_cast<size_t>(WorkBufferSize), vk::BufferUsageFlagBits::eTransferDst);
+
+		std::cout << "churn: " << FrameCount << " frames, " << FramesInFlight << " frames in flight, one " << AssetSize / (1024 * 1024)
+			<< " MiB buffer replaced per frame, on '" << physicalDevice.getProperties().deviceName << "'" << std::endl;
+		bool allDestroyed = true;
+		for (const bool useDeletionQueue : { false, true }) {
+			auto frameScheduler = std::make_unique<helpers::frame_scheduler>(physicalDevice, device, queueFamilyIndex, FramesInFlight);
+			auto deletionQueue = std::make_unique<helpers::deletion_queue>(device);
+			std::tuple<vk::Buffer, helpers::memory_allocation> asset;
+			std::vector<double> frameTimesMs;
+			const auto begin = std::chrono::steady_clock::now();
+			for (uint32_t f = 0; f < FrameCount; ++f) {
+				const auto frameBegin = std::chrono::steady_clock::now();
+				auto& frame = frameScheduler->begin_frame();
+				deletionQueue->collect(frameScheduler->completed_frame_count());
+
+				// Replace the asset. The previous one may still be in use by the frames in flight:
+				if (std::get<vk::Buffer>(asset)) {
+					if (useDeletionQueue) {
+						deletionQueue->destroy_later(frameScheduler->frame_number(), std::get<vk::Buffer>(asset), std::get<helpers::memory_allocation>(asset));
+					}
+					else {
+						device.waitIdle();
+						helpers::destroy_buffer(device, std::get<vk::Buffer>(asset));
+						helpers::free_memory(device, std::get<helpers::memory_allocation>(asset));
+					}
+				}
+				asset = helpers::create_device_local_buffer_and_memory(device, physicalDevice, static_cast<size_t>(AssetSize), vk::BufferUsageFlagBits::eTransferDst);
+
+				frame.commandBuffer.fillBuffer(std::get<vk::Buffer>(asset), 0, VK_WHOLE_SIZE, f);
+				for (uint32_t i = 0; i < 4; ++i) {
+					frame.commandBuffer.fillBuffer(workBuffer, 0, VK_WHOLE_SIZE, f + i);
+				}
+				frameScheduler->submit_frame(queue);
+				frameTimesMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameBegin).count());
+			}
+			device.waitIdle();
+			const auto totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			const auto stats = deletionQueue->get_statistics();
+
+			helpers::destroy_buffer(device, std::get<vk::Buffer>(asset));
+			helpers::free_memory(device, std::get<helpers::memory_allocation>(asset));
+			deletionQueue->flush();
+			allDestroyed = allDestroyed && deletionQueue->get_statistics().destroyed == stats.enqueued;
+
+			std::sort(frameTimesMs.begin(), frameTimesMs.end());
+			std::cout << "  " << (useDeletionQueue ? "deletion queue" : "waitIdle      ") << ": " << totalMs / FrameCount << " ms per frame, p50 "
+				<< frameTimesMs[frameTimesMs.size() / 2] << " ms, p99 " << frameTimesMs[frameTimesMs.size() * 99 / 100] << " ms";
+			if (useDeletionQueue) {
+				std::cout << ", at most " << stats.peakPending << " buffers pending";
+			}
+			std::cout << std::endl;
+		}
+
+		helpers::destroy_buffer(device, workBuffer);
+		helpers::free_memory(device, workMemory);
+		helpers::destroy_memory_arena(device);
+		helpers::destroy_logical_device(device);
+		helpers::destroy_vulkan_instance(vkInst);
+		return allDestroyed ? 0 : 1;
+	}
+
+	// Live bytes of the memory arena's texture category, over all memory types
+	vk::DeviceSize get_texture_bytes(const vk::Device device)
+	{
+		vk::DeviceSize bytes = 0;
+		for (const auto& usage : helpers::get_memory_arena(device).get_telemetry().categories) {
+			if (helpers::memory_category::texture == usage.category) {
+				bytes += usage.bytes;
+			}
+		}
+		return bytes;
+	}
+
+	int benchmark_flipbook(const benchmark_options& options)
+	{
+		const uint32_t FramesInFlight = 2;
+		const uint32_t SlotCount = helpers::flipbook_streamer::DefaultSlotCount;
+		const uint32_t RenderFramesPerFlipbookFrame = 2;
+		const auto RenderFrameDuration = std::chrono::microseconds(16667);
+		// Until the first frames have been decoded, every update is late. Afterwards, the lookahead should keep up:
+		const uint64_t MaxLateUpdatesPercent = 10;
+		const uint64_t MaxDiscardedPercent = 10;
+
+		auto vkInst = create_benchmark_instance();
+		const auto physicalDevices = vkInst.enumeratePhysicalDevices();
+		if (physicalDevices.empty()) {
+			throw std::runtime_error("No Vulkan device found");
+		}
+		const auto physicalDevice = physicalDevices.front();
+		auto device = helpers::create_logical_device(physicalDevice, VK_NULL_HANDLE);
+		auto [queueFamilyIndex, queue] = helpers::get_queue_on_logical_device(physicalDevice, VK_NULL_HANDLE, device);
+
+		auto frameScheduler = std::make_unique<helpers::frame_scheduler>(physicalDevice, device, queueFamilyIndex, FramesInFlight);
+		const auto textureBytesBefore = get_texture_bytes(device);
+		auto flipbook = std::make_unique<helpers::flipbook_streamer>(physicalDevice, device, queueFamilyIndex, queue,
+			helpers::get_flipbook_frame_paths(DefaultImageDirectory, DefaultImagePrefix), FramesInFlight, SlotCount);
+		const auto textureBytes = get_texture_bytes(device) - textureBytesBefore;
+		const auto frameBytes = static_cast<vk::DeviceSize>(flipbook->width()) * flipbook->height() * 4;
+		const uint32_t RenderFrameCount = flipbook->frame_count() * RenderFramesPerFlipbookFrame * options.iterations;
+
+		std::cout << "flipbook: " << flipbook->frame_count() << " frames of " << flipbook->width() << "x" << flipbook->height()
+			<< " in " << SlotCount << " slots, played " << options.iterations << " times, on '" << physicalDevice.getProperties().deviceName << "'" << std::endl;
+
+		// Pace the render frames like vsync would, s.t. the worker thread decodes at the playback rate:
+		vk::DeviceSize maxTextureBytes = textureBytes;
+		std::vector<double> updateTimesMs;
+		auto nextFrame = std::chrono::steady_clock::now();
+		for (uint32_t f = 0; f < RenderFrameCount; ++f) {
+			std::this_thread::sleep_until(nextFrame);
+			nextFrame += RenderFrameDuration;
+
+			frameScheduler->begin_frame();
+			const auto updateBegin = std::chrono::steady_clock::now();
+			flipbook->update(f / RenderFramesPerFlipbookFrame, frameScheduler->frame_number());
+			updateTimesMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateBegin).count());
+			frameScheduler->submit_frame(queue);
+			maxTextureBytes = std::max(maxTextureBytes, get_texture_bytes(device) - textureBytesBefore);
+		}
+		device.waitIdle();
+
+		const auto stats = flipbook->get_statistics();
+		std::sort(updateTimesMs.begin(), updateTimesMs.end());
+		std::cout << "  decoded: " << stats.framesDecoded << ", uploaded: " << stats.framesUploaded << ", discarded: " << stats.framesDiscarded
+			<< ", late updates: " << stats.lateUpdates << " of " << RenderFrameCount << std::endl;
+		std::cout << "  update: p50 " << updateTimesMs[updateTimesMs.size() / 2] << " ms, p99 " << updateTimesMs[updateTimesMs.size() * 99 / 100]
+			<< " ms, max " << updateTimesMs.back() << " ms" << std::endl;
+		std::cout << "  texture memory: " << textureBytes / (1024 * 1024) << " MiB, at most " << maxTextureBytes / (1024 * 1024)
+			<< " MiB while streaming, for " << SlotCount << " slots of " << frameBytes / 1024 << " KiB" << std::endl;
+
+		const bool uploaded = stats.framesUploaded > 0;
+		const bool fewLateUpdates = stats.lateUpdates * 100 <= RenderFrameCount * MaxLateUpdatesPercent;
+		const bool fewDiscarded = stats.framesDiscarded * 100 <= stats.framesDecoded * MaxDiscardedPercent;
+		// The array image's memory may be padded, but not by a whole slot:
+		const bool memoryBounded = maxTextureBytes == textureBytes && textureBytes >= SlotCount * frameBytes && textureBytes < (SlotCount + 1) * frameBytes;
+		std::cout << "  results: " << (uploaded ? "frames have been uploaded" : "NO UPLOADS")
+			<< ", " << (fewLateUpdates ? "few late updates" : "TOO MANY LATE UPDATES")
+			<< ", " << (fewDiscarded ? "few discarded frames" : "TOO MANY DISCARDED FRAMES")
+			<< ", " << (memoryBounded ? "texture memory bounded by the slots" : "TEXTURE MEMORY NOT BOUNDED") << std::endl;
+		const bool passed = uploaded && fewLateUpdates && fewDiscarded && memoryBounded;
+
+		flipbook.reset();
+		frameScheduler.reset();
+		helpers::destroy_memory_arena(device);
+		helpers::destroy_logical_device(device);
+		helpers::destroy_vulkan_instance(vkInst);
+		return passed ? 0 : 1;
+	}
+}
+
+// Count all allocations of the process, for the allocations per iteration of the asset benchmark. The array, sized,
+// and nothrow forms of operator new/delete forward to these by default.
+void* operator new(std::size_t size)
+{
+	gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(0 == size ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		print_usage();
+		return 1;
+	}
+
+	const std::string command = argv[1];
+	benchmark_options options;
+	try {
+		if (!parse_options(std::vector<std::string>(argv + 2, argv + argc), options)) {
+			print_usage();
+			return 1;
+		}
+		if (command == "obj") {
+			return benchmark_obj(options);
+		}
+		if (command == "indexed") {
+			return benchmark_indexed(options);
+		}
+		if (command == "images") {
+			return benchmark_images(options);
+		}
+		if (command == "recording") {
+			return benchmark_recording(options);
+		}
+		if (command == "culling") {
+			return benchmark_culling(options);
+		}
+		if (command == "render_graph") {
+			return benchmark_render_graph(options);
+		}
+		if (command == "churn") {
+			return benchmark_churn(options);
+		}
+		if (command == "flipbook") {
+			return benchmark_flipbook(options);
+		}
+		if (command == "assets") {
+			return benchmark_assets(options);
+		}
+		print_usage();
+		return 1;
+	}
+	catch (const std::exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -1,7 +1,286 @@
 #include "pch.h"
 
-int main()
+// Usage:
+//   vk_workshop [--frames <n>] [--trace <trace.json>] [--memory-json <memory.json>] [--present-mode throughput|low-latency|power-saving]
+//   vk_workshop --headless [--frames <n>] [--device <index>] [--expected-checksum <hex>] [--trace <trace.json>] [--memory-json <memory.json>]
+//
+// --headless: Skips GLFW, the surface and the swapchain, and renders into offscreen images instead, which works on
+//             machines without a display or GPU, too (e.g. with lavapipe). Afterwards, the final image is read back,
+//             and its checksum and the frame time percentiles are printed. Exits with 1 if the checksum doesn't match
+//             the expected one.
+// --frames:   Stop after this many frames (headless: defaults to 1000; windowed: runs until the window is closed).
+// --device:   Index of the physical device to use (see the list printed at startup in headless mode).
+// --trace:    Write the CPU and GPU timings of the profiled scopes as Chrome trace JSON (open in chrome://tracing).
+// --memory-json: Write the memory telemetry (usage per heap, budgets, usage per category) as JSON at exit, and in
+//             windowed mode also whenever the key M is pressed.
+// --present-mode: What the swapchain is optimized for (default: throughput). Can be switched at runtime with the keys 1, 2, 3;
+//             the present-to-present intervals of each present mode are printed at exit.
+
+namespace
 {
+	struct app_options
+	{
+		bool headless = false;
+		uint64_t frameCount = 0;				// 0 => until the window is closed (headless: DefaultHeadlessFrameCount)
+		size_t deviceIndex = 0;
+		std::optional<uint64_t> expectedChecksum;
+		std::string tracePath;					// Empty => no trace
+		std::string memoryJsonPath;				// Empty => the memory telemetry is only printed
+		helpers::present_mode_preference presentMode = helpers::present_mode_preference::throughput;
+	};
+
+	constexpr uint64_t DefaultHeadlessFrameCount = 1000;
+
+	void print_usage()
+	{
+		std::cout << "Usage:\n"
+			<< "  vk_workshop [--frames <n>] [--trace <trace.json>] [--memory-json <memory.json>] [--present-mode throughput|low-latency|power-saving]\n"
+			<< "  vk_workshop --headless [--frames <n>] [--device <index>] [--expected-checksum <hex>] [--trace <trace.json>] [--memory-json <memory.json>]\n";
+	}
+
+	bool parse_options(const std::vector<std::string>& args, app_options& outOptions)
+	{
+		for (size_t i = 0; i < args.size(); ++i) {
+			if (args[i] == "--headless") {
+				outOptions.headless = true;
+			}
+			else if (args[i] == "--frames" && i + 1 < args.size()) {
+				outOptions.frameCount = std::stoull(args[++i]);
+			}
+			else if (args[i] == "--device" && i + 1 < args.size()) {
+				outOptions.deviceIndex = static_cast<size_t>(std::stoul(args[++i]));
+			}
+			else if (args[i] == "--expected-checksum" && i + 1 < args.size()) {
+				outOptions.expectedChecksum = std::stoull(args[++i], nullptr, 16);
+			}
+			else if (args[i] == "--trace" && i + 1 < args.size()) {
+				outOptions.tracePath = args[++i];
+			}
+			else if (args[i] == "--memory-json" && i + 1 < args.size()) {
+				outOptions.memoryJsonPath = args[++i];
+			}
+			else if (args[i] == "--present-mode" && i + 1 < args.size()) {
+				const auto& mode = args[++i];
+				if (mode == helpers::to_string(helpers::present_mode_preference::throughput)) {
+					outOptions.presentMode = helpers::present_mode_preference::throughput;
+				}
+				else if (mode == helpers::to_string(helpers::present_mode_preference::low_latency)) {
+					outOptions.presentMode = helpers::present_mode_preference::low_latency;
+				}
+				else if (mode == helpers::to_string(helpers::present_mode_preference::power_saving)) {
+					outOptions.presentMode = helpers::present_mode_preference::power_saving;
+				}
+				else {
+					return false;
+				}
+			}
+			else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The value below which the given fraction of the (sorted) samples lie
+	double percentile(const std::vector<double>& sortedSamples, const double fraction)
+	{
+		const auto index = static_cast<size_t>(fraction * static_cast<double>(sortedSamples.size() - 1) + 0.5);
+		return sortedSamples[std::min(index, sortedSamples.size() - 1)];
+	}
+
+	void print_percentiles(const std::string& name, std::vector<double> samples)
+	{
+		if (samples.empty()) {
+			return;
+		}
+		std::sort(samples.begin(), samples.end());
+		std::cout << "  " << name << ": p50 " << percentile(samples, 0.5) << " ms, p90 " << percentile(samples, 0.9)
+			<< " ms, p99 " << percentile(samples, 0.99) << " ms, max " << samples.back() << " ms" << std::endl;
+	}
+
+	void print_profiler_results(const helpers::gpu_profiler& profiler, const app_options& options)
+	{
+		profiler.print_statistics(std::cout);
+		if (!options.tracePath.empty()) {
+			profiler.write_chrome_trace(options.tracePath);
+			std::cout << "Trace written to '" << options.tracePath << "'" << std::endl;
+		}
+	}
+
+	void print_memory_telemetry(const vk::Device device, const app_options& options)
+	{
+		const auto& arena = helpers::get_memory_arena(device);
+		arena.print_telemetry(std::cout);
+		if (!options.memoryJsonPath.empty()) {
+			arena.write_telemetry_json(options.memoryJsonPath);
+			std::cout << "Memory telemetry written to '" << options.memoryJsonPath << "'" << std::endl;
+		}
+	}
+
+	void print_device_queues(const helpers::device_queues& queues)
+	{
+		std::cout << "Queues: graphics family " << queues.graphics.familyIndex
+			<< ", transfer family " << queues.transfer.familyIndex << (queues.has_dedicated_transfer() ? " (dedicated)" : " (graphics queue)")
+			<< ", compute family " << queues.compute.familyIndex << (queues.has_async_compute() ? " (async)" : " (graphics queue)") << std::endl;
+	}
+
+	// Renders the same frames as the windowed mode -- each frame copies the clear color of its frame slot into
+	// an image -- but into offscreen images. Reads back the final image and returns 1 if its checksum doesn't match.
+	int run_headless(const app_options& options)
+	{
+		const uint32_t WIDTH = 800;
+		const uint32_t HEIGHT = 800;
+		const uint32_t CONCURRENT_FRAMES = 3;
+		const auto imageFormat = vk::Format::eB8G8R8A8Unorm;
+		const auto frameCount = 0 == options.frameCount ? DefaultHeadlessFrameCount : options.frameCount;
+
+		auto vkInst = helpers::create_headless_vulkan_instance();
+		const auto physicalDevices = vkInst.enumeratePhysicalDevices();
+		for (size_t i = 0; i < physicalDevices.size(); ++i) {
+			std::cout << (i == options.deviceIndex ? "* " : "  ") << i << ": " << physicalDevices[i].getProperties().deviceName << std::endl;
+		}
+		if (options.deviceIndex >= physicalDevices.size()) {
+			throw std::runtime_error("There is no physical device with index " + std::to_string(options.deviceIndex));
+		}
+		auto physicalDevice = physicalDevices[options.deviceIndex];
+		const auto queueFamilies = helpers::find_queue_family_indices(physicalDevice, VK_NULL_HANDLE);
+		auto device = helpers::create_logical_device(physicalDevice, VK_NULL_HANDLE, queueFamilies);
+		const auto deviceQueues = helpers::get_device_queues(device, queueFamilies);
+		print_device_queues(deviceQueues);
+		const auto queueFamilyIndex = deviceQueues.graphics.familyIndex;
+		const auto queue = deviceQueues.graphics.queue;
+
+		// Offscreen images instead of swapchain images, plus one clear color buffer per frame slot (as in the windowed mode):
+		const std::array<std::array<uint8_t, 4>, CONCURRENT_FRAMES> clearColors = {{ { 0, 0, 255, 255 }, { 0, 255, 0, 255 }, { 255, 0, 0, 255 } }};
+		std::vector<std::tuple<vk::Image, helpers::memory_allocation>> images;
+		std::vector<std::tuple<vk::Buffer, helpers::memory_allocation>> clearBuffers;
+		for (uint32_t i = 0; i < CONCURRENT_FRAMES; ++i) {
+			images.push_back(helpers::create_image(device, physicalDevice, WIDTH, HEIGHT, imageFormat,
+				vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc,
+				1u, 1u, helpers::memory_category::render_target
+			));
+			std::vector<uint8_t> clearColorData(WIDTH * HEIGHT * 4);
+			for (size_t t = 0; t < clearColorData.size(); t += 4) {
+				std::copy(clearColors[i].begin(), clearColors[i].end(), clearColorData.begin() + t);
+			}
+			clearBuffers.push_back(helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, clearColorData.size(), vk::BufferUsageFlagBits::eTransferSrc));
+			helpers::copy_data_into_host_coherent_memory(device, clearColorData.size(), clearColorData.data(), std::get<helpers::memory_allocation>(clearBuffers.back()));
+		}
+
+		auto frameScheduler = std::make_unique<helpers::frame_scheduler>(physicalDevice, device, queueFamilyIndex, CONCURRENT_FRAMES);
+		auto profiler = std::make_unique<helpers::gpu_profiler>(physicalDevice, device, queueFamilyIndex, queue, CONCURRENT_FRAMES);
+		auto renderGraph = std::make_unique<helpers::render_graph>(physicalDevice, device, CONCURRENT_FRAMES);
+		std::vector<double> frameTimesMs;
+		frameTimesMs.reserve(static_cast<size_t>(frameCount));
+		size_t lastImageIndex = 0;
+		auto previousFrameBegin = std::chrono::steady_clock::now();
+		for (uint64_t f = 0; f < frameCount; ++f) {
+			auto& frame = frameScheduler->begin_frame();
+			profiler->begin_frame(frame.commandBuffer);
+			const auto frameBegin = std::chrono::steady_clock::now();
+			if (f > 0) {
+				frameTimesMs.push_back(std::chrono::duration<double, std::milli>(frameBegin - previousFrameBegin).count());
+			}
+			previousFrameBegin = frameBegin;
+
+			{
+				// The scopes end before the command buffer is ended by submit_frame:
+				auto recordScope = profiler->cpu("record");
+				auto frameScope = profiler->scope(frame.commandBuffer, "frame");
+				// Each slot has its own image => the image is not in use by the GPU anymore, once the slot is available again:
+				lastImageIndex = static_cast<size_t>(f % CONCURRENT_FRAMES);
+				const auto clearBuffer = std::get<vk::Buffer>(clearBuffers[lastImageIndex]);
+				// The image is overwritten completely => its previous contents don't matter. Afterwards, it stays in the
+				// transfer source layout, s.t. it can be read back:
+				renderGraph->reset();
+				const auto target = renderGraph->import_image(std::get<vk::Image>(images[lastImageIndex]), imageFormat,
+					helpers::image_state{ vk::ImageLayout::eUndefined },
+					helpers::image_state{ vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead }
+				);
+				renderGraph->add_pass("copy_clear_color", [&](helpers::render_graph_pass_builder& pass) {
+					pass.write(target, helpers::image_usage::transfer_dst);
+				}, [&](const vk::CommandBuffer commandBuffer, const helpers::render_graph& graph) {
+					auto copyScope = profiler->scope(commandBuffer, "copy_buffer_to_image");
+					helpers::copy_buffer_to_image(commandBuffer, clearBuffer, graph.image(target), WIDTH, HEIGHT);
+				});
+				renderGraph->execute(frame.commandBuffer);
+			}
+			frameScheduler->submit_frame(queue);
+		}
+		device.waitIdle();
+
+		// Read back the final image:
+		auto [readbackBuffer, readbackMemory] = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, WIDTH * HEIGHT * 4, vk::BufferUsageFlagBits::eTransferDst);
+		auto commandPool = device.createCommandPool(vk::CommandPoolCreateInfo{}.setQueueFamilyIndex(queueFamilyIndex));
+		auto commandBuffer = helpers::allocate_command_buffer(device, commandPool);
+		commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		commandBuffer.copyImageToBuffer(std::get<vk::Image>(images[lastImageIndex]), vk::ImageLayout::eTransferSrcOptimal, readbackBuffer, {
+			vk::BufferImageCopy{ 0, 0, 0, vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, vk::Offset3D{ 0, 0, 0 }, vk::Extent3D{ WIDTH, HEIGHT, 1 } }
+		});
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {},
+			{ vk::MemoryBarrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead } }, {}, {});
+		commandBuffer.end();
+		queue.submit({ vk::SubmitInfo{}.setCommandBufferCount(1u).setPCommandBuffers(&commandBuffer) }, nullptr);
+		queue.waitIdle();
+		const auto checksum = helpers::fnv1a_64(readbackMemory.mappedData, WIDTH * HEIGHT * 4);
+
+		std::vector<double> gpuBusyMs;
+		for (const auto& t : frameScheduler->completed_frame_timings()) {
+			if (t.gpuBusyMs >= 0.0) {
+				gpuBusyMs.push_back(t.gpuBusyMs);
+			}
+		}
+		std::cout << "Headless: " << frameCount << " frames of " << WIDTH << "x" << HEIGHT << " on '" << physicalDevice.getProperties().deviceName << "'" << std::endl;
+		print_percentiles("frame time", frameTimesMs);
+		print_percentiles("GPU busy  ", gpuBusyMs);
+		std::cout << "  checksum of the final image: " << std::hex << checksum << std::dec << std::endl;
+		const bool matches = !options.expectedChecksum.has_value() || *options.expectedChecksum == checksum;
+		if (!matches) {
+			std::cout << "  MISMATCH: expected " << std::hex << *options.expectedChecksum << std::dec << std::endl;
+		}
+		print_profiler_results(*profiler, options);
+		renderGraph->print_statistics(std::cout);
+		print_memory_telemetry(device, options);
+
+		// Cleanup:
+		device.destroyCommandPool(commandPool);
+		helpers::destroy_buffer(device, readbackBuffer);
+		helpers::free_memory(device, readbackMemory);
+		for (auto [buffer, memory] : clearBuffers) {
+			helpers::destroy_buffer(device, buffer);
+			helpers::free_memory(device, memory);
+		}
+		for (auto [image, memory] : images) {
+			helpers::destroy_image(device, image);
+			helpers::free_memory(device, memory);
+		}
+		renderGraph.reset();
+		profiler.reset();
+		frameScheduler.reset();
+		helpers::destroy_memory_arena(device);
+		helpers::destroy_logical_device(device);
+		helpers::destroy_vulkan_instance(vkInst);
+		return matches ? 0 : 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	app_options options;
+	try {
+		if (!parse_options(std::vector<std::string>(argv + 1, argv + argc), options)) {
+			print_usage();
+			return 1;
+		}
+		if (options.headless) {
+			return run_headless(options);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+
     glfwInit();
 
 	// Define some constants to be used throughout the program:
@@ -20,25 +299,35 @@ int main()
 	auto surface = helpers::create_surface(window, vkInst);
 	// ===> 4. Get a handle to (one) physical device, i.e. to the GPU
     auto physicalDevice = vkInst.enumeratePhysicalDevices().front(); // TODO Part 1: If you have multiple GPUs (on a laptop, for instance), select the one you want to use for rendering!
-	// ===> 5. Create a logical device which serves as this application's interface to the physical device
-	auto device = helpers::create_logical_device(physicalDevice, surface);	
-	// ===> 6. Get a queue on the logical device so we can send commands to it
-	auto [queueFamilyIndex, queue] = helpers::get_queue_on_logical_device(physicalDevice, surface, device);
-
-	// ===> 7. Create a swapchain
-	auto swapchainCreateInfo = vk::SwapchainCreateInfoKHR{}
-		.setSurface(surface)
-		.setImageExtent(vk::Extent2D{WIDTH, HEIGHT})
-		.setMinImageCount(CONCURRENT_FRAMES)
-		.setImageArrayLayers(1u)
-		.setImageUsage(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst)
-		.setImageFormat(vk::Format::eB8G8R8A8Unorm)				// TODO Part 1: Query physical device for supported formats and select one!
-		.setImageColorSpace(vk::ColorSpaceKHR::eSrgbNonlinear)	//              ... or actually format + color space combinations
-		.setPresentMode(vk::PresentModeKHR::eFifo);				// TODO Part 1: Query physical device for supported presentation modes and select one!
-	auto swapchain = device.createSwapchainKHR(swapchainCreateInfo);
-
-	// ===> 8. Get all the swapchain's images
-	auto swapchainImages = device.getSwapchainImagesKHR(swapchain);
+	// ===> 5. Create a logical device which serves as this application's interface to the physical device.
+	//         Besides the graphics queue, it gets dedicated transfer and compute queues, if the physical device has them:
+	const auto queueFamilies = helpers::find_queue_family_indices(physicalDevice, surface);
+	auto device = helpers::create_logical_device(physicalDevice, surface, queueFamilies);
+	// ===> 6. Get the queues on the logical device so we can send commands to them. Rendering and presenting happen on the
+	//         graphics queue; uploads can go to deviceQueues.transfer (see helpers::upload_engine), which is the graphics
+	//         queue itself if there is no dedicated transfer queue:
+	const auto deviceQueues = helpers::get_device_queues(device, queueFamilies);
+	print_device_queues(deviceQueues);
+	const auto queueFamilyIndex = deviceQueues.graphics.familyIndex;
+	const auto queue = deviceQueues.graphics.queue;
+	// Load the pipeline cache of the previous run (if it has been written by this device and driver).
+	// Pass pipelineCache->handle() to all pipeline creation, or use pipelineCache->create_graphics_pipeline:
+	auto pipelineCache = std::make_unique<helpers::pipeline_cache>(physicalDevice, device, helpers::get_pipeline_cache_path(physicalDevice));
+
+	// ===> 7. Create a swapchain. The swapchain manager selects a format, present mode and image count which the surface
+	//         supports (see helpers::present_mode_preference), and recreates the swapchain whenever it is out of date:
+	auto swapchain = std::make_unique<helpers::swapchain_manager>(physicalDevice, device, surface, CONCURRENT_FRAMES, options.presentMode, [window]() {
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		return vk::Extent2D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	});
+	glfwSetWindowUserPointer(window, swapchain.get());
+	glfwSetFramebufferSizeCallback(window, [](GLFWwindow* resizedWindow, int, int) {
+		static_cast<helpers::swapchain_manager*>(glfwGetWindowUserPointer(resizedWindow))->request_recreation();
+	});
+
+	// ===> 8. The swapchain's images are available through swapchain->images(). They are replaced whenever the swapchain
+	//         is recreated, i.e. whenever swapchain->generation() changes.
 
 	//*****************
 	// Here's plan #1:
@@ -74,103 +363,139 @@ int main()
 	// Create the buffer:
 	std::array<vk::Buffer, CONCURRENT_FRAMES> clearBuffers;
 	for (size_t i = 0; i < CONCURRENT_FRAMES; ++i) {
-		// Describe a new buffer:
-		auto createInfo = vk::BufferCreateInfo{}
-			.setSize(static_cast<vk::DeviceSize>(WIDTH * HEIGHT * 4))
-			.setUsage(vk::BufferUsageFlagBits::eTransferSrc);
-		clearBuffers[i] = device.createBuffer(createInfo);
-		vk::Buffer buffer1;
-		// Allocate the memory (we want host-coherent memory):
-		auto memory = helpers::allocate_host_coherent_memory_for_given_requirements(physicalDevice, device, createInfo.size, device.getBufferMemoryRequirements(clearBuffers[i]));
-
-		// Bind the buffer handle to the memory:
-		device.bindBufferMemory(clearBuffers[i], memory, 0); // TODO Part 1: Use only ONE memory allocation for all buffers, and bind them to different offsets!
+		// Create a new buffer with host-coherent backing memory. All of the buffers are sub-allocated
+		// from the same memory block of the memory arena, i.e. they are bound to different offsets:
+		auto [buffer, memory] = helpers::create_host_coherent_buffer_and_memory(device, physicalDevice, WIDTH * HEIGHT * 4, vk::BufferUsageFlagBits::eTransferSrc);
+		clearBuffers[i] = buffer;
 
 		// Copy the colors of your liking into the buffer's memory:
-		auto clearColorMappedMemory = device.mapMemory(memory, 0, createInfo.size);
-		memcpy(clearColorMappedMemory, (*clearColorData)[i].data(), createInfo.size);
-		device.unmapMemory(memory);
+		helpers::copy_data_into_host_coherent_memory(device, WIDTH * HEIGHT * 4, (*clearColorData)[i].data(), memory);
 
 		// Make sure to clean up at the end of the application:
-		cleanupHandlers.emplace_back([device, buffer=clearBuffers[i], memory](){
+		cleanupHandlers.emplace_back([device, buffer=clearBuffers[i], memory=memory](){
 			helpers::free_memory(device, memory);
 			device.destroyBuffer(buffer);
 		});
 	}
+	helpers::get_memory_arena(device).print_statistics(std::cout);
 
-	// ===> 10. Create a command pool so that we can create commands
-	auto commandPoolCreateInfo = vk::CommandPoolCreateInfo{}
-		.setQueueFamilyIndex(queueFamilyIndex);
-	auto commandPool = device.createCommandPool(commandPoolCreateInfo);
+	// ===> 10. Create a frame scheduler which owns one set of per-frame resources (command pool + command buffer,
+	//          semaphores, fence) for each of the frames which are in flight concurrently:
+	auto frameScheduler = std::make_unique<helpers::frame_scheduler>(physicalDevice, device, queueFamilyIndex, CONCURRENT_FRAMES);
+	// Measures the GPU time of scopes within the frames' command buffers (see --trace for a timeline):
+	auto profiler = std::make_unique<helpers::gpu_profiler>(physicalDevice, device, queueFamilyIndex, queue, CONCURRENT_FRAMES);
+	// Describes each frame as passes which declare the images they read and write, and derives the barriers and image
+	// layout transitions between them (see helpers::render_graph):
+	auto renderGraph = std::make_unique<helpers::render_graph>(physicalDevice, device, CONCURRENT_FRAMES);
 	
 	// ===> 11. Start our render loop and clear those swap chain images!!
 	const double startTime = glfwGetTime();
-    while(!glfwWindowShouldClose(window)) {
+	bool memoryKeyWasPressed = false;
+    while(!glfwWindowShouldClose(window) && (0 == options.frameCount || frameScheduler->frame_number() < options.frameCount)) {
     	auto curTime = glfwGetTime();
+
+    	// Wait until the GPU has finished the frame which used the same per-frame resources CONCURRENT_FRAMES frames
+    	// ago. Only then, the command buffer is reset and begun. The CPU only blocks if it is too far ahead.
+    	auto& frame = frameScheduler->begin_frame();
+		profiler->begin_frame(frame.commandBuffer);
 		
-    	// Create a semaphore that will be signalled as soon as an image becomes available:
-		auto imageAvailableSemaphore = device.createSemaphore(vk::SemaphoreCreateInfo{});
-    	// Request the next image (we'll get the index returned, we already have gotten the image handles in ===> 8.):
-		auto swapChainImageIndex = device.acquireNextImageKHR(swapchain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphore, nullptr).value;
-    	auto& currentSwapchainImage = swapchainImages[swapChainImageIndex];
+    	// Request the next image (we'll get the index returned, the image handles are in swapchain->images(), see ===> 8.).
+    	// The frame's imageAvailableSemaphore will be signalled as soon as the image becomes available.
+    	// If the swapchain is out of date (e.g. because the window has been resized), it is recreated first:
+		auto swapChainImageIndex = swapchain->acquire_next_image(frame.imageAvailableSemaphore);
+		if (!swapChainImageIndex.has_value()) {
+			// The window is minimized => there is nothing to render into. Submit the frame anyway (without waiting on
+			// the semaphore, which hasn't been signalled), s.t. its fence gets signalled, and sleep until something happens:
+			frameScheduler->submit_frame(queue);
+			glfwWaitEvents();
+			continue;
+		}
+    	auto& currentSwapchainImage = swapchain->images()[*swapChainImageIndex];
 
     	// As soon as we have the image, let's copy the clear color into it!
     	// ^ what is meant by "as soon as we have the image" is the following:
     	//   We record the command buffer right now -- which is most likely BEFORE the
     	//   requested swap chain image has been acquired.
     	//   vkAcquireNextImageKHR will signal the imageAvailableSemaphore when is has acquired the image.
-    	//   The very same imageAvailableSemaphore is set as a "wait semaphore" to the VkSubmitInfo below. (*1)
-    	auto commandBuffer = helpers::allocate_command_buffer(device, commandPool);
-    	commandBuffer.begin(vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    	//   The very same imageAvailableSemaphore is set as a "wait semaphore" by submit_frame below. (*1)
 		//
-    	// Attention:   The following call (which is vkCmdCopyBufferToImage in disguise) is producing validation errors (see console)
-    	// TODO Part 1: Fix those validation errors by adding suitable image layout transitions!
-    	//				Feel free to use helpers::establish_pipeline_barrier_with_image_layout_transition
-    	//				
-		helpers::copy_buffer_to_image(commandBuffer, clearBuffers[swapChainImageIndex], currentSwapchainImage, 800, 800);
-    	commandBuffer.end();
-
-    	// Create a semaphore that will be signalled when rendering has finished:
-		auto renderFinishedSemaphore = device.createSemaphore(vk::SemaphoreCreateInfo{});
-    	// Submit the command buffer
-    	vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands; // TODO Part 1: Can we wait in a specific/later stage?
-    	auto submitInfo = vk::SubmitInfo{}
-    		.setCommandBufferCount(1u)
-    		.setPCommandBuffers(&commandBuffer)
-    		.setWaitSemaphoreCount(1u)
-    		.setPWaitSemaphores(&imageAvailableSemaphore) // <--- (*1) Wait on the swap chain image to become available
-    		.setSignalSemaphoreCount(1u)
-    		.setPSignalSemaphores(&renderFinishedSemaphore) // Another semaphore: This will be signalled as soon as this batch of work has completed. 
-    		.setPWaitDstStageMask(&waitStage);
-		queue.submit({ submitInfo }, nullptr);
+		// The copy (which is vkCmdCopyBufferToImage in disguise) needs the image in eTransferDstOptimal layout, and the
+		// present needs it in ePresentSrcKHR layout. The render graph derives both transitions from the pass' declared
+		// usage and the imported image's initial and final state. The image is overwritten => its previous contents
+		// (eUndefined) don't matter. The first transition waits for the transfer stage, which is the stage in which the
+		// submit waits for the imageAvailableSemaphore (*2) => the transition happens after the image has been acquired:
+		const vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eTransfer;
+		const auto clearBuffer = clearBuffers[*swapChainImageIndex % CONCURRENT_FRAMES];
+		renderGraph->reset();
+		const auto backbuffer = renderGraph->import_image(currentSwapchainImage, swapchain->format(),
+			helpers::image_state{ vk::ImageLayout::eUndefined, waitStage },
+			helpers::image_state{ vk::ImageLayout::ePresentSrcKHR, vk::PipelineStageFlagBits::eBottomOfPipe }
+		);
+		renderGraph->add_pass("copy_clear_color", [&](helpers::render_graph_pass_builder& pass) {
+			pass.write(backbuffer, helpers::image_usage::transfer_dst);
+		}, [&](const vk::CommandBuffer commandBuffer, const helpers::render_graph& graph) {
+			auto copyScope = profiler->scope(commandBuffer, "copy_buffer_to_image");
+			// There may be more swapchain images than clear buffers, and the window may have been resized => copy as much
+			// of the WIDTH x HEIGHT clear buffer as fits:
+			const auto extent = swapchain->extent();
+			helpers::copy_buffer_to_image(commandBuffer, clearBuffer, graph.image(backbuffer),
+				std::min(extent.width, static_cast<uint32_t>(WIDTH)), std::min(extent.height, static_cast<uint32_t>(HEIGHT)), WIDTH);
+		});
+		renderGraph->execute(frame.commandBuffer);
+
+    	// Submit the command buffer. It waits on the imageAvailableSemaphore (*1) in the transfer stage (*2), signals the
+    	// frame's renderFinishedSemaphore as soon as this batch of work has completed, and signals the frame's fence.
+		frameScheduler->submit_frame(queue, waitStage);
 		
-    	// Present the image to the screen:
-    	                                        // Also the present instruction is producing validation errors because the image is not in the right layout.
-    	auto presentInfo = vk::PresentInfoKHR{} // TODO Part 1: Add suitable image layout transitions, s.t. the image is in vk::ImageLayout::ePresentSrcKHR layout!
-    		.setSwapchainCount(1u)              //              Think about where the right place would be to add those image layout transitions!
-    		.setPSwapchains(&swapchain)
-			.setPImageIndices(&swapChainImageIndex)
-    		.setWaitSemaphoreCount(1u)
-    		.setPWaitSemaphores(&renderFinishedSemaphore); // Wait until rendering has finished (until vkQueueSubmit has signalled the renderFinishedSemaphore)
-    	queue.presentKHR(presentInfo);
-
-    	device.waitIdle();
-    	device.destroySemaphore(renderFinishedSemaphore);
-    	device.freeCommandBuffers(commandPool, 1, &commandBuffer);
-    	device.destroySemaphore(imageAvailableSemaphore);
+    	// Present the image to the screen, as soon as rendering has finished (i.e. vkQueueSubmit has signalled the renderFinishedSemaphore).
+    	// The render graph's final barrier has transitioned the image into the ePresentSrcKHR layout:
+		swapchain->present(queue, *swapChainImageIndex, frame.renderFinishedSemaphore);
+
+    	// No device.waitIdle() here! The next begin_frame only waits if the GPU is CONCURRENT_FRAMES frames behind.
+    	if (frameScheduler->frame_number() % 600 == 0) {
+    		frameScheduler->print_timings(std::cout);
+    		pipelineCache->save(); // Only writes if pipelines have been added since the last time
+    	}
     	
 		glfwPollEvents();
     	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
     		glfwSetWindowShouldClose(window, GLFW_TRUE);
     	}
+		// Switch present modes at runtime (the swapchain is recreated with the next acquire):
+		if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
+			swapchain->set_preference(helpers::present_mode_preference::throughput);
+		}
+		if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
+			swapchain->set_preference(helpers::present_mode_preference::low_latency);
+		}
+		if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
+			swapchain->set_preference(helpers::present_mode_preference::power_saving);
+		}
+		// Dump the memory telemetry (once per key press):
+		const bool memoryKeyIsPressed = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+		if (memoryKeyIsPressed && !memoryKeyWasPressed) {
+			print_memory_telemetry(device, options);
+		}
+		memoryKeyWasPressed = memoryKeyIsPressed;
     }
+	device.waitIdle();
+	frameScheduler->print_timings(std::cout);
+	pipelineCache->print_statistics(std::cout);
+	swapchain->print_statistics(std::cout);
+	print_profiler_results(*profiler, options);
+	renderGraph->print_statistics(std::cout);
+	print_memory_telemetry(device, options);
 
     // Perform cleanup:
 	for (auto it = cleanupHandlers.rbegin(); it != cleanupHandlers.rend(); ++it) {
 		(*it)();
 	}
-	device.destroy(commandPool);
-	device.destroy(swapchain);
+	renderGraph.reset();
+	profiler.reset();
+	frameScheduler.reset();
+	pipelineCache.reset(); // Writes the cache back to disk
+	swapchain.reset();
+	helpers::destroy_memory_arena(device);
 	helpers::destroy_logical_device(device);
 	helpers::destroy_surface(vkInst, surface);
 	helpers::destroy_vulkan_instance(vkInst);